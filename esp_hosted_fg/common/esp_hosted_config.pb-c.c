@@ -997,6 +997,96 @@ void   ctrl_msg__resp__scan_result__free_unpacked
   assert(message->base.descriptor == &ctrl_msg__resp__scan_result__descriptor);
   protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
 }
+void   ctrl_msg__req__scan_list_stream__init
+                     (CtrlMsgReqScanListStream         *message)
+{
+  static const CtrlMsgReqScanListStream init_value = CTRL_MSG__REQ__SCAN_LIST_STREAM__INIT;
+  *message = init_value;
+}
+size_t ctrl_msg__req__scan_list_stream__get_packed_size
+                     (const CtrlMsgReqScanListStream *message)
+{
+  assert(message->base.descriptor == &ctrl_msg__req__scan_list_stream__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t ctrl_msg__req__scan_list_stream__pack
+                     (const CtrlMsgReqScanListStream *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &ctrl_msg__req__scan_list_stream__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t ctrl_msg__req__scan_list_stream__pack_to_buffer
+                     (const CtrlMsgReqScanListStream *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &ctrl_msg__req__scan_list_stream__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+CtrlMsgReqScanListStream *
+       ctrl_msg__req__scan_list_stream__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (CtrlMsgReqScanListStream *)
+     protobuf_c_message_unpack (&ctrl_msg__req__scan_list_stream__descriptor,
+                                allocator, len, data);
+}
+void   ctrl_msg__req__scan_list_stream__free_unpacked
+                     (CtrlMsgReqScanListStream *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &ctrl_msg__req__scan_list_stream__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+void   ctrl_msg__resp__scan_list_stream__init
+                     (CtrlMsgRespScanListStream         *message)
+{
+  static const CtrlMsgRespScanListStream init_value = CTRL_MSG__RESP__SCAN_LIST_STREAM__INIT;
+  *message = init_value;
+}
+size_t ctrl_msg__resp__scan_list_stream__get_packed_size
+                     (const CtrlMsgRespScanListStream *message)
+{
+  assert(message->base.descriptor == &ctrl_msg__resp__scan_list_stream__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t ctrl_msg__resp__scan_list_stream__pack
+                     (const CtrlMsgRespScanListStream *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &ctrl_msg__resp__scan_list_stream__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t ctrl_msg__resp__scan_list_stream__pack_to_buffer
+                     (const CtrlMsgRespScanListStream *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &ctrl_msg__resp__scan_list_stream__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+CtrlMsgRespScanListStream *
+       ctrl_msg__resp__scan_list_stream__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (CtrlMsgRespScanListStream *)
+     protobuf_c_message_unpack (&ctrl_msg__resp__scan_list_stream__descriptor,
+                                allocator, len, data);
+}
+void   ctrl_msg__resp__scan_list_stream__free_unpacked
+                     (CtrlMsgRespScanListStream *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &ctrl_msg__resp__scan_list_stream__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
 void   ctrl_msg__req__soft_apconnected_sta__init
                      (CtrlMsgReqSoftAPConnectedSTA         *message)
 {
@@ -2617,6 +2707,51 @@ void   ctrl_msg__event__set_dhcp_dns_status__free_unpacked
   assert(message->base.descriptor == &ctrl_msg__event__set_dhcp_dns_status__descriptor);
   protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
 }
+void   ctrl_msg__event__scan_result__init
+                     (CtrlMsgEventScanResult         *message)
+{
+  static const CtrlMsgEventScanResult init_value = CTRL_MSG__EVENT__SCAN_RESULT__INIT;
+  *message = init_value;
+}
+size_t ctrl_msg__event__scan_result__get_packed_size
+                     (const CtrlMsgEventScanResult *message)
+{
+  assert(message->base.descriptor == &ctrl_msg__event__scan_result__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t ctrl_msg__event__scan_result__pack
+                     (const CtrlMsgEventScanResult *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &ctrl_msg__event__scan_result__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t ctrl_msg__event__scan_result__pack_to_buffer
+                     (const CtrlMsgEventScanResult *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &ctrl_msg__event__scan_result__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+CtrlMsgEventScanResult *
+       ctrl_msg__event__scan_result__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (CtrlMsgEventScanResult *)
+     protobuf_c_message_unpack (&ctrl_msg__event__scan_result__descriptor,
+                                allocator, len, data);
+}
+void   ctrl_msg__event__scan_result__free_unpacked
+                     (CtrlMsgEventScanResult *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &ctrl_msg__event__scan_result__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
 void   ctrl_msg__req__custom_rpc_unserialised_msg__init
                      (CtrlMsgReqCustomRpcUnserialisedMsg         *message)
 {
@@ -2752,6 +2887,96 @@ void   ctrl_msg__event__custom_rpc_unserialised_msg__free_unpacked
   assert(message->base.descriptor == &ctrl_msg__event__custom_rpc_unserialised_msg__descriptor);
   protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
 }
+void   ctrl_msg__req__batch__init
+                     (CtrlMsgReqBatch         *message)
+{
+  static const CtrlMsgReqBatch init_value = CTRL_MSG__REQ__BATCH__INIT;
+  *message = init_value;
+}
+size_t ctrl_msg__req__batch__get_packed_size
+                     (const CtrlMsgReqBatch *message)
+{
+  assert(message->base.descriptor == &ctrl_msg__req__batch__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t ctrl_msg__req__batch__pack
+                     (const CtrlMsgReqBatch *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &ctrl_msg__req__batch__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t ctrl_msg__req__batch__pack_to_buffer
+                     (const CtrlMsgReqBatch *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &ctrl_msg__req__batch__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+CtrlMsgReqBatch *
+       ctrl_msg__req__batch__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (CtrlMsgReqBatch *)
+     protobuf_c_message_unpack (&ctrl_msg__req__batch__descriptor,
+                                allocator, len, data);
+}
+void   ctrl_msg__req__batch__free_unpacked
+                     (CtrlMsgReqBatch *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &ctrl_msg__req__batch__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+void   ctrl_msg__resp__batch__init
+                     (CtrlMsgRespBatch         *message)
+{
+  static const CtrlMsgRespBatch init_value = CTRL_MSG__RESP__BATCH__INIT;
+  *message = init_value;
+}
+size_t ctrl_msg__resp__batch__get_packed_size
+                     (const CtrlMsgRespBatch *message)
+{
+  assert(message->base.descriptor == &ctrl_msg__resp__batch__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t ctrl_msg__resp__batch__pack
+                     (const CtrlMsgRespBatch *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &ctrl_msg__resp__batch__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t ctrl_msg__resp__batch__pack_to_buffer
+                     (const CtrlMsgRespBatch *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &ctrl_msg__resp__batch__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+CtrlMsgRespBatch *
+       ctrl_msg__resp__batch__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (CtrlMsgRespBatch *)
+     protobuf_c_message_unpack (&ctrl_msg__resp__batch__descriptor,
+                                allocator, len, data);
+}
+void   ctrl_msg__resp__batch__free_unpacked
+                     (CtrlMsgRespBatch *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &ctrl_msg__resp__batch__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
 void   ctrl_msg__init
                      (CtrlMsg         *message)
 {
@@ -4131,6 +4356,95 @@ const ProtobufCMessageDescriptor ctrl_msg__resp__scan_result__descriptor =
   (ProtobufCMessageInit) ctrl_msg__resp__scan_result__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
+static const ProtobufCFieldDescriptor ctrl_msg__req__scan_list_stream__field_descriptors[1] =
+{
+  {
+    "max_per_event",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgReqScanListStream, max_per_event),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned ctrl_msg__req__scan_list_stream__field_indices_by_name[] = {
+  0,   /* field[0] = max_per_event */
+};
+static const ProtobufCIntRange ctrl_msg__req__scan_list_stream__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 1 }
+};
+const ProtobufCMessageDescriptor ctrl_msg__req__scan_list_stream__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "CtrlMsg_Req_ScanListStream",
+  "CtrlMsgReqScanListStream",
+  "CtrlMsgReqScanListStream",
+  "",
+  sizeof(CtrlMsgReqScanListStream),
+  1,
+  ctrl_msg__req__scan_list_stream__field_descriptors,
+  ctrl_msg__req__scan_list_stream__field_indices_by_name,
+  1,  ctrl_msg__req__scan_list_stream__number_ranges,
+  (ProtobufCMessageInit) ctrl_msg__req__scan_list_stream__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor ctrl_msg__resp__scan_list_stream__field_descriptors[2] =
+{
+  {
+    "resp",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgRespScanListStream, resp),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "scan_id",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgRespScanListStream, scan_id),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned ctrl_msg__resp__scan_list_stream__field_indices_by_name[] = {
+  0,   /* field[0] = resp */
+  1,   /* field[1] = scan_id */
+};
+static const ProtobufCIntRange ctrl_msg__resp__scan_list_stream__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 2 }
+};
+const ProtobufCMessageDescriptor ctrl_msg__resp__scan_list_stream__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "CtrlMsg_Resp_ScanListStream",
+  "CtrlMsgRespScanListStream",
+  "CtrlMsgRespScanListStream",
+  "",
+  sizeof(CtrlMsgRespScanListStream),
+  2,
+  ctrl_msg__resp__scan_list_stream__field_descriptors,
+  ctrl_msg__resp__scan_list_stream__field_indices_by_name,
+  1,  ctrl_msg__resp__scan_list_stream__number_ranges,
+  (ProtobufCMessageInit) ctrl_msg__resp__scan_list_stream__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
 #define ctrl_msg__req__soft_apconnected_sta__field_descriptors NULL
 #define ctrl_msg__req__soft_apconnected_sta__field_indices_by_name NULL
 #define ctrl_msg__req__soft_apconnected_sta__number_ranges NULL
@@ -6191,6 +6505,109 @@ const ProtobufCMessageDescriptor ctrl_msg__event__set_dhcp_dns_status__descripto
   (ProtobufCMessageInit) ctrl_msg__event__set_dhcp_dns_status__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
+static const ProtobufCFieldDescriptor ctrl_msg__event__scan_result__field_descriptors[6] =
+{
+  {
+    "resp",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgEventScanResult, resp),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "scan_id",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgEventScanResult, scan_id),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "seq_num",
+    3,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgEventScanResult, seq_num),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "chnl",
+    4,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgEventScanResult, chnl),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "done",
+    5,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_BOOL,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgEventScanResult, done),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "entries",
+    6,
+    PROTOBUF_C_LABEL_REPEATED,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsgEventScanResult, n_entries),
+    offsetof(CtrlMsgEventScanResult, entries),
+    &scan_result__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned ctrl_msg__event__scan_result__field_indices_by_name[] = {
+  3,   /* field[3] = chnl */
+  4,   /* field[4] = done */
+  5,   /* field[5] = entries */
+  0,   /* field[0] = resp */
+  1,   /* field[1] = scan_id */
+  2,   /* field[2] = seq_num */
+};
+static const ProtobufCIntRange ctrl_msg__event__scan_result__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 6 }
+};
+const ProtobufCMessageDescriptor ctrl_msg__event__scan_result__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "CtrlMsg_Event_ScanResult",
+  "CtrlMsgEventScanResult",
+  "CtrlMsgEventScanResult",
+  "",
+  sizeof(CtrlMsgEventScanResult),
+  6,
+  ctrl_msg__event__scan_result__field_descriptors,
+  ctrl_msg__event__scan_result__field_indices_by_name,
+  1,  ctrl_msg__event__scan_result__number_ranges,
+  (ProtobufCMessageInit) ctrl_msg__event__scan_result__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
 static const ProtobufCFieldDescriptor ctrl_msg__req__custom_rpc_unserialised_msg__field_descriptors[2] =
 {
   {
@@ -6370,7 +6787,109 @@ const ProtobufCMessageDescriptor ctrl_msg__event__custom_rpc_unserialised_msg__d
   (ProtobufCMessageInit) ctrl_msg__event__custom_rpc_unserialised_msg__init,
   NULL,NULL,NULL    /* reserved[123] */
 };
-static const ProtobufCFieldDescriptor ctrl_msg__field_descriptors[68] =
+static const ProtobufCFieldDescriptor ctrl_msg__req__batch__field_descriptors[2] =
+{
+  {
+    "reqs",
+    1,
+    PROTOBUF_C_LABEL_REPEATED,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsgReqBatch, n_reqs),
+    offsetof(CtrlMsgReqBatch, reqs),
+    &ctrl_msg__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "stop_on_failure",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_BOOL,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgReqBatch, stop_on_failure),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned ctrl_msg__req__batch__field_indices_by_name[] = {
+  0,   /* field[0] = reqs */
+  1,   /* field[1] = stop_on_failure */
+};
+static const ProtobufCIntRange ctrl_msg__req__batch__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 2 }
+};
+const ProtobufCMessageDescriptor ctrl_msg__req__batch__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "CtrlMsg_Req_Batch",
+  "CtrlMsgReqBatch",
+  "CtrlMsgReqBatch",
+  "",
+  sizeof(CtrlMsgReqBatch),
+  2,
+  ctrl_msg__req__batch__field_descriptors,
+  ctrl_msg__req__batch__field_indices_by_name,
+  1,  ctrl_msg__req__batch__number_ranges,
+  (ProtobufCMessageInit) ctrl_msg__req__batch__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor ctrl_msg__resp__batch__field_descriptors[2] =
+{
+  {
+    "resp",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_INT32,
+    0,   /* quantifier_offset */
+    offsetof(CtrlMsgRespBatch, resp),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "resps",
+    2,
+    PROTOBUF_C_LABEL_REPEATED,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsgRespBatch, n_resps),
+    offsetof(CtrlMsgRespBatch, resps),
+    &ctrl_msg__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned ctrl_msg__resp__batch__field_indices_by_name[] = {
+  0,   /* field[0] = resp */
+  1,   /* field[1] = resps */
+};
+static const ProtobufCIntRange ctrl_msg__resp__batch__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 2 }
+};
+const ProtobufCMessageDescriptor ctrl_msg__resp__batch__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "CtrlMsg_Resp_Batch",
+  "CtrlMsgRespBatch",
+  "CtrlMsgRespBatch",
+  "",
+  sizeof(CtrlMsgRespBatch),
+  2,
+  ctrl_msg__resp__batch__field_descriptors,
+  ctrl_msg__resp__batch__field_indices_by_name,
+  1,  ctrl_msg__resp__batch__number_ranges,
+  (ProtobufCMessageInit) ctrl_msg__resp__batch__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor ctrl_msg__field_descriptors[73] =
 {
   {
     "msg_type",
@@ -6756,6 +7275,30 @@ static const ProtobufCFieldDescriptor ctrl_msg__field_descriptors[68] =
     0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
     0,NULL,NULL    /* reserved1,reserved2, etc */
   },
+  {
+    "req_scan_ap_list_stream",
+    129,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsg, payload_case),
+    offsetof(CtrlMsg, req_scan_ap_list_stream),
+    &ctrl_msg__req__scan_list_stream__descriptor,
+    NULL,
+    0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "req_batch",
+    130,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsg, payload_case),
+    offsetof(CtrlMsg, req_batch),
+    &ctrl_msg__req__batch__descriptor,
+    NULL,
+    0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
   {
     "resp_get_mac_address",
     201,
@@ -7092,6 +7635,30 @@ static const ProtobufCFieldDescriptor ctrl_msg__field_descriptors[68] =
     0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
     0,NULL,NULL    /* reserved1,reserved2, etc */
   },
+  {
+    "resp_scan_ap_list_stream",
+    229,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsg, payload_case),
+    offsetof(CtrlMsg, resp_scan_ap_list_stream),
+    &ctrl_msg__resp__scan_list_stream__descriptor,
+    NULL,
+    0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "resp_batch",
+    230,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsg, payload_case),
+    offsetof(CtrlMsg, resp_batch),
+    &ctrl_msg__resp__batch__descriptor,
+    NULL,
+    0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
   {
     "event_esp_init",
     301,
@@ -7188,18 +7755,32 @@ static const ProtobufCFieldDescriptor ctrl_msg__field_descriptors[68] =
     0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
     0,NULL,NULL    /* reserved1,reserved2, etc */
   },
+  {
+    "event_scan_result",
+    309,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(CtrlMsg, payload_case),
+    offsetof(CtrlMsg, event_scan_result),
+    &ctrl_msg__event__scan_result__descriptor,
+    NULL,
+    0 | PROTOBUF_C_FIELD_FLAG_ONEOF,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
 };
 static const unsigned ctrl_msg__field_indices_by_name[] = {
-  66,   /* field[66] = event_custom_rpc_unserialised_msg */
-  60,   /* field[60] = event_esp_init */
-  61,   /* field[61] = event_heartbeat */
-  67,   /* field[67] = event_set_dhcp_dns_status */
-  64,   /* field[64] = event_station_connected_to_AP */
-  65,   /* field[65] = event_station_connected_to_ESP_SoftAP */
-  62,   /* field[62] = event_station_disconnect_from_AP */
-  63,   /* field[63] = event_station_disconnect_from_ESP_SoftAP */
+  70,   /* field[70] = event_custom_rpc_unserialised_msg */
+  64,   /* field[64] = event_esp_init */
+  65,   /* field[65] = event_heartbeat */
+  72,   /* field[72] = event_scan_result */
+  71,   /* field[71] = event_set_dhcp_dns_status */
+  68,   /* field[68] = event_station_connected_to_AP */
+  69,   /* field[69] = event_station_connected_to_ESP_SoftAP */
+  66,   /* field[66] = event_station_disconnect_from_AP */
+  67,   /* field[67] = event_station_disconnect_from_ESP_SoftAP */
   1,   /* field[1] = msg_id */
   0,   /* field[0] = msg_type */
+  33,   /* field[33] = req_batch */
   24,   /* field[24] = req_config_heartbeat */
   10,   /* field[10] = req_connect_ap */
   29,   /* field[29] = req_custom_rpc_unserialised_msg */
@@ -7219,6 +7800,7 @@ static const unsigned ctrl_msg__field_indices_by_name[] = {
   20,   /* field[20] = req_ota_write */
   3,   /* field[3] = req_resp_type */
   8,   /* field[8] = req_scan_ap_list */
+  32,   /* field[32] = req_scan_ap_list_stream */
   27,   /* field[27] = req_set_country_code */
   30,   /* field[30] = req_set_dhcp_dns_status */
   5,   /* field[5] = req_set_mac_address */
@@ -7229,43 +7811,45 @@ static const unsigned ctrl_msg__field_indices_by_name[] = {
   15,   /* field[15] = req_softap_connected_stas_list */
   14,   /* field[14] = req_start_softap */
   16,   /* field[16] = req_stop_softap */
-  52,   /* field[52] = resp_config_heartbeat */
-  38,   /* field[38] = resp_connect_ap */
-  57,   /* field[57] = resp_custom_rpc_unserialised_msg */
-  39,   /* field[39] = resp_disconnect_ap */
-  53,   /* field[53] = resp_enable_disable_feat */
-  37,   /* field[37] = resp_get_ap_config */
-  56,   /* field[56] = resp_get_country_code */
-  59,   /* field[59] = resp_get_dhcp_dns_status */
-  54,   /* field[54] = resp_get_fw_version */
-  32,   /* field[32] = resp_get_mac_address */
-  46,   /* field[46] = resp_get_power_save_mode */
-  40,   /* field[40] = resp_get_softap_config */
-  51,   /* field[51] = resp_get_wifi_curr_tx_power */
-  34,   /* field[34] = resp_get_wifi_mode */
-  47,   /* field[47] = resp_ota_begin */
-  49,   /* field[49] = resp_ota_end */
-  48,   /* field[48] = resp_ota_write */
-  36,   /* field[36] = resp_scan_ap_list */
-  55,   /* field[55] = resp_set_country_code */
-  58,   /* field[58] = resp_set_dhcp_dns_status */
-  33,   /* field[33] = resp_set_mac_address */
-  45,   /* field[45] = resp_set_power_save_mode */
-  41,   /* field[41] = resp_set_softap_vendor_specific_ie */
-  50,   /* field[50] = resp_set_wifi_max_tx_power */
-  35,   /* field[35] = resp_set_wifi_mode */
-  43,   /* field[43] = resp_softap_connected_stas_list */
-  42,   /* field[42] = resp_start_softap */
-  44,   /* field[44] = resp_stop_softap */
+  63,   /* field[63] = resp_batch */
+  54,   /* field[54] = resp_config_heartbeat */
+  40,   /* field[40] = resp_connect_ap */
+  59,   /* field[59] = resp_custom_rpc_unserialised_msg */
+  41,   /* field[41] = resp_disconnect_ap */
+  55,   /* field[55] = resp_enable_disable_feat */
+  39,   /* field[39] = resp_get_ap_config */
+  58,   /* field[58] = resp_get_country_code */
+  61,   /* field[61] = resp_get_dhcp_dns_status */
+  56,   /* field[56] = resp_get_fw_version */
+  34,   /* field[34] = resp_get_mac_address */
+  48,   /* field[48] = resp_get_power_save_mode */
+  42,   /* field[42] = resp_get_softap_config */
+  53,   /* field[53] = resp_get_wifi_curr_tx_power */
+  36,   /* field[36] = resp_get_wifi_mode */
+  49,   /* field[49] = resp_ota_begin */
+  51,   /* field[51] = resp_ota_end */
+  50,   /* field[50] = resp_ota_write */
+  38,   /* field[38] = resp_scan_ap_list */
+  62,   /* field[62] = resp_scan_ap_list_stream */
+  57,   /* field[57] = resp_set_country_code */
+  60,   /* field[60] = resp_set_dhcp_dns_status */
+  35,   /* field[35] = resp_set_mac_address */
+  47,   /* field[47] = resp_set_power_save_mode */
+  43,   /* field[43] = resp_set_softap_vendor_specific_ie */
+  52,   /* field[52] = resp_set_wifi_max_tx_power */
+  37,   /* field[37] = resp_set_wifi_mode */
+  45,   /* field[45] = resp_softap_connected_stas_list */
+  44,   /* field[44] = resp_start_softap */
+  46,   /* field[46] = resp_stop_softap */
   2,   /* field[2] = uid */
 };
 static const ProtobufCIntRange ctrl_msg__number_ranges[4 + 1] =
 {
   { 1, 0 },
   { 101, 4 },
-  { 201, 32 },
-  { 301, 60 },
-  { 0, 68 }
+  { 201, 34 },
+  { 301, 64 },
+  { 0, 73 }
 };
 const ProtobufCMessageDescriptor ctrl_msg__descriptor =
 {
@@ -7275,7 +7859,7 @@ const ProtobufCMessageDescriptor ctrl_msg__descriptor =
   "CtrlMsg",
   "",
   sizeof(CtrlMsg),
-  68,
+  73,
   ctrl_msg__field_descriptors,
   ctrl_msg__field_indices_by_name,
   4,  ctrl_msg__number_ranges,
@@ -7548,7 +8132,7 @@ const ProtobufCEnumDescriptor ctrl_msg_type__descriptor =
   ctrl_msg_type__value_ranges,
   NULL,NULL,NULL,NULL   /* reserved[1234] */
 };
-static const ProtobufCEnumValue ctrl_msg_id__enum_values_by_number[71] =
+static const ProtobufCEnumValue ctrl_msg_id__enum_values_by_number[76] =
 {
   { "MsgId_Invalid", "CTRL_MSG_ID__MsgId_Invalid", 0 },
   { "Req_Base", "CTRL_MSG_ID__Req_Base", 100 },
@@ -7580,7 +8164,9 @@ static const ProtobufCEnumValue ctrl_msg_id__enum_values_by_number[71] =
   { "Req_Custom_RPC_Unserialised_Msg", "CTRL_MSG_ID__Req_Custom_RPC_Unserialised_Msg", 126 },
   { "Req_SetDhcpDnsStatus", "CTRL_MSG_ID__Req_SetDhcpDnsStatus", 127 },
   { "Req_GetDhcpDnsStatus", "CTRL_MSG_ID__Req_GetDhcpDnsStatus", 128 },
-  { "Req_Max", "CTRL_MSG_ID__Req_Max", 129 },
+  { "Req_GetAPScanListStream", "CTRL_MSG_ID__Req_GetAPScanListStream", 129 },
+  { "Req_Batch", "CTRL_MSG_ID__Req_Batch", 130 },
+  { "Req_Max", "CTRL_MSG_ID__Req_Max", 131 },
   { "Resp_Base", "CTRL_MSG_ID__Resp_Base", 200 },
   { "Resp_GetMACAddress", "CTRL_MSG_ID__Resp_GetMACAddress", 201 },
   { "Resp_SetMacAddress", "CTRL_MSG_ID__Resp_SetMacAddress", 202 },
@@ -7610,7 +8196,9 @@ static const ProtobufCEnumValue ctrl_msg_id__enum_values_by_number[71] =
   { "Resp_Custom_RPC_Unserialised_Msg", "CTRL_MSG_ID__Resp_Custom_RPC_Unserialised_Msg", 226 },
   { "Resp_SetDhcpDnsStatus", "CTRL_MSG_ID__Resp_SetDhcpDnsStatus", 227 },
   { "Resp_GetDhcpDnsStatus", "CTRL_MSG_ID__Resp_GetDhcpDnsStatus", 228 },
-  { "Resp_Max", "CTRL_MSG_ID__Resp_Max", 229 },
+  { "Resp_GetAPScanListStream", "CTRL_MSG_ID__Resp_GetAPScanListStream", 229 },
+  { "Resp_Batch", "CTRL_MSG_ID__Resp_Batch", 230 },
+  { "Resp_Max", "CTRL_MSG_ID__Resp_Max", 231 },
   { "Event_Base", "CTRL_MSG_ID__Event_Base", 300 },
   { "Event_ESPInit", "CTRL_MSG_ID__Event_ESPInit", 301 },
   { "Event_Heartbeat", "CTRL_MSG_ID__Event_Heartbeat", 302 },
@@ -7620,25 +8208,28 @@ static const ProtobufCEnumValue ctrl_msg_id__enum_values_by_number[71] =
   { "Event_StationConnectedToESPSoftAP", "CTRL_MSG_ID__Event_StationConnectedToESPSoftAP", 306 },
   { "Event_Custom_RPC_Unserialised_Msg", "CTRL_MSG_ID__Event_Custom_RPC_Unserialised_Msg", 307 },
   { "Event_SetDhcpDnsStatus", "CTRL_MSG_ID__Event_SetDhcpDnsStatus", 308 },
-  { "Event_Max", "CTRL_MSG_ID__Event_Max", 309 },
+  { "Event_ScanResult", "CTRL_MSG_ID__Event_ScanResult", 309 },
+  { "Event_Max", "CTRL_MSG_ID__Event_Max", 310 },
 };
 static const ProtobufCIntRange ctrl_msg_id__value_ranges[] = {
-{0, 0},{100, 1},{200, 31},{300, 61},{0, 71}
-};
-static const ProtobufCEnumValueIndex ctrl_msg_id__enum_values_by_name[71] =
-{
-  { "Event_Base", 61 },
-  { "Event_Custom_RPC_Unserialised_Msg", 68 },
-  { "Event_ESPInit", 62 },
-  { "Event_Heartbeat", 63 },
-  { "Event_Max", 70 },
-  { "Event_SetDhcpDnsStatus", 69 },
-  { "Event_StationConnectedToAP", 66 },
-  { "Event_StationConnectedToESPSoftAP", 67 },
-  { "Event_StationDisconnectFromAP", 64 },
-  { "Event_StationDisconnectFromESPSoftAP", 65 },
+{0, 0},{100, 1},{200, 33},{300, 65},{0, 76}
+};
+static const ProtobufCEnumValueIndex ctrl_msg_id__enum_values_by_name[76] =
+{
+  { "Event_Base", 65 },
+  { "Event_Custom_RPC_Unserialised_Msg", 72 },
+  { "Event_ESPInit", 66 },
+  { "Event_Heartbeat", 67 },
+  { "Event_Max", 75 },
+  { "Event_ScanResult", 74 },
+  { "Event_SetDhcpDnsStatus", 73 },
+  { "Event_StationConnectedToAP", 70 },
+  { "Event_StationConnectedToESPSoftAP", 71 },
+  { "Event_StationDisconnectFromAP", 68 },
+  { "Event_StationDisconnectFromESPSoftAP", 69 },
   { "MsgId_Invalid", 0 },
   { "Req_Base", 1 },
+  { "Req_Batch", 31 },
   { "Req_ConfigHeartbeat", 22 },
   { "Req_ConnectAP", 8 },
   { "Req_Custom_RPC_Unserialised_Msg", 27 },
@@ -7646,6 +8237,7 @@ static const ProtobufCEnumValueIndex ctrl_msg_id__enum_values_by_name[71] =
   { "Req_EnableDisable", 23 },
   { "Req_GetAPConfig", 7 },
   { "Req_GetAPScanList", 6 },
+  { "Req_GetAPScanListStream", 30 },
   { "Req_GetCountryCode", 26 },
   { "Req_GetDhcpDnsStatus", 29 },
   { "Req_GetFwVersion", 24 },
@@ -7655,7 +8247,7 @@ static const ProtobufCEnumValueIndex ctrl_msg_id__enum_values_by_name[71] =
   { "Req_GetSoftAPConnectedSTAList", 13 },
   { "Req_GetWifiCurrTxPower", 21 },
   { "Req_GetWifiMode", 4 },
-  { "Req_Max", 30 },
+  { "Req_Max", 32 },
   { "Req_OTABegin", 17 },
   { "Req_OTAEnd", 19 },
   { "Req_OTAWrite", 18 },
@@ -7668,36 +8260,38 @@ static const ProtobufCEnumValueIndex ctrl_msg_id__enum_values_by_name[71] =
   { "Req_SetWifiMode", 5 },
   { "Req_StartSoftAP", 12 },
   { "Req_StopSoftAP", 14 },
-  { "Resp_Base", 31 },
-  { "Resp_ConfigHeartbeat", 52 },
-  { "Resp_ConnectAP", 38 },
-  { "Resp_Custom_RPC_Unserialised_Msg", 57 },
-  { "Resp_DisconnectAP", 39 },
-  { "Resp_EnableDisable", 53 },
-  { "Resp_GetAPConfig", 37 },
-  { "Resp_GetAPScanList", 36 },
-  { "Resp_GetCountryCode", 56 },
-  { "Resp_GetDhcpDnsStatus", 59 },
-  { "Resp_GetFwVersion", 54 },
-  { "Resp_GetMACAddress", 32 },
-  { "Resp_GetPowerSaveMode", 46 },
-  { "Resp_GetSoftAPConfig", 40 },
-  { "Resp_GetSoftAPConnectedSTAList", 43 },
-  { "Resp_GetWifiCurrTxPower", 51 },
-  { "Resp_GetWifiMode", 34 },
-  { "Resp_Max", 60 },
-  { "Resp_OTABegin", 47 },
-  { "Resp_OTAEnd", 49 },
-  { "Resp_OTAWrite", 48 },
-  { "Resp_SetCountryCode", 55 },
-  { "Resp_SetDhcpDnsStatus", 58 },
-  { "Resp_SetMacAddress", 33 },
-  { "Resp_SetPowerSaveMode", 45 },
-  { "Resp_SetSoftAPVendorSpecificIE", 41 },
-  { "Resp_SetWifiMaxTxPower", 50 },
-  { "Resp_SetWifiMode", 35 },
-  { "Resp_StartSoftAP", 42 },
-  { "Resp_StopSoftAP", 44 },
+  { "Resp_Base", 33 },
+  { "Resp_Batch", 63 },
+  { "Resp_ConfigHeartbeat", 54 },
+  { "Resp_ConnectAP", 40 },
+  { "Resp_Custom_RPC_Unserialised_Msg", 59 },
+  { "Resp_DisconnectAP", 41 },
+  { "Resp_EnableDisable", 55 },
+  { "Resp_GetAPConfig", 39 },
+  { "Resp_GetAPScanList", 38 },
+  { "Resp_GetAPScanListStream", 62 },
+  { "Resp_GetCountryCode", 58 },
+  { "Resp_GetDhcpDnsStatus", 61 },
+  { "Resp_GetFwVersion", 56 },
+  { "Resp_GetMACAddress", 34 },
+  { "Resp_GetPowerSaveMode", 48 },
+  { "Resp_GetSoftAPConfig", 42 },
+  { "Resp_GetSoftAPConnectedSTAList", 45 },
+  { "Resp_GetWifiCurrTxPower", 53 },
+  { "Resp_GetWifiMode", 36 },
+  { "Resp_Max", 64 },
+  { "Resp_OTABegin", 49 },
+  { "Resp_OTAEnd", 51 },
+  { "Resp_OTAWrite", 50 },
+  { "Resp_SetCountryCode", 57 },
+  { "Resp_SetDhcpDnsStatus", 60 },
+  { "Resp_SetMacAddress", 35 },
+  { "Resp_SetPowerSaveMode", 47 },
+  { "Resp_SetSoftAPVendorSpecificIE", 43 },
+  { "Resp_SetWifiMaxTxPower", 52 },
+  { "Resp_SetWifiMode", 37 },
+  { "Resp_StartSoftAP", 44 },
+  { "Resp_StopSoftAP", 46 },
 };
 const ProtobufCEnumDescriptor ctrl_msg_id__descriptor =
 {
@@ -7706,9 +8300,9 @@ const ProtobufCEnumDescriptor ctrl_msg_id__descriptor =
   "CtrlMsgId",
   "CtrlMsgId",
   "",
-  71,
+  76,
   ctrl_msg_id__enum_values_by_number,
-  71,
+  76,
   ctrl_msg_id__enum_values_by_name,
   4,
   ctrl_msg_id__value_ranges,
@@ -17,11 +17,85 @@
 #define PRIO_Q_OTHERS                             2
 #define MAX_PRIORITY_QUEUES                       3
 
+/* WMM access categories in 802.11 ACI order. Wi-Fi data is split into one
+ * lane per AC inside PRIO_Q_OTHERS on both sides; on the host the AC is also
+ * the netdev TX queue. 0, best effort, takes everything unclassified. */
+enum ESP_AC {
+	ESP_AC_BE,
+	ESP_AC_BK,
+	ESP_AC_VI,
+	ESP_AC_VO,
+	ESP_NUM_AC,
+};
+
+/* 802.1d user priority of a 6-bit DSCP. Host and ESP both classify with
+ * this, following RFC 8325 (as cfg80211_classify8021d() does) and falling
+ * back to the class selector bits. */
+static inline uint8_t esp_dscp_to_up(uint8_t dscp)
+{
+	switch (dscp) {
+	case 8:				/* CS1 */
+		return 1;
+	case 10: case 12: case 14:	/* AF1x */
+	case 16:			/* CS2 */
+		return 0;
+	case 18: case 20: case 22:	/* AF2x */
+		return 3;
+	case 24:			/* CS3 */
+	case 26: case 28: case 30:	/* AF3x */
+	case 32:			/* CS4 */
+	case 34: case 36: case 38:	/* AF4x */
+		return 4;
+	case 40:			/* CS5 */
+		return 5;
+	case 44:			/* VOICE-ADMIT */
+	case 46:			/* EF */
+		return 6;
+	case 48:			/* CS6 */
+		return 7;
+	default:
+		return dscp >> 3;
+	}
+}
+
+/* Access category of an 802.1d user priority (0..7) */
+static inline uint8_t esp_up_to_ac(uint8_t up)
+{
+	switch (up & 7) {
+	case 1: case 2:
+		return ESP_AC_BK;
+	case 4: case 5:
+		return ESP_AC_VI;
+	case 6: case 7:
+		return ESP_AC_VO;
+	default:
+		return ESP_AC_BE;
+	}
+}
+
 /* ESP Payload Header Flags */
 #define MORE_FRAGMENT                             (1 << 0)
 #define FLAG_WAKEUP_PKT                           (1 << 1)
 #define FLAG_POWER_SAVE_STARTED                   (1 << 2)
 #define FLAG_POWER_SAVE_STOPPED                   (1 << 3)
+/* First fragment of a fragmented serial message. Payload starts with
+ * ESP_SERIAL_TOTAL_LEN_SIZE bytes (little endian) of total message length,
+ * so that receiver can size the reassembly buffer once.
+ * Only sent to a peer which announced ESP_SERIAL_CAP_TOTAL_LEN */
+#define FLAG_FRAG_TOTAL_LEN                       (1 << 4)
+/* Slave->host STA/AP frame whose TCP/UDP checksum the slave verified */
+#define FLAG_CSUM_VALID                           (1 << 5)
+/* Host->slave STA/AP frame with CHECKSUM_PARTIAL semantics: the TCP/UDP
+ * checksum field holds the pseudo-header sum, the slave completes it */
+#define FLAG_CSUM_PARTIAL                         (1 << 6)
+/* ESP_HCI_IF frame holding a run of struct esp_hci_batch_rec, see
+ * ESP_PRIV_HCI_BATCH */
+#define FLAG_HCI_BATCH                            (1 << 7)
+
+#define ESP_SERIAL_TOTAL_LEN_SIZE                 4
+/* Largest host->slave serial message. The slave reassembles up to this
+ * much when the host announces the length with FLAG_FRAG_TOTAL_LEN */
+#define ESP_SERIAL_MAX_TX                         (32 * 1024)
 
 /* Serial interface */
 #define SERIAL_IF_FILE                            "/dev/esps0"
@@ -98,7 +172,9 @@ typedef enum {
 
 typedef enum {
 	ESP_TEST_RAW_TP = (1 << 0),
-	ESP_TEST_RAW_TP__ESP_TO_HOST = (1 << 1)
+	ESP_TEST_RAW_TP__ESP_TO_HOST = (1 << 1),
+	ESP_TEST_RAW_TP__ECHO = (1 << 2),
+	ESP_TEST_RAW_TP__BIDIR = (1 << 3),
 } ESP_RAW_TP_MEASUREMENT;
 
 typedef enum {
@@ -108,14 +184,28 @@ typedef enum {
 
 typedef enum {
 	ESP_PRIV_EVENT_INIT,
+	/* Periodic struct esp_telemetry, see ESP_PRIV_CMD_TELEMETRY */
+	ESP_PRIV_EVENT_TELEMETRY,
 } ESP_PRIV_EVENT_TYPE;
 
 /* Host->slave private commands carried on ESP_PRIV_IF with priv_pkt_type
  * ESP_PACKET_TYPE_COMMAND (1-byte payload = the command code below).
- * raw_tp_mode: 1 = Host->ESP, 2 = ESP->Host. */
+ * raw_tp_mode: 1 = Host->ESP, 2 = ESP->Host, 4 = echo, 5 = both ways. */
 typedef enum {
 	ESP_PRIV_CMD_RAW_TP_HOST_TO_ESP = 1,
 	ESP_PRIV_CMD_RAW_TP_ESP_TO_HOST = 2,
+	/* Host accepts FLAG_FRAG_TOTAL_LEN on slave->host serial fragments */
+	ESP_PRIV_CMD_SERIAL_TOTAL_LEN = 3,
+	/* Slave sends every ESP_TEST_IF frame back unchanged (latency test) */
+	ESP_PRIV_CMD_RAW_TP_ECHO = 4,
+	/* Host->ESP and ESP->Host at the same time */
+	ESP_PRIV_CMD_RAW_TP_BIDIR = 5,
+	/* Followed by struct esp_priv_telemetry_cmd */
+	ESP_PRIV_CMD_TELEMETRY = 6,
+	/* Followed by one byte of ESP_CSUM_OFFLOAD_* the host wants */
+	ESP_PRIV_CMD_CSUM_OFFLOAD = 7,
+	/* Followed by struct esp_priv_hci_batch_cmd */
+	ESP_PRIV_CMD_HCI_BATCH = 8,
 } ESP_PRIV_COMMAND_TYPE;
 
 typedef enum {
@@ -126,8 +216,53 @@ typedef enum {
 	ESP_PRIV_FW_DATA,
 	ESP_PRIV_RX_BUF_CONFIG,
 	ESP_PRIV_CUSTOM_STR,
+	ESP_PRIV_SERIAL_CAPS,
+	ESP_PRIV_TELEMETRY,
+	ESP_PRIV_CSUM_OFFLOAD,
+	ESP_PRIV_HCI_BATCH,
 } ESP_PRIV_TAG_TYPE;
 
+/* ESP_PRIV_SERIAL_CAPS: serial interface features supported by slave */
+typedef enum {
+	ESP_SERIAL_CAP_TOTAL_LEN = (1 << 0),
+} ESP_SERIAL_CAPABILITIES;
+
+/* ESP_PRIV_CSUM_OFFLOAD: TCP/UDP checksum work the slave can take over.
+ * Only plain IPv4 (unfragmented) and IPv6 (no extension headers) frames
+ * qualify; anything else is left to the host. */
+typedef enum {
+	/* Verify E2H checksums, mark good frames FLAG_CSUM_VALID */
+	ESP_CSUM_OFFLOAD_RX = (1 << 0),
+	/* Complete checksums of H2E frames marked FLAG_CSUM_PARTIAL */
+	ESP_CSUM_OFFLOAD_TX = (1 << 1),
+} ESP_CSUM_OFFLOAD_CAPABILITIES;
+
+/* ESP_PRIV_HCI_BATCH: several HCI packets per ESP_HCI_IF frame.
+ * A FLAG_HCI_BATCH frame carries back to back records of at most
+ * ESP_HCI_BATCH_MAX_LEN bytes in total, each an esp_hci_batch_rec followed
+ * by the packet without its H4 type byte. Packets keep their HCI order. */
+typedef enum {
+	/* Slave takes batched frames from the host */
+	ESP_HCI_BATCH_H2E = (1 << 0),
+	/* Slave batches ACL/ISO data to the host once asked to */
+	ESP_HCI_BATCH_E2H = (1 << 1),
+} ESP_HCI_BATCH_CAPABILITIES;
+
+/* Fits an SPI transfer with the payload header */
+#define ESP_HCI_BATCH_MAX_LEN                     1536
+
+struct esp_hci_batch_rec {
+	uint16_t	len;            /* little endian, type byte excluded */
+	/* Last, so that type and packet read as one H4 frame */
+	uint8_t		pkt_type;
+} __attribute__((packed));
+
+struct esp_priv_hci_batch_cmd {
+	uint8_t		cmd;            /* ESP_PRIV_CMD_HCI_BATCH */
+	/* Longest a slave->host batch is held open; 0 stops batching */
+	uint16_t	flush_us;       /* little endian */
+} __attribute__((packed));
+
 /* ESP_PRIV_RX_BUF_CONFIG: the slave advertises its datapath buffer sizing in the
  * boot-up event so the host sizes its RX buffer accordingly (no hardcoded cap).
  * Per direction: e2h = slave->host, h2e = host->slave. Sizes are in 512-byte
@@ -155,6 +290,76 @@ struct esp_priv_event {
 	uint8_t		event_data[0];
 }__attribute__((packed));
 
+/* Slave health record, ESP_PRIV_EVENT_TELEMETRY event data.
+ *
+ * The slave advertises ESP_PRIV_TELEMETRY (1 byte: ESP_TELEMETRY_VERSION) in
+ * the boot-up event; the host then sets the report interval with
+ * ESP_PRIV_CMD_TELEMETRY. All fields are little endian. New fields are only
+ * appended, so a reader takes the first min(event_len, sizeof) bytes.
+ * Counters run from slave boot and wrap; the host works on differences. */
+#define ESP_TELEMETRY_VERSION           1
+#define ESP_TELEMETRY_QUEUES            3
+/* Bucket n counts E2H bus writes of 2^n .. 2^(n+1)-1 frames, the last
+ * bucket everything larger */
+#define ESP_TELEMETRY_AGGR_BUCKETS      8
+#define ESP_TELEMETRY_MAX_TASKS         8
+#define ESP_TELEMETRY_TASK_NAME_LEN     8
+
+struct esp_priv_telemetry_cmd {
+	uint8_t		cmd;            /* ESP_PRIV_CMD_TELEMETRY */
+	uint32_t	interval_ms;    /* 0 stops the reports */
+} __attribute__((packed));
+
+struct esp_telemetry_task {
+	/* NUL padded, not terminated when all 8 bytes are used */
+	char		name[ESP_TELEMETRY_TASK_NAME_LEN];
+	/* Share of the CPU time of all cores over the last interval */
+	uint8_t		cpu_pct;
+} __attribute__((packed));
+
+struct esp_telemetry {
+	uint8_t		version;
+	/* Valid entries in task[], busiest first; 0 without FreeRTOS run time stats */
+	uint8_t		nr_tasks;
+	/* 100 - idle share over the last interval, 0xFF if unknown */
+	uint8_t		cpu_load_pct;
+	uint8_t		reserved;
+	uint32_t	seq;
+	uint32_t	uptime_ms;
+	uint32_t	interval_ms;
+
+	/* Heap, bytes */
+	uint32_t	heap_free;
+	uint32_t	heap_min_free;  /* low-water mark since boot */
+	uint32_t	heap_largest;   /* largest free internal block */
+	uint32_t	dma_free;
+
+	/* To-host lanes (PRIO_Q_SERIAL, BT, OTHERS): depth now and peak since
+	 * the previous record */
+	uint16_t	to_host_q[ESP_TELEMETRY_QUEUES];
+	uint16_t	to_host_q_peak[ESP_TELEMETRY_QUEUES];
+
+	/* Datapath, 0 unless the firmware has ESP_PKT_STATS */
+	uint32_t	h2e_sta_out;    /* host frames handed to the Wi-Fi STA */
+	uint32_t	h2e_sta_fail;
+	uint32_t	h2e_ap_out;
+	uint32_t	h2e_ap_fail;
+	uint32_t	e2h_sta_in;     /* Wi-Fi STA frames towards the host */
+	uint32_t	wifi_tx_retries;
+	uint32_t	flowctrl_on;
+	uint32_t	flowctrl_off;
+	uint32_t	serial_rx;
+	uint32_t	serial_tx;
+
+	/* Transport */
+	uint32_t	h2e_rx_drop;    /* invalid or bad checksum host frames */
+	uint32_t	e2h_drop;       /* frames dropped before the bus */
+	uint32_t	e2h_tx_fail;    /* failed bus writes */
+	uint32_t	e2h_aggr[ESP_TELEMETRY_AGGR_BUCKETS];
+
+	struct esp_telemetry_task task[ESP_TELEMETRY_MAX_TASKS];
+} __attribute__((packed));
+
 struct fw_version {
 	char		project_name[3];
 	uint8_t		major1;
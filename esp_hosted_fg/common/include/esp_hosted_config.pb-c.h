@@ -37,6 +37,8 @@ typedef struct CtrlMsgReqStartSoftAP CtrlMsgReqStartSoftAP;
 typedef struct CtrlMsgRespStartSoftAP CtrlMsgRespStartSoftAP;
 typedef struct CtrlMsgReqScanResult CtrlMsgReqScanResult;
 typedef struct CtrlMsgRespScanResult CtrlMsgRespScanResult;
+typedef struct CtrlMsgReqScanListStream CtrlMsgReqScanListStream;
+typedef struct CtrlMsgRespScanListStream CtrlMsgRespScanListStream;
 typedef struct CtrlMsgReqSoftAPConnectedSTA CtrlMsgReqSoftAPConnectedSTA;
 typedef struct CtrlMsgRespSoftAPConnectedSTA CtrlMsgRespSoftAPConnectedSTA;
 typedef struct CtrlMsgReqOTABegin CtrlMsgReqOTABegin;
@@ -73,9 +75,12 @@ typedef struct CtrlMsgEventStationConnectedToAP CtrlMsgEventStationConnectedToAP
 typedef struct CtrlMsgEventStationDisconnectFromESPSoftAP CtrlMsgEventStationDisconnectFromESPSoftAP;
 typedef struct CtrlMsgEventStationConnectedToESPSoftAP CtrlMsgEventStationConnectedToESPSoftAP;
 typedef struct CtrlMsgEventSetDhcpDnsStatus CtrlMsgEventSetDhcpDnsStatus;
+typedef struct CtrlMsgEventScanResult CtrlMsgEventScanResult;
 typedef struct CtrlMsgReqCustomRpcUnserialisedMsg CtrlMsgReqCustomRpcUnserialisedMsg;
 typedef struct CtrlMsgRespCustomRpcUnserialisedMsg CtrlMsgRespCustomRpcUnserialisedMsg;
 typedef struct CtrlMsgEventCustomRpcUnserialisedMsg CtrlMsgEventCustomRpcUnserialisedMsg;
+typedef struct CtrlMsgReqBatch CtrlMsgReqBatch;
+typedef struct CtrlMsgRespBatch CtrlMsgRespBatch;
 typedef struct CtrlMsg CtrlMsg;
 
 
@@ -182,11 +187,13 @@ typedef enum _CtrlMsgId {
   CTRL_MSG_ID__Req_Custom_RPC_Unserialised_Msg = 126,
   CTRL_MSG_ID__Req_SetDhcpDnsStatus = 127,
   CTRL_MSG_ID__Req_GetDhcpDnsStatus = 128,
+  CTRL_MSG_ID__Req_GetAPScanListStream = 129,
+  CTRL_MSG_ID__Req_Batch = 130,
   /*
    * Add new control path command response before Req_Max
    * and update Req_Max 
    */
-  CTRL_MSG_ID__Req_Max = 129,
+  CTRL_MSG_ID__Req_Max = 131,
   /*
    ** Response Msgs *
    */
@@ -219,11 +226,13 @@ typedef enum _CtrlMsgId {
   CTRL_MSG_ID__Resp_Custom_RPC_Unserialised_Msg = 226,
   CTRL_MSG_ID__Resp_SetDhcpDnsStatus = 227,
   CTRL_MSG_ID__Resp_GetDhcpDnsStatus = 228,
+  CTRL_MSG_ID__Resp_GetAPScanListStream = 229,
+  CTRL_MSG_ID__Resp_Batch = 230,
   /*
    * Add new control path command response before Resp_Max
    * and update Resp_Max 
    */
-  CTRL_MSG_ID__Resp_Max = 229,
+  CTRL_MSG_ID__Resp_Max = 231,
   /*
    ** Event Msgs *
    */
@@ -236,11 +245,12 @@ typedef enum _CtrlMsgId {
   CTRL_MSG_ID__Event_StationConnectedToESPSoftAP = 306,
   CTRL_MSG_ID__Event_Custom_RPC_Unserialised_Msg = 307,
   CTRL_MSG_ID__Event_SetDhcpDnsStatus = 308,
+  CTRL_MSG_ID__Event_ScanResult = 309,
   /*
    * Add new control path command notification before Event_Max
    * and update Event_Max 
    */
-  CTRL_MSG_ID__Event_Max = 309
+  CTRL_MSG_ID__Event_Max = 310
     PROTOBUF_C__FORCE_ENUM_TO_BE_INT_SIZE(CTRL_MSG_ID)
 } CtrlMsgId;
 typedef enum _HostedFeature {
@@ -521,6 +531,31 @@ struct  CtrlMsgRespScanResult
     , 0, 0,NULL, 0 }
 
 
+/*
+ * Streamed scan: results are pushed as Event_ScanResult,
+ * one or more events per scanned channel 
+ */
+struct  CtrlMsgReqScanListStream
+{
+  ProtobufCMessage base;
+  uint32_t max_per_event;
+};
+#define CTRL_MSG__REQ__SCAN_LIST_STREAM__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&ctrl_msg__req__scan_list_stream__descriptor) \
+    , 0 }
+
+
+struct  CtrlMsgRespScanListStream
+{
+  ProtobufCMessage base;
+  int32_t resp;
+  uint32_t scan_id;
+};
+#define CTRL_MSG__RESP__SCAN_LIST_STREAM__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&ctrl_msg__resp__scan_list_stream__descriptor) \
+    , 0, 0 }
+
+
 struct  CtrlMsgReqSoftAPConnectedSTA
 {
   ProtobufCMessage base;
@@ -942,6 +977,22 @@ struct  CtrlMsgEventSetDhcpDnsStatus
     , 0, 0, 0, {0,NULL}, {0,NULL}, {0,NULL}, 0, {0,NULL}, 0, 0 }
 
 
+struct  CtrlMsgEventScanResult
+{
+  ProtobufCMessage base;
+  int32_t resp;
+  uint32_t scan_id;
+  uint32_t seq_num;
+  uint32_t chnl;
+  protobuf_c_boolean done;
+  size_t n_entries;
+  ScanResult **entries;
+};
+#define CTRL_MSG__EVENT__SCAN_RESULT__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&ctrl_msg__event__scan_result__descriptor) \
+    , 0, 0, 0, 0, 0, 0,NULL }
+
+
 /*
  * Add Custom RPC message structures after existing message structures to make it easily notice 
  */
@@ -980,6 +1031,34 @@ struct  CtrlMsgEventCustomRpcUnserialisedMsg
     , 0, 0, {0,NULL} }
 
 
+/*
+ * Batch: sub requests are executed in order in single round trip.
+ * resps carries one response per executed sub request 
+ */
+struct  CtrlMsgReqBatch
+{
+  ProtobufCMessage base;
+  size_t n_reqs;
+  CtrlMsg **reqs;
+  protobuf_c_boolean stop_on_failure;
+};
+#define CTRL_MSG__REQ__BATCH__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&ctrl_msg__req__batch__descriptor) \
+    , 0,NULL, 0 }
+
+
+struct  CtrlMsgRespBatch
+{
+  ProtobufCMessage base;
+  int32_t resp;
+  size_t n_resps;
+  CtrlMsg **resps;
+};
+#define CTRL_MSG__RESP__BATCH__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&ctrl_msg__resp__batch__descriptor) \
+    , 0, 0,NULL }
+
+
 typedef enum {
   CTRL_MSG__PAYLOAD__NOT_SET = 0,
   CTRL_MSG__PAYLOAD_REQ_GET_MAC_ADDRESS = 101,
@@ -1010,6 +1089,8 @@ typedef enum {
   CTRL_MSG__PAYLOAD_REQ_CUSTOM_RPC_UNSERIALISED_MSG = 126,
   CTRL_MSG__PAYLOAD_REQ_SET_DHCP_DNS_STATUS = 127,
   CTRL_MSG__PAYLOAD_REQ_GET_DHCP_DNS_STATUS = 128,
+  CTRL_MSG__PAYLOAD_REQ_SCAN_AP_LIST_STREAM = 129,
+  CTRL_MSG__PAYLOAD_REQ_BATCH = 130,
   CTRL_MSG__PAYLOAD_RESP_GET_MAC_ADDRESS = 201,
   CTRL_MSG__PAYLOAD_RESP_SET_MAC_ADDRESS = 202,
   CTRL_MSG__PAYLOAD_RESP_GET_WIFI_MODE = 203,
@@ -1038,6 +1119,8 @@ typedef enum {
   CTRL_MSG__PAYLOAD_RESP_CUSTOM_RPC_UNSERIALISED_MSG = 226,
   CTRL_MSG__PAYLOAD_RESP_SET_DHCP_DNS_STATUS = 227,
   CTRL_MSG__PAYLOAD_RESP_GET_DHCP_DNS_STATUS = 228,
+  CTRL_MSG__PAYLOAD_RESP_SCAN_AP_LIST_STREAM = 229,
+  CTRL_MSG__PAYLOAD_RESP_BATCH = 230,
   CTRL_MSG__PAYLOAD_EVENT_ESP_INIT = 301,
   CTRL_MSG__PAYLOAD_EVENT_HEARTBEAT = 302,
   CTRL_MSG__PAYLOAD_EVENT_STATION_DISCONNECT_FROM__AP = 303,
@@ -1045,7 +1128,8 @@ typedef enum {
   CTRL_MSG__PAYLOAD_EVENT_STATION_CONNECTED_TO__AP = 305,
   CTRL_MSG__PAYLOAD_EVENT_STATION_CONNECTED_TO__ESP__SOFT_AP = 306,
   CTRL_MSG__PAYLOAD_EVENT_CUSTOM_RPC_UNSERIALISED_MSG = 307,
-  CTRL_MSG__PAYLOAD_EVENT_SET_DHCP_DNS_STATUS = 308
+  CTRL_MSG__PAYLOAD_EVENT_SET_DHCP_DNS_STATUS = 308,
+  CTRL_MSG__PAYLOAD_EVENT_SCAN_RESULT = 309
     PROTOBUF_C__FORCE_ENUM_TO_BE_INT_SIZE(CTRL_MSG__PAYLOAD__CASE)
 } CtrlMsg__PayloadCase;
 
@@ -1101,6 +1185,8 @@ struct  CtrlMsg
     CtrlMsgReqCustomRpcUnserialisedMsg *req_custom_rpc_unserialised_msg;
     CtrlMsgReqSetDhcpDnsStatus *req_set_dhcp_dns_status;
     CtrlMsgReqGetDhcpDnsStatus *req_get_dhcp_dns_status;
+    CtrlMsgReqScanListStream *req_scan_ap_list_stream;
+    CtrlMsgReqBatch *req_batch;
     /*
      ** Responses *
      */
@@ -1132,6 +1218,8 @@ struct  CtrlMsg
     CtrlMsgRespCustomRpcUnserialisedMsg *resp_custom_rpc_unserialised_msg;
     CtrlMsgRespSetDhcpDnsStatus *resp_set_dhcp_dns_status;
     CtrlMsgRespGetDhcpDnsStatus *resp_get_dhcp_dns_status;
+    CtrlMsgRespScanListStream *resp_scan_ap_list_stream;
+    CtrlMsgRespBatch *resp_batch;
     /*
      ** Notifications *
      */
@@ -1143,6 +1231,7 @@ struct  CtrlMsg
     CtrlMsgEventStationConnectedToESPSoftAP *event_station_connected_to_esp_softap;
     CtrlMsgEventCustomRpcUnserialisedMsg *event_custom_rpc_unserialised_msg;
     CtrlMsgEventSetDhcpDnsStatus *event_set_dhcp_dns_status;
+    CtrlMsgEventScanResult *event_scan_result;
   };
 };
 #define CTRL_MSG__INIT \
@@ -1568,6 +1657,44 @@ CtrlMsgRespScanResult *
 void   ctrl_msg__resp__scan_result__free_unpacked
                      (CtrlMsgRespScanResult *message,
                       ProtobufCAllocator *allocator);
+/* CtrlMsgReqScanListStream methods */
+void   ctrl_msg__req__scan_list_stream__init
+                     (CtrlMsgReqScanListStream         *message);
+size_t ctrl_msg__req__scan_list_stream__get_packed_size
+                     (const CtrlMsgReqScanListStream   *message);
+size_t ctrl_msg__req__scan_list_stream__pack
+                     (const CtrlMsgReqScanListStream   *message,
+                      uint8_t             *out);
+size_t ctrl_msg__req__scan_list_stream__pack_to_buffer
+                     (const CtrlMsgReqScanListStream   *message,
+                      ProtobufCBuffer     *buffer);
+CtrlMsgReqScanListStream *
+       ctrl_msg__req__scan_list_stream__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   ctrl_msg__req__scan_list_stream__free_unpacked
+                     (CtrlMsgReqScanListStream *message,
+                      ProtobufCAllocator *allocator);
+/* CtrlMsgRespScanListStream methods */
+void   ctrl_msg__resp__scan_list_stream__init
+                     (CtrlMsgRespScanListStream         *message);
+size_t ctrl_msg__resp__scan_list_stream__get_packed_size
+                     (const CtrlMsgRespScanListStream   *message);
+size_t ctrl_msg__resp__scan_list_stream__pack
+                     (const CtrlMsgRespScanListStream   *message,
+                      uint8_t             *out);
+size_t ctrl_msg__resp__scan_list_stream__pack_to_buffer
+                     (const CtrlMsgRespScanListStream   *message,
+                      ProtobufCBuffer     *buffer);
+CtrlMsgRespScanListStream *
+       ctrl_msg__resp__scan_list_stream__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   ctrl_msg__resp__scan_list_stream__free_unpacked
+                     (CtrlMsgRespScanListStream *message,
+                      ProtobufCAllocator *allocator);
 /* CtrlMsgReqSoftAPConnectedSTA methods */
 void   ctrl_msg__req__soft_apconnected_sta__init
                      (CtrlMsgReqSoftAPConnectedSTA         *message);
@@ -2252,6 +2379,25 @@ CtrlMsgEventSetDhcpDnsStatus *
 void   ctrl_msg__event__set_dhcp_dns_status__free_unpacked
                      (CtrlMsgEventSetDhcpDnsStatus *message,
                       ProtobufCAllocator *allocator);
+/* CtrlMsgEventScanResult methods */
+void   ctrl_msg__event__scan_result__init
+                     (CtrlMsgEventScanResult         *message);
+size_t ctrl_msg__event__scan_result__get_packed_size
+                     (const CtrlMsgEventScanResult   *message);
+size_t ctrl_msg__event__scan_result__pack
+                     (const CtrlMsgEventScanResult   *message,
+                      uint8_t             *out);
+size_t ctrl_msg__event__scan_result__pack_to_buffer
+                     (const CtrlMsgEventScanResult   *message,
+                      ProtobufCBuffer     *buffer);
+CtrlMsgEventScanResult *
+       ctrl_msg__event__scan_result__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   ctrl_msg__event__scan_result__free_unpacked
+                     (CtrlMsgEventScanResult *message,
+                      ProtobufCAllocator *allocator);
 /* CtrlMsgReqCustomRpcUnserialisedMsg methods */
 void   ctrl_msg__req__custom_rpc_unserialised_msg__init
                      (CtrlMsgReqCustomRpcUnserialisedMsg         *message);
@@ -2309,6 +2455,44 @@ CtrlMsgEventCustomRpcUnserialisedMsg *
 void   ctrl_msg__event__custom_rpc_unserialised_msg__free_unpacked
                      (CtrlMsgEventCustomRpcUnserialisedMsg *message,
                       ProtobufCAllocator *allocator);
+/* CtrlMsgReqBatch methods */
+void   ctrl_msg__req__batch__init
+                     (CtrlMsgReqBatch         *message);
+size_t ctrl_msg__req__batch__get_packed_size
+                     (const CtrlMsgReqBatch   *message);
+size_t ctrl_msg__req__batch__pack
+                     (const CtrlMsgReqBatch   *message,
+                      uint8_t             *out);
+size_t ctrl_msg__req__batch__pack_to_buffer
+                     (const CtrlMsgReqBatch   *message,
+                      ProtobufCBuffer     *buffer);
+CtrlMsgReqBatch *
+       ctrl_msg__req__batch__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   ctrl_msg__req__batch__free_unpacked
+                     (CtrlMsgReqBatch *message,
+                      ProtobufCAllocator *allocator);
+/* CtrlMsgRespBatch methods */
+void   ctrl_msg__resp__batch__init
+                     (CtrlMsgRespBatch         *message);
+size_t ctrl_msg__resp__batch__get_packed_size
+                     (const CtrlMsgRespBatch   *message);
+size_t ctrl_msg__resp__batch__pack
+                     (const CtrlMsgRespBatch   *message,
+                      uint8_t             *out);
+size_t ctrl_msg__resp__batch__pack_to_buffer
+                     (const CtrlMsgRespBatch   *message,
+                      ProtobufCBuffer     *buffer);
+CtrlMsgRespBatch *
+       ctrl_msg__resp__batch__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   ctrl_msg__resp__batch__free_unpacked
+                     (CtrlMsgRespBatch *message,
+                      ProtobufCAllocator *allocator);
 /* CtrlMsg methods */
 void   ctrl_msg__init
                      (CtrlMsg         *message);
@@ -2396,6 +2580,12 @@ typedef void (*CtrlMsgReqScanResult_Closure)
 typedef void (*CtrlMsgRespScanResult_Closure)
                  (const CtrlMsgRespScanResult *message,
                   void *closure_data);
+typedef void (*CtrlMsgReqScanListStream_Closure)
+                 (const CtrlMsgReqScanListStream *message,
+                  void *closure_data);
+typedef void (*CtrlMsgRespScanListStream_Closure)
+                 (const CtrlMsgRespScanListStream *message,
+                  void *closure_data);
 typedef void (*CtrlMsgReqSoftAPConnectedSTA_Closure)
                  (const CtrlMsgReqSoftAPConnectedSTA *message,
                   void *closure_data);
@@ -2504,6 +2694,9 @@ typedef void (*CtrlMsgEventStationConnectedToESPSoftAP_Closure)
 typedef void (*CtrlMsgEventSetDhcpDnsStatus_Closure)
                  (const CtrlMsgEventSetDhcpDnsStatus *message,
                   void *closure_data);
+typedef void (*CtrlMsgEventScanResult_Closure)
+                 (const CtrlMsgEventScanResult *message,
+                  void *closure_data);
 typedef void (*CtrlMsgReqCustomRpcUnserialisedMsg_Closure)
                  (const CtrlMsgReqCustomRpcUnserialisedMsg *message,
                   void *closure_data);
@@ -2513,6 +2706,12 @@ typedef void (*CtrlMsgRespCustomRpcUnserialisedMsg_Closure)
 typedef void (*CtrlMsgEventCustomRpcUnserialisedMsg_Closure)
                  (const CtrlMsgEventCustomRpcUnserialisedMsg *message,
                   void *closure_data);
+typedef void (*CtrlMsgReqBatch_Closure)
+                 (const CtrlMsgReqBatch *message,
+                  void *closure_data);
+typedef void (*CtrlMsgRespBatch_Closure)
+                 (const CtrlMsgRespBatch *message,
+                  void *closure_data);
 typedef void (*CtrlMsg_Closure)
                  (const CtrlMsg *message,
                   void *closure_data);
@@ -2554,6 +2753,8 @@ extern const ProtobufCMessageDescriptor ctrl_msg__req__start_soft_ap__descriptor
 extern const ProtobufCMessageDescriptor ctrl_msg__resp__start_soft_ap__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__req__scan_result__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__resp__scan_result__descriptor;
+extern const ProtobufCMessageDescriptor ctrl_msg__req__scan_list_stream__descriptor;
+extern const ProtobufCMessageDescriptor ctrl_msg__resp__scan_list_stream__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__req__soft_apconnected_sta__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__resp__soft_apconnected_sta__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__req__otabegin__descriptor;
@@ -2590,9 +2791,12 @@ extern const ProtobufCMessageDescriptor ctrl_msg__event__station_connected_to_ap
 extern const ProtobufCMessageDescriptor ctrl_msg__event__station_disconnect_from_espsoft_ap__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__event__station_connected_to_espsoft_ap__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__event__set_dhcp_dns_status__descriptor;
+extern const ProtobufCMessageDescriptor ctrl_msg__event__scan_result__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__req__custom_rpc_unserialised_msg__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__resp__custom_rpc_unserialised_msg__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__event__custom_rpc_unserialised_msg__descriptor;
+extern const ProtobufCMessageDescriptor ctrl_msg__req__batch__descriptor;
+extern const ProtobufCMessageDescriptor ctrl_msg__resp__batch__descriptor;
 extern const ProtobufCMessageDescriptor ctrl_msg__descriptor;
 
 PROTOBUF_C__END_DECLS
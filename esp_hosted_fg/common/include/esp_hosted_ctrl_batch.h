@@ -0,0 +1,16 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR Apache-2.0
+ */
+
+/* Batch request limits shared between the host control library and the
+ * slave, so a batch the host accepts is never refused by the slave. */
+
+#ifndef __ESP_HOSTED_CTRL_BATCH_H__
+#define __ESP_HOSTED_CTRL_BATCH_H__
+
+/* Max sub requests in single batch request */
+#define CTRL_BATCH_MAX_REQS    16
+
+#endif /* __ESP_HOSTED_CTRL_BATCH_H__ */
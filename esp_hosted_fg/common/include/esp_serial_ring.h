@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+// SPDX-License-Identifier: GPL-2.0-only OR Apache-2.0
+
+/*
+ * Shared memory ring for the serial interface (/dev/esps0)
+ *
+ * Instead of read()/write() per control message, the user may ask the
+ * driver to expose a RX and a TX ring which are mmap()ed into the process.
+ *
+ *  mmap layout:
+ *  ----------------------------------------------------------------
+ *  | struct esp_serial_ring_hdr (one page) | RX data | TX data     |
+ *  ----------------------------------------------------------------
+ *  RX data starts at hdr->rx_off and TX data at hdr->tx_off.
+ *
+ *  RX ring: byte stream, same content as read() would return.
+ *           Producer is the driver (rx_head), consumer is the user (rx_tail).
+ *  TX ring: records of [u32 len | payload], each record 4 byte aligned.
+ *           Every record is sent exactly like a single write() call.
+ *           A record with len ESP_SERIAL_RING_PAD means 'skip to the ring start'.
+ *           Producer is the user (tx_head), consumer is the driver (tx_tail).
+ *
+ *  Indices are free running and wrapped with (size - 1), sizes are power of 2.
+ *  Producers publish data before the index (release), consumers read the
+ *  index before the data (acquire).
+ *
+ *  Notifications:
+ *  - RX: poll()/select() for POLLIN or an eventfd registered with
+ *    ESP_SERIAL_IOC_SET_EVENTFD. Both are only signalled when the driver
+ *    appends to the ring, so the user should drain until empty before sleeping.
+ *  - TX: after advancing tx_head, the user issues ESP_SERIAL_IOC_TX_KICK only if
+ *    tx_need_kick is set. The driver clears it while it is draining the ring.
+ *    With a mapped ring, POLLOUT is reported once the driver has drained it,
+ *    so a user finding the ring full kicks and then poll()s for POLLOUT.
+ *    If a record fails to send, the driver stops at it, bumps tx_errors and
+ *    reports POLLERR. The next kick retries it.
+ *
+ *  A record longer than ESP_SERIAL_MAX_TX is skipped by the driver; such
+ *  messages are sent with write(). A record whose length does not fit the
+ *  ring makes the driver drop everything pending.
+ */
+
+#ifndef __ESP_SERIAL_RING__H
+#define __ESP_SERIAL_RING__H
+
+#ifdef __KERNEL__
+  #include <linux/types.h>
+  #include <linux/ioctl.h>
+#else
+  #include <stdint.h>
+  #include <sys/ioctl.h>
+#endif
+
+/* ESP_SERIAL_MAX_TX */
+#include "adapter.h"
+
+#define ESP_SERIAL_RING_MAGIC         0x45535252 /* "ESRR" */
+#define ESP_SERIAL_RING_VERSION       1
+
+#define ESP_SERIAL_RING_MIN_SIZE      4096
+#define ESP_SERIAL_RING_MAX_SIZE      (1 << 20)
+#define ESP_SERIAL_RING_DEF_SIZE      (64 * 1024)
+
+#define ESP_SERIAL_RING_PAD           0xFFFFFFFF
+#define ESP_SERIAL_RING_ALIGN(x)      (((x) + 3) & ~3U)
+#define ESP_SERIAL_RING_REC_HDR_LEN   sizeof(uint32_t)
+
+struct esp_serial_ring_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t rx_size;
+	uint32_t tx_size;
+	uint32_t rx_off;
+	uint32_t tx_off;
+	uint32_t rx_dropped;        /* bytes dropped by driver: RX ring full */
+	uint32_t tx_need_kick;      /* written by driver */
+	uint32_t tx_errors;         /* records driver failed to send */
+
+	/* Keep producer and consumer indices on separate cache lines */
+	uint32_t rx_head __attribute__((aligned(64)));
+	uint32_t rx_tail __attribute__((aligned(64)));
+	uint32_t tx_head __attribute__((aligned(64)));
+	uint32_t tx_tail __attribute__((aligned(64)));
+};
+
+struct esp_serial_ring_cfg {
+	uint32_t rx_size;           /* in: power of 2, 0 for default */
+	uint32_t tx_size;           /* in: power of 2, 0 for default */
+	uint32_t map_size;          /* out: length to pass to mmap() */
+};
+
+#define ESP_SERIAL_IOC_MAGIC          'E'
+#define ESP_SERIAL_IOC_RING_ENABLE    _IOWR(ESP_SERIAL_IOC_MAGIC, 1, struct esp_serial_ring_cfg)
+#define ESP_SERIAL_IOC_SET_EVENTFD    _IOW(ESP_SERIAL_IOC_MAGIC, 2, int32_t)
+#define ESP_SERIAL_IOC_TX_KICK        _IO(ESP_SERIAL_IOC_MAGIC, 3)
+
+#endif
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+
+/* TCP/UDP checksums done on the ESP on behalf of the host.
+ *
+ * The Wi-Fi path has no checksum engine, so this is a software sum over
+ * each frame. It is worth it when the host CPU is the bottleneck, which is
+ * why it is a Kconfig option and the host has to ask for RX verification.
+ *
+ * E2H: frames that check out get FLAG_CSUM_VALID, the host marks them
+ *      CHECKSUM_UNNECESSARY. Bad or unparsed frames go up unmarked and
+ *      the host stack checks them as before.
+ * H2E: for FLAG_CSUM_PARTIAL frames the host stack already put the
+ *      pseudo-header sum in the checksum field (Linux CHECKSUM_PARTIAL),
+ *      so the slave only sums the L4 segment and stores the complement.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "adapter.h"
+#include "csum_offload.h"
+
+#if CSUM_OFFLOAD
+
+#define ETH_HDR_LEN            14
+#define ETH_TYPE_IPV4          0x0800
+#define ETH_TYPE_IPV6          0x86DD
+#define IPV4_HDR_MIN           20
+#define IPV6_HDR_LEN           40
+#define IP_PROTO_TCP           6
+#define IP_PROTO_UDP           17
+#define TCP_HDR_MIN            20
+#define TCP_CSUM_OFFSET        16
+#define UDP_HDR_LEN            8
+#define UDP_CSUM_OFFSET        6
+
+static const char TAG[] = "csum_offload";
+
+static uint8_t csum_offload_enabled;
+
+static uint32_t csum_add(uint32_t sum, const uint8_t *p, uint16_t len)
+{
+	while (len > 1) {
+		sum += ((uint32_t)p[0] << 8) | p[1];
+		p += 2;
+		len -= 2;
+	}
+	if (len)
+		sum += (uint32_t)p[0] << 8;
+
+	return sum;
+}
+
+static uint16_t csum_fold(uint32_t sum)
+{
+	while (sum >> 16)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+
+	return sum;
+}
+
+/* Locate the TCP/UDP header of a plain IPv4/IPv6 frame.
+ * Returns its offset in the frame, 0 if the frame does not qualify. */
+static uint16_t l4_locate(const uint8_t *frame, uint16_t len, uint8_t *proto,
+		uint16_t *l4_len, uint32_t *pseudo)
+{
+	const uint8_t *ip = frame + ETH_HDR_LEN;
+	uint16_t eth_type, ihl, tot_len;
+
+	if (len < ETH_HDR_LEN + IPV4_HDR_MIN)
+		return 0;
+
+	eth_type = (frame[12] << 8) | frame[13];
+
+	if (eth_type == ETH_TYPE_IPV4) {
+		if ((ip[0] >> 4) != 4)
+			return 0;
+		ihl = (ip[0] & 0x0F) * 4;
+		tot_len = (ip[2] << 8) | ip[3];
+		if (ihl < IPV4_HDR_MIN || tot_len < ihl || ETH_HDR_LEN + tot_len > len)
+			return 0;
+		/* More fragments or non-zero fragment offset */
+		if ((ip[6] & 0x3F) || ip[7])
+			return 0;
+		*proto = ip[9];
+		*l4_len = tot_len - ihl;
+		*pseudo = csum_add(0, ip + 12, 8) + *proto + *l4_len;
+		return ETH_HDR_LEN + ihl;
+	}
+
+	if (eth_type == ETH_TYPE_IPV6) {
+		if (len < ETH_HDR_LEN + IPV6_HDR_LEN || (ip[0] >> 4) != 6)
+			return 0;
+		*l4_len = (ip[4] << 8) | ip[5];
+		if (ETH_HDR_LEN + IPV6_HDR_LEN + *l4_len > len)
+			return 0;
+		/* Next header straight after the fixed header, no extensions */
+		*proto = ip[6];
+		*pseudo = csum_add(0, ip + 8, 32) + *proto + *l4_len;
+		return ETH_HDR_LEN + IPV6_HDR_LEN;
+	}
+
+	return 0;
+}
+
+/* Offset of the checksum field in the L4 header, 0 if not TCP/UDP */
+static uint16_t l4_csum_offset(uint8_t proto, uint16_t l4_len)
+{
+	if (proto == IP_PROTO_TCP && l4_len >= TCP_HDR_MIN)
+		return TCP_CSUM_OFFSET;
+	if (proto == IP_PROTO_UDP && l4_len >= UDP_HDR_LEN)
+		return UDP_CSUM_OFFSET;
+	return 0;
+}
+
+uint8_t csum_offload_caps(void)
+{
+	return ESP_CSUM_OFFLOAD_RX | ESP_CSUM_OFFLOAD_TX;
+}
+
+void csum_offload_process_cmd(const uint8_t *payload, uint16_t payload_len)
+{
+	if (payload_len < 2) {
+		ESP_LOGW(TAG, "Short csum offload command");
+		return;
+	}
+
+	csum_offload_enabled = payload[1] & csum_offload_caps();
+	ESP_LOGI(TAG, "Host checksum offload: rx %s, tx %s",
+			(csum_offload_enabled & ESP_CSUM_OFFLOAD_RX) ? "on" : "off",
+			(csum_offload_enabled & ESP_CSUM_OFFLOAD_TX) ? "on" : "off");
+}
+
+bool csum_offload_rx_verify(const uint8_t *frame, uint16_t len)
+{
+	uint16_t off, csum_off, l4_len;
+	uint32_t pseudo;
+	uint8_t proto;
+
+	if (!(csum_offload_enabled & ESP_CSUM_OFFLOAD_RX) || !frame)
+		return false;
+
+	off = l4_locate(frame, len, &proto, &l4_len, &pseudo);
+	if (!off)
+		return false;
+
+	csum_off = l4_csum_offset(proto, l4_len);
+	if (!csum_off)
+		return false;
+
+	/* UDP without checksum: nothing to vouch for */
+	if (proto == IP_PROTO_UDP &&
+	    !frame[off + csum_off] && !frame[off + csum_off + 1])
+		return false;
+
+	return csum_fold(csum_add(pseudo, frame + off, l4_len)) == 0xFFFF;
+}
+
+void csum_offload_tx_fill(uint8_t *frame, uint16_t len)
+{
+	uint16_t off, csum_off, l4_len, csum;
+	uint32_t pseudo;
+	uint8_t proto;
+
+	if (!frame)
+		return;
+
+	off = l4_locate(frame, len, &proto, &l4_len, &pseudo);
+	if (!off)
+		return;
+
+	csum_off = l4_csum_offset(proto, l4_len);
+	if (!csum_off)
+		return;
+
+	/* Pseudo-header sum is already in the checksum field */
+	csum = ~csum_fold(csum_add(0, frame + off, l4_len));
+	if (proto == IP_PROTO_UDP && !csum)
+		csum = 0xFFFF;
+
+	frame[off + csum_off] = csum >> 8;
+	frame[off + csum_off + 1] = csum & 0xFF;
+}
+
+#endif /* CSUM_OFFLOAD */
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+
+#ifndef __CSUM_OFFLOAD__H__
+#define __CSUM_OFFLOAD__H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_ESP_HOSTED_CSUM_OFFLOAD
+#define CSUM_OFFLOAD 1
+#else
+#define CSUM_OFFLOAD 0
+#endif
+
+#if CSUM_OFFLOAD
+/* ESP_CSUM_OFFLOAD_* for the boot-up event */
+uint8_t csum_offload_caps(void);
+/* ESP_PRIV_CMD_CSUM_OFFLOAD from host */
+void csum_offload_process_cmd(const uint8_t *payload, uint16_t payload_len);
+/* true: the TCP/UDP checksum of this Ethernet frame is good and the host
+ * asked for RX offload */
+bool csum_offload_rx_verify(const uint8_t *frame, uint16_t len);
+/* Complete the checksum of a FLAG_CSUM_PARTIAL Ethernet frame in place */
+void csum_offload_tx_fill(uint8_t *frame, uint16_t len);
+#else
+static inline uint8_t csum_offload_caps(void) { return 0; }
+static inline bool csum_offload_rx_verify(const uint8_t *frame, uint16_t len)
+{
+	return false;
+}
+static inline void csum_offload_tx_fill(uint8_t *frame, uint16_t len) { }
+#endif
+
+#endif
@@ -41,6 +41,7 @@
 #include "slave_control.h"
 #include "slave_bt.h"
 #include "stats.h"
+#include "csum_offload.h"
 #include "esp_fw_version.h"
 #include "esp_hosted_cli.h"
 #ifdef ESP_HOSTED_COPROCESSOR_EXAMPLE_HTTP_CLIENT
@@ -96,9 +97,13 @@ static struct rx_data {
 	uint8_t valid;
 	uint16_t cur_seq_no;
 	int len;
+	int size;               /* allocated, when total length was announced */
 	uint8_t *data;
 } r;
 
+/* Host accepts FLAG_FRAG_TOTAL_LEN, see ESP_PRIV_CMD_SERIAL_TOTAL_LEN */
+static uint8_t serial_total_len_to_host;
+
 /* Add at the top with other static variables */
 #if H_HOST_PS_ALLOWED
 #define MAX_DHCP_DNS_RETRIES 10
@@ -191,6 +196,8 @@ esp_err_t wlan_ap_rx_callback(void *buffer, uint16_t len, void *eb)
 	ESP_HEXLOGV("AP_Get", buffer, len, 32);
 
 	populate_wifi_buffer_handle(&buf_handle, ESP_AP_IF, buffer, len);
+	if (csum_offload_rx_verify(buffer, len))
+		buf_handle.flag |= FLAG_CSUM_VALID;
 
 	if (send_to_host_queue(&buf_handle, PRIO_Q_OTHERS))
 		goto DONE;
@@ -242,6 +249,8 @@ esp_err_t wlan_sta_rx_callback(void *buffer, uint16_t len, void *eb)
 			/* Send to Host */
 			ESP_LOGV(TAG, "host packet");
 			populate_wifi_buffer_handle(&buf_handle, ESP_STA_IF, buffer, len);
+			if (csum_offload_rx_verify(buffer, len))
+				buf_handle.flag |= FLAG_CSUM_VALID;
 
 			if (unlikely(send_to_host_queue(&buf_handle, PRIO_Q_OTHERS)))
 				goto DONE;
@@ -287,7 +296,8 @@ esp_err_t wlan_sta_rx_callback(void *buffer, uint16_t len, void *eb)
 			}
 
 			if (copy_buff) {
-				populate_buff_handle(&buf_handle, ESP_STA_IF, copy_buff, len, free, copy_buff, 0, 0, 0);
+				populate_buff_handle(&buf_handle, ESP_STA_IF, copy_buff, len, free, copy_buff,
+						csum_offload_rx_verify(copy_buff, len) ? FLAG_CSUM_VALID : 0, 0, 0);
 				if (unlikely(send_to_host_queue(&buf_handle, PRIO_Q_OTHERS))) {
 					free(copy_buff);
 					return ESP_OK;
@@ -358,6 +368,30 @@ static void process_serial_rx_pkt(uint8_t *buf)
 	if (!r.len) {
 		/* New Buffer */
 		r.cur_seq_no = le16toh(header->seq_num);
+
+		if (header->flags & FLAG_FRAG_TOTAL_LEN) {
+			/* Total length announced: allocate once */
+			if (payload_len < ESP_SERIAL_TOTAL_LEN_SIZE) {
+				ESP_LOGE(TAG, "serial rx: short first fragment %u", payload_len);
+				return;
+			}
+			r.size = payload[0] | (payload[1] << 8) |
+				(payload[2] << 16) | ((uint32_t)payload[3] << 24);
+			payload += ESP_SERIAL_TOTAL_LEN_SIZE;
+			payload_len -= ESP_SERIAL_TOTAL_LEN_SIZE;
+
+			if (r.size < payload_len || r.size > ESP_SERIAL_MAX_TX) {
+				ESP_LOGE(TAG, "serial rx: invalid total len %d, dropping", r.size);
+				r.size = 0;
+				return;
+			}
+			r.data = malloc(r.size);
+			if (!r.data) {
+				ESP_LOGE(TAG, "serial rx alloc failed (need %d bytes), dropping", r.size);
+				r.size = 0;
+				return;
+			}
+		}
 	}
 
 	if (header->seq_num != r.cur_seq_no) {
@@ -368,17 +402,30 @@ static void process_serial_rx_pkt(uint8_t *buf)
 		return;
 	}
 
-	new_data = realloc(r.data, r.len + payload_len);
-	if (!new_data) {
-		ESP_LOGE(TAG, "serial rx realloc failed (need %d bytes), dropping",
-			r.len + payload_len);
-		free(r.data);
-		r.data = NULL;
-		r.len = 0;
-		r.cur_seq_no = 0;
-		return;
+	if (r.size) {
+		if (r.len + payload_len > r.size) {
+			ESP_LOGE(TAG, "serial rx overflow: %d + %u > %d, dropping",
+				r.len, payload_len, r.size);
+			free(r.data);
+			r.data = NULL;
+			r.len = 0;
+			r.size = 0;
+			r.cur_seq_no = 0;
+			return;
+		}
+	} else {
+		new_data = realloc(r.data, r.len + payload_len);
+		if (!new_data) {
+			ESP_LOGE(TAG, "serial rx realloc failed (need %d bytes), dropping",
+				r.len + payload_len);
+			free(r.data);
+			r.data = NULL;
+			r.len = 0;
+			r.cur_seq_no = 0;
+			return;
+		}
+		r.data = new_data;
 	}
-	r.data = new_data;
 	memcpy(r.data + r.len, payload, payload_len);
 	r.len += payload_len;
 
@@ -414,6 +461,39 @@ static void process_priv_command(uint8_t *payload, uint16_t payload_len)
 	if (!payload || !payload_len)
 		return;
 
+	if (payload[0] == ESP_PRIV_CMD_SERIAL_TOTAL_LEN) {
+		ESP_LOGI(TAG, "Host accepts serial total length");
+		serial_total_len_to_host = 1;
+		return;
+	}
+
+	if (payload[0] == ESP_PRIV_CMD_CSUM_OFFLOAD) {
+#if CSUM_OFFLOAD
+		csum_offload_process_cmd(payload, payload_len);
+#else
+		ESP_LOGW(TAG, "Checksum offload not built in");
+#endif
+		return;
+	}
+
+	if (payload[0] == ESP_PRIV_CMD_HCI_BATCH) {
+#if HCI_BATCH
+		process_hci_batch_cmd(payload, payload_len);
+#else
+		ESP_LOGW(TAG, "HCI batching not built in");
+#endif
+		return;
+	}
+
+	if (payload[0] == ESP_PRIV_CMD_TELEMETRY) {
+#if ESP_TELEMETRY
+		process_telemetry_cmd(payload, payload_len);
+#else
+		ESP_LOGW(TAG, "Telemetry not built in");
+#endif
+		return;
+	}
+
 #if TEST_RAW_TP
 	process_raw_tp_cmd(payload[0]);
 #else
@@ -453,8 +533,14 @@ static void process_rx_pkt(interface_buffer_handle_t *buf_handle)
 	payload = buf_handle->payload + le16toh(header->offset);
 	payload_len = le16toh(header->len);
 
+	ESP_LOGV(TAG, "rx if=%u/%u seq=%u len=%u flags=0x%x",
+			header->if_type, header->if_num, le16toh(header->seq_num),
+			payload_len, header->flags);
 	ESP_HEXLOGV("bus_RX", payload, payload_len, 16);
 
+	if ((buf_handle->if_type == ESP_STA_IF || buf_handle->if_type == ESP_AP_IF) &&
+	    (header->flags & FLAG_CSUM_PARTIAL))
+		csum_offload_tx_fill(payload, payload_len);
 
 	if (buf_handle->if_type == ESP_STA_IF && station_connected) {
 		/* Forward data to wlan driver */
@@ -489,12 +575,17 @@ static void process_rx_pkt(interface_buffer_handle_t *buf_handle)
 	}
 #if defined(CONFIG_BT_ENABLED) && BLUETOOTH_HCI
 	else if (buf_handle->if_type == ESP_HCI_IF) {
-		process_hci_rx_pkt(payload, payload_len);
+#if HCI_BATCH
+		if (header->flags & FLAG_HCI_BATCH)
+			process_hci_rx_batch(payload, payload_len);
+		else
+#endif
+			process_hci_rx_pkt(payload, payload_len);
 	}
 #endif
 #if TEST_RAW_TP
 	else if (buf_handle->if_type == ESP_TEST_IF) {
-		debug_update_raw_tp_rx_count(payload_len);
+		debug_process_raw_tp_rx(payload, payload_len);
 	}
 #endif
 
@@ -541,6 +632,7 @@ static ssize_t serial_read_data(uint8_t *data, ssize_t len)
 		r.data = NULL;
 		r.valid = 0;
 		r.len = 0;
+		r.size = 0;
 		r.cur_seq_no = 0;
 	} else {
 		ESP_LOGI(TAG,"No data to be read, len %d", len);
@@ -548,6 +640,24 @@ static ssize_t serial_read_data(uint8_t *data, ssize_t len)
 	return len;
 }
 
+/* Number E2H frames the way the host numbers H2E ones (esp_stamp_tx_seq()):
+ * serial keeps its own fragment sequence and 0 is never handed out, so the
+ * seq logged here matches the host's esp_rx_frame trace of the same frame. */
+static void stamp_tx_seq(interface_buffer_handle_t *buf_handle)
+{
+	static portMUX_TYPE tx_seq_lock = portMUX_INITIALIZER_UNLOCKED;
+	static uint16_t tx_seq_num;
+
+	if (buf_handle->if_type == ESP_SERIAL_IF || buf_handle->seq_num)
+		return;
+
+	portENTER_CRITICAL(&tx_seq_lock);
+	if (!++tx_seq_num)
+		tx_seq_num = 1;
+	buf_handle->seq_num = tx_seq_num;
+	portEXIT_CRITICAL(&tx_seq_lock);
+}
+
 int send_to_host_queue(interface_buffer_handle_t *buf_handle, uint8_t queue_type)
 {
 	/* write() takes ownership of buf_handle and frees it, so return OK once it
@@ -555,6 +665,10 @@ int send_to_host_queue(interface_buffer_handle_t *buf_handle, uint8_t queue_type
 	 * queue_type is unused - the driver derives the lane from if_type. */
 	if (!if_context || !if_context->if_ops || !if_context->if_ops->write)
 		return ESP_FAIL;
+	stamp_tx_seq(buf_handle);
+	ESP_LOGV(TAG, "tx if=%u/%u seq=%u len=%u flags=0x%x",
+			buf_handle->if_type, buf_handle->if_num, buf_handle->seq_num,
+			buf_handle->payload_len, buf_handle->flag);
 	if_context->if_ops->write(if_handle, buf_handle);
 	return ESP_OK;
 }
@@ -565,6 +679,23 @@ static esp_err_t serial_write_data(uint8_t* data, ssize_t len)
 	int32_t left_len = len;
 	int32_t frag_len = 0;
 	static uint16_t seq_num = 0;
+	uint8_t *first_frag = NULL;
+
+	/* Announce total length in first fragment so that host allocates once.
+	 * First fragment is a separate buffer: [total len | data] */
+	if (serial_total_len_to_host && (len > ETH_DATA_LEN)) {
+		first_frag = malloc(ETH_DATA_LEN);
+		if (!first_frag) {
+			free(data);
+			return ESP_FAIL;
+		}
+		first_frag[0] = len & 0xFF;
+		first_frag[1] = (len >> 8) & 0xFF;
+		first_frag[2] = (len >> 16) & 0xFF;
+		first_frag[3] = (len >> 24) & 0xFF;
+		memcpy(first_frag + ESP_SERIAL_TOTAL_LEN_SIZE, data,
+				ETH_DATA_LEN - ESP_SERIAL_TOTAL_LEN_SIZE);
+	}
 
 	do {
 		interface_buffer_handle_t buf_handle = {0};
@@ -575,7 +706,15 @@ static esp_err_t serial_write_data(uint8_t* data, ssize_t len)
 		buf_handle.if_num = 0;
 		buf_handle.seq_num = seq_num;
 
-		if (left_len > ETH_DATA_LEN) {
+		if (first_frag) {
+			frag_len = ETH_DATA_LEN - ESP_SERIAL_TOTAL_LEN_SIZE;
+			buf_handle.flag = MORE_FRAGMENT | FLAG_FRAG_TOTAL_LEN;
+			buf_handle.payload = first_frag;
+			buf_handle.payload_len = ETH_DATA_LEN;
+			buf_handle.priv_buffer_handle = first_frag;
+			buf_handle.free_buf_handle = free;
+			first_frag = NULL;
+		} else if (left_len > ETH_DATA_LEN) {
 			frag_len = ETH_DATA_LEN;
 			buf_handle.flag = MORE_FRAGMENT;
 		} else {
@@ -585,10 +724,16 @@ static esp_err_t serial_write_data(uint8_t* data, ssize_t len)
 			buf_handle.free_buf_handle = free;
 		}
 
-		buf_handle.payload = pos;
-		buf_handle.payload_len = frag_len;
+		if (!buf_handle.payload) {
+			buf_handle.payload = pos;
+			buf_handle.payload_len = frag_len;
+		}
 
 		if (send_to_host_queue(&buf_handle, PRIO_Q_SERIAL)) {
+			if (buf_handle.priv_buffer_handle &&
+			    buf_handle.priv_buffer_handle != data) {
+				free(buf_handle.priv_buffer_handle);
+			}
 			if (data) {
 				free(data);
 				data = NULL;
@@ -107,6 +107,9 @@ typedef struct {
 interface_context_t * interface_insert_driver(int (*callback)(uint8_t val));
 int interface_remove_driver();
 void generate_startup_event(uint8_t cap);
+/* Transport part of the telemetry record: lane depths, drops, aggregation */
+struct esp_telemetry;
+void fill_transport_telemetry(struct esp_telemetry *t);
 int send_to_host_queue(interface_buffer_handle_t *buf_handle, uint8_t queue_type);
 
 void send_dhcp_dns_info_to_host(uint8_t network_up, uint8_t send_wifi_connected);
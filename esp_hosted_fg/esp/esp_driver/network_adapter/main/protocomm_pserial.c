@@ -38,9 +38,12 @@ static const char TAG[] = "protocomm_pserial";
 
 #define SIZE_OF_TYPE                  1
 #define SIZE_OF_LENGTH                2
+#define SIZE_OF_LENGTH_V2             4
 
 #define PROTO_PSER_TLV_T_EPNAME       1
 #define PROTO_PSER_TLV_T_DATA         2
+/* Data with 32 bit length, only used when length doesn't fit in 16 bits */
+#define PROTO_PSER_TLV_T_DATA_V2      3
 
 struct pserial_config {
 	pserial_xmit    xmit;
@@ -58,26 +61,42 @@ static esp_err_t parse_tlv(uint8_t **buf, size_t *total_len,
 		int *type, size_t *len, uint8_t **ptr)
 {
 	uint8_t *b = *buf;
-	uint16_t *out_len = NULL;
+	size_t len_size = SIZE_OF_LENGTH;
 
 	if (*total_len == 0) {
 		return ESP_FAIL;
 	}
 
 	*type = b[0];
-	out_len = (uint16_t *)(b + 1);
-	*len = *out_len;
-	*ptr = (uint8_t *) (b + 3);
+	if (*type == PROTO_PSER_TLV_T_DATA_V2) {
+		len_size = SIZE_OF_LENGTH_V2;
+	}
+	if (*total_len < SIZE_OF_TYPE + len_size) {
+		return ESP_FAIL;
+	}
+
+	if (len_size == SIZE_OF_LENGTH_V2) {
+		*len = b[1] | (b[2] << 8) | (b[3] << 16) | ((uint32_t)b[4] << 24);
+		/* same handling as 16 bit data */
+		*type = PROTO_PSER_TLV_T_DATA;
+	} else {
+		*len = b[1] | (b[2] << 8);
+	}
+	*ptr = (uint8_t *) (b + SIZE_OF_TYPE + len_size);
 	/*printf("*len %d \n", *len); */
-	*total_len -= (*len + 1 + 2);
-	*buf = b + 1 + 2 + (*len);
+	if (*total_len < SIZE_OF_TYPE + len_size + *len) {
+		return ESP_FAIL;
+	}
+	*total_len -= (*len + SIZE_OF_TYPE + len_size);
+	*buf = b + SIZE_OF_TYPE + len_size + (*len);
 	return ESP_OK;
 }
 
 static esp_err_t compose_tlv(char *epname, uint8_t **out, size_t *outlen)
 {
-	uint16_t len = 0;
+	uint32_t len = 0;
 	uint16_t ep_len = strlen(epname);
+	size_t len_size = (*outlen > 0xFFFF) ? SIZE_OF_LENGTH_V2 : SIZE_OF_LENGTH;
 	/*
 	 * TLV (Type - Length - Value) structure is as follows:
 	 * --------------------------------------------------------------------------------------------
@@ -86,11 +105,13 @@ static esp_err_t compose_tlv(char *epname, uint8_t **out, size_t *outlen)
 	 *
 	 *  Bytes used per field as follows:
 	 * --------------------------------------------------------------------------------------------
-	 *       1        |        2        | Endpoint length |     1     |      2      | Data length |
+	 *       1        |        2        | Endpoint length |     1     |    2 or 4   | Data length |
 	 * --------------------------------------------------------------------------------------------
+	 *  Data Length is 4 bytes with Data Type PROTO_PSER_TLV_T_DATA_V2, for data
+	 *  longer than 16 bits length. Older hosts keep getting 2 bytes otherwise.
 	 */
 	uint32_t buf_len = SIZE_OF_TYPE + SIZE_OF_LENGTH +
-		ep_len + SIZE_OF_TYPE + SIZE_OF_LENGTH + *outlen;
+		ep_len + SIZE_OF_TYPE + len_size + *outlen;
 	uint8_t *buf = (uint8_t *)calloc(1, buf_len);
 	if (buf == NULL) {
 		ESP_LOGE(TAG,"%s Mem Alloc Failed [%d]bytes", __func__, (int)buf_len);
@@ -104,12 +125,25 @@ static esp_err_t compose_tlv(char *epname, uint8_t **out, size_t *outlen)
 	len++;
 	memcpy(&buf[len], epname, strlen(epname));
 	len = len + strlen(epname) ;
-	buf[len] = PROTO_PSER_TLV_T_DATA;
-	len++;
-	buf[len] = (*outlen & 0xFF);
-	len++;
-	buf[len] = ((*outlen >> 8) & 0xFF);
-	len++;
+	if (len_size == SIZE_OF_LENGTH_V2) {
+		buf[len] = PROTO_PSER_TLV_T_DATA_V2;
+		len++;
+		buf[len] = (*outlen & 0xFF);
+		len++;
+		buf[len] = ((*outlen >> 8) & 0xFF);
+		len++;
+		buf[len] = ((*outlen >> 16) & 0xFF);
+		len++;
+		buf[len] = ((*outlen >> 24) & 0xFF);
+		len++;
+	} else {
+		buf[len] = PROTO_PSER_TLV_T_DATA;
+		len++;
+		buf[len] = (*outlen & 0xFF);
+		len++;
+		buf[len] = ((*outlen >> 8) & 0xFF);
+		len++;
+	}
 	buf_len = len + *outlen;
 	memcpy(&buf[len], (*out), *outlen);
 	free(*out);
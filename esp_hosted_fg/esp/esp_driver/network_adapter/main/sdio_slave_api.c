@@ -35,6 +35,9 @@
 #include "mempool.h"
 #include "endian.h"
 #include "stats.h"
+#include "csum_offload.h"
+#include "slave_bt.h"
+#include "wmm.h"
 #include "esp_fw_version.h"
 
 /* ===================== TX strategy (menuconfig) =====================
@@ -91,6 +94,10 @@
    * bus is the ceiling) and on C6/C61 (pool 64) lets this queue drain the whole
    * WiFi pool, starving AMPDU reorder. For more run-ahead raise the WiFi pool
    * (DYNAMIC_RX_BUFFER_NUM), not this. Memory win is SERIAL/BT=5, not OTHERS. */
+/* OTHERS is split per WMM access category: the 32 above is the BE lane, which
+ * also takes raw-TP and non-IP. VO/VI/BK stay shallower, the WiFi pool still
+ * bounds the total. */
+#define SDIO_Q_DEPTH_AC       16
 
 static const uint16_t to_host_q_depth[MAX_PRIORITY_QUEUES] = {
 	[PRIO_Q_SERIAL] = SDIO_Q_DEPTH_SERIAL,
@@ -133,6 +140,9 @@ static uint8_t *sdio_slave_rx_buffer[SDIO_RX_BUFFER_NUM];
 static QueueHandle_t to_host_queue[MAX_PRIORITY_QUEUES]; /* per-priority to-host queues
 	 * (PRIO_Q_SERIAL/BT/OTHERS) - serial/control gets its own lane, drained ahead
 	 * of bulk data so RPC responses aren't batched behind a data aggregate. */
+/* PRIO_Q_OTHERS per access category; [ESP_AC_BE] is to_host_queue[PRIO_Q_OTHERS] */
+static QueueHandle_t to_host_ac_queue[ESP_NUM_AC];
+static struct wmm_sched to_host_wmm;
 
 #if TX_MODE == TX_MODE_SW_AGGR
 static uint8_t *tx_aggr_buf;             /* one persistent DMA aggregate buffer */
@@ -145,6 +155,15 @@ static uint32_t stream_tx_acc;           /* bytes since last yield (idle-starvat
 #define STREAM_YIELD_BYTES (512u * 1024u) /* yield to idle every ~512KB -> feed 5s task WDT */
 #endif
 
+/* Always-on counters for the telemetry record */
+static struct {
+	uint32_t h2e_rx_drop;
+	uint32_t e2h_drop;
+	uint32_t e2h_tx_fail;
+	uint32_t e2h_aggr[ESP_TELEMETRY_AGGR_BUCKETS];
+	uint16_t q_peak[MAX_PRIORITY_QUEUES];
+} sdio_tel;
+
 #if SDIO_TX_DEBUG
 static uint32_t tx_seq;                  /* payload sequence number, for drop tracing */
 static uint64_t dbg_frames, dbg_aggs, dbg_bytes;
@@ -214,6 +233,21 @@ static inline uint16_t build_frame(uint8_t *dst, interface_buffer_handle_t *b)
 	return aligned;
 }
 
+static void count_e2h_write(uint16_t frames, bool ok)
+{
+	uint8_t b = 0;
+
+	if (!ok) {
+		sdio_tel.e2h_tx_fail++;
+		return;
+	}
+	while (frames >>= 1)
+		b++;
+	if (b >= ESP_TELEMETRY_AGGR_BUCKETS)
+		b = ESP_TELEMETRY_AGGR_BUCKETS - 1;
+	sdio_tel.e2h_aggr[b]++;
+}
+
 /* ===================== single send_task ===================== */
 #if TX_MODE == TX_MODE_SW_AGGR
 /* SW-aggregation TX path: a single send_task drains the to-host queue(s),
@@ -228,19 +262,20 @@ static inline uint16_t build_frame(uint8_t *dst, interface_buffer_handle_t *b)
  * SINGLE-CONSUMER INVARIANT: only send_task receives from these queues, so the
  * peek-then-receive below is safe (nobody else removes the front in between).
  * A second consumer would break it - rework before adding one. */
-static void process_tx_queue(QueueHandle_t q, uint16_t queued, uint8_t *aggr_buf)
+static uint16_t process_tx_queue(QueueHandle_t q, uint16_t queued, uint8_t *aggr_buf)
 {
 	interface_buffer_handle_t buf = {0};
 	uint16_t aggr_len = 0;
+	uint16_t aggr_frames = 0;
 	bool flush_after_pkt = false;
 
 	if (!queued)
-		return;
+		return 0;
 
 	if (!aggr_buf) {
 		if (xQueueReceive(q, &buf, portMAX_DELAY))
 			free_tx_buf(&buf);
-		return;
+		return 1;
 	}
 
 	while (queued || uxQueueMessagesWaiting(q)) {
@@ -266,6 +301,7 @@ static void process_tx_queue(QueueHandle_t q, uint16_t queued, uint8_t *aggr_buf
 			if (queued)
 				queued--;
 			free_tx_buf(&buf);
+			sdio_tel.e2h_drop++;
 			continue;
 		}
 
@@ -288,13 +324,23 @@ static void process_tx_queue(QueueHandle_t q, uint16_t queued, uint8_t *aggr_buf
 			queued--;
 
 		aggr_len += build_frame(aggr_buf + aggr_len, &buf);
+		aggr_frames++;
 		free_tx_buf(&buf);
 		if (flush_after_pkt)
 			break;
 	}
 
-	if (aggr_len && sdio_slave_transmit(aggr_buf, aggr_len) != ESP_OK)
+	if (!aggr_len)
+		return aggr_frames;
+
+	if (sdio_slave_transmit(aggr_buf, aggr_len) != ESP_OK) {
 		ESP_LOGE(TAG, "aggregate transmit failed");
+		count_e2h_write(aggr_frames, false);
+	} else {
+		count_e2h_write(aggr_frames, true);
+	}
+
+	return aggr_frames;
 }
 
 static void send_task(void *arg)
@@ -303,7 +349,7 @@ static void send_task(void *arg)
 		bool worked = false;
 
 		/* highest priority first: PRIO_Q_SERIAL(0) -> BT(1) -> OTHERS(2) */
-		for (int p = 0; p < MAX_PRIORITY_QUEUES; p++) {
+		for (int p = 0; p < PRIO_Q_OTHERS; p++) {
 			uint16_t waiting = uxQueueMessagesWaiting(to_host_queue[p]);
 
 			if (waiting) {
@@ -312,6 +358,16 @@ static void send_task(void *arg)
 			}
 		}
 
+		/* OTHERS: one aggregate from the access category whose turn it is */
+		int ac = wmm_sched_next(&to_host_wmm, to_host_ac_queue);
+		if (ac >= 0) {
+			QueueHandle_t q = to_host_ac_queue[ac];
+
+			wmm_sched_charge(&to_host_wmm, process_tx_queue(q,
+					uxQueueMessagesWaiting(q), tx_aggr_buf));
+			worked = true;
+		}
+
 		if (!worked)
 			vTaskDelay(1);
 	}
@@ -353,9 +409,10 @@ static void reclaim_finished(void)
 	}
 }
 
-static void process_tx_stream(QueueHandle_t q, uint16_t queued)
+static uint16_t process_tx_stream(QueueHandle_t q, uint16_t queued)
 {
 	interface_buffer_handle_t buf = {0};
+	uint16_t frames = 0;
 
 	while (queued--) {
 		uint16_t frame_len, aligned;
@@ -363,9 +420,11 @@ static void process_tx_stream(QueueHandle_t q, uint16_t queued)
 
 		if (!xQueueReceive(q, &buf, 0))
 			break;
+		frames++;
 		if (!datapath || !buf.payload || !buf.payload_len ||
 		    buf.payload_len + SDIO_HDR_SIZE > sdio_rx_buf_size) {
 			free_tx_buf(&buf);
+			sdio_tel.e2h_drop++;
 			continue;
 		}
 
@@ -387,6 +446,7 @@ static void process_tx_stream(QueueHandle_t q, uint16_t queued)
 		if (!sendbuf) {
 			xSemaphoreGive(tx_stream_sem);
 			free_tx_buf(&buf);
+			sdio_tel.e2h_drop++;
 			continue;
 		}
 		build_frame(sendbuf, &buf);     /* header+payload, zero-padded to aligned */
@@ -394,11 +454,15 @@ static void process_tx_stream(QueueHandle_t q, uint16_t queued)
 		if (sdio_slave_send_queue(sendbuf, aligned, sendbuf, portMAX_DELAY) != ESP_OK) {
 			hosted_mempool_free(buf_mp_tx_g, sendbuf);
 			xSemaphoreGive(tx_stream_sem);
+			count_e2h_write(1, false);
 		} else {
 			stream_tx_acc += aligned;
+			count_e2h_write(1, true);
 		}
 		reclaim_finished();
 	}
+
+	return frames;
 }
 
 static void send_task(void *arg)
@@ -407,7 +471,7 @@ static void send_task(void *arg)
 		bool worked = false;
 
 		/* highest priority first: PRIO_Q_SERIAL(0) -> BT(1) -> OTHERS(2) */
-		for (int p = 0; p < MAX_PRIORITY_QUEUES; p++) {
+		for (int p = 0; p < PRIO_Q_OTHERS; p++) {
 			uint16_t waiting = uxQueueMessagesWaiting(to_host_queue[p]);
 
 			if (waiting) {
@@ -416,6 +480,18 @@ static void send_task(void *arg)
 			}
 		}
 
+		/* OTHERS: at most one turn's worth from the scheduled access category */
+		int ac = wmm_sched_next(&to_host_wmm, to_host_ac_queue);
+		if (ac >= 0) {
+			uint16_t waiting = uxQueueMessagesWaiting(to_host_ac_queue[ac]);
+
+			if (waiting > to_host_wmm.credit)
+				waiting = to_host_wmm.credit;
+			wmm_sched_charge(&to_host_wmm,
+					process_tx_stream(to_host_ac_queue[ac], waiting));
+			worked = true;
+		}
+
 		reclaim_finished();
 		if (!worked) {
 			vTaskDelay(1);
@@ -435,6 +511,8 @@ static void send_task(void *arg)
  * the send_task frees it after packing. */
 static int32_t sdio_write(interface_handle_t *handle, interface_buffer_handle_t *buf_handle)
 {
+	QueueHandle_t q;
+	uint16_t depth;
 	uint8_t prio;
 
 	if (!buf_handle || !buf_handle->payload || !buf_handle->payload_len)
@@ -446,13 +524,60 @@ static int32_t sdio_write(interface_handle_t *handle, interface_buffer_handle_t
 	prio = (buf_handle->if_type == ESP_SERIAL_IF) ? PRIO_Q_SERIAL :
 	       (buf_handle->if_type == ESP_HCI_IF)    ? PRIO_Q_BT : PRIO_Q_OTHERS;
 
-	if (xQueueSend(to_host_queue[prio], buf_handle, portMAX_DELAY) != pdTRUE) {
+	q = to_host_queue[prio];
+	/* WiFi data is further split per access category */
+	if (buf_handle->if_type == ESP_STA_IF || buf_handle->if_type == ESP_AP_IF)
+		q = to_host_ac_queue[wmm_frame_ac(buf_handle->payload,
+						  buf_handle->payload_len)];
+
+	if (xQueueSend(q, buf_handle, portMAX_DELAY) != pdTRUE) {
 		free_tx_buf(buf_handle);
+		sdio_tel.e2h_drop++;
 		return ESP_FAIL;
 	}
+
+	depth = sdio_to_host_queue_depth(prio);
+	if (depth > sdio_tel.q_peak[prio])
+		sdio_tel.q_peak[prio] = depth;
+
 	return buf_handle->payload_len;
 }
 
+/* Frames waiting in one to-host lane, OTHERS across all its access
+ * categories. For stats only, racy by nature. */
+uint16_t sdio_to_host_queue_depth(uint8_t prio)
+{
+	uint16_t depth = 0;
+
+	if (prio >= MAX_PRIORITY_QUEUES || !to_host_queue[prio])
+		return 0;
+
+	if (prio != PRIO_Q_OTHERS)
+		return uxQueueMessagesWaiting(to_host_queue[prio]);
+
+	for (int ac = 0; ac < ESP_NUM_AC; ac++)
+		depth += uxQueueMessagesWaiting(to_host_ac_queue[ac]);
+
+	return depth;
+}
+
+void fill_transport_telemetry(struct esp_telemetry *t)
+{
+	int i;
+
+	for (i = 0; i < MAX_PRIORITY_QUEUES && i < ESP_TELEMETRY_QUEUES; i++) {
+		t->to_host_q[i] = htole16(sdio_to_host_queue_depth(i));
+		t->to_host_q_peak[i] = htole16(sdio_tel.q_peak[i]);
+		sdio_tel.q_peak[i] = 0;
+	}
+
+	t->h2e_rx_drop = htole32(sdio_tel.h2e_rx_drop);
+	t->e2h_drop = htole32(sdio_tel.e2h_drop);
+	t->e2h_tx_fail = htole32(sdio_tel.e2h_tx_fail);
+	for (i = 0; i < ESP_TELEMETRY_AGGR_BUCKETS; i++)
+		t->e2h_aggr[i] = htole32(sdio_tel.e2h_aggr[i]);
+}
+
 /* ===================== H2E receive (de-aggregating) ===================== */
 static int sdio_read(interface_handle_t *if_handle, interface_buffer_handle_t *buf_handle)
 {
@@ -494,6 +619,7 @@ static int sdio_read(interface_handle_t *if_handle, interface_buffer_handle_t *b
 	if (!len || offset < SDIO_HDR_SIZE || (uint32_t)blk_pos + frame_len > blk_total) {
 		ESP_LOGE(TAG, "Drop invalid rx frame: len=%u offset=%u pos=%u total=%u",
 				len, offset, blk_pos, blk_total);
+		sdio_tel.h2e_rx_drop++;
 		sdio_read_done(blk_handle);
 		blk_base = NULL; blk_handle = NULL; blk_total = 0; blk_pos = 0;
 		return ESP_FAIL;
@@ -505,6 +631,7 @@ static int sdio_read(interface_handle_t *if_handle, interface_buffer_handle_t *b
 	checksum = compute_checksum((uint8_t *)header, frame_len);
 	if (checksum != rx_checksum) {
 		ESP_LOGE(TAG, "sdio rx checksum mismatch, drop block");
+		sdio_tel.h2e_rx_drop++;
 		sdio_read_done(blk_handle);
 		blk_base = NULL; blk_handle = NULL; blk_total = 0; blk_pos = 0;
 		return ESP_FAIL;
@@ -602,6 +729,16 @@ void generate_startup_event(uint8_t cap)
 	*pos++ = ESP_PRIV_FIRMWARE_CHIP_ID;   *pos++ = LENGTH_1_BYTE; *pos++ = CONFIG_IDF_FIRMWARE_CHIP_ID; len += 3;
 	*pos++ = ESP_PRIV_CAPABILITY;         *pos++ = LENGTH_1_BYTE; *pos++ = cap;        len += 3;
 	*pos++ = ESP_PRIV_TEST_RAW_TP;        *pos++ = LENGTH_1_BYTE; *pos++ = raw_tp_cap; len += 3;
+	*pos++ = ESP_PRIV_SERIAL_CAPS;        *pos++ = LENGTH_1_BYTE; *pos++ = ESP_SERIAL_CAP_TOTAL_LEN; len += 3;
+	if (debug_get_telemetry_conf()) {
+		*pos++ = ESP_PRIV_TELEMETRY;  *pos++ = LENGTH_1_BYTE; *pos++ = debug_get_telemetry_conf(); len += 3;
+	}
+	if (csum_offload_caps()) {
+		*pos++ = ESP_PRIV_CSUM_OFFLOAD; *pos++ = LENGTH_1_BYTE; *pos++ = csum_offload_caps(); len += 3;
+	}
+	if (hci_batch_caps()) {
+		*pos++ = ESP_PRIV_HCI_BATCH; *pos++ = LENGTH_1_BYTE; *pos++ = hci_batch_caps(); len += 3;
+	}
 
 	pos = tlv_append_rx_buf_config(pos, &len);
 	pos = tlv_append_custom_str(pos, &len);
@@ -715,6 +852,15 @@ static interface_handle_t *sdio_init(void)
 		to_host_queue[p] = xQueueCreate(to_host_q_depth[p], sizeof(interface_buffer_handle_t));
 		assert(to_host_queue[p]);
 	}
+	for (int ac = 0; ac < ESP_NUM_AC; ac++) {
+		if (ac == ESP_AC_BE) {
+			to_host_ac_queue[ac] = to_host_queue[PRIO_Q_OTHERS];
+			continue;
+		}
+		to_host_ac_queue[ac] = xQueueCreate(SDIO_Q_DEPTH_AC, sizeof(interface_buffer_handle_t));
+		assert(to_host_ac_queue[ac]);
+	}
+	wmm_sched_init(&to_host_wmm);
 #if TX_MODE == TX_MODE_SW_AGGR
 	tx_aggr_buf = heap_caps_malloc(sdio_rx_buf_size, MALLOC_CAP_DMA);
 	assert(tx_aggr_buf);
@@ -22,4 +22,8 @@
     #error "SDIO is not supported for this target. Please use SPI"
 #endif
 
+#include <stdint.h>
+
+uint16_t sdio_to_host_queue_depth(uint8_t prio);
+
 #endif
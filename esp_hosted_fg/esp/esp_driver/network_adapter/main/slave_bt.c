@@ -27,6 +27,12 @@
 #include "esp_mac.h"
 
 #include "esp_idf_version.h"
+#include "endian.h"
+
+#if HCI_BATCH
+  #include "esp_timer.h"
+  #include "freertos/semphr.h"
+#endif
 
 #if BT_OVER_C3_S3
 
@@ -62,11 +68,185 @@ static void controller_rcv_pkt_ready(void)
 		xSemaphoreGive(vhci_send_sem);
 }
 
+#if HCI_BATCH
+/* Controller->host ACL/ISO packets are packed into one FLAG_HCI_BATCH frame
+ * once the host enables it with ESP_PRIV_CMD_HCI_BATCH. A batch goes out
+ * when full, hci_batch_flush_us after its first packet, or with the first
+ * packet of any other type, which joins it so HCI order is kept. */
+#define HCI_H4_ACL              0x02
+#define HCI_H4_ISO              0x05
+
+static SemaphoreHandle_t hci_batch_lock;
+static esp_timer_handle_t hci_batch_timer;
+static volatile uint16_t hci_batch_flush_us;
+static uint8_t *hci_batch_buf;
+static uint16_t hci_batch_len;
+
+static int hci_batch_flush_locked(void)
+{
+	interface_buffer_handle_t buf_handle;
+	uint8_t *buf = hci_batch_buf;
+
+	if (!buf)
+		return 0;
+
+	esp_timer_stop(hci_batch_timer);
+
+	memset(&buf_handle, 0, sizeof(buf_handle));
+
+	buf_handle.if_type = ESP_HCI_IF;
+	buf_handle.if_num = 0;
+	buf_handle.flag = FLAG_HCI_BATCH;
+	buf_handle.payload_len = hci_batch_len;
+	buf_handle.payload = buf;
+	buf_handle.wlan_buf_handle = buf;
+	buf_handle.free_buf_handle = free;
+
+	hci_batch_buf = NULL;
+	hci_batch_len = 0;
+
+	if (send_to_host_queue(&buf_handle, PRIO_Q_BT)) {
+		free(buf);
+		return ESP_FAIL;
+	}
+
+	return 0;
+}
+
+static void hci_batch_flush(void)
+{
+	xSemaphoreTake(hci_batch_lock, portMAX_DELAY);
+	hci_batch_flush_locked();
+	xSemaphoreGive(hci_batch_lock);
+}
+
+static void hci_batch_timer_cb(void *arg)
+{
+	hci_batch_flush();
+}
+
+/* @data is an H4 frame, type byte first */
+static int hci_batch_add(uint8_t *data, uint16_t len)
+{
+	struct esp_hci_batch_rec *rec;
+	uint16_t rec_len = sizeof(*rec) + len - 1;
+	bool first = false;
+	int ret = 0;
+
+	xSemaphoreTake(hci_batch_lock, portMAX_DELAY);
+
+	if (hci_batch_buf && hci_batch_len + rec_len > ESP_HCI_BATCH_MAX_LEN)
+		hci_batch_flush_locked();
+
+	if (!hci_batch_buf) {
+		hci_batch_buf = (uint8_t *) malloc(ESP_HCI_BATCH_MAX_LEN);
+		if (!hci_batch_buf) {
+			ESP_LOGE(TAG, "HCI batch: memory allocation failed");
+			xSemaphoreGive(hci_batch_lock);
+			return ESP_FAIL;
+		}
+		first = true;
+	}
+
+	rec = (struct esp_hci_batch_rec *) (hci_batch_buf + hci_batch_len);
+	rec->len = htole16(len - 1);
+	rec->pkt_type = data[0];
+	memcpy(rec + 1, data + 1, len - 1);
+	hci_batch_len += rec_len;
+
+	ESP_HEXLOGV("bt_tx batch", data, len, 32);
+
+	if ((data[0] != HCI_H4_ACL && data[0] != HCI_H4_ISO) ||
+	    hci_batch_len + sizeof(*rec) >= ESP_HCI_BATCH_MAX_LEN)
+		ret = hci_batch_flush_locked();
+	else if (first)
+		esp_timer_start_once(hci_batch_timer, hci_batch_flush_us);
+
+	xSemaphoreGive(hci_batch_lock);
+
+	return ret;
+}
+
+uint8_t hci_batch_caps(void)
+{
+	return ESP_HCI_BATCH_H2E | ESP_HCI_BATCH_E2H;
+}
+
+void process_hci_batch_cmd(const uint8_t *payload, uint16_t payload_len)
+{
+	const struct esp_priv_hci_batch_cmd *cmd;
+
+	if (payload_len < sizeof(*cmd) || !hci_batch_lock)
+		return;
+
+	cmd = (const struct esp_priv_hci_batch_cmd *) payload;
+	hci_batch_flush_us = le16toh(cmd->flush_us);
+
+	/* Whatever is pending goes out under the old setting */
+	if (!hci_batch_flush_us)
+		hci_batch_flush();
+
+	ESP_LOGI(TAG, "HCI batching to host %s, flush after %u us",
+			hci_batch_flush_us ? "on" : "off", hci_batch_flush_us);
+}
+
+static esp_err_t hci_batch_init(void)
+{
+	const esp_timer_create_args_t timer_args = {
+		.callback = hci_batch_timer_cb,
+		.name = "hci_batch",
+	};
+
+	if (hci_batch_lock)
+		return ESP_OK;
+
+	hci_batch_lock = xSemaphoreCreateMutex();
+	if (!hci_batch_lock)
+		return ESP_ERR_NO_MEM;
+
+	if (esp_timer_create(&timer_args, &hci_batch_timer) != ESP_OK) {
+		vSemaphoreDelete(hci_batch_lock);
+		hci_batch_lock = NULL;
+		return ESP_ERR_NO_MEM;
+	}
+
+	return ESP_OK;
+}
+
+static void hci_batch_deinit(void)
+{
+	if (!hci_batch_lock)
+		return;
+
+	hci_batch_flush_us = 0;
+	esp_timer_stop(hci_batch_timer);
+	esp_timer_delete(hci_batch_timer);
+	hci_batch_timer = NULL;
+
+	free(hci_batch_buf);
+	hci_batch_buf = NULL;
+	hci_batch_len = 0;
+
+	vSemaphoreDelete(hci_batch_lock);
+	hci_batch_lock = NULL;
+}
+#endif /* HCI_BATCH */
+
 static int host_rcv_pkt(uint8_t *data, uint16_t len)
 {
 	interface_buffer_handle_t buf_handle;
 	uint8_t *buf = NULL;
 
+#if HCI_BATCH
+	if (hci_batch_flush_us && len > 1 &&
+	    sizeof(struct esp_hci_batch_rec) + len - 1 <= ESP_HCI_BATCH_MAX_LEN)
+		return hci_batch_add(data, len);
+
+	/* Keep HCI order with anything still batched */
+	if (hci_batch_lock)
+		hci_batch_flush();
+#endif
+
 	buf = (uint8_t *) malloc(len);
 
 	if (!buf) {
@@ -100,6 +280,26 @@ static esp_vhci_host_callback_t vhci_host_cb = {
 	.notify_host_recv = host_rcv_pkt
 };
 
+/* @data is an H4 frame, type byte first */
+static void vhci_send_h4(uint8_t *data, uint16_t len)
+{
+	if (!esp_vhci_host_check_send_available()) {
+		ESP_LOGD(TAG, "VHCI not available");
+	}
+
+#if SOC_ESP_NIMBLE_CONTROLLER
+	esp_vhci_host_send_packet(data, len);
+#else
+	if (vhci_send_sem) {
+		if (xSemaphoreTake(vhci_send_sem, VHCI_MAX_TIMEOUT_MS) == pdTRUE) {
+			esp_vhci_host_send_packet(data, len);
+		} else {
+			ESP_LOGI(TAG, "VHCI sem timeout");
+		}
+	}
+#endif
+}
+
 void process_hci_rx_pkt(uint8_t *payload, uint16_t payload_len) {
 
 	if (!bt_running())
@@ -112,22 +312,38 @@ void process_hci_rx_pkt(uint8_t *payload, uint16_t payload_len) {
 	payload--;
 	payload_len++;
 
-	if (!esp_vhci_host_check_send_available()) {
-		ESP_LOGD(TAG, "VHCI not available");
-	}
+	vhci_send_h4(payload, payload_len);
+}
 
-#if SOC_ESP_NIMBLE_CONTROLLER
-	esp_vhci_host_send_packet(payload, payload_len);
-#else
-	if (vhci_send_sem) {
-		if (xSemaphoreTake(vhci_send_sem, VHCI_MAX_TIMEOUT_MS) == pdTRUE) {
-			esp_vhci_host_send_packet(payload, payload_len);
-		} else {
-			ESP_LOGI(TAG, "VHCI sem timeout");
+#if HCI_BATCH
+void process_hci_rx_batch(uint8_t *payload, uint16_t payload_len)
+{
+	struct esp_hci_batch_rec *rec;
+	uint16_t len;
+
+	if (!bt_running())
+		return;
+
+	while (payload_len >= sizeof(*rec)) {
+		rec = (struct esp_hci_batch_rec *) payload;
+		len = le16toh(rec->len);
+
+		if (!len || len > payload_len - sizeof(*rec)) {
+			ESP_LOGW(TAG, "HCI batch: bad record len %u, %u bytes left",
+					len, payload_len);
+			return;
 		}
+
+		ESP_HEXLOGV("bt_rx batch", &rec->pkt_type, len + 1, 32);
+
+		/* The type byte sits right before the packet, as VHCI wants */
+		vhci_send_h4(&rec->pkt_type, len + 1);
+
+		payload += sizeof(*rec) + len;
+		payload_len -= sizeof(*rec) + len;
 	}
-#endif
 }
+#endif /* HCI_BATCH */
 
 #elif BLUETOOTH_UART
 /* ***** UART specific part ***** */
@@ -549,6 +765,11 @@ esp_err_t initialise_bluetooth(void)
 	}
 
 	xSemaphoreGive(vhci_send_sem);
+
+#if HCI_BATCH
+	if (hci_batch_init() != ESP_OK)
+		ESP_LOGW(TAG, "HCI batching unavailable");
+#endif
 #endif /* BLUETOOTH_HCI */
 
 	return ESP_OK;
@@ -560,6 +781,9 @@ void deinitialize_bluetooth(void)
 		return;
 
 #if BLUETOOTH_HCI
+#if HCI_BATCH
+	hci_batch_deinit();
+#endif
 	if (vhci_send_sem) {
 		/* Dummy take and give sema before deleting it */
 		xSemaphoreTake(vhci_send_sem, portMAX_DELAY);
@@ -4,6 +4,8 @@
 #ifndef __SLAVE_BT_H__
 #define __SLAVE_BT_H__
 
+#include <stdint.h>
+#include "sdkconfig.h"
 #include "esp_err.h"
 
 // include only if BT component enabled and soc supports BT
@@ -111,6 +113,9 @@
 
 #elif BLUETOOTH_HCI
   void process_hci_rx_pkt(uint8_t *payload, uint16_t payload_len);
+  #ifdef CONFIG_ESP_HOSTED_HCI_BATCH
+    #define HCI_BATCH 1
+  #endif
 #endif
 
 void deinitialize_bluetooth(void);
@@ -119,4 +124,19 @@ uint8_t get_bluetooth_capabilities(void);
 
 #endif /* CONFIG_BT_ENABLED && CONFIG_SOC_BT_SUPPORTED */
 
+#ifndef HCI_BATCH
+#define HCI_BATCH 0
+#endif
+
+#if HCI_BATCH
+/* ESP_HCI_BATCH_* for the boot-up event */
+uint8_t hci_batch_caps(void);
+/* ESP_PRIV_CMD_HCI_BATCH from host */
+void process_hci_batch_cmd(const uint8_t *payload, uint16_t payload_len);
+/* FLAG_HCI_BATCH frame from host */
+void process_hci_rx_batch(uint8_t *payload, uint16_t payload_len);
+#else
+static inline uint8_t hci_batch_caps(void) { return 0; }
+#endif
+
 #endif /* __SLAVE_BT_H__ */
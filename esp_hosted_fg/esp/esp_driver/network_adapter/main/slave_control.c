@@ -24,6 +24,7 @@
 #include "slave_bt.h"
 #include "esp_fw_version.h"
 #include "esp_hosted_wifi_phy.h"
+#include "esp_hosted_ctrl_batch.h"
 #ifdef CONFIG_NETWORK_SPLIT_ENABLED
   #include "esp_check.h"
   #include "lwip/inet.h"
@@ -111,6 +112,43 @@ static wifi_event_sta_connected_t lkg_sta_connected_event = {0};
 uint16_t sta_connect_retry;
 
 static bool scan_done = false;
+
+/* Streamed scan: channels are scanned one at a time and results of
+ * every channel are pushed to host as Event_ScanResult, instead of
+ * collecting complete scan list in a single response */
+#define SCAN_STREAM_DEFAULT_AP_PER_EVENT  4
+#define SCAN_STREAM_MAX_AP_PER_EVENT      16
+#define SCAN_STREAM_MAX_CHANNELS          64
+
+typedef struct {
+	int32_t resp;
+	uint32_t scan_id;
+	uint32_t seq_num;
+	uint8_t chnl;
+	uint8_t done;
+	uint16_t count;
+	wifi_ap_record_t ap[];
+} scan_stream_event_t;
+
+static struct {
+	volatile bool active;
+	uint32_t scan_id;
+	uint32_t seq_num;
+	uint16_t max_per_event;
+	uint8_t ch_idx;
+	uint8_t n_chnls;
+	/* Channels whose scan completed */
+	uint8_t n_scanned;
+	uint8_t chnls[SCAN_STREAM_MAX_CHANNELS];
+} scan_stream;
+
+#if WIFI_DUALBAND_SUPPORT
+static const uint8_t scan_stream_5g_chnls[] = {
+	36, 40, 44, 48, 52, 56, 60, 64,
+	100, 104, 108, 112, 116, 120, 124, 128, 132, 136, 140, 144,
+	149, 153, 157, 161, 165, 169, 173, 177
+};
+#endif
 static esp_ota_handle_t handle;
 const esp_partition_t* update_partition = NULL;
 static int ota_msg = 0;
@@ -126,6 +164,8 @@ static void softap_event_register(void);
 static void softap_event_unregister(void);
 static void ap_scan_list_event_register(void);
 static void ap_scan_list_event_unregister(void);
+static void ap_scan_stream_event_handler(void* arg, esp_event_base_t event_base,
+		int32_t event_id, void* event_data);
 static esp_err_t convert_mac_to_bytes(uint8_t *out, char *s);
 static bool is_wifi_config_equal(const wifi_config_t *cfg1, const wifi_config_t *cfg2);
 
@@ -1669,45 +1709,19 @@ err:
 	return ESP_OK;
 }
 
-/* Function sends scanned list of available APs */
-static esp_err_t req_get_ap_scan_list_handler (CtrlMsg *req,
-		CtrlMsg *resp, void *priv_data)
+/* Station interface is needed for scan. SoftAP, if started, is kept running */
+static esp_err_t scan_prepare_wifi_mode(void)
 {
 	esp_err_t ret = ESP_OK;
 	wifi_mode_t mode = 0;
-	uint16_t ap_count = 0;
-	credentials_t credentials = {0};
-	wifi_ap_record_t *ap_info = NULL;
-	ScanResult **results = NULL;
-	CtrlMsgRespScanResult *resp_payload = NULL;
-	wifi_scan_config_t scanConf = {
-		.show_hidden = true
-	};
 #if WIFI_DUALBAND_SUPPORT
 	wifi_band_mode_t band_mode = 0; // 0 is currently an invalid value
 #endif
 
-	if (!req || !resp) {
-		ESP_LOGE(TAG, "Invalid parameters");
-		return ESP_FAIL;
-	}
-
-	resp_payload = (CtrlMsgRespScanResult *)
-		calloc(1,sizeof(CtrlMsgRespScanResult));
-	if (!resp_payload) {
-		ESP_LOGE(TAG,"Failed To allocate memory");
-		return ESP_ERR_NO_MEM;
-	}
-
-	ctrl_msg__resp__scan_result__init(resp_payload);
-	resp->payload_case = CTRL_MSG__PAYLOAD_RESP_SCAN_AP_LIST;
-	resp->resp_scan_ap_list = resp_payload;
-
-	ap_scan_list_event_register();
 	ret = esp_wifi_get_mode(&mode);
 	if (ret) {
 		ESP_LOGE(TAG,"Failed to get wifi mode");
-		goto err;
+		return ret;
 	}
 
 	if ((softap_started) &&
@@ -1735,6 +1749,51 @@ static esp_err_t req_get_ap_scan_list_handler (CtrlMsg *req,
 	}
 #endif
 
+	return ESP_OK;
+}
+
+/* Function sends scanned list of available APs */
+static esp_err_t req_get_ap_scan_list_handler (CtrlMsg *req,
+		CtrlMsg *resp, void *priv_data)
+{
+	esp_err_t ret = ESP_OK;
+	uint16_t ap_count = 0;
+	credentials_t credentials = {0};
+	wifi_ap_record_t *ap_info = NULL;
+	ScanResult **results = NULL;
+	CtrlMsgRespScanResult *resp_payload = NULL;
+	wifi_scan_config_t scanConf = {
+		.show_hidden = true
+	};
+
+	if (!req || !resp) {
+		ESP_LOGE(TAG, "Invalid parameters");
+		return ESP_FAIL;
+	}
+
+	resp_payload = (CtrlMsgRespScanResult *)
+		calloc(1,sizeof(CtrlMsgRespScanResult));
+	if (!resp_payload) {
+		ESP_LOGE(TAG,"Failed To allocate memory");
+		return ESP_ERR_NO_MEM;
+	}
+
+	ctrl_msg__resp__scan_result__init(resp_payload);
+	resp->payload_case = CTRL_MSG__PAYLOAD_RESP_SCAN_AP_LIST;
+	resp->resp_scan_ap_list = resp_payload;
+
+	if (scan_stream.active) {
+		ESP_LOGE(TAG, "Streamed scan in progress");
+		resp_payload->resp = FAILURE;
+		return ESP_OK;
+	}
+
+	ap_scan_list_event_register();
+	ret = scan_prepare_wifi_mode();
+	if (ret) {
+		goto err;
+	}
+
 	ret = esp_wifi_scan_start(&scanConf, true);
 	if (ret) {
 		ESP_LOGE(TAG,"Failed to start scan start command");
@@ -1847,6 +1906,204 @@ err:
 	return ESP_OK;
 }
 
+/* Build list of channels for streamed scan, as per current country config */
+static void scan_stream_build_chnl_list(void)
+{
+	wifi_country_t country = {0};
+	uint8_t n = 0;
+
+	if (esp_wifi_get_country(&country) || !country.nchan) {
+		country.schan = 1;
+		country.nchan = 13;
+	}
+
+	for (int i = 0; (i < country.nchan) && (n < SCAN_STREAM_MAX_CHANNELS); i++) {
+		scan_stream.chnls[n++] = country.schan + i;
+	}
+#if WIFI_DUALBAND_SUPPORT
+	for (int i = 0; (i < sizeof(scan_stream_5g_chnls)) && (n < SCAN_STREAM_MAX_CHANNELS); i++) {
+		scan_stream.chnls[n++] = scan_stream_5g_chnls[i];
+	}
+#endif
+	scan_stream.n_chnls = n;
+	scan_stream.ch_idx = 0;
+	scan_stream.n_scanned = 0;
+}
+
+/* Start scan on next channel of streamed scan, from scan_stream.ch_idx onwards.
+ * Channels not allowed in current configuration are skipped */
+static esp_err_t scan_stream_scan_next_chnl(void)
+{
+	wifi_scan_config_t scanConf = {
+		.show_hidden = true
+	};
+
+	for (; scan_stream.ch_idx < scan_stream.n_chnls; scan_stream.ch_idx++) {
+		scanConf.channel = scan_stream.chnls[scan_stream.ch_idx];
+		if (esp_wifi_scan_start(&scanConf, false) == ESP_OK) {
+			return ESP_OK;
+		}
+		ESP_LOGD(TAG, "Skip scan of channel %u", scanConf.channel);
+	}
+
+	return ESP_FAIL;
+}
+
+/* Send records of channel just scanned to host, max_per_event APs per event.
+ * Only records of single channel are held at any time */
+static void scan_stream_send_chnl_results(uint8_t chnl)
+{
+	uint16_t ap_count = 0;
+	uint16_t sent = 0;
+	wifi_ap_record_t *ap_info = NULL;
+	scan_stream_event_t *evt = NULL;
+
+	if (esp_wifi_scan_get_ap_num(&ap_count) || !ap_count) {
+		return;
+	}
+
+	ap_info = (wifi_ap_record_t *)calloc(ap_count, sizeof(wifi_ap_record_t));
+	evt = (scan_stream_event_t *)calloc(1, sizeof(scan_stream_event_t) +
+			scan_stream.max_per_event * sizeof(wifi_ap_record_t));
+	if (!ap_info || !evt) {
+		ESP_LOGE(TAG, "Failed to allocate memory for channel %u results", chnl);
+		goto err;
+	}
+
+	if (esp_wifi_scan_get_ap_records(&ap_count, ap_info)) {
+		ESP_LOGE(TAG, "Failed to get ap records of channel %u", chnl);
+		goto err;
+	}
+
+	while (sent < ap_count) {
+		evt->count = min(ap_count - sent, scan_stream.max_per_event);
+		evt->resp = SUCCESS;
+		evt->scan_id = scan_stream.scan_id;
+		evt->seq_num = scan_stream.seq_num++;
+		evt->chnl = chnl;
+		evt->done = 0;
+		memcpy(evt->ap, &ap_info[sent], evt->count * sizeof(wifi_ap_record_t));
+
+		send_event_data_to_host(CTRL_MSG_ID__Event_ScanResult, evt,
+				sizeof(scan_stream_event_t) + evt->count * sizeof(wifi_ap_record_t));
+		sent += evt->count;
+	}
+	ESP_LOGD(TAG, "Channel %u: %u APs streamed", chnl, ap_count);
+
+err:
+	mem_free(evt);
+	mem_free(ap_info);
+}
+
+/* Last event of streamed scan, with no entries and done set */
+static void scan_stream_finish(int32_t status)
+{
+	scan_stream_event_t evt = {0};
+
+	evt.resp = status;
+	evt.scan_id = scan_stream.scan_id;
+	evt.seq_num = scan_stream.seq_num++;
+	evt.done = 1;
+
+	esp_event_handler_unregister(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+			&ap_scan_stream_event_handler);
+	scan_stream.active = false;
+
+	send_event_data_to_host(CTRL_MSG_ID__Event_ScanResult, &evt, sizeof(evt));
+	ESP_LOGI(TAG, "Streamed scan [%" PRIu32 "] done", evt.scan_id);
+}
+
+/* event handler for streamed scan, invoked once per scanned channel */
+static void ap_scan_stream_event_handler(void *arg, esp_event_base_t event_base,
+		int32_t event_id, void *event_data)
+{
+	wifi_event_sta_scan_done_t *done_evt = event_data;
+
+	if ((event_base != WIFI_EVENT) || (event_id != WIFI_EVENT_SCAN_DONE) ||
+	    !scan_stream.active) {
+		return;
+	}
+
+	if (done_evt && done_evt->status) {
+		ESP_LOGW(TAG, "Scan of channel %u failed",
+				scan_stream.chnls[scan_stream.ch_idx]);
+	} else {
+		scan_stream_send_chnl_results(scan_stream.chnls[scan_stream.ch_idx]);
+		scan_stream.n_scanned++;
+	}
+
+	scan_stream.ch_idx++;
+	if (scan_stream_scan_next_chnl()) {
+		/* FAILURE if not a single channel could be scanned */
+		scan_stream_finish(scan_stream.n_scanned ? SUCCESS : FAILURE);
+	}
+}
+
+/* Function starts streamed scan of available APs.
+ * Response only carries scan_id. Scanned APs follow as Event_ScanResult,
+ * as and when each channel is scanned. Last event has done set */
+static esp_err_t req_get_ap_scan_list_stream_handler(CtrlMsg *req,
+		CtrlMsg *resp, void *priv_data)
+{
+	CtrlMsgRespScanListStream *resp_payload = NULL;
+	uint32_t max_per_event = 0;
+
+	if (!req || !resp || !req->req_scan_ap_list_stream) {
+		ESP_LOGE(TAG, "Invalid parameters");
+		return ESP_FAIL;
+	}
+
+	resp_payload = (CtrlMsgRespScanListStream *)
+		calloc(1,sizeof(CtrlMsgRespScanListStream));
+	if (!resp_payload) {
+		ESP_LOGE(TAG,"Failed To allocate memory");
+		return ESP_ERR_NO_MEM;
+	}
+
+	ctrl_msg__resp__scan_list_stream__init(resp_payload);
+	resp->payload_case = CTRL_MSG__PAYLOAD_RESP_SCAN_AP_LIST_STREAM;
+	resp->resp_scan_ap_list_stream = resp_payload;
+	resp_payload->resp = FAILURE;
+
+	if (scan_stream.active) {
+		ESP_LOGE(TAG, "Streamed scan already in progress");
+		return ESP_OK;
+	}
+
+	if (scan_prepare_wifi_mode()) {
+		return ESP_OK;
+	}
+
+	max_per_event = req->req_scan_ap_list_stream->max_per_event;
+	if (!max_per_event) {
+		max_per_event = SCAN_STREAM_DEFAULT_AP_PER_EVENT;
+	} else if (max_per_event > SCAN_STREAM_MAX_AP_PER_EVENT) {
+		max_per_event = SCAN_STREAM_MAX_AP_PER_EVENT;
+	}
+	scan_stream.max_per_event = max_per_event;
+	scan_stream.scan_id++;
+	scan_stream.seq_num = 0;
+	scan_stream_build_chnl_list();
+
+	ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT,
+				WIFI_EVENT_SCAN_DONE, &ap_scan_stream_event_handler, NULL));
+	scan_stream.active = true;
+
+	if (scan_stream_scan_next_chnl()) {
+		ESP_LOGE(TAG, "Failed to start streamed scan");
+		scan_stream.active = false;
+		esp_event_handler_unregister(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+				&ap_scan_stream_event_handler);
+		return ESP_OK;
+	}
+
+	ESP_LOGI(TAG, "Streamed scan [%" PRIu32 "] started on %u channels",
+			scan_stream.scan_id, scan_stream.n_chnls);
+	resp_payload->scan_id = scan_stream.scan_id;
+	resp_payload->resp = SUCCESS;
+	return ESP_OK;
+}
+
 /* Functions stops softap. */
 static esp_err_t req_stop_softap_handler (CtrlMsg *req,
 		CtrlMsg *resp, void *priv_data)
@@ -3072,6 +3329,121 @@ static esp_err_t req_custom_unserialised_rpc_msg_handler(CtrlMsg *req, CtrlMsg *
 	return ESP_OK;
 }
 
+static esp_err_t esp_ctrl_msg_command_dispatcher(CtrlMsg *req, CtrlMsg *resp,
+		void *priv_data);
+static void esp_ctrl_msg_cleanup(CtrlMsg *resp);
+
+/* Every response payload carries 'int32 resp' status. Payloads of
+ * oneof share same storage, so any member reaches the message */
+static int32_t get_ctrl_msg_resp_status(CtrlMsg *resp)
+{
+	const ProtobufCMessage *payload = NULL;
+	const ProtobufCFieldDescriptor *field = NULL;
+
+	payload = (const ProtobufCMessage *)resp->resp_get_mac_address;
+	if (!payload) {
+		return FAILURE;
+	}
+
+	field = protobuf_c_message_descriptor_get_field_by_name(
+			payload->descriptor, "resp");
+	if (!field || (field->type != PROTOBUF_C_TYPE_INT32)) {
+		return SUCCESS;
+	}
+
+	return *(const int32_t *)((const uint8_t *)payload + field->offset);
+}
+
+/* Batch request: sub requests are dispatched in order, as if each one
+ * was received separately. Response of every executed sub request is
+ * collected in single batch response */
+static esp_err_t req_batch_handler(CtrlMsg *req, CtrlMsg *resp, void *priv_data)
+{
+	CtrlMsgReqBatch *req_payload = NULL;
+	CtrlMsgRespBatch *resp_payload = NULL;
+	CtrlMsg *sub_req = NULL;
+	CtrlMsg *sub_resp = NULL;
+	uint32_t i = 0;
+
+	if (!req || !resp || !req->req_batch) {
+		ESP_LOGE(TAG, "Invalid parameters");
+		return ESP_FAIL;
+	}
+
+	req_payload = req->req_batch;
+	resp_payload = (CtrlMsgRespBatch *)calloc(1, sizeof(CtrlMsgRespBatch));
+	if (!resp_payload) {
+		ESP_LOGE(TAG, "Failed to allocate memory");
+		return ESP_ERR_NO_MEM;
+	}
+
+	ctrl_msg__resp__batch__init(resp_payload);
+	resp->payload_case = CTRL_MSG__PAYLOAD_RESP_BATCH;
+	resp->resp_batch = resp_payload;
+	resp_payload->resp = SUCCESS;
+
+	if (!req_payload->n_reqs) {
+		return ESP_OK;
+	}
+
+	if (req_payload->n_reqs > CTRL_BATCH_MAX_REQS) {
+		ESP_LOGE(TAG, "Batch of %u requests exceeds max %u",
+				(unsigned int)req_payload->n_reqs, CTRL_BATCH_MAX_REQS);
+		resp_payload->resp = FAILURE;
+		return ESP_OK;
+	}
+
+	resp_payload->resps = (CtrlMsg **)calloc(req_payload->n_reqs,
+			sizeof(CtrlMsg *));
+	if (!resp_payload->resps) {
+		ESP_LOGE(TAG, "Failed to allocate memory");
+		resp_payload->resp = FAILURE;
+		return ESP_OK;
+	}
+
+	for (i = 0; i < req_payload->n_reqs; i++) {
+		sub_req = req_payload->reqs[i];
+		if (!sub_req || (sub_req->msg_id == CTRL_MSG_ID__Req_Batch)) {
+			ESP_LOGE(TAG, "Invalid batch sub request [%" PRIu32 "]", i);
+			resp_payload->resp = FAILURE;
+			break;
+		}
+
+		sub_resp = (CtrlMsg *)calloc(1, sizeof(CtrlMsg));
+		if (!sub_resp) {
+			ESP_LOGE(TAG, "Failed to allocate memory");
+			resp_payload->resp = FAILURE;
+			break;
+		}
+
+		ctrl_msg__init(sub_resp);
+		sub_resp->msg_type = CTRL_MSG_TYPE__Resp;
+		sub_resp->msg_id = sub_req->msg_id - CTRL_MSG_ID__Req_Base +
+			CTRL_MSG_ID__Resp_Base;
+		sub_resp->uid = sub_req->uid;
+
+		if (esp_ctrl_msg_command_dispatcher(sub_req, sub_resp, priv_data)) {
+			ESP_LOGE(TAG, "Batch sub request [%" PRIu32 "] id[%u] failed",
+					i, sub_req->msg_id);
+			esp_ctrl_msg_cleanup(sub_resp);
+			mem_free(sub_resp);
+			resp_payload->resp = FAILURE;
+			break;
+		}
+
+		resp_payload->resps[resp_payload->n_resps++] = sub_resp;
+
+		if (req_payload->stop_on_failure &&
+		    (get_ctrl_msg_resp_status(sub_resp) != SUCCESS)) {
+			ESP_LOGI(TAG, "Batch stopped at sub request [%" PRIu32 "]", i);
+			resp_payload->resp = FAILURE;
+			break;
+		}
+	}
+
+	return ESP_OK;
+}
+
 static esp_ctrl_msg_req_t req_table[] = {
 	{
 		.req_num = CTRL_MSG_ID__Req_GetMACAddress ,
@@ -3185,6 +3557,14 @@ static esp_ctrl_msg_req_t req_table[] = {
 		.req_num = CTRL_MSG_ID__Req_Custom_RPC_Unserialised_Msg,
 		.command_handler = req_custom_unserialised_rpc_msg_handler
 	},
+	{
+		.req_num = CTRL_MSG_ID__Req_GetAPScanListStream,
+		.command_handler = req_get_ap_scan_list_stream_handler
+	},
+	{
+		.req_num = CTRL_MSG_ID__Req_Batch,
+		.command_handler = req_batch_handler
+	},
 };
 
 
@@ -3378,6 +3758,21 @@ static void esp_ctrl_msg_cleanup(CtrlMsg *resp)
 		} case (CTRL_MSG_ID__Event_ESPInit) : {
 			mem_free(resp->event_esp_init);
 			break;
+		} case (CTRL_MSG_ID__Resp_GetAPScanListStream) : {
+			mem_free(resp->resp_scan_ap_list_stream);
+			break;
+		} case (CTRL_MSG_ID__Resp_Batch) : {
+			if (resp->resp_batch) {
+				if (resp->resp_batch->resps) {
+					for (int i=0 ; i<resp->resp_batch->n_resps; i++) {
+						esp_ctrl_msg_cleanup(resp->resp_batch->resps[i]);
+						mem_free(resp->resp_batch->resps[i]);
+					}
+					mem_free(resp->resp_batch->resps);
+				}
+				mem_free(resp->resp_batch);
+			}
+			break;
 		} case (CTRL_MSG_ID__Event_Heartbeat) : {
 			mem_free(resp->event_heartbeat);
 			break;
@@ -3402,6 +3797,21 @@ static void esp_ctrl_msg_cleanup(CtrlMsg *resp)
 		} case (CTRL_MSG_ID__Event_SetDhcpDnsStatus) : {
 			mem_free(resp->event_set_dhcp_dns_status);
 			break;
+		} case (CTRL_MSG_ID__Event_ScanResult) : {
+			if (resp->event_scan_result) {
+				if (resp->event_scan_result->entries) {
+					for (int i=0 ; i<resp->event_scan_result->n_entries; i++) {
+						if (resp->event_scan_result->entries[i]) {
+							mem_free(resp->event_scan_result->entries[i]->ssid.data);
+							mem_free(resp->event_scan_result->entries[i]->bssid.data);
+							mem_free(resp->event_scan_result->entries[i]);
+						}
+					}
+					mem_free(resp->event_scan_result->entries);
+				}
+				mem_free(resp->event_scan_result);
+			}
+			break;
 		} case (CTRL_MSG_ID__Event_Custom_RPC_Unserialised_Msg): {
 			if (resp->event_custom_rpc_unserialised_msg) {
 				if (resp->event_custom_rpc_unserialised_msg->data.data) {
@@ -3779,6 +4189,79 @@ static esp_err_t ctrl_ntfy_SetDhcpDnsStatus(CtrlMsg *ntfy,
 	return ESP_OK;
 }
 
+static esp_err_t ctrl_ntfy_ScanResult(CtrlMsg *ntfy,
+		const uint8_t *data, ssize_t len)
+{
+	scan_stream_event_t *evt = (scan_stream_event_t *) data;
+	CtrlMsgEventScanResult *ntfy_payload = NULL;
+	ScanResult *entry = NULL;
+	char bssid_l[BSSID_LENGTH] = {0};
+
+	if (!evt || (len < sizeof(scan_stream_event_t)) ||
+	    (len < sizeof(scan_stream_event_t) + evt->count * sizeof(wifi_ap_record_t))) {
+		ESP_LOGE(TAG, "%s: Invalid event data", __func__);
+		return ESP_FAIL;
+	}
+
+	ntfy_payload = (CtrlMsgEventScanResult*)
+		calloc(1,sizeof(CtrlMsgEventScanResult));
+	if (!ntfy_payload) {
+		ESP_LOGE(TAG,"%s allocate [%u] bytes failed", __func__, sizeof(CtrlMsgEventScanResult));
+		return ESP_ERR_NO_MEM;
+	}
+	ctrl_msg__event__scan_result__init(ntfy_payload);
+
+	ntfy->payload_case = CTRL_MSG__PAYLOAD_EVENT_SCAN_RESULT;
+	ntfy->event_scan_result = ntfy_payload;
+
+	ntfy_payload->resp = evt->resp;
+	ntfy_payload->scan_id = evt->scan_id;
+	ntfy_payload->seq_num = evt->seq_num;
+	ntfy_payload->chnl = evt->chnl;
+	ntfy_payload->done = evt->done;
+
+	if (!evt->count) {
+		return ESP_OK;
+	}
+
+	ntfy_payload->entries = (ScanResult **)calloc(evt->count, sizeof(ScanResult *));
+	if (!ntfy_payload->entries) {
+		goto err;
+	}
+
+	for (int i = 0; i < evt->count; i++) {
+		entry = (ScanResult *)calloc(1, sizeof(ScanResult));
+		if (!entry) {
+			goto err;
+		}
+		scan_result__init(entry);
+		ntfy_payload->entries[i] = entry;
+		ntfy_payload->n_entries++;
+
+		entry->ssid.len = strnlen((char *)evt->ap[i].ssid, SSID_LENGTH);
+		entry->ssid.data = (uint8_t *)strndup((char *)evt->ap[i].ssid,
+				SSID_LENGTH);
+
+		snprintf(bssid_l, BSSID_LENGTH, MACSTR, MAC2STR(evt->ap[i].bssid));
+		entry->bssid.len = strnlen(bssid_l, BSSID_LENGTH);
+		entry->bssid.data = (uint8_t *)strndup(bssid_l, BSSID_LENGTH);
+
+		if (!entry->ssid.data || !entry->bssid.data) {
+			goto err;
+		}
+
+		entry->chnl = evt->ap[i].primary;
+		entry->rssi = evt->ap[i].rssi;
+		entry->sec_prot = evt->ap[i].authmode;
+	}
+
+	return ESP_OK;
+
+err:
+	ESP_LOGE(TAG, "%s: mem allocate failed", __func__);
+	return ESP_ERR_NO_MEM;
+}
+
 static esp_err_t ctrl_ntfy_Custom_RPC_Unserialised_Msg(CtrlMsg *ntfy, const uint8_t *data, ssize_t struct_size)
 {
 	if (!data || struct_size <= 0) {
@@ -3876,6 +4359,9 @@ esp_err_t ctrl_notify_handler(uint32_t session_id,const uint8_t *inbuf,
 		} case (CTRL_MSG_ID__Event_Custom_RPC_Unserialised_Msg): {
 			ret = ctrl_ntfy_Custom_RPC_Unserialised_Msg(&ntfy, inbuf, inlen);
 			break;
+		} case (CTRL_MSG_ID__Event_ScanResult): {
+			ret = ctrl_ntfy_ScanResult(&ntfy, inbuf, inlen);
+			break;
 		} default: {
 			ESP_LOGE(TAG, "Incorrect/unsupported Ctrl Notification[%u]\n",ntfy.msg_id);
 			goto err;
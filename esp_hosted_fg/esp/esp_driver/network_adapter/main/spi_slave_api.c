@@ -16,6 +16,9 @@
 #include "freertos/task.h"
 #include "mempool.h"
 #include "stats.h"
+#include "csum_offload.h"
+#include "slave_bt.h"
+#include "wmm.h"
 #include "esp_timer.h"
 #include "esp_fw_version.h"
 #include "host_power_save.h"
@@ -87,7 +90,9 @@ static const char TAG[] = "SPI_DRIVER";
     #define SPI_TX_WIFI_QUEUE_SIZE     CONFIG_ESP_TX_WIFI_Q_SIZE
     #define SPI_TX_BT_QUEUE_SIZE       CONFIG_ESP_TX_BT_Q_SIZE
     #define SPI_TX_SERIAL_QUEUE_SIZE   CONFIG_ESP_TX_SERIAL_Q_SIZE
-    #define SPI_TX_TOTAL_QUEUE_SIZE (SPI_TX_WIFI_QUEUE_SIZE+SPI_TX_BT_QUEUE_SIZE+SPI_TX_SERIAL_QUEUE_SIZE)
+    /* VO/VI/BK lanes; BE is the WIFI queue */
+    #define SPI_TX_WIFI_AC_QUEUE_SIZE  (SPI_TX_WIFI_QUEUE_SIZE/2+1)
+    #define SPI_TX_TOTAL_QUEUE_SIZE (SPI_TX_WIFI_QUEUE_SIZE+3*SPI_TX_WIFI_AC_QUEUE_SIZE+SPI_TX_BT_QUEUE_SIZE+SPI_TX_SERIAL_QUEUE_SIZE)
 #else
     #define SPI_TX_QUEUE_SIZE          CONFIG_ESP_TX_Q_SIZE
     #define SPI_TX_TOTAL_QUEUE_SIZE    SPI_TX_QUEUE_SIZE
@@ -108,7 +113,13 @@ static interface_handle_t if_handle_g;
 
 #ifdef CONFIG_ESP_ENABLE_TX_PRIORITY_QUEUES
   static QueueHandle_t spi_tx_queue[MAX_PRIORITY_QUEUES];
+  /* PRIO_Q_OTHERS per access category; [ESP_AC_BE] is spi_tx_queue[PRIO_Q_OTHERS] */
+  static QueueHandle_t spi_tx_ac_queue[ESP_NUM_AC];
+  static struct wmm_sched spi_tx_wmm;
   static SemaphoreHandle_t spi_tx_sem;
+  /* get_next_tx_buffer() runs in both the post-process and the app task;
+   * spi_tx_wmm is not thread safe */
+  static SemaphoreHandle_t spi_tx_sched_lock;
 #else
   static QueueHandle_t spi_tx_queue;
 #endif
@@ -325,6 +336,32 @@ void generate_startup_event(uint8_t cap)
 	fw_ver.revision_patch_1 = PROJECT_REVISION_PATCH_1;
 	fw_ver.revision_patch_2 = PROJECT_REVISION_PATCH_2;
 
+	/* TLV - Serial capabilities */
+	*pos = ESP_PRIV_SERIAL_CAPS;        pos++;len++;
+	*pos = LENGTH_1_BYTE;               pos++;len++;
+	*pos = ESP_SERIAL_CAP_TOTAL_LEN;    pos++;len++;
+
+	/* TLV - Telemetry record version */
+	if (debug_get_telemetry_conf()) {
+		*pos = ESP_PRIV_TELEMETRY;          pos++;len++;
+		*pos = LENGTH_1_BYTE;               pos++;len++;
+		*pos = debug_get_telemetry_conf();  pos++;len++;
+	}
+
+	/* TLV - TCP/UDP checksum offload */
+	if (csum_offload_caps()) {
+		*pos = ESP_PRIV_CSUM_OFFLOAD;       pos++;len++;
+		*pos = LENGTH_1_BYTE;               pos++;len++;
+		*pos = csum_offload_caps();         pos++;len++;
+	}
+
+	/* TLV - HCI batching */
+	if (hci_batch_caps()) {
+		*pos = ESP_PRIV_HCI_BATCH;          pos++;len++;
+		*pos = LENGTH_1_BYTE;               pos++;len++;
+		*pos = hci_batch_caps();            pos++;len++;
+	}
+
 	/* TLV - Firmware Version */
 	*pos = ESP_PRIV_FW_DATA;            pos++;len++;
 	*pos = sizeof(fw_ver);              pos++;len++;
@@ -382,6 +419,21 @@ static void IRAM_ATTR spi_post_trans_cb(spi_slave_transaction_t *trans)
 #endif
 }
 
+#ifdef CONFIG_ESP_ENABLE_TX_PRIORITY_QUEUES
+/* One WiFi frame, from the access category whose turn it is.
+ * Caller holds spi_tx_sched_lock. */
+static BaseType_t spi_tx_data_receive(interface_buffer_handle_t *buf_handle)
+{
+	int ac = wmm_sched_next(&spi_tx_wmm, spi_tx_ac_queue);
+
+	if (ac < 0 || xQueueReceive(spi_tx_ac_queue[ac], buf_handle, 0) != pdTRUE)
+		return pdFALSE;
+
+	wmm_sched_charge(&spi_tx_wmm, 1);
+	return pdTRUE;
+}
+#endif
+
 static uint8_t * get_next_tx_buffer(uint32_t *len)
 {
 	interface_buffer_handle_t buf_handle = {0};
@@ -389,14 +441,18 @@ static uint8_t * get_next_tx_buffer(uint32_t *len)
 
 
 	#ifdef CONFIG_ESP_ENABLE_TX_PRIORITY_QUEUES
+	/* Semaphore and queues are taken together, so a count taken here
+	 * always has its frame in one of the queues */
+	xSemaphoreTake(spi_tx_sched_lock, portMAX_DELAY);
 	ret = xSemaphoreTake(spi_tx_sem, 0);
 	if (pdTRUE == ret) {
 
 		if (pdFALSE == xQueueReceive(spi_tx_queue[PRIO_Q_SERIAL], &buf_handle, 0))
 			if (pdFALSE == xQueueReceive(spi_tx_queue[PRIO_Q_BT], &buf_handle, 0))
-				if (pdFALSE == xQueueReceive(spi_tx_queue[PRIO_Q_OTHERS], &buf_handle, 0))
+				if (pdFALSE == spi_tx_data_receive(&buf_handle))
 					ret = pdFALSE;
 	}
+	xSemaphoreGive(spi_tx_sched_lock);
 	#else
 	ret = xQueueReceive(spi_tx_queue, &buf_handle, 0);
 	#endif
@@ -742,6 +798,8 @@ static interface_handle_t * esp_spi_init(void)
 #ifdef CONFIG_ESP_ENABLE_TX_PRIORITY_QUEUES
 	spi_tx_sem = xSemaphoreCreateCounting(SPI_TX_TOTAL_QUEUE_SIZE, 0);
 	assert(spi_tx_sem);
+	spi_tx_sched_lock = xSemaphoreCreateMutex();
+	assert(spi_tx_sched_lock);
 
 	spi_tx_queue[PRIO_Q_OTHERS] = xQueueCreate(SPI_TX_WIFI_QUEUE_SIZE, sizeof(interface_buffer_handle_t));
 	assert(spi_tx_queue[PRIO_Q_OTHERS]);
@@ -749,6 +807,15 @@ static interface_handle_t * esp_spi_init(void)
 	assert(spi_tx_queue[PRIO_Q_BT]);
 	spi_tx_queue[PRIO_Q_SERIAL] = xQueueCreate(SPI_TX_SERIAL_QUEUE_SIZE, sizeof(interface_buffer_handle_t));
 	assert(spi_tx_queue[PRIO_Q_SERIAL]);
+	for (int ac = 0; ac < ESP_NUM_AC; ac++) {
+		if (ac == ESP_AC_BE) {
+			spi_tx_ac_queue[ac] = spi_tx_queue[PRIO_Q_OTHERS];
+			continue;
+		}
+		spi_tx_ac_queue[ac] = xQueueCreate(SPI_TX_WIFI_AC_QUEUE_SIZE, sizeof(interface_buffer_handle_t));
+		assert(spi_tx_ac_queue[ac]);
+	}
+	wmm_sched_init(&spi_tx_wmm);
 #else
 	spi_tx_queue = xQueueCreate(SPI_TX_QUEUE_SIZE, sizeof(interface_buffer_handle_t));
 	assert(spi_tx_queue);
@@ -873,6 +940,9 @@ static int32_t esp_spi_write(interface_handle_t *handle, interface_buffer_handle
 		xQueueSend(spi_tx_queue[PRIO_Q_SERIAL], &tx_buf_handle, portMAX_DELAY);
 	else if (header->if_type == ESP_HCI_IF)
 		xQueueSend(spi_tx_queue[PRIO_Q_BT], &tx_buf_handle, portMAX_DELAY);
+	else if (header->if_type == ESP_STA_IF || header->if_type == ESP_AP_IF)
+		xQueueSend(spi_tx_ac_queue[wmm_frame_ac(buf_handle->payload,
+				buf_handle->payload_len)], &tx_buf_handle, portMAX_DELAY);
 	else
 		xQueueSend(spi_tx_queue[PRIO_Q_OTHERS], &tx_buf_handle, portMAX_DELAY);
 
@@ -933,6 +1003,33 @@ static esp_err_t esp_spi_reset(interface_handle_t *handle)
 	return ret;
 }
 
+/* SPI sends one frame per transaction: only the lanes are reported */
+void fill_transport_telemetry(struct esp_telemetry *t)
+{
+#ifdef CONFIG_ESP_ENABLE_TX_PRIORITY_QUEUES
+	int i;
+
+	for (i = 0; i < MAX_PRIORITY_QUEUES && i < ESP_TELEMETRY_QUEUES; i++) {
+		uint16_t depth = 0;
+
+		if (!spi_tx_queue[i])
+			continue;
+		if (i == PRIO_Q_OTHERS)
+			for (int ac = 0; ac < ESP_NUM_AC; ac++)
+				depth += uxQueueMessagesWaiting(spi_tx_ac_queue[ac]);
+		else
+			depth = uxQueueMessagesWaiting(spi_tx_queue[i]);
+		t->to_host_q[i] = htole16(depth);
+		t->to_host_q_peak[i] = t->to_host_q[i];
+	}
+#else
+	if (spi_tx_queue) {
+		t->to_host_q[PRIO_Q_OTHERS] = htole16(uxQueueMessagesWaiting(spi_tx_queue));
+		t->to_host_q_peak[PRIO_Q_OTHERS] = t->to_host_q[PRIO_Q_OTHERS];
+	}
+#endif
+}
+
 static void esp_spi_deinit(interface_handle_t *handle)
 {
 	esp_err_t ret = ESP_OK;
@@ -4,13 +4,19 @@
 
 #include "stats.h"
 #include <unistd.h>
+#include <stdlib.h>
 #include "esp_log.h"
 #include <string.h>
 #include <inttypes.h>
 
-#if TEST_RAW_TP || ESP_PKT_STATS || CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS || ESP_PKT_NUM_DEBUG
+#if ESP_TELEMETRY
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#endif
+
+#if TEST_RAW_TP || ESP_PKT_STATS || CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS || ESP_PKT_NUM_DEBUG || ESP_TELEMETRY
 static const char TAG[] = "stats";
-#endif /* TEST_RAW_TP || ESP_PKT_STATS || CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS || ESP_PKT_NUM_DEBUG */
+#endif /* TEST_RAW_TP || ESP_PKT_STATS || CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS || ESP_PKT_NUM_DEBUG || ESP_TELEMETRY */
 
 #if ESP_PKT_NUM_DEBUG
 struct dbg_stats_t dbg_stats;
@@ -205,9 +211,39 @@ static void log_runtime_stats_task(void* pvParameters)
 uint64_t test_raw_tp_rx_len;
 uint64_t test_raw_tp_tx_len;
 
-void debug_update_raw_tp_rx_count(uint16_t len)
+/* Set by ESP_PRIV_CMD_RAW_TP_ECHO: every test frame goes back to the host */
+static volatile uint8_t raw_tp_echo;
+
+void debug_process_raw_tp_rx(uint8_t *payload, uint16_t len)
 {
+	interface_buffer_handle_t buf_handle = {0};
+	uint8_t *copy = NULL;
+
 	test_raw_tp_rx_len += len;
+
+	if (!raw_tp_echo)
+		return;
+
+	/* The bus RX buffer is freed once this returns */
+	copy = malloc(len);
+	if (!copy) {
+		ESP_LOGW(TAG, "RawTP echo: no mem for %u bytes", len);
+		return;
+	}
+	memcpy(copy, payload, len);
+
+	buf_handle.if_type = ESP_TEST_IF;
+	buf_handle.if_num = 0;
+	buf_handle.payload = copy;
+	buf_handle.payload_len = len;
+	buf_handle.free_buf_handle = free;
+	buf_handle.priv_buffer_handle = copy;
+
+	if (send_to_host_queue(&buf_handle, PRIO_Q_OTHERS)) {
+		free(copy);
+		return;
+	}
+	test_raw_tp_tx_len += len;
 }
 
 /* static buffer to hold tx data during test */
@@ -387,17 +423,218 @@ void process_raw_tp_cmd(uint8_t cmd)
 {
 	init_raw_tp_timer();
 
+	raw_tp_echo = 0;
+
 	if (cmd == ESP_PRIV_CMD_RAW_TP_ESP_TO_HOST) {
 		ESP_LOGI(TAG, "RawTP: ESP->Host started");
 		init_raw_tp_test_task();
 	} else if (cmd == ESP_PRIV_CMD_RAW_TP_HOST_TO_ESP) {
 		ESP_LOGI(TAG, "RawTP: Host->ESP started");
+	} else if (cmd == ESP_PRIV_CMD_RAW_TP_ECHO) {
+		ESP_LOGI(TAG, "RawTP: echo started");
+		raw_tp_echo = 1;
+	} else if (cmd == ESP_PRIV_CMD_RAW_TP_BIDIR) {
+		ESP_LOGI(TAG, "RawTP: Host<->ESP started");
+		init_raw_tp_test_task();
 	} else {
 		ESP_LOGW(TAG, "RawTP: unknown cmd %u", cmd);
 	}
 }
 #endif /* TEST_RAW_TP */
 
+#if ESP_TELEMETRY
+/* Health record for the host, pushed as ESP_PRIV_EVENT_TELEMETRY every
+ * telemetry_interval_ms once the host asks for it. */
+#define TELEMETRY_MIN_INTERVAL_MS      100
+
+extern volatile uint8_t datapath;
+static TaskHandle_t telemetry_task_hdl;
+static volatile uint32_t telemetry_interval_ms;
+static uint32_t telemetry_seq;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define TELEMETRY_TASK_CPU 1
+
+/* Task states at the previous record, to turn run time counters into shares */
+static TaskStatus_t *telemetry_prev;
+static UBaseType_t telemetry_prev_nr;
+static uint32_t telemetry_prev_run_time;
+
+static uint32_t telemetry_prev_counter(TaskHandle_t task)
+{
+	for (UBaseType_t i = 0; i < telemetry_prev_nr; i++) {
+		if (telemetry_prev[i].xHandle == task)
+			return telemetry_prev[i].ulRunTimeCounter;
+	}
+	return 0;
+}
+
+/* Busiest tasks and overall load since the previous record */
+static void telemetry_fill_tasks(struct esp_telemetry *t)
+{
+	uint32_t top_delta[ESP_TELEMETRY_MAX_TASKS] = {0};
+	UBaseType_t top_idx[ESP_TELEMETRY_MAX_TASKS] = {0};
+	uint32_t run_time, total, delta, idle = 0;
+	TaskStatus_t *cur;
+	UBaseType_t nr, i;
+	uint8_t nr_top = 0, j;
+
+	nr = uxTaskGetNumberOfTasks() + ARRAY_SIZE_OFFSET;
+	cur = malloc(sizeof(TaskStatus_t) * nr);
+	if (!cur)
+		return;
+	nr = uxTaskGetSystemState(cur, nr, &run_time);
+
+	total = (run_time - telemetry_prev_run_time) * portNUM_PROCESSORS;
+	if (telemetry_prev && total) {
+		for (i = 0; i < nr; i++) {
+			delta = cur[i].ulRunTimeCounter - telemetry_prev_counter(cur[i].xHandle);
+
+			if (!strncmp(cur[i].pcTaskName, "IDLE", 4)) {
+				idle += delta;
+				continue;
+			}
+
+			/* keep top_delta[] sorted, busiest first */
+			for (j = nr_top; j > 0 && top_delta[j - 1] < delta; j--) {
+				if (j < ESP_TELEMETRY_MAX_TASKS) {
+					top_delta[j] = top_delta[j - 1];
+					top_idx[j] = top_idx[j - 1];
+				}
+			}
+			if (j < ESP_TELEMETRY_MAX_TASKS) {
+				top_delta[j] = delta;
+				top_idx[j] = i;
+				if (nr_top < ESP_TELEMETRY_MAX_TASKS)
+					nr_top++;
+			}
+		}
+
+		for (j = 0; j < nr_top; j++) {
+			const char *name = cur[top_idx[j]].pcTaskName;
+
+			memcpy(t->task[j].name, name,
+					strnlen(name, ESP_TELEMETRY_TASK_NAME_LEN));
+			t->task[j].cpu_pct = (uint64_t)top_delta[j] * 100 / total;
+		}
+		t->nr_tasks = nr_top;
+		t->cpu_load_pct = idle >= total ? 0 :
+			100 - (uint64_t)idle * 100 / total;
+	}
+
+	free(telemetry_prev);
+	telemetry_prev = cur;
+	telemetry_prev_nr = nr;
+	telemetry_prev_run_time = run_time;
+}
+#endif
+
+static void telemetry_send(void)
+{
+	interface_buffer_handle_t buf_handle = {0};
+	struct esp_priv_event *event;
+	struct esp_telemetry *t;
+	uint16_t len = sizeof(struct esp_priv_event) + sizeof(struct esp_telemetry);
+	uint8_t *buf;
+
+	buf = calloc(1, len);
+	if (!buf)
+		return;
+
+	event = (struct esp_priv_event *)buf;
+	event->event_type = ESP_PRIV_EVENT_TELEMETRY;
+	event->event_len = sizeof(struct esp_telemetry);
+	t = (struct esp_telemetry *)event->event_data;
+
+	t->version = ESP_TELEMETRY_VERSION;
+	t->cpu_load_pct = 0xFF;
+	t->seq = htole32(telemetry_seq++);
+	t->uptime_ms = htole32((uint32_t)(esp_timer_get_time() / 1000));
+	t->interval_ms = htole32(telemetry_interval_ms);
+
+	t->heap_free = htole32(esp_get_free_heap_size());
+	t->heap_min_free = htole32(esp_get_minimum_free_heap_size());
+	t->heap_largest = htole32(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL));
+	t->dma_free = htole32(heap_caps_get_free_size(MALLOC_CAP_DMA));
+
+#if ESP_PKT_STATS
+	t->h2e_sta_out = htole32(pkt_stats.hs_bus_sta_out);
+	t->h2e_sta_fail = htole32(pkt_stats.hs_bus_sta_fail);
+	t->h2e_ap_out = htole32(pkt_stats.hs_bus_ap_out);
+	t->h2e_ap_fail = htole32(pkt_stats.hs_bus_ap_fail);
+	t->e2h_sta_in = htole32(pkt_stats.sta_sh_in);
+	t->wifi_tx_retries = htole32(pkt_stats.wifi_tx_retries);
+	t->flowctrl_on = htole32(pkt_stats.sta_flowctrl_on);
+	t->flowctrl_off = htole32(pkt_stats.sta_flowctrl_off);
+	t->serial_rx = htole32(pkt_stats.serial_rx);
+	t->serial_tx = htole32(pkt_stats.serial_tx_total);
+#endif
+
+	fill_transport_telemetry(t);
+#ifdef TELEMETRY_TASK_CPU
+	telemetry_fill_tasks(t);
+#endif
+
+	/* The transports leave priv_pkt_type 0, ESP_PACKET_TYPE_EVENT */
+	buf_handle.if_type = ESP_PRIV_IF;
+	buf_handle.if_num = 0;
+	buf_handle.payload = buf;
+	buf_handle.payload_len = len;
+	buf_handle.free_buf_handle = free;
+	buf_handle.priv_buffer_handle = buf;
+
+	if (send_to_host_queue(&buf_handle, PRIO_Q_OTHERS))
+		free(buf);
+}
+
+static void telemetry_task(void *pvParameters)
+{
+	TickType_t wait;
+
+	for (;;) {
+		wait = telemetry_interval_ms ?
+			pdMS_TO_TICKS(telemetry_interval_ms) : portMAX_DELAY;
+
+		/* A new interval from the host restarts the wait */
+		if (ulTaskNotifyTake(pdTRUE, wait))
+			continue;
+
+		if (datapath && telemetry_interval_ms)
+			telemetry_send();
+	}
+}
+
+void process_telemetry_cmd(uint8_t *payload, uint16_t payload_len)
+{
+	struct esp_priv_telemetry_cmd cmd;
+	uint32_t interval;
+
+	if (payload_len < sizeof(cmd)) {
+		ESP_LOGW(TAG, "Telemetry: short command (%u bytes)", payload_len);
+		return;
+	}
+	memcpy(&cmd, payload, sizeof(cmd));
+
+	interval = le32toh(cmd.interval_ms);
+	if (interval && interval < TELEMETRY_MIN_INTERVAL_MS)
+		interval = TELEMETRY_MIN_INTERVAL_MS;
+	telemetry_interval_ms = interval;
+
+	if (interval)
+		ESP_LOGI(TAG, "Telemetry every %" PRIu32 " ms", interval);
+	else
+		ESP_LOGI(TAG, "Telemetry stopped");
+
+	if (!telemetry_task_hdl) {
+		assert(xTaskCreate(telemetry_task, "telemetry_task",
+					CONFIG_ESP_DEFAULT_TASK_STACK_SIZE, NULL,
+					CONFIG_ESP_HOSTED_TASK_PRIORITY_LOW, &telemetry_task_hdl) == pdTRUE);
+	} else {
+		xTaskNotifyGive(telemetry_task_hdl);
+	}
+}
+#endif /* ESP_TELEMETRY */
+
 void create_debugging_tasks(void)
 {
 #ifdef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
@@ -411,6 +648,15 @@ void create_debugging_tasks(void)
 #endif /* ESP_PKT_STATS */
 }
 
+uint8_t debug_get_telemetry_conf(void)
+{
+#if ESP_TELEMETRY
+	return ESP_TELEMETRY_VERSION;
+#else
+	return 0;
+#endif
+}
+
 uint8_t debug_get_raw_tp_conf(void) {
 	uint8_t raw_tp_cap = 0;
 #if TEST_RAW_TP
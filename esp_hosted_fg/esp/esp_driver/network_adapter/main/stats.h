@@ -45,6 +45,12 @@
 #define ESP_PKT_STATS 1
 #endif
 
+#ifdef CONFIG_ESP_HOSTED_TELEMETRY
+#define ESP_TELEMETRY 1
+#else
+#define ESP_TELEMETRY 0
+#endif
+
 #ifdef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
   /* Stats to show task wise CPU utilization */
   #define STATS_TICKS                  pdMS_TO_TICKS(4 * 1000)
@@ -61,7 +67,7 @@ void debug_runtime_stats_task(void* pvParameters);
  * at a time
  */
 
-#if TEST_RAW_TP || ESP_PKT_STATS
+#if TEST_RAW_TP || ESP_PKT_STATS || ESP_TELEMETRY
 #include "interface.h"
 
 /* Raw throughput is supported only one direction
@@ -82,7 +88,8 @@ typedef struct {
 #define TEST_RAW_TP__BUF_SIZE        CONFIG_ESP_RAW_TP_ESP_TO_HOST_PKT_LEN
 #define TEST_RAW_TP__TIMEOUT         CONFIG_ESP_RAW_TP_REPORT_INTERVAL
 
-void debug_update_raw_tp_rx_count(uint16_t len);
+/* Count a host test frame and, in echo mode, send it back */
+void debug_process_raw_tp_rx(uint8_t *payload, uint16_t len);
 #endif
 
 
@@ -114,6 +121,13 @@ extern struct pkt_stats_t pkt_stats;
 
 void create_debugging_tasks(void);
 uint8_t debug_get_raw_tp_conf(void);
+/* ESP_TELEMETRY_VERSION if built in, else 0 */
+uint8_t debug_get_telemetry_conf(void);
+
+#if ESP_TELEMETRY
+/* Apply ESP_PRIV_CMD_TELEMETRY (struct esp_priv_telemetry_cmd) */
+void process_telemetry_cmd(uint8_t *payload, uint16_t payload_len);
+#endif
 
 #if TEST_RAW_TP
 /* Start raw-TP on host command (cmd = ESP_PRIV_CMD_RAW_TP_*). */
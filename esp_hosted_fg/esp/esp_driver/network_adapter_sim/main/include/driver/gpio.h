@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Simulation stand-in: there are no GPIOs, slave reset pin is -1.
+
+#pragma once
+
+typedef int gpio_num_t;
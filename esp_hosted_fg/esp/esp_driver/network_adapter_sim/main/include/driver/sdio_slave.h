@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Simulation stand-in for the IDF SDIO slave driver API. Same names and
+// semantics as driver/sdio_slave.h on chip, implemented over the host's
+// virtual transport in sim_sdio_slave.c.
+
+#ifndef __SIM_DRIVER_SDIO_SLAVE_H
+#define __SIM_DRIVER_SDIO_SLAVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef void *sdio_slave_buf_handle_t;
+
+typedef enum {
+	SDIO_SLAVE_TIMING_PSEND_PSAMPLE = 0,
+	SDIO_SLAVE_TIMING_NSEND_PSAMPLE,
+	SDIO_SLAVE_TIMING_PSEND_NSAMPLE,
+	SDIO_SLAVE_TIMING_NSEND_NSAMPLE,
+} sdio_slave_timing_t;
+
+typedef enum {
+	SDIO_SLAVE_SEND_STREAM = 0,
+	SDIO_SLAVE_SEND_PACKET = 1,
+} sdio_slave_sending_mode_t;
+
+typedef enum {
+	SDIO_SLAVE_HOSTINT_BIT0 = (1 << 0),
+	SDIO_SLAVE_HOSTINT_BIT1 = (1 << 1),
+	SDIO_SLAVE_HOSTINT_BIT2 = (1 << 2),
+	SDIO_SLAVE_HOSTINT_BIT3 = (1 << 3),
+	SDIO_SLAVE_HOSTINT_BIT4 = (1 << 4),
+	SDIO_SLAVE_HOSTINT_BIT5 = (1 << 5),
+	SDIO_SLAVE_HOSTINT_BIT6 = (1 << 6),
+	SDIO_SLAVE_HOSTINT_BIT7 = (1 << 7),
+	SDIO_SLAVE_HOSTINT_SEND_NEW_PACKET = (1 << 23),
+} sdio_slave_hostint_t;
+
+typedef void (*sdio_event_cb_t)(uint8_t event);
+
+typedef struct {
+	sdio_slave_timing_t         timing;
+	sdio_slave_sending_mode_t   sending_mode;
+	int                         send_queue_size;
+	size_t                      recv_buffer_size;
+	sdio_event_cb_t             event_cb;
+	uint32_t                    flags;
+} sdio_slave_config_t;
+
+esp_err_t sdio_slave_initialize(sdio_slave_config_t *config);
+void sdio_slave_deinit(void);
+esp_err_t sdio_slave_start(void);
+void sdio_slave_stop(void);
+esp_err_t sdio_slave_reset(void);
+
+sdio_slave_buf_handle_t sdio_slave_recv_register_buf(uint8_t *start);
+esp_err_t sdio_slave_recv_load_buf(sdio_slave_buf_handle_t handle);
+esp_err_t sdio_slave_recv(sdio_slave_buf_handle_t *handle_ret, uint8_t **out_addr,
+		size_t *out_len, TickType_t wait);
+
+esp_err_t sdio_slave_send_queue(uint8_t *addr, size_t len, void *arg, TickType_t wait);
+esp_err_t sdio_slave_send_get_finished(void **out_arg, TickType_t wait);
+esp_err_t sdio_slave_transmit(uint8_t *addr, size_t len);
+
+esp_err_t sdio_slave_set_host_intena(sdio_slave_hostint_t mask);
+
+#endif
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Simulation stand-in: there is no slave network stack, frames are always
+// bridged to the host.
+
+#ifndef __SIM_ESP_NETIF_H
+#define __SIM_ESP_NETIF_H
+
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef struct esp_netif_obj esp_netif_t;
+
+esp_err_t esp_netif_receive(esp_netif_t *esp_netif, void *buffer, size_t len, void *eb);
+
+#endif
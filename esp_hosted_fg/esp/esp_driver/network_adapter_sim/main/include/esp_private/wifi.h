@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Simulation stand-in for the WiFi driver internal datapath API.
+
+#ifndef __SIM_ESP_PRIVATE_WIFI_H
+#define __SIM_ESP_PRIVATE_WIFI_H
+
+#include "esp_wifi.h"
+
+int esp_wifi_internal_tx(wifi_interface_t wifi_if, void *buffer, uint16_t len);
+void esp_wifi_internal_free_rx_buffer(void *buffer);
+
+#endif
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Simulation stand-in for the IDF WiFi API. Only what the hosted datapath
+// uses; implemented in sim_wifi.c.
+
+#ifndef __SIM_ESP_WIFI_H
+#define __SIM_ESP_WIFI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+
+typedef enum {
+	WIFI_IF_STA = 0,
+	WIFI_IF_AP,
+	WIFI_IF_MAX
+} wifi_interface_t;
+
+typedef enum {
+	WIFI_MODE_NULL = 0,
+	WIFI_MODE_STA,
+	WIFI_MODE_AP,
+	WIFI_MODE_APSTA,
+	WIFI_MODE_MAX
+} wifi_mode_t;
+
+typedef enum {
+	WIFI_PS_NONE,
+	WIFI_PS_MIN_MODEM,
+	WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+typedef enum {
+	WIFI_AUTH_OPEN = 0,
+	WIFI_AUTH_WEP,
+	WIFI_AUTH_WPA_PSK,
+	WIFI_AUTH_WPA2_PSK,
+	WIFI_AUTH_WPA_WPA2_PSK,
+	WIFI_AUTH_ENTERPRISE,
+	WIFI_AUTH_WPA3_PSK,
+	WIFI_AUTH_WPA2_WPA3_PSK,
+	WIFI_AUTH_WAPI_PSK,
+	WIFI_AUTH_MAX
+} wifi_auth_mode_t;
+
+typedef enum {
+	WPA3_SAE_PWE_UNSPECIFIED,
+	WPA3_SAE_PWE_HUNT_AND_PECK,
+	WPA3_SAE_PWE_HASH_TO_ELEMENT,
+	WPA3_SAE_PWE_BOTH,
+} wifi_sae_pwe_method_t;
+
+typedef enum {
+	WIFI_FAST_SCAN = 0,
+	WIFI_ALL_CHANNEL_SCAN,
+} wifi_scan_method_t;
+
+typedef enum {
+	WIFI_CONNECT_AP_BY_SIGNAL = 0,
+	WIFI_CONNECT_AP_BY_SECURITY,
+} wifi_sort_method_t;
+
+typedef struct {
+	int8_t rssi;
+	wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t password[64];
+	wifi_scan_method_t scan_method;
+	wifi_sort_method_t sort_method;
+	wifi_scan_threshold_t threshold;
+	wifi_sae_pwe_method_t sae_pwe_h2e;
+	uint8_t sae_h2e_identifier[32];
+} wifi_sta_config_t;
+
+typedef struct {
+	uint8_t ssid[32];
+	uint8_t password[64];
+} wifi_ap_config_t;
+
+typedef union {
+	wifi_ap_config_t ap;
+	wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+	char cc[3];
+	uint8_t schan;
+	uint8_t nchan;
+	int8_t max_tx_power;
+	int policy;
+} wifi_country_t;
+
+typedef struct {
+	int magic;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() { .magic = 0 }
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_country(const wifi_country_t *country);
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_start(void);
+
+#endif
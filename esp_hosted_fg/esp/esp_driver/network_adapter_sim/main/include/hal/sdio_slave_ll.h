@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Simulation stand-in: only the DMA descriptor layout is used, to size the
+// RX buffers like the chip does.
+
+#ifndef __SIM_HAL_SDIO_SLAVE_LL_H
+#define __SIM_HAL_SDIO_SLAVE_LL_H
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t size   : 14;
+	uint32_t length : 14;
+	uint32_t        : 2;
+	uint32_t eof    : 1;
+	uint32_t owner  : 1;
+	uint8_t *buf;
+	void *next;
+} sdio_slave_ll_desc_t;
+
+#endif
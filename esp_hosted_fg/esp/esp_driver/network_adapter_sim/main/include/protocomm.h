@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Simulation stand-in for protocomm. The control path is not part of the
+// simulation; see sim_stubs.c.
+
+#ifndef __SIM_PROTOCOMM_H
+#define __SIM_PROTOCOMM_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "esp_err.h"
+
+typedef struct protocomm protocomm_t;
+
+typedef esp_err_t (*protocomm_req_handler_t)(uint32_t session_id,
+		const uint8_t *inbuf, ssize_t inlen,
+		uint8_t **outbuf, ssize_t *outlen, void *priv_data);
+
+protocomm_t *protocomm_new(void);
+esp_err_t protocomm_add_endpoint(protocomm_t *pc, const char *ep_name,
+		protocomm_req_handler_t h, void *priv_data);
+
+#endif
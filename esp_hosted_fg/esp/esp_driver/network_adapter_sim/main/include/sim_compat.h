@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Force-included in every source of the simulation build: bits that the
+// chip toolchain provides implicitly but glibc/the linux target do not.
+
+#ifndef __SIM_COMPAT_H
+#define __SIM_COMPAT_H
+
+#include <stddef.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_compiler.h"
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#ifndef DMA_ATTR
+#define DMA_ATTR
+#endif
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+#endif
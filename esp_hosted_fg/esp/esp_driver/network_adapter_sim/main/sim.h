@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Counters shared by the simulation stand-ins and the datapath report.
+// Only FreeRTOS tasks touch them and the linux port runs one task at a
+// time, so plain increments are fine.
+
+#ifndef __SIM_H
+#define __SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct sim_bus_stats {
+	uint64_t h2e_blocks;        /* host->slave SDIO blocks */
+	uint64_t h2e_frames;
+	uint64_t h2e_bytes;
+	uint64_t e2h_blocks;        /* slave->host transmits */
+	uint64_t e2h_frames;
+	uint64_t e2h_bytes;
+	uint64_t e2h_errors;
+};
+
+struct sim_wifi_stats {
+	uint64_t tx_frames;         /* accepted by esp_wifi_internal_tx() */
+	uint64_t tx_no_mem;         /* refused, RX buffers exhausted */
+	uint64_t rx_frames;         /* handed to the rx callbacks */
+};
+
+extern struct sim_bus_stats sim_bus_stats;
+extern struct sim_wifi_stats sim_wifi_stats;
+extern uint64_t sim_ctrl_msgs;
+
+/* Number of frames in an SDIO block, as the receiver would split it */
+uint32_t sim_block_frames(const uint8_t *blk, size_t len);
+
+void sim_stats_start(void);
+
+#endif
@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// SDIO slave driver over the host's virtual transport.
+//
+// The host driver built with 'target=virt' and loaded with virt_mode=2
+// exposes the bus as a character device. A read() returns one host->slave
+// block exactly as the SLC would have DMAed it into a receive buffer, a
+// write() sends one slave->host block. Everything above this file, i.e.
+// sdio_slave_api.c and esp_hosted_coprocessor.c, is the firmware code as is.
+//
+// There is no bus interrupt: the receive path polls the device once per
+// tick while it is idle, so a burst after idle time sees up to one tick of
+// extra latency. Back to back blocks are read without waiting.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "driver/sdio_slave.h"
+#include "adapter.h"
+#include "endian.h"
+#include "sim.h"
+
+#define SIM_RX_BUF_MAX          8
+/* STREAM mode keeps up to SDIO_STREAM_QUEUE_SIZE (14) buffers in flight */
+#define SIM_SEND_DONE_DEPTH     32
+/* sdio_init() publishes the interface handle only after start returns */
+#define SIM_OPEN_DELAY_MS       100
+
+static const char *TAG = "sim_sdio";
+
+struct sim_bus_stats sim_bus_stats;
+
+static struct {
+	int fd;
+	sdio_slave_config_t config;
+	QueueHandle_t rx_loaded;        /* buffers loaded by the driver, free for the host */
+	QueueHandle_t send_done;        /* finished send_queue() args */
+	bool opened;
+} sim_bus = {
+	.fd = -1,
+};
+
+uint32_t sim_block_frames(const uint8_t *blk, size_t len)
+{
+	const struct esp_payload_header *h;
+	uint32_t frames = 0;
+	uint32_t frame_len;
+	size_t pos = 0;
+
+	while (pos + sizeof(*h) <= len) {
+		h = (const struct esp_payload_header *)(blk + pos);
+		if (!h->len)
+			break;
+
+		frame_len = le16toh(h->len) + le16toh(h->offset);
+		pos += (frame_len + 3) & ~3;
+		frames++;
+	}
+
+	return frames;
+}
+
+esp_err_t sdio_slave_initialize(sdio_slave_config_t *config)
+{
+	if (!config || !config->recv_buffer_size)
+		return ESP_ERR_INVALID_ARG;
+
+	sim_bus.fd = open(CONFIG_SIM_BUS_DEVICE, O_RDWR | O_NONBLOCK);
+	if (sim_bus.fd < 0) {
+		ESP_LOGE(TAG, "open %s: %s. Is esp32_virt.ko loaded with virt_mode=2?",
+				CONFIG_SIM_BUS_DEVICE, strerror(errno));
+		return ESP_ERR_NOT_FOUND;
+	}
+
+	sim_bus.config = *config;
+	sim_bus.rx_loaded = xQueueCreate(SIM_RX_BUF_MAX, sizeof(sdio_slave_buf_handle_t));
+	sim_bus.send_done = xQueueCreate(SIM_SEND_DONE_DEPTH, sizeof(void *));
+	assert(sim_bus.rx_loaded && sim_bus.send_done);
+
+	ESP_LOGI(TAG, "bus on %s, rx buf %u", CONFIG_SIM_BUS_DEVICE,
+			(unsigned)config->recv_buffer_size);
+
+	return ESP_OK;
+}
+
+void sdio_slave_deinit(void)
+{
+	if (sim_bus.fd >= 0)
+		close(sim_bus.fd);
+	sim_bus.fd = -1;
+
+	if (sim_bus.rx_loaded)
+		vQueueDelete(sim_bus.rx_loaded);
+	if (sim_bus.send_done)
+		vQueueDelete(sim_bus.send_done);
+	sim_bus.rx_loaded = NULL;
+	sim_bus.send_done = NULL;
+}
+
+static void sim_open_task(void *arg)
+{
+	vTaskDelay(pdMS_TO_TICKS(SIM_OPEN_DELAY_MS));
+
+	/* What the host does once it has enumerated the card */
+	if (sim_bus.config.event_cb)
+		sim_bus.config.event_cb(ESP_OPEN_DATA_PATH);
+
+	sim_stats_start();
+	vTaskDelete(NULL);
+}
+
+esp_err_t sdio_slave_start(void)
+{
+	if (sim_bus.fd < 0)
+		return ESP_ERR_INVALID_STATE;
+
+	if (!sim_bus.opened) {
+		sim_bus.opened = true;
+		assert(xTaskCreate(sim_open_task, "sim_open",
+				CONFIG_ESP_DEFAULT_TASK_STACK_SIZE, NULL,
+				CONFIG_ESP_HOSTED_TASK_PRIORITY_LOW, NULL) == pdTRUE);
+	}
+
+	return ESP_OK;
+}
+
+void sdio_slave_stop(void)
+{
+}
+
+esp_err_t sdio_slave_reset(void)
+{
+	return ESP_OK;
+}
+
+sdio_slave_buf_handle_t sdio_slave_recv_register_buf(uint8_t *start)
+{
+	/* Buffer address doubles as its handle */
+	return start;
+}
+
+esp_err_t sdio_slave_recv_load_buf(sdio_slave_buf_handle_t handle)
+{
+	if (!handle || !sim_bus.rx_loaded)
+		return ESP_ERR_INVALID_ARG;
+
+	if (xQueueSend(sim_bus.rx_loaded, &handle, 0) != pdTRUE)
+		return ESP_ERR_INVALID_STATE;
+
+	return ESP_OK;
+}
+
+esp_err_t sdio_slave_recv(sdio_slave_buf_handle_t *handle_ret, uint8_t **out_addr,
+		size_t *out_len, TickType_t wait)
+{
+	sdio_slave_buf_handle_t handle;
+	TickType_t start = xTaskGetTickCount();
+	ssize_t len;
+
+	if (xQueueReceive(sim_bus.rx_loaded, &handle, wait) != pdTRUE)
+		return ESP_ERR_TIMEOUT;
+
+	for (;;) {
+		len = read(sim_bus.fd, handle, sim_bus.config.recv_buffer_size);
+		if (len > 0)
+			break;
+
+		if (len < 0 && errno != EAGAIN && errno != EINTR) {
+			ESP_LOGE(TAG, "bus read: %s", strerror(errno));
+			xQueueSendToFront(sim_bus.rx_loaded, &handle, 0);
+			return ESP_FAIL;
+		}
+
+		if (wait != portMAX_DELAY && (xTaskGetTickCount() - start) >= wait) {
+			xQueueSendToFront(sim_bus.rx_loaded, &handle, 0);
+			return ESP_ERR_TIMEOUT;
+		}
+
+		vTaskDelay(1);
+	}
+
+	sim_bus_stats.h2e_blocks++;
+	sim_bus_stats.h2e_bytes += len;
+	sim_bus_stats.h2e_frames += sim_block_frames(handle, len);
+
+	*handle_ret = handle;
+	*out_addr = handle;
+	*out_len = len;
+
+	return ESP_OK;
+}
+
+esp_err_t sdio_slave_transmit(uint8_t *addr, size_t len)
+{
+	ssize_t ret;
+
+	if (sim_bus.fd < 0)
+		return ESP_ERR_INVALID_STATE;
+
+	ret = write(sim_bus.fd, addr, len);
+	if (ret != (ssize_t)len) {
+		sim_bus_stats.e2h_errors++;
+		ESP_LOGE(TAG, "bus write of %u: %s", (unsigned)len,
+				ret < 0 ? strerror(errno) : "short");
+		return ESP_FAIL;
+	}
+
+	sim_bus_stats.e2h_blocks++;
+	sim_bus_stats.e2h_bytes += len;
+	sim_bus_stats.e2h_frames += sim_block_frames(addr, len);
+
+	return ESP_OK;
+}
+
+/* STREAM mode: every queued buffer is one bus write, finished right away */
+esp_err_t sdio_slave_send_queue(uint8_t *addr, size_t len, void *arg, TickType_t wait)
+{
+	esp_err_t ret;
+
+	ret = sdio_slave_transmit(addr, len);
+	if (ret)
+		return ret;
+
+	if (xQueueSend(sim_bus.send_done, &arg, wait) != pdTRUE)
+		return ESP_ERR_TIMEOUT;
+
+	return ESP_OK;
+}
+
+esp_err_t sdio_slave_send_get_finished(void **out_arg, TickType_t wait)
+{
+	if (!sim_bus.send_done)
+		return ESP_ERR_INVALID_STATE;
+
+	if (xQueueReceive(sim_bus.send_done, out_arg, wait) != pdTRUE)
+		return ESP_ERR_TIMEOUT;
+
+	return ESP_OK;
+}
+
+esp_err_t sdio_slave_set_host_intena(sdio_slave_hostint_t mask)
+{
+	return ESP_OK;
+}
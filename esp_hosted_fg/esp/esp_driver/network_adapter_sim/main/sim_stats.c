@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Periodic datapath report of the simulation build:
+//  - aggregation efficiency: frames per SDIO block, both directions
+//  - to-host queue depth per lane, sampled every SIM_DEPTH_SAMPLE_MS
+//  - CPU cost per frame: process CPU time over frames moved
+//
+// CPU time is the whole process, scheduler emulation included. Absolute
+// numbers say little about a chip; compare them between builds/configs.
+
+#include <assert.h>
+#include <inttypes.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "adapter.h"
+#include "sdio_slave_api.h"
+#include "sim.h"
+
+#define SIM_DEPTH_SAMPLE_MS     10
+
+static const char *TAG = "sim_stats";
+
+static uint64_t cpu_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double per(uint64_t num, uint64_t den)
+{
+	return den ? (double)num / den : 0;
+}
+
+static void sim_stats_task(void *arg)
+{
+	const TickType_t interval = pdMS_TO_TICKS(CONFIG_SIM_REPORT_INTERVAL_SEC * 1000);
+	struct sim_bus_stats now, bus, last_bus = sim_bus_stats;
+	struct sim_wifi_stats wifi, last_wifi = sim_wifi_stats;
+	uint64_t depth_sum[MAX_PRIORITY_QUEUES] = {0};
+	uint16_t depth_max[MAX_PRIORITY_QUEUES] = {0};
+	uint64_t cpu, last_cpu = cpu_time_ns();
+	uint64_t frames, ctrl, last_ctrl = sim_ctrl_msgs;
+	TickType_t next = xTaskGetTickCount() + interval;
+	uint32_t samples = 0;
+	uint16_t depth;
+	int p;
+
+	for (;;) {
+		vTaskDelay(pdMS_TO_TICKS(SIM_DEPTH_SAMPLE_MS));
+
+		for (p = 0; p < MAX_PRIORITY_QUEUES; p++) {
+			depth = sdio_to_host_queue_depth(p);
+			depth_sum[p] += depth;
+			if (depth > depth_max[p])
+				depth_max[p] = depth;
+		}
+		samples++;
+
+		if ((int32_t)(xTaskGetTickCount() - next) < 0)
+			continue;
+		next += interval;
+
+		cpu = cpu_time_ns();
+		now = sim_bus_stats;
+		wifi = sim_wifi_stats;
+		ctrl = sim_ctrl_msgs;
+
+		bus.h2e_blocks = now.h2e_blocks - last_bus.h2e_blocks;
+		bus.h2e_frames = now.h2e_frames - last_bus.h2e_frames;
+		bus.h2e_bytes = now.h2e_bytes - last_bus.h2e_bytes;
+		bus.e2h_blocks = now.e2h_blocks - last_bus.e2h_blocks;
+		bus.e2h_frames = now.e2h_frames - last_bus.e2h_frames;
+		bus.e2h_bytes = now.e2h_bytes - last_bus.e2h_bytes;
+		bus.e2h_errors = now.e2h_errors - last_bus.e2h_errors;
+		frames = bus.h2e_frames + bus.e2h_frames;
+
+		ESP_LOGI(TAG, "h2e: %" PRIu64 " blk %" PRIu64 " frm %.2f frm/blk %.1f Mbps",
+				bus.h2e_blocks, bus.h2e_frames,
+				per(bus.h2e_frames, bus.h2e_blocks),
+				per(bus.h2e_bytes * 8, CONFIG_SIM_REPORT_INTERVAL_SEC * 1000000ULL));
+		ESP_LOGI(TAG, "e2h: %" PRIu64 " blk %" PRIu64 " frm %.2f frm/blk %.1f Mbps err %" PRIu64,
+				bus.e2h_blocks, bus.e2h_frames,
+				per(bus.e2h_frames, bus.e2h_blocks),
+				per(bus.e2h_bytes * 8, CONFIG_SIM_REPORT_INTERVAL_SEC * 1000000ULL),
+				bus.e2h_errors);
+		ESP_LOGI(TAG, "to-host q depth avg/max: serial %.1f/%u bt %.1f/%u others %.1f/%u",
+				per(depth_sum[PRIO_Q_SERIAL], samples), depth_max[PRIO_Q_SERIAL],
+				per(depth_sum[PRIO_Q_BT], samples), depth_max[PRIO_Q_BT],
+				per(depth_sum[PRIO_Q_OTHERS], samples), depth_max[PRIO_Q_OTHERS]);
+		ESP_LOGI(TAG, "wifi: tx %" PRIu64 " no_mem %" PRIu64 " rx %" PRIu64 " ctrl: %" PRIu64,
+				wifi.tx_frames - last_wifi.tx_frames,
+				wifi.tx_no_mem - last_wifi.tx_no_mem,
+				wifi.rx_frames - last_wifi.rx_frames,
+				ctrl - last_ctrl);
+		ESP_LOGI(TAG, "cpu: %.0f ns/frm", per(cpu - last_cpu, frames));
+
+		last_bus = now;
+		last_wifi = wifi;
+		last_ctrl = ctrl;
+		last_cpu = cpu;
+		samples = 0;
+		for (p = 0; p < MAX_PRIORITY_QUEUES; p++) {
+			depth_sum[p] = 0;
+			depth_max[p] = 0;
+		}
+	}
+}
+
+void sim_stats_start(void)
+{
+	if (!CONFIG_SIM_REPORT_INTERVAL_SEC)
+		return;
+
+	assert(xTaskCreate(sim_stats_task, "sim_stats",
+			CONFIG_ESP_DEFAULT_TASK_STACK_SIZE, NULL,
+			CONFIG_ESP_HOSTED_TASK_PRIORITY_LOW, NULL) == pdTRUE);
+}
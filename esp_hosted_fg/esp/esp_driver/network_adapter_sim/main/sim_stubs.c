@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Stand-ins for what the simulation leaves out: the control path
+// (protocomm + slave_control.c), host power save and the slave network
+// stack.
+//
+// Control requests from the host still go through the real serial
+// reassembly in esp_hosted_coprocessor.c. They are then consumed and
+// counted here but not answered, so host RPCs time out.
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include <protocomm.h>
+#include "protocomm_pserial.h"
+#include "slave_control.h"
+#include "host_power_save.h"
+#include "esp_netif.h"
+#include "esp_private/wifi.h"
+#include "sim.h"
+
+static const char *TAG = "sim_stubs";
+
+struct protocomm {
+	pserial_xmit xmit;
+	pserial_recv recv;
+};
+
+static struct protocomm sim_pc;
+uint64_t sim_ctrl_msgs;
+
+protocomm_t *protocomm_new(void)
+{
+	return &sim_pc;
+}
+
+esp_err_t protocomm_add_endpoint(protocomm_t *pc, const char *ep_name,
+		protocomm_req_handler_t h, void *priv_data)
+{
+	return ESP_OK;
+}
+
+esp_err_t protocomm_pserial_start(protocomm_t *pc, pserial_xmit xmit, pserial_recv recv)
+{
+	pc->xmit = xmit;
+	pc->recv = recv;
+	return ESP_OK;
+}
+
+esp_err_t protocomm_pserial_data_ready(protocomm_t *pc, uint8_t *in, int len, int msg_id)
+{
+	uint8_t *buf;
+
+	/* Events: no subscriber */
+	if (msg_id)
+		return ESP_OK;
+
+	/* Take the request so that the next one can be reassembled */
+	buf = malloc(len ? len : 1);
+	if (!buf)
+		return ESP_ERR_NO_MEM;
+
+	pc->recv(buf, len);
+	free(buf);
+
+	sim_ctrl_msgs++;
+	ESP_LOGD(TAG, "control request of %d bytes not answered", len);
+
+	return ESP_OK;
+}
+
+esp_err_t data_transfer_handler(uint32_t session_id, const uint8_t *inbuf,
+		ssize_t inlen, uint8_t **outbuf, ssize_t *outlen, void *priv_data)
+{
+	return ESP_FAIL;
+}
+
+esp_err_t ctrl_notify_handler(uint32_t session_id, const uint8_t *inbuf,
+		ssize_t inlen, uint8_t **outbuf, ssize_t *outlen, void *priv_data)
+{
+	return ESP_FAIL;
+}
+
+esp_err_t esp_hosted_wifi_init(wifi_init_config_t *cfg)
+{
+	return ESP_OK;
+}
+
+esp_err_t esp_hosted_set_sta_config(wifi_interface_t iface, wifi_config_t *cfg)
+{
+	return ESP_OK;
+}
+
+void host_power_save_init(void (*host_wakeup_callback)(void))
+{
+}
+
+void host_power_save_alert(uint32_t ps_evt)
+{
+}
+
+esp_err_t esp_netif_receive(esp_netif_t *esp_netif, void *buffer, size_t len, void *eb)
+{
+	esp_wifi_internal_free_rx_buffer(eb);
+	return ESP_OK;
+}
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+	size_t len = strlen(src);
+
+	if (size) {
+		size_t n = len < size - 1 ? len : size - 1;
+
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+
+	return len;
+}
+#endif
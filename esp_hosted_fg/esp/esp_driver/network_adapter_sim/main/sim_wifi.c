@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+// Emulated WiFi driver.
+//
+// There is no association to wait for: once started, both the station and
+// the SoftAP are up. Frames sent with esp_wifi_internal_tx() come back on
+// the same interface with MACs swapped (CONFIG_SIM_WIFI_LOOPBACK), through
+// the same rx callbacks and buffer ownership rules as the real driver. The
+// driver owns CONFIG_SIM_WIFI_RX_BUFFER_NUM rx buffers; while they are all
+// held by the datapath, TX fails with ESP_ERR_NO_MEM.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_private/wifi.h"
+#include "sim.h"
+
+#define SIM_MAC_LEN             6
+
+struct sim_wifi_frame {
+	wifi_interface_t ifx;
+	uint16_t len;
+	uint8_t *buf;
+};
+
+static const char *TAG = "sim_wifi";
+
+struct sim_wifi_stats sim_wifi_stats;
+
+static QueueHandle_t wifi_rx_queue;
+static uint32_t rx_buf_used;
+static wifi_mode_t wifi_mode;
+static wifi_config_t wifi_config[WIFI_IF_MAX];
+
+extern volatile uint8_t station_connected;
+extern volatile uint8_t softap_started;
+
+esp_err_t wlan_sta_rx_callback(void *buffer, uint16_t len, void *eb);
+esp_err_t wlan_ap_rx_callback(void *buffer, uint16_t len, void *eb);
+
+static void wifi_rx_task(void *arg)
+{
+	struct sim_wifi_frame f;
+
+	for (;;) {
+		if (xQueueReceive(wifi_rx_queue, &f, portMAX_DELAY) != pdTRUE)
+			continue;
+
+		sim_wifi_stats.rx_frames++;
+
+		/* Buffer doubles as eb, released by esp_wifi_internal_free_rx_buffer() */
+		if (f.ifx == WIFI_IF_AP)
+			wlan_ap_rx_callback(f.buf, f.len, f.buf);
+		else
+			wlan_sta_rx_callback(f.buf, f.len, f.buf);
+	}
+}
+
+int esp_wifi_internal_tx(wifi_interface_t wifi_if, void *buffer, uint16_t len)
+{
+#if CONFIG_SIM_WIFI_LOOPBACK
+	struct sim_wifi_frame f;
+	uint8_t mac[SIM_MAC_LEN];
+#endif
+
+	if (!buffer || !len || wifi_if >= WIFI_IF_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+#if CONFIG_SIM_WIFI_LOOPBACK
+	if (wifi_rx_queue && len >= 2 * SIM_MAC_LEN) {
+		if (rx_buf_used >= CONFIG_SIM_WIFI_RX_BUFFER_NUM) {
+			sim_wifi_stats.tx_no_mem++;
+			return ESP_ERR_NO_MEM;
+		}
+
+		f.buf = malloc(len);
+		if (!f.buf) {
+			sim_wifi_stats.tx_no_mem++;
+			return ESP_ERR_NO_MEM;
+		}
+
+		memcpy(f.buf, buffer, len);
+		memcpy(mac, f.buf, SIM_MAC_LEN);
+		memcpy(f.buf, f.buf + SIM_MAC_LEN, SIM_MAC_LEN);
+		memcpy(f.buf + SIM_MAC_LEN, mac, SIM_MAC_LEN);
+		f.ifx = wifi_if;
+		f.len = len;
+
+		/* Queue is as deep as the buffer pool, cannot overflow */
+		rx_buf_used++;
+		xQueueSend(wifi_rx_queue, &f, 0);
+	}
+#endif
+
+	sim_wifi_stats.tx_frames++;
+
+	return ESP_OK;
+}
+
+void esp_wifi_internal_free_rx_buffer(void *buffer)
+{
+	if (!buffer)
+		return;
+
+	free(buffer);
+	rx_buf_used--;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+	if (mode >= WIFI_MODE_MAX)
+		return ESP_ERR_INVALID_ARG;
+
+	wifi_mode = mode;
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_country(const wifi_country_t *country)
+{
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+	if (interface >= WIFI_IF_MAX || !conf)
+		return ESP_ERR_INVALID_ARG;
+
+	*conf = wifi_config[interface];
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+	return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+	if (!wifi_rx_queue) {
+		wifi_rx_queue = xQueueCreate(CONFIG_SIM_WIFI_RX_BUFFER_NUM,
+				sizeof(struct sim_wifi_frame));
+		assert(wifi_rx_queue);
+
+		assert(xTaskCreate(wifi_rx_task, "sim_wifi_rx",
+				CONFIG_ESP_DEFAULT_TASK_STACK_SIZE, NULL,
+				CONFIG_ESP_HOSTED_TASK_PRIORITY_HIGH, NULL) == pdTRUE);
+	}
+
+	station_connected = 1;
+	softap_started = 1;
+#if CONFIG_SIM_WIFI_LOOPBACK
+	ESP_LOGI(TAG, "started, mode %d, TX looped back as RX", wifi_mode);
+#else
+	ESP_LOGI(TAG, "started, mode %d, TX consumed", wifi_mode);
+#endif
+
+	return ESP_OK;
+}
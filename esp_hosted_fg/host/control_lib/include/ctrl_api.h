@@ -11,6 +11,7 @@
 
 #include <stdbool.h>
 #include "esp_hosted_config.pb-c.h"
+#include "esp_hosted_ctrl_batch.h"
 
 #define SUCCESS                              0
 #define FAILURE                              -1
@@ -30,6 +31,12 @@
 
 #define COUNTRY_CODE_LEN                     3
 
+/* BSS cache, fed by scan responses and streamed scan events */
+#define WIFI_BSS_CACHE_MAX_ENTRIES           64
+#define WIFI_BSS_CACHE_DEFAULT_TTL_MS        (30*1000)
+/* RSSI change (dB) after which cached BSS is reported in delta query */
+#define WIFI_BSS_CACHE_RSSI_DELTA            5
+
 /* If request is already being served and
  * another request is pending, time period for
  * which new request will wait in seconds
@@ -139,6 +146,9 @@ typedef enum {
 
 	CTRL_REQ_CUSTOM_RPC_UNSERIALISED_MSG = CTRL_MSG_ID__Req_Custom_RPC_Unserialised_Msg,
 
+	CTRL_REQ_GET_AP_SCAN_LIST_STREAM   = CTRL_MSG_ID__Req_GetAPScanListStream,
+	CTRL_REQ_BATCH                     = CTRL_MSG_ID__Req_Batch,
+
 	/*
 	 * Add new control path command response before Req_Max
 	 * and update Req_Max
@@ -186,6 +196,9 @@ typedef enum {
 	CTRL_RESP_GET_DHCP_DNS_STATUS       = CTRL_MSG_ID__Resp_GetDhcpDnsStatus,
 
 	CTRL_RESP_CUSTOM_RPC_UNSERIALISED_MSG = CTRL_MSG_ID__Resp_Custom_RPC_Unserialised_Msg,
+
+	CTRL_RESP_GET_AP_SCAN_LIST_STREAM  = CTRL_MSG_ID__Resp_GetAPScanListStream,
+	CTRL_RESP_BATCH                    = CTRL_MSG_ID__Resp_Batch,
 	/*
 	 * Add new control path command and response before Resp_Max
 	 * and update Resp_Max
@@ -209,6 +222,8 @@ typedef enum {
 		CTRL_MSG_ID__Event_SetDhcpDnsStatus,
 	CTRL_EVENT_CUSTOM_RPC_UNSERIALISED_MSG =
 		CTRL_MSG_ID__Event_Custom_RPC_Unserialised_Msg,
+	CTRL_EVENT_SCAN_RESULT =
+		CTRL_MSG_ID__Event_ScanResult,
 	/*
 	 * Add new control path command notification before Event_Max
 	 * and update Event_Max
@@ -342,6 +357,47 @@ typedef struct {
 	wifi_scanlist_t *out_list;
 } wifi_ap_scan_list_t;
 
+typedef struct {
+	/* Req: max APs per CTRL_EVENT_SCAN_RESULT event, 0 for default */
+	uint32_t max_per_event;
+	/* Resp: id carried by all events of this scan */
+	uint32_t scan_id;
+} wifi_ap_scan_stream_t;
+
+typedef struct {
+	uint32_t scan_id;
+	uint32_t seq_num;
+	int channel;
+	/* set in last event of the scan */
+	bool done;
+	int count;
+	/* dynamic size */
+	wifi_scanlist_t *out_list;
+} event_scan_result_t;
+
+typedef struct {
+	wifi_scanlist_t ap;
+	/* milliseconds since BSS was last reported by ESP */
+	uint32_t age_ms;
+	/* cache generation when this entry was last added, changed or removed */
+	uint32_t generation;
+	/* only in delta query: BSS aged out of cache after 'since' generation */
+	bool removed;
+} wifi_bss_cache_entry_t;
+
+typedef struct {
+	/* Req: sub requests, with msg_id and u filled, executed in order.
+	 * ctrl_resp_cb of sub requests is ignored */
+	struct Ctrl_cmd_t *reqs;
+	int count;
+	/* Req: do not execute sub requests after first failed one */
+	bool stop_on_failure;
+	/* Resp: one response per executed sub request, in order.
+	 * Allocated by lib, freed along with batch response */
+	struct Ctrl_cmd_t *resps;
+	int resp_count;
+} batch_req_t;
+
 typedef struct {
 	int count;
 	/* dynamic list*/
@@ -464,6 +520,7 @@ typedef struct Ctrl_cmd_t {
 		wifi_mode_t                 wifi_mode;
 
 		wifi_ap_scan_list_t         wifi_ap_scan;
+		wifi_ap_scan_stream_t       wifi_ap_scan_stream;
 		wifi_ap_config_t            wifi_ap_config;
 
 		softap_config_t             wifi_softap_config;
@@ -488,8 +545,10 @@ typedef struct Ctrl_cmd_t {
 		event_sta_disconn_t         e_sta_disconn;
 		event_softap_sta_conn_t     e_softap_sta_conn;
 		event_softap_sta_disconn_t  e_softap_sta_disconn;
+		event_scan_result_t         e_scan_result;
 		dhcp_dns_status_t           dhcp_dns_status;
 		custom_rpc_unserialised_data_t custom_rpc_unserialised_data;
+		batch_req_t                 batch;
 	}u;
 
 	/* By default this callback is set to NULL.
@@ -624,6 +683,45 @@ ctrl_cmd_t * wifi_get_power_save_mode(ctrl_cmd_t *req);
 /* Get list of available neighboring APs of ESP32 */
 ctrl_cmd_t * wifi_ap_scan_list(ctrl_cmd_t *req);
 
+/* Start streamed scan of neighboring APs. Response carries scan_id only.
+ * Scanned APs are delivered as CTRL_EVENT_SCAN_RESULT events, per channel,
+ * as soon as channel is scanned. Last event of the scan has `done` set.
+ * Results are also added to BSS cache, even if no event callback is set */
+ctrl_cmd_t * wifi_ap_scan_list_stream(ctrl_cmd_t *req);
+
+/* Set time to live of BSS cache entries, in milliseconds.
+ * BSS not reported by ESP within this time is removed from cache.
+ * Default is WIFI_BSS_CACHE_DEFAULT_TTL_MS */
+int wifi_bss_cache_set_ttl(uint32_t ttl_ms);
+
+/* Copy upto `max_entries` valid BSSs from cache into `out`
+ *
+ * Outputs:
+ * > generation - (optional) current cache generation, to be used
+ *                for next wifi_bss_cache_get_delta()
+ * Returns:
+ * > Number of entries copied, FAILURE on invalid argument
+ **/
+int wifi_bss_cache_get(wifi_bss_cache_entry_t *out, int max_entries,
+		uint32_t *generation);
+
+/* Copy upto `max_entries` BSSs added, changed or removed after cache
+ * generation `since`. Change is new SSID, channel, auth mode or
+ * RSSI change of at least WIFI_BSS_CACHE_RSSI_DELTA.
+ * Entries are copied in order of generation.
+ *
+ * Outputs:
+ * > generation - (optional) generation to pass as `since` in next query.
+ *                If `out` got full, it is generation of last copied entry
+ * Returns:
+ * > Number of entries copied, FAILURE on invalid argument
+ **/
+int wifi_bss_cache_get_delta(uint32_t since, wifi_bss_cache_entry_t *out,
+		int max_entries, uint32_t *generation);
+
+/* Remove all BSSs from cache */
+void wifi_bss_cache_flush(void);
+
 /* Get the AP config to which ESP32 station is connected */
 ctrl_cmd_t * wifi_get_ap_config(ctrl_cmd_t *req);
 
@@ -697,4 +795,26 @@ ctrl_cmd_t * set_dhcp_dns_status(ctrl_cmd_t *req);
 /* Send custom RPC unserialised message */
 ctrl_cmd_t * send_custom_rpc_unserialised_req_to_slave(ctrl_cmd_t *req);
 
+/* Enable or disable cache of slave state in control lib.
+ * While enabled, wifi_get_mac(), wifi_get_mode(), wifi_get_softap_config(),
+ * get_fw_version() and get_dhcp_dns_status() are answered from last successful
+ * response, without a round trip to ESP32, till an event or a set request
+ * which may change the value invalidates it.
+ * For async requests served from cache, the response callback is called
+ * before the API returns.
+ * Disabled by default. Enabling or disabling drops all cached values.
+ * Returns SUCCESS or FAILURE */
+int slave_state_cache_enable(bool enable);
+
+/* Drop all cached slave state. Next getters are sent to ESP32 */
+void slave_state_cache_flush(void);
+
+/* Send multiple requests to ESP32 in single round trip.
+ * Sub requests are executed by ESP32 in given order. Requests whose
+ * response carries lib allocated buffers (scan list, connected station list,
+ * custom RPC) and nested batch can not be part of batch.
+ * resp_event_status is FAILURE if any sub request could not be executed,
+ * status of each sub request is in its own response */
+ctrl_cmd_t * send_batch_req(ctrl_cmd_t *req);
+
 #endif
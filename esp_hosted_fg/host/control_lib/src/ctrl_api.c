@@ -80,6 +80,12 @@ ctrl_cmd_t * wifi_ap_scan_list(ctrl_cmd_t *req)
 	CTRL_DECODE_RESP_IF_NOT_ASYNC();
 }
 
+ctrl_cmd_t * wifi_ap_scan_list_stream(ctrl_cmd_t *req)
+{
+	CTRL_SEND_REQ(CTRL_REQ_GET_AP_SCAN_LIST_STREAM);
+	CTRL_DECODE_RESP_IF_NOT_ASYNC();
+}
+
 ctrl_cmd_t * wifi_get_ap_config(ctrl_cmd_t *req)
 {
 	CTRL_SEND_REQ(CTRL_REQ_GET_AP_CONFIG);
@@ -205,3 +211,9 @@ ctrl_cmd_t * send_custom_rpc_unserialised_req_to_slave(ctrl_cmd_t *req)
 	CTRL_SEND_REQ(CTRL_REQ_CUSTOM_RPC_UNSERIALISED_MSG);
 	CTRL_DECODE_RESP_IF_NOT_ASYNC();
 }
+
+ctrl_cmd_t * send_batch_req(ctrl_cmd_t *req)
+{
+	CTRL_SEND_REQ(CTRL_REQ_BATCH);
+	CTRL_DECODE_RESP_IF_NOT_ASYNC();
+}
@@ -78,11 +78,11 @@
         hosted_calloc(1, sizeof(TyPe));                                       \
     if (!req_payload) {                                                       \
         command_log("Failed to allocate memory for req.%s\n",#MsG_StRuCt);    \
-		failure_status = CTRL_ERR_MEMORY_FAILURE;                             \
+		*failure_status = CTRL_ERR_MEMORY_FAILURE;                            \
         goto fail_req;                                                        \
     }                                                                         \
-    req.MsG_StRuCt = req_payload;                                             \
-	buff_to_free1 = (uint8_t*)req_payload;
+    req->MsG_StRuCt = req_payload;                                            \
+	*buff_to_free1 = (uint8_t*)req_payload;
 
 struct ctrl_lib_context {
 	int state;
@@ -92,6 +92,10 @@ typedef void (*ctrl_rx_ind_t)(void);
 
 esp_queue_t* ctrl_msg_Q = NULL;
 static void * ctrl_rx_thread_handle;
+/* Async responses served from the state cache, see cached_resp_thread() */
+static esp_queue_t* cached_resp_Q = NULL;
+static void * cached_resp_sem;
+static void * cached_resp_thread_handle;
 static void * read_sem;
 static void * ctrl_req_sem;
 static void * async_timer_handle;
@@ -100,6 +104,10 @@ static struct ctrl_lib_context ctrl_lib_ctxt;
 static int call_event_callback(ctrl_cmd_t *app_event);
 static int is_async_resp_callback_registered_by_resp_msg_id(int resp_msg_id);
 static int call_async_resp_callback(ctrl_cmd_t *app_resp);
+static void bss_cache_update(wifi_scanlist_t *list, int count);
+static uint32_t state_cache_fields_changed_by_event(int event);
+static void state_cache_invalidate(uint32_t fields);
+static void state_cache_update(ctrl_cmd_t *app_resp);
 
 /* uid to link between requests and responses
  * uids are incrementing values from 1 onwards. */
@@ -134,6 +142,60 @@ static ctrl_resp_cb_t ctrl_resp_cb_table [CTRL_RESP_MAX - CTRL_RESP_BASE] = { NU
  */
 static ctrl_event_cb_t ctrl_event_cb_table[CTRL_EVENT_MAX - CTRL_EVENT_BASE] = { NULL };
 
+/* BSS cache
+ * Every AP reported in scan response or streamed scan event is cached here
+ * with time it was last seen. Entries not seen for `bss_cache_ttl_ms` are
+ * aged out. Each add, change or removal bumps cache generation, which lets
+ * application ask only for BSSs changed since its last query.
+ * Aged out entries are retained as removed, till their slot is reused.
+ */
+struct bss_cache_entry {
+	wifi_scanlist_t ap;
+	uint32_t last_seen_ms;
+	uint32_t generation;
+	/* RSSI when entry was last reported as changed */
+	int reported_rssi;
+	uint8_t in_use;
+	uint8_t removed;
+};
+
+static struct bss_cache_entry bss_cache[WIFI_BSS_CACHE_MAX_ENTRIES];
+static uint32_t bss_cache_generation;
+static uint32_t bss_cache_ttl_ms = WIFI_BSS_CACHE_DEFAULT_TTL_MS;
+static void * bss_cache_sem;
+
+/* Cache of slave state
+ * Opt-in, using slave_state_cache_enable(). While enabled, getters of
+ * rarely changing slave state are served from here without a round trip
+ * to ESP, as long as the field is valid.
+ * Fields are filled from successful get responses and invalidated by
+ * events and by the set requests which may change them.
+ */
+enum {
+	STATE_CACHE_STA_MAC,
+	STATE_CACHE_SOFTAP_MAC,
+	STATE_CACHE_WIFI_MODE,
+	STATE_CACHE_SOFTAP_CONFIG,
+	STATE_CACHE_FW_VERSION,
+	STATE_CACHE_DHCP_DNS_STATUS,
+	STATE_CACHE_MAX,
+};
+
+#define STATE_CACHE_BIT(field)       (1UL << (field))
+#define STATE_CACHE_ALL              (STATE_CACHE_BIT(STATE_CACHE_MAX) - 1)
+
+struct state_cache {
+	uint8_t enabled;
+	uint32_t valid;
+	/* field to be filled from response of in-flight get, -1 if none */
+	int pending;
+	int pending_resp_id;
+	ctrl_cmd_t resp[STATE_CACHE_MAX];
+};
+
+static struct state_cache state_cache = { .pending = -1 };
+static void * state_cache_sem;
+
 /* Open serial interface
  * This function may fail if the ESP32 kernel module is not loaded
  **/
@@ -315,6 +377,49 @@ static int ctrl_app_parse_event(CtrlMsg *ctrl_msg, ctrl_cmd_t *app_ntfy)
 						ctrl_msg->event_set_dhcp_dns_status->dns_ip.len);
 			}
 			break;
+		} case CTRL_EVENT_SCAN_RESULT: {
+			CtrlMsgEventScanResult *rp = ctrl_msg->event_scan_result;
+			event_scan_result_t *ev = &app_ntfy->u.e_scan_result;
+			wifi_scanlist_t *list = NULL;
+			uint16_t i = 0;
+
+			CHECK_CTRL_MSG_NON_NULL(event_scan_result);
+			app_ntfy->resp_event_status = rp->resp;
+
+			ev->scan_id = rp->scan_id;
+			ev->seq_num = rp->seq_num;
+			ev->channel = rp->chnl;
+			ev->done = rp->done;
+
+			if (rp->n_entries) {
+				list = (wifi_scanlist_t *)hosted_calloc(rp->n_entries,
+						sizeof(wifi_scanlist_t));
+				CHECK_CTRL_MSG_NON_NULL_VAL(list, "Malloc Failed");
+			}
+
+			for (i=0; i<rp->n_entries; i++) {
+
+				if (rp->entries[i]->ssid.len)
+					memcpy(list[i].ssid, (char *)rp->entries[i]->ssid.data,
+						min(rp->entries[i]->ssid.len, SSID_LENGTH-1));
+
+				if (rp->entries[i]->bssid.len)
+					memcpy(list[i].bssid, (char *)rp->entries[i]->bssid.data,
+						min(rp->entries[i]->bssid.len, BSSID_STR_SIZE-1));
+
+				list[i].channel = rp->entries[i]->chnl;
+				list[i].rssi = rp->entries[i]->rssi;
+				list[i].encryption_mode = rp->entries[i]->sec_prot;
+			}
+			ev->count = rp->n_entries;
+			ev->out_list = list;
+
+			bss_cache_update(list, ev->count);
+
+			/* Note allocation, to be freed later by app */
+			app_ntfy->free_buffer_func = hosted_free;
+			app_ntfy->free_buffer_handle = list;
+			break;
 		} case CTRL_EVENT_CUSTOM_RPC_UNSERIALISED_MSG: {
 			CHECK_CTRL_MSG_NON_NULL(event_custom_rpc_unserialised_msg);
 			app_ntfy->resp_event_status = ctrl_msg->event_custom_rpc_unserialised_msg->resp;
@@ -361,33 +466,30 @@ fail_parse_ctrl_msg:
 	return FAILURE;
 }
 
-/* This will copy control response from `CtrlMsg` into
+/* Requests whose response carries buffers allocated by lib
+ * are not allowed as batch sub requests */
+static int is_batch_sub_req_allowed(int req_msg_id)
+{
+	switch (req_msg_id) {
+		case CTRL_REQ_GET_AP_SCAN_LIST:
+		case CTRL_REQ_GET_SOFTAP_CONN_STA_LIST:
+		case CTRL_REQ_CUSTOM_RPC_UNSERIALISED_MSG:
+		case CTRL_REQ_BATCH:
+			return 0;
+		default:
+			return 1;
+	}
+}
+
+/* This will copy payload of control response `CtrlMsg` into
  * application structure `ctrl_cmd_t`
- * This function is called after protobuf decoding is successful
+ * `ctrl_msg` is not freed here, as batch sub responses
+ * are owned by the batch response
  **/
-static int ctrl_app_parse_resp(CtrlMsg *ctrl_msg, ctrl_cmd_t *app_resp)
+static int ctrl_app_parse_resp_payload(CtrlMsg *ctrl_msg, ctrl_cmd_t *app_resp)
 {
 	uint16_t i = 0;
 
-	/* 1. Check non NULL */
-	if (!ctrl_msg || !app_resp) {
-		command_log("NULL Ctrl resp or NULL App Resp\n");
-		goto fail_parse_ctrl_msg2;
-	}
-
-	/* 2. update basic fields */
-	app_resp->msg_type = CTRL_RESP;
-	app_resp->msg_id = ctrl_msg->msg_id;
-	app_resp->uid = ctrl_msg->uid;
-	app_resp->resp_event_status = FAILURE;
-	/* if app_resp->uid is 0, slave fw is not updated to return uid
-	 * so we skip this check */
-	if (app_resp->uid && (expected_resp_uid != app_resp->uid)) {
-		// response uid mismatch: ignore this response
-		goto fail_parse_ctrl_msg2;
-	}
-
-	/* 3. parse CtrlMsg into ctrl_cmd_t */
 	switch (ctrl_msg->msg_id) {
 		case CTRL_RESP_GET_MAC_ADDR : {
 			uint8_t len_l = min(ctrl_msg->resp_get_mac_address->mac.len, MAX_MAC_STR_SIZE-1);
@@ -449,10 +551,18 @@ static int ctrl_app_parse_resp(CtrlMsg *ctrl_msg, ctrl_cmd_t *app_resp)
 			}
 
 			ap->out_list = list;
+			bss_cache_update(list, ap->count);
+
 			/* Note allocation, to be freed later by app */
 			app_resp->free_buffer_func = hosted_free;
 			app_resp->free_buffer_handle = list;
 			break;
+		} case CTRL_RESP_GET_AP_SCAN_LIST_STREAM : {
+			CHECK_CTRL_MSG_NON_NULL(resp_scan_ap_list_stream);
+			CHECK_CTRL_MSG_FAILED(resp_scan_ap_list_stream);
+			app_resp->u.wifi_ap_scan_stream.scan_id =
+				ctrl_msg->resp_scan_ap_list_stream->scan_id;
+			break;
 		} case CTRL_RESP_GET_AP_CONFIG : {
 			CHECK_CTRL_MSG_NON_NULL(resp_get_ap_config);
 			wifi_ap_config_t *p = &app_resp->u.wifi_ap_config;
@@ -779,6 +889,40 @@ static int ctrl_app_parse_resp(CtrlMsg *ctrl_msg, ctrl_cmd_t *app_resp)
 				app_resp->free_buffer_handle = p_a->data;
 			}
 			break;
+		} case CTRL_RESP_BATCH: {
+			CtrlMsgRespBatch *p_c = ctrl_msg->resp_batch;
+			batch_req_t *p_a = &app_resp->u.batch;
+			ctrl_cmd_t *resps = NULL;
+
+			CHECK_CTRL_MSG_NON_NULL(resp_batch);
+
+			if (p_c->n_resps) {
+				resps = (ctrl_cmd_t *)hosted_calloc(p_c->n_resps,
+						sizeof(ctrl_cmd_t));
+				CHECK_CTRL_MSG_NON_NULL_VAL(resps, "Malloc Failed");
+				app_resp->free_buffer_func = hosted_free;
+				app_resp->free_buffer_handle = resps;
+			}
+
+			for (i=0; i<p_c->n_resps; i++) {
+				resps[i].msg_type = CTRL_RESP;
+				resps[i].msg_id = p_c->resps[i]->msg_id;
+				resps[i].uid = p_c->resps[i]->uid;
+				resps[i].resp_event_status = FAILURE;
+				if (!is_batch_sub_req_allowed(p_c->resps[i]->msg_id -
+						CTRL_RESP_BASE + CTRL_REQ_BASE)) {
+					command_log("Unexpected batch sub resp[%u]\n",
+							p_c->resps[i]->msg_id);
+					continue;
+				}
+				ctrl_app_parse_resp_payload(p_c->resps[i], &resps[i]);
+			}
+			p_a->resps = resps;
+			p_a->resp_count = p_c->n_resps;
+
+			/* sub responses are kept even if some sub request failed */
+			CHECK_CTRL_MSG_FAILED(resp_batch);
+			break;
 		} default: {
 			command_log("Unsupported Control Resp[%u]\n", ctrl_msg->msg_id);
 			goto fail_parse_ctrl_msg;
@@ -786,19 +930,45 @@ static int ctrl_app_parse_resp(CtrlMsg *ctrl_msg, ctrl_cmd_t *app_resp)
 		}
 	}
 
-	/* 4. Free up buffers */
-	ctrl_msg__free_unpacked(ctrl_msg, NULL);
-	ctrl_msg = NULL;
-	expected_resp_uid = -1;
 	return SUCCESS;
 
-	/* 5. Free up buffers in failure cases */
 fail_parse_ctrl_msg:
+	return FAILURE;
+}
+
+/* This will copy control response from `CtrlMsg` into
+ * application structure `ctrl_cmd_t`
+ * This function is called after protobuf decoding is successful
+ **/
+static int ctrl_app_parse_resp(CtrlMsg *ctrl_msg, ctrl_cmd_t *app_resp)
+{
+	/* 1. Check non NULL */
+	if (!ctrl_msg || !app_resp) {
+		command_log("NULL Ctrl resp or NULL App Resp\n");
+		goto fail_parse_ctrl_msg2;
+	}
+
+	/* 2. update basic fields */
+	app_resp->msg_type = CTRL_RESP;
+	app_resp->msg_id = ctrl_msg->msg_id;
+	app_resp->uid = ctrl_msg->uid;
+	app_resp->resp_event_status = FAILURE;
+	/* if app_resp->uid is 0, slave fw is not updated to return uid
+	 * so we skip this check */
+	if (app_resp->uid && (expected_resp_uid != app_resp->uid)) {
+		// response uid mismatch: ignore this response
+		goto fail_parse_ctrl_msg2;
+	}
+
+	/* 3. parse CtrlMsg into ctrl_cmd_t
+	 * Failure in parsing is conveyed in resp_event_status */
+	ctrl_app_parse_resp_payload(ctrl_msg, app_resp);
+
+	/* 4. Free up buffers */
 	ctrl_msg__free_unpacked(ctrl_msg, NULL);
 	ctrl_msg = NULL;
 	expected_resp_uid = -1;
 	return SUCCESS;
-	/* intended fall-through */
 
 fail_parse_ctrl_msg2:
 	ctrl_msg__free_unpacked(ctrl_msg, NULL);
@@ -851,10 +1021,17 @@ static int process_ctrl_rx_msg(CtrlMsg * proto_msg, ctrl_rx_ind_t ctrl_rx_func)
 	if (proto_msg->msg_type == CTRL_MSG_TYPE__Event) {
 		/* Events are handled only asynchronously */
 
+		/* Drop cached slave state changed by this event,
+		 * irrespective of event subscription */
+		state_cache_invalidate(
+				state_cache_fields_changed_by_event(proto_msg->msg_id));
+
 		/* check if callback is available.
-		 * if not, silently drop the msg */
-		if (CALLBACK_AVAILABLE ==
-				is_event_callback_registered(proto_msg->msg_id)) {
+		 * if not, silently drop the msg.
+		 * Scan results are always parsed, to keep BSS cache updated */
+		if ((CALLBACK_AVAILABLE ==
+				is_event_callback_registered(proto_msg->msg_id)) ||
+		    (proto_msg->msg_id == CTRL_MSG_ID__Event_ScanResult)) {
 			/* if event callback is registered, we need to
 			 * parse the event into app structs and
 			 * call the registered callback function
@@ -873,7 +1050,12 @@ static int process_ctrl_rx_msg(CtrlMsg * proto_msg, ctrl_rx_ind_t ctrl_rx_func)
 			ctrl_app_parse_event(proto_msg, app_event);
 
 			/* callback to registered function */
-			call_event_callback(app_event);
+			if (CALLBACK_AVAILABLE ==
+					is_event_callback_registered(app_event->msg_id)) {
+				call_event_callback(app_event);
+			} else {
+				CLEANUP_APP_MSG(app_event);
+			}
 
 			//CLEANUP_APP_MSG(app_event);
 		} else {
@@ -907,6 +1089,7 @@ static int process_ctrl_rx_msg(CtrlMsg * proto_msg, ctrl_rx_ind_t ctrl_rx_func)
 		/* Decode protobuf buffer of response and
 		 * copy into app structures */
 		ctrl_app_parse_resp(proto_msg, app_resp);
+		state_cache_update(app_resp);
 
 		/* Is callback is available,
 		 * progress as async response */
@@ -1340,62 +1523,19 @@ static void ctrl_async_timeout_handler(void const *arg)
 	hosted_post_semaphore(ctrl_req_sem);
 }
 
-/* This is entry level function when control request APIs are used
- * This function will encode control request in protobuf and send to ESP32
- * It will copy application structure `ctrl_cmd_t` to
- * protobuf control req `CtrlMsg`
+/* Compose protobuf control req `CtrlMsg` from application
+ * structure `ctrl_cmd_t`
+ * Buffers allocated for payload are returned in buff_to_free1 and
+ * buff_to_free2, to be freed by caller once the msg is packed
  **/
-int ctrl_app_send_req(ctrl_cmd_t *app_req)
+static int ctrl_app_compose_req(ctrl_cmd_t *app_req, CtrlMsg *req,
+		uint8_t **buff_to_free1, void **buff_to_free2, uint8_t *failure_status)
 {
-	int       ret = SUCCESS;
-	CtrlMsg   req = {0};
-	uint32_t  tx_len = 0;
-	uint8_t  *tx_data = NULL;
-	uint8_t  *buff_to_free1 = NULL;
-	void     *buff_to_free2 = NULL;
-	uint8_t   failure_status = 0;
-	uint8_t   got_ctrl_req_sem = 0;
-
-	if (!app_req) {
-		failure_status = CTRL_ERR_INCORRECT_ARG;
-		command_log("Invalid request pointer\n");
-		goto fail_req;
-	}
-
-	/* 1. Check if any ongoing request present
-	 * Send failure in that case */
-	ret = hosted_get_semaphore(ctrl_req_sem, WAIT_TIME_B2B_CTRL_REQ);
-	if (ret) {
-		failure_status = CTRL_ERR_REQ_IN_PROG;
-		command_log("Request already in progress\n");
-		goto fail_req;
-	} else {
-		got_ctrl_req_sem = 1;
-	}
-
-	app_req->msg_type = CTRL_REQ;
-
-	// handle rollover in uid value (range: 1 to INT32_MAX)
-	if (uid < INT32_MAX)
-		uid++;
-	else
-		uid = 1;
-	app_req->uid = uid;
-
-	/* 2. Protobuf msg init */
-	ctrl_msg__init(&req);
-
-	req.msg_id = app_req->msg_id;
+	req->msg_id = app_req->msg_id;
 	/* payload case is exact match to msg id in esp_hosted_config.pb-c.h */
-	req.payload_case = (CtrlMsg__PayloadCase) app_req->msg_id;
+	req->payload_case = (CtrlMsg__PayloadCase) app_req->msg_id;
 
-	req.uid = app_req->uid;
-	assert(expected_resp_uid == -1);
-	// set the expected response uid
-	expected_resp_uid = req.uid;
-
-	/* 3. identify request and compose CtrlMsg */
-	switch(req.msg_id) {
+	switch(req->msg_id) {
 		case CTRL_REQ_GET_WIFI_MODE:
 		case CTRL_REQ_GET_AP_CONFIG:
 		case CTRL_REQ_DISCONNECT_AP:
@@ -1415,13 +1555,18 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			if (app_req->cmd_timeout_sec < DEFAULT_CTRL_RESP_AP_SCAN_TIMEOUT)
 				app_req->cmd_timeout_sec = DEFAULT_CTRL_RESP_AP_SCAN_TIMEOUT;
 			break;
+		} case CTRL_REQ_GET_AP_SCAN_LIST_STREAM: {
+			CTRL_ALLOC_ASSIGN(CtrlMsgReqScanListStream, req_scan_ap_list_stream);
+			ctrl_msg__req__scan_list_stream__init(req_payload);
+			req_payload->max_per_event = app_req->u.wifi_ap_scan_stream.max_per_event;
+			break;
 		} case CTRL_REQ_GET_MAC_ADDR: {
 			CTRL_ALLOC_ASSIGN(CtrlMsgReqGetMacAddress, req_get_mac_address);
 
 			if ((app_req->u.wifi_mac.mode <= WIFI_MODE_NONE) ||
 			    (app_req->u.wifi_mac.mode >= WIFI_MODE_APSTA)) {
 				command_log("Invalid parameter\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 			ctrl_msg__req__get_mac_address__init(req_payload);
@@ -1437,7 +1582,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			    (!strlen(p->mac)) ||
 			    (strlen(p->mac) > MAX_MAC_STR_SIZE)) {
 				command_log("Invalid parameter\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 			ctrl_msg__req__set_mac_address__init(req_payload);
@@ -1453,7 +1598,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 
 			if ((p->mode < WIFI_MODE_NONE) || (p->mode >= WIFI_MODE_MAX)) {
 				command_log("Invalid wifi mode\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 			ctrl_msg__req__set_mode__init(req_payload);
@@ -1469,19 +1614,19 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			if ((strlen((char *)p->ssid) > MAX_SSID_LENGTH) ||
 					(!strlen((char *)p->ssid))) {
 				command_log("Invalid SSID length\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
 			if (strlen((char *)p->pwd) > MAX_PWD_LENGTH) {
 				command_log("Invalid password length\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
 			if (strlen((char *)p->bssid) > MAX_MAC_STR_SIZE) {
 				command_log("Invalid BSSID length\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 			ctrl_msg__req__connect_ap__init(req_payload);
@@ -1503,19 +1648,19 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			if ((p->type > WIFI_VND_IE_TYPE_ASSOC_RESP) ||
 			    (p->type < WIFI_VND_IE_TYPE_BEACON)) {
 				command_log("Invalid vendor ie type \n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
 			if ((p->idx > WIFI_VND_IE_ID_1) || (p->idx < WIFI_VND_IE_ID_0)) {
 				command_log("Invalid vendor ie ID index \n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
 			if (!p->vnd_ie.payload) {
 				command_log("Invalid vendor IE buffer \n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 			ctrl_msg__req__set_soft_apvendor_specific_ie__init(req_payload);
@@ -1530,7 +1675,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 				command_log("Mem alloc fail\n");
 				goto fail_req;
 			}
-			buff_to_free2 = req_payload->vendor_ie_data;
+			*buff_to_free2 = req_payload->vendor_ie_data;
 
 			ctrl_msg__req__vendor_iedata__init(req_payload->vendor_ie_data);
 
@@ -1549,7 +1694,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			if ((strlen((char *)&p->ssid) > MAX_SSID_LENGTH) ||
 			    (!strlen((char *)&p->ssid))) {
 				command_log("Invalid SSID length\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
@@ -1557,7 +1702,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			    ((p->encryption_mode != WIFI_AUTH_OPEN) &&
 			     (strlen((char *)&p->pwd) < MIN_PWD_LENGTH))) {
 				command_log("Invalid password length\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
@@ -1566,21 +1711,21 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			    (p->encryption_mode > WIFI_AUTH_WPA_WPA2_PSK)) {
 
 				command_log("Asked Encryption mode not supported\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
 			if ((p->max_connections < MIN_CONN_NO) ||
 			    (p->max_connections > MAX_CONN_NO)) {
 				command_log("Invalid maximum connection number\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
 			if ((p->bandwidth < WIFI_BW_HT20) ||
 			    (p->bandwidth > WIFI_BW_HT40)) {
 				command_log("Invalid bandwidth\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 			ctrl_msg__req__start_soft_ap__init(req_payload);
@@ -1602,7 +1747,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			if ((p->ps_mode < WIFI_PS_NONE) ||
 			    (p->ps_mode >= WIFI_PS_INVALID)) {
 				command_log("Invalid power save mode\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 			ctrl_msg__req__set_mode__init(req_payload);
@@ -1615,7 +1760,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 
 			if (!p->ota_data || (p->ota_data_len == 0)) {
 				command_log("Invalid parameter\n");
-				failure_status = CTRL_ERR_INCORRECT_ARG;
+				*failure_status = CTRL_ERR_INCORRECT_ARG;
 				goto fail_req;
 			}
 
@@ -1693,13 +1838,432 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 			}
             break;
         } default: {
-            failure_status = CTRL_ERR_UNSUPPORTED_MSG;
-            command_log("RPC Req[%u] unsupported\n",req.msg_id);
+            *failure_status = CTRL_ERR_UNSUPPORTED_MSG;
+            command_log("RPC Req[%u] unsupported\n",req->msg_id);
             goto fail_req;
             break;
         }
 	}
 
+	return SUCCESS;
+
+fail_req:
+	return FAILURE;
+}
+
+/* Buffers allocated to compose batch request.
+ * Freed after the request is packed */
+struct ctrl_batch_bufs {
+	CtrlMsgReqBatch batch;
+	int count;
+	CtrlMsg *msgs;
+	CtrlMsg **msg_ptrs;
+	uint8_t **buff_to_free1;
+	void **buff_to_free2;
+};
+
+static void ctrl_batch_bufs_free(struct ctrl_batch_bufs *bufs)
+{
+	int i = 0;
+
+	if (!bufs)
+		return;
+
+	for (i=0; i<bufs->count; i++) {
+		mem_free(bufs->buff_to_free2[i]);
+		mem_free(bufs->buff_to_free1[i]);
+	}
+	mem_free(bufs->buff_to_free2);
+	mem_free(bufs->buff_to_free1);
+	mem_free(bufs->msg_ptrs);
+	mem_free(bufs->msgs);
+	mem_free(bufs);
+}
+
+/* Compose batch request, each sub request as it would have been
+ * composed when sent alone. Response timeout of batch is extended
+ * to cover timeouts of all sub requests */
+static int ctrl_app_compose_batch_req(ctrl_cmd_t *app_req, CtrlMsg *req,
+		struct ctrl_batch_bufs **bufs_out, uint8_t *failure_status)
+{
+	batch_req_t *p = &app_req->u.batch;
+	struct ctrl_batch_bufs *bufs = NULL;
+	ctrl_cmd_t *sub = NULL;
+	int timeout_sec = 0;
+	int i = 0;
+
+	if (!p->reqs || (p->count <= 0) || (p->count > CTRL_BATCH_MAX_REQS)) {
+		command_log("Invalid batch of %d requests\n", p->count);
+		*failure_status = CTRL_ERR_INCORRECT_ARG;
+		return FAILURE;
+	}
+
+	bufs = (struct ctrl_batch_bufs *)hosted_calloc(1, sizeof(struct ctrl_batch_bufs));
+	if (!bufs) {
+		command_log("Failed to allocate memory for batch\n");
+		*failure_status = CTRL_ERR_MEMORY_FAILURE;
+		return FAILURE;
+	}
+	*bufs_out = bufs;
+
+	bufs->msgs = (CtrlMsg *)hosted_calloc(p->count, sizeof(CtrlMsg));
+	bufs->msg_ptrs = (CtrlMsg **)hosted_calloc(p->count, sizeof(CtrlMsg *));
+	bufs->buff_to_free1 = (uint8_t **)hosted_calloc(p->count, sizeof(uint8_t *));
+	bufs->buff_to_free2 = (void **)hosted_calloc(p->count, sizeof(void *));
+	if (!bufs->msgs || !bufs->msg_ptrs ||
+	    !bufs->buff_to_free1 || !bufs->buff_to_free2) {
+		command_log("Failed to allocate memory for batch\n");
+		*failure_status = CTRL_ERR_MEMORY_FAILURE;
+		return FAILURE;
+	}
+
+	for (i=0; i<p->count; i++) {
+		sub = &p->reqs[i];
+
+		if (!is_batch_sub_req_allowed(sub->msg_id)) {
+			command_log("Req[%u] not allowed in batch\n", sub->msg_id);
+			*failure_status = CTRL_ERR_INCORRECT_ARG;
+			return FAILURE;
+		}
+
+		sub->msg_type = CTRL_REQ;
+		sub->uid = app_req->uid;
+
+		ctrl_msg__init(&bufs->msgs[i]);
+		bufs->msgs[i].uid = sub->uid;
+		/* count is bumped before compose, so that buffers of
+		 * partially composed sub request are freed too */
+		bufs->count++;
+		if (ctrl_app_compose_req(sub, &bufs->msgs[i], &bufs->buff_to_free1[i],
+				&bufs->buff_to_free2[i], failure_status)) {
+			command_log("Batch sub req[%d] id[%u] invalid\n", i, sub->msg_id);
+			return FAILURE;
+		}
+		bufs->msg_ptrs[i] = &bufs->msgs[i];
+
+		timeout_sec += sub->cmd_timeout_sec ?
+			sub->cmd_timeout_sec : DEFAULT_CTRL_RESP_TIMEOUT;
+	}
+
+	if (app_req->cmd_timeout_sec < timeout_sec)
+		app_req->cmd_timeout_sec = timeout_sec;
+
+	ctrl_msg__req__batch__init(&bufs->batch);
+	bufs->batch.n_reqs = p->count;
+	bufs->batch.reqs = bufs->msg_ptrs;
+	bufs->batch.stop_on_failure = p->stop_on_failure;
+
+	req->msg_id = app_req->msg_id;
+	req->payload_case = CTRL_MSG__PAYLOAD_REQ_BATCH;
+	req->req_batch = &bufs->batch;
+	return SUCCESS;
+}
+
+/* Cache field which serves the get request, -1 if request is not cached */
+static int state_cache_field(ctrl_cmd_t *app_req)
+{
+	switch (app_req->msg_id) {
+		case CTRL_REQ_GET_MAC_ADDR:
+			if (app_req->u.wifi_mac.mode == WIFI_MODE_STA)
+				return STATE_CACHE_STA_MAC;
+			if (app_req->u.wifi_mac.mode == WIFI_MODE_AP)
+				return STATE_CACHE_SOFTAP_MAC;
+			return -1;
+		case CTRL_REQ_GET_WIFI_MODE:
+			return STATE_CACHE_WIFI_MODE;
+		case CTRL_REQ_GET_SOFTAP_CONFIG:
+			return STATE_CACHE_SOFTAP_CONFIG;
+		case CTRL_REQ_GET_FW_VERSION:
+			return STATE_CACHE_FW_VERSION;
+		case CTRL_REQ_GET_DHCP_DNS_STATUS:
+			return STATE_CACHE_DHCP_DNS_STATUS;
+		default:
+			return -1;
+	}
+}
+
+/* Cache fields which the request may change on ESP */
+static uint32_t state_cache_fields_changed_by_req(ctrl_cmd_t *app_req)
+{
+	switch (app_req->msg_id) {
+		case CTRL_REQ_SET_MAC_ADDR:
+			if (app_req->u.wifi_mac.mode == WIFI_MODE_AP)
+				return STATE_CACHE_BIT(STATE_CACHE_SOFTAP_MAC);
+			return STATE_CACHE_BIT(STATE_CACHE_STA_MAC);
+		case CTRL_REQ_SET_WIFI_MODE:
+		case CTRL_REQ_START_SOFTAP:
+		case CTRL_REQ_STOP_SOFTAP:
+			return STATE_CACHE_BIT(STATE_CACHE_WIFI_MODE) |
+				STATE_CACHE_BIT(STATE_CACHE_SOFTAP_CONFIG);
+		case CTRL_REQ_CONNECT_AP:
+		case CTRL_REQ_DISCONNECT_AP:
+			return STATE_CACHE_BIT(STATE_CACHE_WIFI_MODE) |
+				STATE_CACHE_BIT(STATE_CACHE_DHCP_DNS_STATUS);
+		case CTRL_REQ_SET_COUNTRY_CODE:
+			return STATE_CACHE_BIT(STATE_CACHE_SOFTAP_CONFIG);
+		case CTRL_REQ_SET_DHCP_DNS_STATUS:
+			return STATE_CACHE_BIT(STATE_CACHE_DHCP_DNS_STATUS);
+		case CTRL_REQ_OTA_END:
+		case CTRL_REQ_ENABLE_DISABLE:
+		case CTRL_REQ_CUSTOM_RPC_UNSERIALISED_MSG:
+		case CTRL_REQ_BATCH:
+			return STATE_CACHE_ALL;
+		default:
+			return 0;
+	}
+}
+
+/* Cache fields which may have changed on ESP, as notified by event */
+static uint32_t state_cache_fields_changed_by_event(int event)
+{
+	switch (event) {
+		case CTRL_EVENT_ESP_INIT:
+			return STATE_CACHE_ALL;
+		case CTRL_EVENT_STATION_CONNECTED_TO_AP:
+		case CTRL_EVENT_STATION_DISCONNECT_FROM_AP:
+		case CTRL_EVENT_DHCP_DNS_STATUS:
+			return STATE_CACHE_BIT(STATE_CACHE_DHCP_DNS_STATUS);
+		case CTRL_EVENT_STATION_CONNECTED_TO_ESP_SOFTAP:
+		case CTRL_EVENT_STATION_DISCONNECT_FROM_ESP_SOFTAP:
+			return STATE_CACHE_BIT(STATE_CACHE_SOFTAP_CONFIG);
+		default:
+			return 0;
+	}
+}
+
+static void state_cache_invalidate(uint32_t fields)
+{
+	if (!fields || !state_cache_sem)
+		return;
+
+	hosted_get_semaphore(state_cache_sem, HOSTED_SEM_BLOCKING);
+	state_cache.valid &= ~fields;
+	/* response of in-flight get may already be stale */
+	if ((state_cache.pending >= 0) &&
+	    (fields & STATE_CACHE_BIT(state_cache.pending)))
+		state_cache.pending = -1;
+	hosted_post_semaphore(state_cache_sem);
+}
+
+/* Fill cache field from successful response of in-flight get request */
+static void state_cache_update(ctrl_cmd_t *app_resp)
+{
+	ctrl_cmd_t *entry = NULL;
+
+	if (!app_resp || !state_cache_sem)
+		return;
+
+	hosted_get_semaphore(state_cache_sem, HOSTED_SEM_BLOCKING);
+	if (state_cache.enabled && (state_cache.pending >= 0) &&
+	    (app_resp->msg_id == state_cache.pending_resp_id) &&
+	    (app_resp->resp_event_status == SUCCESS)) {
+		entry = &state_cache.resp[state_cache.pending];
+		memcpy(entry, app_resp, sizeof(ctrl_cmd_t));
+		entry->ctrl_resp_cb = NULL;
+		entry->free_buffer_handle = NULL;
+		entry->free_buffer_func = NULL;
+		state_cache.valid |= STATE_CACHE_BIT(state_cache.pending);
+	}
+	state_cache.pending = -1;
+	hosted_post_semaphore(state_cache_sem);
+}
+
+/* Called with ctrl_req_sem held, before request is sent
+ * 1. Invalidates fields the request may change
+ * 2. If request is a getter with valid cache field, returns a copy of the
+ *    cached response, to be delivered by deliver_cached_resp() once
+ *    ctrl_req_sem is released
+ * 3. Otherwise, notes the field to be filled from the response and
+ *    returns NULL
+ **/
+static ctrl_cmd_t *state_cache_serve_req(ctrl_cmd_t *app_req)
+{
+	ctrl_cmd_t *app_resp = NULL;
+	int field = -1;
+
+	if (!state_cache_sem)
+		return NULL;
+
+	hosted_get_semaphore(state_cache_sem, HOSTED_SEM_BLOCKING);
+	state_cache.valid &= ~state_cache_fields_changed_by_req(app_req);
+	state_cache.pending = -1;
+
+	field = state_cache_field(app_req);
+	if (!state_cache.enabled || (field < 0)) {
+		hosted_post_semaphore(state_cache_sem);
+		return NULL;
+	}
+
+	if (!(state_cache.valid & STATE_CACHE_BIT(field))) {
+		state_cache.pending = field;
+		state_cache.pending_resp_id = app_req->msg_id - CTRL_REQ_BASE + CTRL_RESP_BASE;
+		hosted_post_semaphore(state_cache_sem);
+		return NULL;
+	}
+
+	app_resp = (ctrl_cmd_t *)hosted_malloc(sizeof(ctrl_cmd_t));
+	if (!app_resp) {
+		hosted_post_semaphore(state_cache_sem);
+		return NULL;
+	}
+	memcpy(app_resp, &state_cache.resp[field], sizeof(ctrl_cmd_t));
+	hosted_post_semaphore(state_cache_sem);
+
+	app_resp->uid = app_req->uid;
+	return app_resp;
+}
+
+/* Hands a response served from the state cache to the application the way
+ * a response from ESP is handed over: async requests get it through their
+ * callback from cached_resp_thread(), sync ones through ctrl_msg_Q.
+ * Called after ctrl_req_sem is released, so the application may send the
+ * next request right from its callback. */
+static int deliver_cached_resp(ctrl_cmd_t *app_req, ctrl_cmd_t *app_resp)
+{
+	esp_queue_elem_t *elem = NULL;
+	esp_queue_t *q = app_req->ctrl_resp_cb ? cached_resp_Q : ctrl_msg_Q;
+
+	elem = (esp_queue_elem_t*)hosted_malloc(sizeof(esp_queue_elem_t));
+	if (!elem)
+		goto fail;
+
+	elem->buf = app_resp;
+	elem->buf_len = sizeof(ctrl_cmd_t);
+	if (esp_queue_put(q, (void*)elem))
+		goto fail;
+
+	if (app_req->ctrl_resp_cb)
+		hosted_post_semaphore(cached_resp_sem);
+	else
+		ctrl_rx_ind();
+
+	return SUCCESS;
+
+fail:
+	mem_free(elem);
+	mem_free(app_resp);
+	return FAILURE;
+}
+
+/* Calls async callbacks of responses served from the state cache, off the
+ * request path like ctrl_rx_thread() does for responses from ESP */
+static void cached_resp_thread(void const *arg)
+{
+	esp_queue_elem_t *elem = NULL;
+	ctrl_cmd_t *app_resp = NULL;
+
+	while (1) {
+		hosted_get_semaphore(cached_resp_sem, HOSTED_SEM_BLOCKING);
+
+		elem = (esp_queue_elem_t*)esp_queue_get(cached_resp_Q);
+		if (!elem)
+			continue;
+
+		app_resp = (ctrl_cmd_t*)elem->buf;
+		mem_free(elem);
+		/* Callback replaced by a later sync request: nobody to hand to */
+		if (call_async_resp_callback(app_resp) == CALLBACK_NOT_REGISTERED)
+			mem_free(app_resp);
+	}
+}
+
+int slave_state_cache_enable(bool enable)
+{
+	if (!state_cache_sem) {
+		command_log("Control lib not initialized\n");
+		return FAILURE;
+	}
+
+	hosted_get_semaphore(state_cache_sem, HOSTED_SEM_BLOCKING);
+	state_cache.enabled = enable;
+	state_cache.valid = 0;
+	state_cache.pending = -1;
+	hosted_post_semaphore(state_cache_sem);
+
+	return SUCCESS;
+}
+
+void slave_state_cache_flush(void)
+{
+	state_cache_invalidate(STATE_CACHE_ALL);
+}
+
+/* This is entry level function when control request APIs are used
+ * This function will encode control request in protobuf and send to ESP32
+ * It will copy application structure `ctrl_cmd_t` to
+ * protobuf control req `CtrlMsg`
+ **/
+int ctrl_app_send_req(ctrl_cmd_t *app_req)
+{
+	int       ret = SUCCESS;
+	CtrlMsg   req = {0};
+	uint32_t  tx_len = 0;
+	uint8_t  *tx_data = NULL;
+	uint8_t  *buff_to_free1 = NULL;
+	void     *buff_to_free2 = NULL;
+	struct ctrl_batch_bufs *batch_bufs = NULL;
+	uint8_t   failure_status = 0;
+	uint8_t   got_ctrl_req_sem = 0;
+	ctrl_cmd_t *cached_resp = NULL;
+
+	if (!app_req) {
+		failure_status = CTRL_ERR_INCORRECT_ARG;
+		command_log("Invalid request pointer\n");
+		goto fail_req;
+	}
+
+	/* 1. Check if any ongoing request present
+	 * Send failure in that case */
+	ret = hosted_get_semaphore(ctrl_req_sem, WAIT_TIME_B2B_CTRL_REQ);
+	if (ret) {
+		failure_status = CTRL_ERR_REQ_IN_PROG;
+		command_log("Request already in progress\n");
+		goto fail_req;
+	} else {
+		got_ctrl_req_sem = 1;
+	}
+
+	app_req->msg_type = CTRL_REQ;
+
+	// handle rollover in uid value (range: 1 to INT32_MAX)
+	if (uid < INT32_MAX)
+		uid++;
+	else
+		uid = 1;
+	app_req->uid = uid;
+
+	/* Getter served from cache of slave state, no round trip needed */
+	cached_resp = state_cache_serve_req(app_req);
+	if (cached_resp) {
+		ret = set_async_resp_callback(app_req->msg_id, app_req->ctrl_resp_cb);
+		hosted_post_semaphore(ctrl_req_sem);
+		if ((ret < 0) || deliver_cached_resp(app_req, cached_resp)) {
+			command_log("Failed to deliver cached resp for req[%u]\n",
+					app_req->msg_id);
+			return FAILURE;
+		}
+		return SUCCESS;
+	}
+
+	/* 2. Protobuf msg init */
+	ctrl_msg__init(&req);
+
+	req.msg_id = app_req->msg_id;
+	req.uid = app_req->uid;
+	assert(expected_resp_uid == -1);
+	// set the expected response uid
+	expected_resp_uid = req.uid;
+
+	/* 3. identify request and compose CtrlMsg */
+	if (app_req->msg_id == CTRL_REQ_BATCH)
+		ret = ctrl_app_compose_batch_req(app_req, &req, &batch_bufs, &failure_status);
+	else
+		ret = ctrl_app_compose_req(app_req, &req, &buff_to_free1,
+				&buff_to_free2, &failure_status);
+	if (ret) {
+		goto fail_req;
+	}
+
 	/* 4. Protobuf msg size */
 	tx_len = ctrl_msg__get_packed_size(&req);
 	if (!tx_len) {
@@ -1755,6 +2319,7 @@ int ctrl_app_send_req(ctrl_cmd_t *app_req)
 	mem_free(tx_data);
 	mem_free(buff_to_free2);
 	mem_free(buff_to_free1);
+	ctrl_batch_bufs_free(batch_bufs);
 	return SUCCESS;
 
 fail_req:
@@ -1792,9 +2357,213 @@ fail_req2:
 	mem_free(tx_data);
 	mem_free(buff_to_free2);
 	mem_free(buff_to_free1);
+	ctrl_batch_bufs_free(batch_bufs);
 	return FAILURE;
 }
 
+/* Mark BSSs not seen within TTL as removed. Called with bss_cache_sem held */
+static void bss_cache_age_out(uint32_t now)
+{
+	struct bss_cache_entry *e = NULL;
+	int i = 0;
+
+	for (i = 0; i < WIFI_BSS_CACHE_MAX_ENTRIES; i++) {
+		e = &bss_cache[i];
+		if (e->in_use && !e->removed &&
+		    ((uint32_t)(now - e->last_seen_ms) > bss_cache_ttl_ms)) {
+			e->removed = 1;
+			e->generation = ++bss_cache_generation;
+		}
+	}
+}
+
+/* Find cache slot for BSS. Returns existing entry of same BSSID,
+ * else free slot, else slot of longest unseen BSS, removed ones first */
+static struct bss_cache_entry * bss_cache_get_slot(const uint8_t *bssid)
+{
+	struct bss_cache_entry *e = NULL;
+	struct bss_cache_entry *victim = NULL;
+	int i = 0;
+
+	for (i = 0; i < WIFI_BSS_CACHE_MAX_ENTRIES; i++) {
+		e = &bss_cache[i];
+		if (e->in_use && !strncmp((char *)e->ap.bssid, (char *)bssid,
+					BSSID_STR_SIZE))
+			return e;
+	}
+
+	for (i = 0; i < WIFI_BSS_CACHE_MAX_ENTRIES; i++) {
+		e = &bss_cache[i];
+		if (!e->in_use) {
+			return e;
+		}
+		if (!victim ||
+		    (e->removed > victim->removed) ||
+		    ((e->removed == victim->removed) &&
+		     ((int32_t)(e->last_seen_ms - victim->last_seen_ms) < 0))) {
+			victim = e;
+		}
+	}
+
+	memset(victim, 0, sizeof(struct bss_cache_entry));
+	return victim;
+}
+
+/* Add or refresh scanned APs in BSS cache */
+static void bss_cache_update(wifi_scanlist_t *list, int count)
+{
+	struct bss_cache_entry *e = NULL;
+	uint32_t now = hosted_get_time_ms();
+	uint8_t changed = 0;
+	int i = 0;
+
+	if (!bss_cache_sem || !list || (count <= 0))
+		return;
+
+	hosted_get_semaphore(bss_cache_sem, HOSTED_SEM_BLOCKING);
+
+	bss_cache_age_out(now);
+
+	for (i = 0; i < count; i++) {
+		if (!list[i].bssid[0])
+			continue;
+
+		e = bss_cache_get_slot(list[i].bssid);
+
+		changed = (!e->in_use || e->removed ||
+			strncmp((char *)e->ap.ssid, (char *)list[i].ssid, SSID_LENGTH) ||
+			(e->ap.channel != list[i].channel) ||
+			(e->ap.encryption_mode != list[i].encryption_mode) ||
+			(abs(e->reported_rssi - list[i].rssi) >= WIFI_BSS_CACHE_RSSI_DELTA));
+
+		memcpy(&e->ap, &list[i], sizeof(wifi_scanlist_t));
+		e->last_seen_ms = now;
+		e->in_use = 1;
+		e->removed = 0;
+
+		if (changed) {
+			e->reported_rssi = list[i].rssi;
+			e->generation = ++bss_cache_generation;
+		}
+	}
+
+	hosted_post_semaphore(bss_cache_sem);
+}
+
+static void bss_cache_copy_entry(struct bss_cache_entry *e,
+		wifi_bss_cache_entry_t *out, uint32_t now)
+{
+	memcpy(&out->ap, &e->ap, sizeof(wifi_scanlist_t));
+	out->age_ms = now - e->last_seen_ms;
+	out->generation = e->generation;
+	out->removed = e->removed;
+}
+
+int wifi_bss_cache_set_ttl(uint32_t ttl_ms)
+{
+	if (!bss_cache_sem || !ttl_ms) {
+		command_log("Invalid ttl or control lib not initialized\n");
+		return FAILURE;
+	}
+
+	hosted_get_semaphore(bss_cache_sem, HOSTED_SEM_BLOCKING);
+	bss_cache_ttl_ms = ttl_ms;
+	hosted_post_semaphore(bss_cache_sem);
+
+	return SUCCESS;
+}
+
+int wifi_bss_cache_get(wifi_bss_cache_entry_t *out, int max_entries,
+		uint32_t *generation)
+{
+	uint32_t now = hosted_get_time_ms();
+	int count = 0;
+	int i = 0;
+
+	if (!bss_cache_sem || !out || (max_entries <= 0)) {
+		command_log("Invalid argument or control lib not initialized\n");
+		return FAILURE;
+	}
+
+	hosted_get_semaphore(bss_cache_sem, HOSTED_SEM_BLOCKING);
+
+	bss_cache_age_out(now);
+
+	for (i = 0; (i < WIFI_BSS_CACHE_MAX_ENTRIES) && (count < max_entries); i++) {
+		if (bss_cache[i].in_use && !bss_cache[i].removed)
+			bss_cache_copy_entry(&bss_cache[i], &out[count++], now);
+	}
+
+	if (generation)
+		*generation = bss_cache_generation;
+
+	hosted_post_semaphore(bss_cache_sem);
+
+	return count;
+}
+
+int wifi_bss_cache_get_delta(uint32_t since, wifi_bss_cache_entry_t *out,
+		int max_entries, uint32_t *generation)
+{
+	struct bss_cache_entry *next = NULL;
+	uint32_t now = hosted_get_time_ms();
+	uint32_t last = since;
+	int count = 0;
+	int i = 0;
+
+	if (!bss_cache_sem || !out || (max_entries <= 0)) {
+		command_log("Invalid argument or control lib not initialized\n");
+		return FAILURE;
+	}
+
+	hosted_get_semaphore(bss_cache_sem, HOSTED_SEM_BLOCKING);
+
+	bss_cache_age_out(now);
+
+	/* Report in generation order, so that if 'out' is too small,
+	 * returned generation resumes exactly after last copied entry */
+	while (count < max_entries) {
+		next = NULL;
+		for (i = 0; i < WIFI_BSS_CACHE_MAX_ENTRIES; i++) {
+			if (!bss_cache[i].in_use || (bss_cache[i].generation <= last))
+				continue;
+			if (!next || (bss_cache[i].generation < next->generation))
+				next = &bss_cache[i];
+		}
+		if (!next)
+			break;
+
+		bss_cache_copy_entry(next, &out[count++], now);
+		last = next->generation;
+	}
+
+	if (generation)
+		*generation = (count == max_entries) ? last : bss_cache_generation;
+
+	hosted_post_semaphore(bss_cache_sem);
+
+	return count;
+}
+
+void wifi_bss_cache_flush(void)
+{
+	int i = 0;
+
+	if (!bss_cache_sem)
+		return;
+
+	hosted_get_semaphore(bss_cache_sem, HOSTED_SEM_BLOCKING);
+
+	for (i = 0; i < WIFI_BSS_CACHE_MAX_ENTRIES; i++) {
+		if (bss_cache[i].in_use && !bss_cache[i].removed) {
+			bss_cache[i].removed = 1;
+			bss_cache[i].generation = ++bss_cache_generation;
+		}
+	}
+
+	hosted_post_semaphore(bss_cache_sem);
+}
+
 /* De-init hosted control lib */
 int deinit_hosted_control_lib_internal(void)
 {
@@ -1811,6 +2580,13 @@ int deinit_hosted_control_lib_internal(void)
 		command_log("cancel ctrl rx thread failed\n");
 	}
 
+	if (cached_resp_thread_handle &&
+	    hosted_thread_cancel(cached_resp_thread_handle)) {
+		ret = FAILURE;
+		command_log("cancel cached resp thread failed\n");
+	}
+	cached_resp_thread_handle = NULL;
+
 	if (async_timer_handle) {
 		/* async_timer_handle will be cleaned in hosted_timer_stop */
 		hosted_timer_stop(async_timer_handle);
@@ -1826,6 +2602,16 @@ int deinit_hosted_control_lib_internal(void)
 		esp_queue_destroy(&ctrl_msg_Q);
 	}
 
+	if (cached_resp_Q) {
+		esp_queue_destroy(&cached_resp_Q);
+	}
+
+	if (cached_resp_sem && hosted_destroy_semaphore(cached_resp_sem)) {
+		ret = FAILURE;
+		command_log("cached resp sem deinit failed\n");
+	}
+	cached_resp_sem = NULL;
+
 	if (ctrl_req_sem && hosted_destroy_semaphore(ctrl_req_sem)) {
 		ret = FAILURE;
 		command_log("ctrl req sem deinit failed\n");
@@ -1836,6 +2622,20 @@ int deinit_hosted_control_lib_internal(void)
 		command_log("read sem deinit failed\n");
 	}
 
+	if (bss_cache_sem && hosted_destroy_semaphore(bss_cache_sem)) {
+		ret = FAILURE;
+		command_log("bss cache sem deinit failed\n");
+	}
+	bss_cache_sem = NULL;
+
+	if (state_cache_sem && hosted_destroy_semaphore(state_cache_sem)) {
+		ret = FAILURE;
+		command_log("state cache sem deinit failed\n");
+	}
+	state_cache_sem = NULL;
+	state_cache.enabled = 0;
+	state_cache.valid = 0;
+
 	return ret;
 }
 
@@ -1847,7 +2647,11 @@ int init_hosted_control_lib_internal(void)
 	/* semaphore init */
 	read_sem = hosted_create_semaphore(1);
 	ctrl_req_sem = hosted_create_semaphore(1);
-	if (!read_sem || !ctrl_req_sem) {
+	bss_cache_sem = hosted_create_semaphore(1);
+	state_cache_sem = hosted_create_semaphore(1);
+	cached_resp_sem = hosted_create_semaphore(0);
+	if (!read_sem || !ctrl_req_sem || !bss_cache_sem || !state_cache_sem ||
+	    !cached_resp_sem) {
 		command_log("sem init failed, exiting\n");
 		goto free_bufs;
 	}
@@ -1865,6 +2669,12 @@ int init_hosted_control_lib_internal(void)
 		goto free_bufs;
 	}
 
+	cached_resp_Q = create_esp_queue();
+	if (!cached_resp_Q) {
+		command_log("Failed to create cached resp Q\n");
+		goto free_bufs;
+	}
+
 	/* Get read semaphore for first time */
 	hosted_get_semaphore(read_sem, HOSTED_SEM_BLOCKING);
 
@@ -1872,6 +2682,12 @@ int init_hosted_control_lib_internal(void)
 	if (spawn_ctrl_rx_thread())
 		goto free_bufs;
 
+	cached_resp_thread_handle = hosted_thread_create(cached_resp_thread, NULL);
+	if (!cached_resp_thread_handle) {
+		command_log("Thread creation failed for cached_resp_thread\n");
+		goto free_bufs;
+	}
+
 	/* state init */
 	set_ctrl_lib_state(CTRL_LIB_STATE_READY);
 
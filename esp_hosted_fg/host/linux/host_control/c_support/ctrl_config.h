@@ -31,6 +31,8 @@
 #define SET_WIFI_MODE                      "set_wifi_mode"
 
 #define GET_AP_SCAN_LIST                   "get_ap_scan_list"
+#define GET_AP_SCAN_LIST_STREAM            "get_ap_scan_list_stream"
+#define BATCH_BRING_UP                     "batch_bring_up"
 #define STA_CONNECT                        "sta_connect"
 #define GET_STA_CONFIG                     "get_sta_config"
 #define STA_DISCONNECT                     "sta_disconnect"
@@ -138,18 +138,15 @@ static int event_cb(ctrl_cmd_t * app_event)
 	return SUCCESS;
 }
 
-int resp_cb(ctrl_cmd_t * app_resp)
+/* Parse one validated sub response of a batch.
+ * Sub responses are owned by the batch response, so not freed here */
+static void parse_resp(ctrl_cmd_t * app_resp)
 {
-
-	if (test_validate_ctrl_resp(app_resp)) {
-		CLEANUP_CTRL_MSG(app_resp);
-		return FAILURE;
-	}
-
 	switch(app_resp->msg_id) {
 
 		case CTRL_RESP_GET_MAC_ADDR: {
 			LOG_MSG(LOG_INFO, "mac address is %s", app_resp->u.wifi_mac.mac);
+			strncpy(sta_network.mac_addr, app_resp->u.wifi_mac.mac, MAC_ADDR_LENGTH);
 			break;
 
 		} case CTRL_RESP_GET_DHCP_DNS_STATUS: {
@@ -181,9 +178,6 @@ int resp_cb(ctrl_cmd_t * app_resp)
 			break;
 		}
 	}
-
-	CLEANUP_CTRL_MSG(app_resp);
-	return SUCCESS;
 }
 
 
@@ -234,32 +228,44 @@ static int unsubscribe_events(void)
 	return ret;
 }
 
-static int fetch_mac_addr_from_slave(void)
+/* MAC and IP/DNS status are fetched in single round trip. IP is not
+ * fetched if MAC could not be */
+static int fetch_network_info_from_slave(void)
 {
 	/* implemented synchronous */
 	ctrl_cmd_t *req = CTRL_CMD_DEFAULT_REQ();
 	ctrl_cmd_t *resp = NULL;
+	ctrl_cmd_t sub[2] = {0};
+	int i = 0;
 
-	req->u.wifi_mac.mode = WIFI_MODE_STA;
-	resp = wifi_get_mac(req);
+	sub[0].msg_id = CTRL_REQ_GET_MAC_ADDR;
+	sub[0].u.wifi_mac.mode = WIFI_MODE_STA;
 
-	if (resp && resp->resp_event_status == SUCCESS) {
-		strncpy(sta_network.mac_addr, resp->u.wifi_mac.mac, MAC_ADDR_LENGTH);
-	}
+	sub[1].msg_id = CTRL_REQ_GET_DHCP_DNS_STATUS;
+	/* Polled until the network is up, keep each try short */
+	sub[1].cmd_timeout_sec = 1;
+
+	req->u.batch.reqs = sub;
+	req->u.batch.count = sizeof(sub)/sizeof(sub[0]);
+	req->u.batch.stop_on_failure = true;
+
+	resp = send_batch_req(req);
 	free(req);
 
-	return resp_cb(resp);
-}
+	/* Batch status is FAILURE if any sub request failed,
+	 * the ones that did not are still valid */
+	if (!resp || (resp->msg_id != CTRL_RESP_BATCH)) {
+		CLEANUP_CTRL_MSG(resp);
+		return FAILURE;
+	}
 
-static int fetch_ip_addr_from_slave(void)
-{
-	ctrl_cmd_t *resp = NULL;
-	ctrl_cmd_t *req = CTRL_CMD_DEFAULT_REQ();
-	req->cmd_timeout_sec = 1;
+	for (i = 0; i < resp->u.batch.resp_count; i++) {
+		if (!test_validate_ctrl_resp(&resp->u.batch.resps[i]))
+			parse_resp(&resp->u.batch.resps[i]);
+	}
 
-	resp = get_dhcp_dns_status(req);
-	free(req);
-	return resp_cb(resp);
+	CLEANUP_CTRL_MSG(resp);
+	return SUCCESS;
 }
 
 static uint8_t app_init_done = 0;
@@ -483,8 +489,8 @@ int main(int argc, char *argv[])
 
 		if (!local_network_up) {
 
-			/* fetch MAC address */
-			fetch_mac_addr_from_slave();
+			/* fetch MAC address and IP */
+			fetch_network_info_from_slave();
 
 			if (strlen(sta_network.mac_addr)==0) {
 				LOG_MSG(LOG_ERR, "Failed to retrieve the MAC address");
@@ -492,8 +498,6 @@ int main(int argc, char *argv[])
 				continue;
 			}
 
-			fetch_ip_addr_from_slave();
-
 			if (sta_network.dns_valid && sta_network.ip_valid) {
 				LOG_MSG(LOG_INFO, "Network identified as up");
 				up_sta_netdev__with_static_ip_dns_route(&sta_network);
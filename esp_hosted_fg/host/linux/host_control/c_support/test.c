@@ -71,6 +71,8 @@ static int parse_cli_cmd(char *in_cmd, char *args[])
 	EXEC_IF_CMD_EQUALS(SET_SOFTAP_MAC_ADDR, test_softap_mode_set_mac_addr_of_esp(SOFTAP_MODE_MAC_ADDRESS));
 	EXEC_IF_CMD_EQUALS(GET_SOFTAP_MAC_ADDR, test_softap_mode_get_mac_addr(mac_address));
 	EXEC_IF_CMD_EQUALS(GET_AP_SCAN_LIST, test_get_available_wifi());
+	EXEC_IF_CMD_EQUALS(GET_AP_SCAN_LIST_STREAM, test_get_available_wifi_stream());
+	EXEC_IF_CMD_EQUALS(BATCH_BRING_UP, test_batch_bring_up());
 	EXEC_IF_CMD_EQUALS(STA_CONNECT, sta_connect_cli(args));
 	EXEC_IF_CMD_EQUALS(GET_STA_CONFIG, test_station_mode_get_info());
 	EXEC_IF_CMD_EQUALS(STA_DISCONNECT, test_station_mode_disconnect());
@@ -34,6 +34,8 @@ int test_station_mode_connect(void);
 int test_async_station_mode_connect(void);
 int test_station_mode_get_info(void);
 int test_get_available_wifi(void);
+int test_get_available_wifi_stream(void);
+int test_batch_bring_up(void);
 int test_station_mode_disconnect(void);
 int test_softap_mode_start(void);
 int test_softap_mode_get_info(void);
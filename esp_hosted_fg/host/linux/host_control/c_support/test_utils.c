@@ -331,6 +331,27 @@ static int ctrl_app_event_callback(ctrl_cmd_t *app_event) {
 					test_is_network_split_on());
 			}
 			break;
+		} case CTRL_EVENT_SCAN_RESULT: {
+			event_scan_result_t *p_e = &app_event->u.e_scan_result;
+			int i = 0;
+
+			if (SUCCESS != app_event->resp_event_status) {
+				printf("%s App EVENT: Scan [%u] failed\n",
+					get_timestamp(ts, MIN_TIMESTAMP_STR_SIZE), p_e->scan_id);
+				break;
+			}
+			for (i=0; i<p_e->count && p_e->out_list; i++) {
+				printf("%s App EVENT: Scan [%u] ssid \"%s\" bssid \"%s\" rssi \"%d\" channel \"%d\" auth mode \"%d\"\n",
+					get_timestamp(ts, MIN_TIMESTAMP_STR_SIZE), p_e->scan_id,
+					p_e->out_list[i].ssid, p_e->out_list[i].bssid,
+					p_e->out_list[i].rssi, p_e->out_list[i].channel,
+					p_e->out_list[i].encryption_mode);
+			}
+			if (p_e->done) {
+				printf("%s App EVENT: Scan [%u] done\n",
+					get_timestamp(ts, MIN_TIMESTAMP_STR_SIZE), p_e->scan_id);
+			}
+			break;
 		} case CTRL_EVENT_CUSTOM_RPC_UNSERIALISED_MSG: {
 			printf("%s App EVENT: Custom RPC unserialised message (Default handler)\n",
 				get_timestamp(ts, MIN_TIMESTAMP_STR_SIZE));
@@ -474,6 +495,7 @@ int register_event_callbacks(void)
 		{ CTRL_EVENT_STATION_DISCONNECT_FROM_ESP_SOFTAP, ctrl_app_event_callback },
 		{ CTRL_EVENT_DHCP_DNS_STATUS,                    ctrl_app_event_callback },
 		{ CTRL_EVENT_CUSTOM_RPC_UNSERIALISED_MSG,        ctrl_app_event_callback },
+		{ CTRL_EVENT_SCAN_RESULT,                        ctrl_app_event_callback },
 	};
 
 	for (evt=0; evt<sizeof(events)/sizeof(event_callback_table_t); evt++) {
@@ -505,6 +527,8 @@ static int get_event_id(const char *event)
 		event_id = CTRL_EVENT_DHCP_DNS_STATUS;
 	} else if (strcmp(event, "custom_rpc_event") == 0) {
 		event_id = CTRL_EVENT_CUSTOM_RPC_UNSERIALISED_MSG;
+	} else if (strcmp(event, "scan_result") == 0) {
+		event_id = CTRL_EVENT_SCAN_RESULT;
 	} else if (strcmp(event, "all") == 0) {
 				event_id = -2;   // Special case for "all"
 	} else {
@@ -533,6 +557,8 @@ static const char *get_event_string(int event_id)
             return "dhcp_dns_status";
         case CTRL_EVENT_CUSTOM_RPC_UNSERIALISED_MSG:
             return "custom_rpc_event";
+        case CTRL_EVENT_SCAN_RESULT:
+            return "scan_result";
         default:
             return "unknown";
     }
@@ -663,6 +689,23 @@ int ctrl_app_resp_callback(ctrl_cmd_t * app_resp)
 				}
 			}
 			break;
+		} case CTRL_RESP_GET_AP_SCAN_LIST_STREAM : {
+			printf("Scan [%u] started, results follow as events\n",
+					app_resp->u.wifi_ap_scan_stream.scan_id);
+			break;
+		} case CTRL_RESP_BATCH : {
+			batch_req_t *p = &app_resp->u.batch;
+
+			printf("Batch executed %d requests\n", p->resp_count);
+			for (i=0; i<p->resp_count; i++) {
+				printf("%d) resp[%u] status[%d]", i, p->resps[i].msg_id,
+						(int)p->resps[i].resp_event_status);
+				if ((p->resps[i].msg_id == CTRL_RESP_GET_MAC_ADDR) &&
+				    (p->resps[i].resp_event_status == SUCCESS))
+					printf(" mac address is %s", p->resps[i].u.wifi_mac.mac);
+				printf("\n");
+			}
+			break;
 		} case CTRL_RESP_GET_AP_CONFIG : {
 			wifi_ap_config_t *p = &app_resp->u.wifi_ap_config;
 			if (0 == strncmp(SUCCESS_STR, p->status, strlen(SUCCESS_STR))) {
@@ -1060,6 +1103,47 @@ int test_get_available_wifi(void)
 	return ctrl_app_resp_callback(resp);
 }
 
+int test_get_available_wifi_stream(void)
+{
+	/* implemented synchronous, scanned APs are received as events */
+	ctrl_cmd_t *req = CTRL_CMD_DEFAULT_REQ();
+	ctrl_cmd_t *resp = NULL;
+
+	resp = wifi_ap_scan_list_stream(req);
+
+	CLEANUP_CTRL_MSG(req);
+	return ctrl_app_resp_callback(resp);
+}
+
+int test_batch_bring_up(void)
+{
+	/* implemented synchronous, all requests sent in single round trip */
+	ctrl_cmd_t *req = CTRL_CMD_DEFAULT_REQ();
+	ctrl_cmd_t *resp = NULL;
+	ctrl_cmd_t sub[4] = {0};
+
+	sub[0].msg_id = CTRL_REQ_SET_WIFI_MODE;
+	sub[0].u.wifi_mode.mode = WIFI_MODE_STA;
+
+	sub[1].msg_id = CTRL_REQ_SET_COUNTRY_CODE;
+	memcpy(sub[1].u.country_code.country, COUNTRY_CODE, COUNTRY_CODE_LEN);
+
+	sub[2].msg_id = CTRL_REQ_SET_PS_MODE;
+	sub[2].u.wifi_ps.ps_mode = WIFI_PS_MIN_MODEM;
+
+	sub[3].msg_id = CTRL_REQ_GET_MAC_ADDR;
+	sub[3].u.wifi_mac.mode = WIFI_MODE_STA;
+
+	req->u.batch.reqs = sub;
+	req->u.batch.count = sizeof(sub)/sizeof(sub[0]);
+	req->u.batch.stop_on_failure = true;
+
+	resp = send_batch_req(req);
+
+	CLEANUP_CTRL_MSG(req);
+	return ctrl_app_resp_callback(resp);
+}
+
 int test_station_mode_disconnect(void)
 {
 	/* implemented synchronous */
@@ -170,7 +170,9 @@ class CTRL_MSGID(Enum):
 	CTRL_REQ_CUSTOM_RPC_UNSERIALISED = 126
 	CTRL_REQ_SET_DHCP_DNS_STATUS = 127
 	CTRL_REQ_GET_DHCP_DNS_STATUS = 128
-	CTRL_REQ_MAX = 129
+	CTRL_REQ_GET_AP_SCAN_LIST_STREAM = 129
+	CTRL_REQ_BATCH = 130
+	CTRL_REQ_MAX = 131
 	CTRL_RESP_BASE = 200
 	CTRL_RESP_GET_MAC_ADDR = 201
 	CTRL_RESP_SET_MAC_ADDRESS = 202
@@ -200,7 +202,9 @@ class CTRL_MSGID(Enum):
 	CTRL_RESP_CUSTOM_RPC_UNSERIALISED = 226
 	CTRL_RESP_SET_DHCP_DNS_STATUS = 227
 	CTRL_RESP_GET_DHCP_DNS_STATUS = 228
-	CTRL_RESP_MAX = 229
+	CTRL_RESP_GET_AP_SCAN_LIST_STREAM = 229
+	CTRL_RESP_BATCH = 230
+	CTRL_RESP_MAX = 231
 	CTRL_EVENT_BASE = 300
 	CTRL_EVENT_ESP_INIT = 301
 	CTRL_EVENT_HEARTBEAT = 302
@@ -210,7 +214,8 @@ class CTRL_MSGID(Enum):
 	CTRL_EVENT_STATION_CONNECTED_TO_ESP_SOFTAP = 306
 	CTRL_EVENT_CUSTOM_RPC_UNSERIALISED_MSG = 307
 	CTRL_EVENT_DHCP_DNS_STATUS = 308
-	CTRL_EVENT_MAX = 309
+	CTRL_EVENT_SCAN_RESULT = 309
+	CTRL_EVENT_MAX = 310
 
 
 class STA_CONFIG(Structure):
@@ -12,9 +12,13 @@
 #include <net/bluetooth/hci_core.h>
 #include "esp_kernel_port.h"
 #include "adapter.h"
+#if ESP_XDP_SUPPORT
+#include <net/xdp.h>
+#endif
 
 #define ESP_IF_TYPE_SDIO        1
 #define ESP_IF_TYPE_SPI         2
+#define ESP_IF_TYPE_VIRT        3
 
 /* Network link status */
 #define ESP_LINK_DOWN           0
@@ -71,6 +75,14 @@ struct esp_adapter {
 	u8                      if_type;
 	atomic_t                state;
 	u32                     capabilities;
+	/* ESP_PRIV_SERIAL_CAPS from slave boot event */
+	u8                      serial_caps;
+	/* ESP_PRIV_TELEMETRY from slave boot event, 0 if not supported */
+	u8                      telemetry_ver;
+	/* ESP_PRIV_CSUM_OFFLOAD from slave boot event */
+	u8                      csum_caps;
+	/* ESP_PRIV_HCI_BATCH from slave boot event */
+	u8                      hci_batch_caps;
 
 	/* Possible types:
 	 * struct esp_sdio_context */
@@ -92,6 +104,9 @@ struct esp_adapter {
 	struct workqueue_struct *tx_workqueue;
 	struct work_struct      tx_work;
 	struct module_params    mod_param;
+
+	/* <debugfs>/<module name>, NULL or ERR_PTR if debugfs is unavailable */
+	struct dentry           *debugfs_dir;
 };
 
 
@@ -104,9 +119,18 @@ struct esp_private {
 	u8                      if_type;
 	u8                      if_num;
 	struct notifier_block   nb;
+#if ESP_XDP_SUPPORT
+	/* Attached XDP program, NULL if none */
+	struct bpf_prog __rcu   *xdp_prog;
+	struct xdp_rxq_info     xdp_rxq;
+#endif
 };
 
 struct esp_skb_cb {
 	struct esp_private      *priv;
+	/* ktime_get_ns() at transport enqueue (TX) or read start (RX), 0 if unset */
+	u64                     tstamp;
+	/* RX payload header flags, for frames handed to the stack later */
+	u8                      rx_flags;
 };
 #endif
@@ -13,12 +13,20 @@ struct esp_adapter * esp_get_adapter(void);
 /* Consumes @skb: 0 = queued, any nonzero = dropped and freed here (NOT
  * "busy, retry"). Callers must neither free nor retry on nonzero. */
 int esp_send_packet(struct esp_adapter *adapter, struct sk_buff *skb);
+void esp_stamp_tx_seq(struct esp_payload_header *header);
+struct esp_private * get_priv_from_payload_header(struct esp_payload_header *header);
+void esp_rx_deliver(struct esp_private *priv, struct sk_buff *skb, u8 flags);
+/* Netdev TX path; NETDEV_TX_BUSY leaves @skb with the caller */
+int esp_tx_frame(struct esp_private *priv, struct sk_buff *skb);
 u8 esp_is_bt_supported_over_sdio(u32 cap);
 int esp_is_tx_queue_paused(void);
 void esp_tx_pause(void);
 void esp_tx_resume(void);
 int process_init_event(u8 *evt_buf, u8 len);
 void process_capabilities(u8 cap);
+void esp_send_priv_command(struct esp_adapter *adapter, u8 cmd);
+/* @data starts with the ESP_PRIV_CMD_* code */
+void esp_send_priv_data(struct esp_adapter *adapter, const u8 *data, u16 len);
 void process_test_capabilities(u8 cap);
 int is_host_sleeping(void);
 
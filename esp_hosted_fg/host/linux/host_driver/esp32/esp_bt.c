@@ -5,9 +5,37 @@
 #include "esp_api.h"
 #include "esp_kernel_port.h"
 #include "esp_if.h"
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
 
 #define INVALID_HDEV_BUS (0xff)
 
+/* HCI batching, see ESP_PRIV_HCI_BATCH.
+ *
+ * With a slave that offers it, ACL/ISO packets in either direction are
+ * packed into one ESP_HCI_IF frame (FLAG_HCI_BATCH) instead of one frame
+ * per packet. A batch is sent when full, hci_batch_us after its first
+ * packet, or together with the first command/event behind it, so HCI order
+ * is never changed. Received batches go up as clones of the bus buffer,
+ * one per packet, without copying. */
+static u32 hci_batch_us = 500;
+module_param(hci_batch_us, uint, S_IRUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(hci_batch_us, "Longest an HCI ACL/ISO batch is held, each direction (us); 0 sends one HCI packet per frame");
+
+#define ESP_HCI_BATCH_FRAME_LEN \
+	(sizeof(struct esp_payload_header) + ESP_HCI_BATCH_MAX_LEN)
+
+/* Host->slave batch under construction, payload header in front */
+static struct {
+	struct mutex            lock;
+	struct sk_buff          *skb;
+	struct hrtimer          timer;
+	struct work_struct      flush_work;
+	struct esp_adapter      *adapter;
+	bool                    enabled;
+} hci_tx_batch = {
+	.lock = __MUTEX_INITIALIZER(hci_tx_batch.lock),
+};
 
 static ESP_BT_SEND_FRAME_PROTOTYPE();
 
@@ -41,14 +69,97 @@ static void esp_hci_update_rx_counter(struct hci_dev *hdev, u8 pkt_type, size_t
 	}
 }
 
+static bool esp_hci_batchable(u8 pkt_type)
+{
+	if (pkt_type == HCI_ACLDATA_PKT)
+		return true;
+#ifdef HCI_ISODATA_PKT
+	if (pkt_type == HCI_ISODATA_PKT)
+		return true;
+#endif
+	return false;
+}
+
+/* Consumes skb */
+static void esp_hci_recv(struct hci_dev *hdev, struct sk_buff *skb, u8 pkt_type)
+{
+	u32 len = skb->len;
+	int ret;
+
+	hci_skb_pkt_type(skb) = pkt_type;
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 13, 0))
+	ret = hci_recv_frame(hdev, skb);
+#else
+	ret = hci_recv_frame(skb);
+#endif
+
+	if (ret) {
+		esp_err("Failed to process HCI frame: %d\n", ret);
+		hdev->stat.err_rx++;
+		/* hci_recv_frame() owns/frees skb on all paths; don't double-free */
+	} else {
+		esp_hci_update_rx_counter(hdev, pkt_type, len);
+	}
+}
+
+/* @skb holds the records only. Every packet but the last goes up in a
+ * clone pointing into the same buffer; the last one takes @skb itself. */
+static void esp_hci_rx_batch(struct hci_dev *hdev, struct sk_buff *skb)
+{
+	struct esp_hci_batch_rec *rec;
+	struct sk_buff *pkt;
+	u32 pos = 0;
+	u16 len;
+	u8 pkt_type;
+
+	while (skb->len - pos >= sizeof(*rec)) {
+		rec = (struct esp_hci_batch_rec *)(skb->data + pos);
+		len = le16_to_cpu(rec->len);
+		pkt_type = rec->pkt_type;
+		pos += sizeof(*rec);
+
+		if (unlikely(!len || len > skb->len - pos)) {
+			esp_err("Bad HCI batch record: len=%u, %u bytes left\n",
+					len, skb->len - pos);
+			hdev->stat.err_rx++;
+			break;
+		}
+
+		esp_hex_dump_dbg("bt_rx: ", skb->data + pos, len);
+
+		if (pos + len == skb->len) {
+			pkt = skb;
+			skb = NULL;
+		} else {
+			pkt = skb_clone(skb, GFP_ATOMIC);
+			if (!pkt) {
+				hdev->stat.err_rx++;
+				pos += len;
+				continue;
+			}
+		}
+
+		skb_pull(pkt, pos);
+		skb_trim(pkt, len);
+		esp_hci_recv(hdev, pkt, pkt_type);
+
+		if (!skb)
+			return;
+		pos += len;
+	}
+
+	dev_kfree_skb_any(skb);
+}
+
 void esp_hci_rx(struct esp_adapter *adapter, struct sk_buff *skb)
 {
 	struct hci_dev *hdev = NULL;
 	struct esp_payload_header *h = NULL;
 	u16 offset = 0;
 	u16 len = 0;
-	u8 *type = NULL;
-	int ret = 0;
+	u8 type = 0;
+	u8 flags = 0;
 
 	if (unlikely(!adapter || !skb || !skb->data || !skb->len)) {
 		esp_err("Invalid args: adapter=%p, skb=%p\n", adapter, skb);
@@ -74,6 +185,7 @@ void esp_hci_rx(struct esp_adapter *adapter, struct sk_buff *skb)
 
 	offset = le16_to_cpu(h->offset);
 	len = le16_to_cpu(h->len);
+	flags = h->flags;
 
 	if (unlikely(!offset || !len || len > (skb->len - offset))) {
 		esp_err("Invalid packet parameters: offset=%u, len=%u, skb->len=%u\n",
@@ -91,7 +203,13 @@ void esp_hci_rx(struct esp_adapter *adapter, struct sk_buff *skb)
 	/* chop off the header from skb */
 	skb_pull(skb, offset);
 
-	type = skb->data;
+	if (flags & FLAG_HCI_BATCH) {
+		skb_trim(skb, len);
+		esp_hci_rx_batch(hdev, skb);
+		return;
+	}
+
+	type = *skb->data;
 	esp_hex_dump_dbg("bt_rx: ", skb->data, len);
 
 	if (unlikely(skb->len <= 1)) {
@@ -99,23 +217,156 @@ void esp_hci_rx(struct esp_adapter *adapter, struct sk_buff *skb)
 		dev_kfree_skb_any(skb);
 		return;
 	}
-	hci_skb_pkt_type(skb) = *type;
 
 	skb_pull(skb, 1);
 
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 13, 0))
-	ret = hci_recv_frame(hdev, skb);
-#else
-	ret = hci_recv_frame(skb);
-#endif
+	esp_hci_recv(hdev, skb, type);
+}
+
+/* Call with hci_tx_batch.lock held */
+static void esp_hci_batch_flush_locked(void)
+{
+	struct esp_adapter *adapter = hci_tx_batch.adapter;
+	struct sk_buff *skb = hci_tx_batch.skb;
+	struct esp_payload_header *hdr;
+	int ret;
+
+	if (!skb)
+		return;
+
+	hci_tx_batch.skb = NULL;
+	hrtimer_try_to_cancel(&hci_tx_batch.timer);
+
+	hdr = (struct esp_payload_header *) skb->data;
+	hdr->if_type = ESP_HCI_IF;
+	hdr->if_num = 0;
+	hdr->flags = FLAG_HCI_BATCH;
+	hdr->len = cpu_to_le16(skb->len - sizeof(struct esp_payload_header));
+	hdr->offset = cpu_to_le16(sizeof(struct esp_payload_header));
 
+	ret = esp_send_packet(adapter, skb);
 	if (ret) {
-		esp_err("Failed to process HCI frame: %d\n", ret);
-		hdev->stat.err_rx++;
-		/* hci_recv_frame() owns/frees skb on all paths; don't double-free */
-	} else {
-		esp_hci_update_rx_counter(hdev, *type, skb->len);
+		esp_err("Failed to send HCI batch, error: %d\n", ret);
+		if (adapter->hcidev)
+			adapter->hcidev->stat.err_tx++;
+	}
+}
+
+static void esp_hci_batch_flush_work(struct work_struct *work)
+{
+	mutex_lock(&hci_tx_batch.lock);
+	esp_hci_batch_flush_locked();
+	mutex_unlock(&hci_tx_batch.lock);
+}
+
+static enum hrtimer_restart esp_hci_batch_timer(struct hrtimer *timer)
+{
+	schedule_work(&hci_tx_batch.flush_work);
+	return HRTIMER_NORESTART;
+}
+
+/* Drops a batch that was not sent yet */
+static void esp_hci_batch_drop(void)
+{
+	mutex_lock(&hci_tx_batch.lock);
+	hrtimer_try_to_cancel(&hci_tx_batch.timer);
+	if (hci_tx_batch.skb) {
+		dev_kfree_skb_any(hci_tx_batch.skb);
+		hci_tx_batch.skb = NULL;
+	}
+	mutex_unlock(&hci_tx_batch.lock);
+}
+
+/* Adds @skb to the open batch; consumes it unless an error is returned.
+ * Caller checks that a record of @skb fits ESP_HCI_BATCH_MAX_LEN. */
+static int esp_hci_batch_xmit(struct esp_adapter *adapter,
+		struct hci_dev *hdev, struct sk_buff *skb)
+{
+	struct esp_hci_batch_rec rec;
+	u8 pkt_type = hci_skb_pkt_type(skb);
+	u32 len = skb->len;
+	bool first = false;
+
+	esp_hex_dump_dbg("bt_tx: ", skb->data, skb_headlen(skb));
+
+	mutex_lock(&hci_tx_batch.lock);
+
+	if (hci_tx_batch.skb &&
+	    hci_tx_batch.skb->len + sizeof(rec) + len > ESP_HCI_BATCH_FRAME_LEN)
+		esp_hci_batch_flush_locked();
+
+	if (!hci_tx_batch.skb) {
+		hci_tx_batch.skb = adapter->if_ops->alloc_skb(ESP_HCI_BATCH_FRAME_LEN);
+		if (!hci_tx_batch.skb) {
+			mutex_unlock(&hci_tx_batch.lock);
+			esp_err("Failed to allocate SKB\n");
+			hdev->stat.err_tx++;
+			return -ENOMEM;
+		}
+		memset(skb_put(hci_tx_batch.skb, sizeof(struct esp_payload_header)),
+				0, sizeof(struct esp_payload_header));
+		first = true;
 	}
+
+	rec.len = cpu_to_le16(len);
+	rec.pkt_type = pkt_type;
+	skb_put_data(hci_tx_batch.skb, &rec, sizeof(rec));
+	skb_copy_bits(skb, 0, skb_put(hci_tx_batch.skb, len), len);
+	esp_hci_update_tx_counter(hdev, pkt_type, len);
+
+	if (!esp_hci_batchable(pkt_type) ||
+	    hci_tx_batch.skb->len + sizeof(rec) >= ESP_HCI_BATCH_FRAME_LEN)
+		esp_hci_batch_flush_locked();
+	else if (first)
+		hrtimer_start(&hci_tx_batch.timer,
+				ns_to_ktime((u64)hci_batch_us * NSEC_PER_USEC),
+				HRTIMER_MODE_REL);
+
+	mutex_unlock(&hci_tx_batch.lock);
+
+	dev_kfree_skb_any(skb);
+	return 0;
+}
+
+static void esp_hci_batch_start(struct esp_adapter *adapter)
+{
+	struct esp_priv_hci_batch_cmd cmd = {
+		.cmd = ESP_PRIV_CMD_HCI_BATCH,
+		.flush_us = cpu_to_le16(min_t(u32, hci_batch_us, U16_MAX)),
+	};
+
+	hci_tx_batch.adapter = adapter;
+	hci_tx_batch.enabled = false;
+
+	if (!hci_batch_us)
+		return;
+
+	if (adapter->hci_batch_caps & ESP_HCI_BATCH_H2E) {
+		ESP_HRTIMER_SETUP(&hci_tx_batch.timer, esp_hci_batch_timer,
+				CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		INIT_WORK(&hci_tx_batch.flush_work, esp_hci_batch_flush_work);
+		hci_tx_batch.enabled = true;
+	}
+
+	if (adapter->hci_batch_caps & ESP_HCI_BATCH_E2H)
+		esp_send_priv_data(adapter, (u8 *)&cmd, sizeof(cmd));
+
+	esp_info("HCI batching: to ESP %s, from ESP %s, %u us\n",
+			hci_tx_batch.enabled ? "on" : "off",
+			(adapter->hci_batch_caps & ESP_HCI_BATCH_E2H) ? "on" : "off",
+			hci_batch_us);
+}
+
+/* No more esp_bt_send_frame() calls by now */
+static void esp_hci_batch_stop(void)
+{
+	if (!hci_tx_batch.enabled)
+		return;
+
+	hci_tx_batch.enabled = false;
+	hrtimer_cancel(&hci_tx_batch.timer);
+	cancel_work_sync(&hci_tx_batch.flush_work);
+	esp_hci_batch_drop();
 }
 
 static int esp_bt_open(struct hci_dev *hdev)
@@ -130,6 +381,9 @@ static int esp_bt_close(struct hci_dev *hdev)
 
 static int esp_bt_flush(struct hci_dev *hdev)
 {
+	if (hci_tx_batch.enabled)
+		esp_hci_batch_drop();
+
 	return 0;
 }
 
@@ -166,6 +420,17 @@ static ESP_BT_SEND_FRAME_PROTOTYPE()
 		return -EINVAL;
 	}
 
+	if (hci_tx_batch.enabled) {
+		if (sizeof(struct esp_hci_batch_rec) + len <= ESP_HCI_BATCH_MAX_LEN)
+			return esp_hci_batch_xmit(adapter, hdev, skb);
+
+		/* Too big for a batch record: send what is batched first to keep
+		 * the order, then this one in a frame of its own, as the ESP does */
+		mutex_lock(&hci_tx_batch.lock);
+		esp_hci_batch_flush_locked();
+		mutex_unlock(&hci_tx_batch.lock);
+	}
+
 	esp_hex_dump_dbg("bt_tx: ", skb->data, len);
 
 	/* Create space for payload header */
@@ -280,6 +545,8 @@ int esp_deinit_bt(struct esp_adapter *adapter)
 	hci_unregister_dev(hdev);
 	msleep(50);
 
+	esp_hci_batch_stop();
+
 	hci_free_dev(hdev);
 
 	esp_info("Bluetooth deinit success\n");
@@ -359,9 +626,12 @@ int esp_init_bt(struct esp_adapter *adapter)
 	hdev->dev_type = HCI_PRIMARY;
 #endif
 
+	esp_hci_batch_start(adapter);
+
 	ret = hci_register_dev(hdev);
 	if (ret < 0) {
 		esp_err("Can not register HCI device, error: %d\n", ret);
+		esp_hci_batch_stop();
 		hci_free_dev(hdev);
 		adapter->hcidev = NULL;
 		return ret;
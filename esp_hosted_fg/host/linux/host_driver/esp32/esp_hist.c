@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+/* Per-stage log2 latency histograms for the host datapath.
+ *
+ * Always built (no ESP_DEBUG_STATS needed): recording is one per-CPU
+ * increment plus one per-CPU add, no locks, no printk. Counters are folded
+ * across CPUs only when debugfs is read:
+ *
+ *   <debugfs>/<module>/latency/summary   count, avg, p50, p99, p999 per stage
+ *   <debugfs>/<module>/latency/<stage>   non-empty buckets of one stage
+ *   <debugfs>/<module>/latency/reset     write anything to clear
+ *
+ * Percentiles are bucket upper bounds, so they are accurate to a factor of 2.
+ */
+
+#include "esp_utils.h"
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/fs.h>
+#include <linux/bitops.h>
+#include <linux/math64.h>
+#include "esp_hist.h"
+
+struct esp_hist_cpu {
+	u64 bucket[ESP_HIST_MAX][ESP_HIST_BUCKETS];
+	u64 sum_ns[ESP_HIST_MAX];
+};
+
+static DEFINE_PER_CPU(struct esp_hist_cpu, esp_hist_pcpu);
+
+static const char * const esp_hist_names[ESP_HIST_MAX] = {
+	[ESP_HIST_TX_XMIT]	= "tx_xmit",
+	[ESP_HIST_TX_QUEUE]	= "tx_queue",
+	[ESP_HIST_TX_CREDIT]	= "tx_credit",
+	[ESP_HIST_TX_WRITE]	= "tx_write",
+	[ESP_HIST_RX_CLAIM]	= "rx_claim",
+	[ESP_HIST_RX_LEN]	= "rx_len",
+	[ESP_HIST_RX_XFER]	= "rx_xfer",
+	[ESP_HIST_RX_DELIVER]	= "rx_deliver",
+	[ESP_HIST_RAW_TP_RTT]	= "raw_tp_rtt",
+};
+
+void esp_hist_add(enum esp_hist_stage stage, u64 delta_ns)
+{
+	unsigned int b = fls64(delta_ns);
+
+	if (unlikely(stage >= ESP_HIST_MAX))
+		return;
+	if (b >= ESP_HIST_BUCKETS)
+		b = ESP_HIST_BUCKETS - 1;
+
+	this_cpu_inc(esp_hist_pcpu.bucket[stage][b]);
+	this_cpu_add(esp_hist_pcpu.sum_ns[stage], delta_ns);
+}
+
+void esp_hist_reset(void)
+{
+	int cpu;
+
+	/* Racy against concurrent recording by design: a sample landing
+	 * mid-clear is either kept or lost, never corrupts a counter. */
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(&esp_hist_pcpu, cpu), 0,
+		       sizeof(struct esp_hist_cpu));
+}
+
+/* Sum one stage over all CPUs; returns the sample count */
+static u64 esp_hist_fold(enum esp_hist_stage stage,
+			 u64 buckets[ESP_HIST_BUCKETS], u64 *sum_ns)
+{
+	struct esp_hist_cpu *h;
+	u64 total = 0;
+	int cpu, b;
+
+	memset(buckets, 0, ESP_HIST_BUCKETS * sizeof(u64));
+	*sum_ns = 0;
+
+	for_each_possible_cpu(cpu) {
+		h = per_cpu_ptr(&esp_hist_pcpu, cpu);
+		for (b = 0; b < ESP_HIST_BUCKETS; b++)
+			buckets[b] += READ_ONCE(h->bucket[stage][b]);
+		*sum_ns += READ_ONCE(h->sum_ns[stage]);
+	}
+
+	for (b = 0; b < ESP_HIST_BUCKETS; b++)
+		total += buckets[b];
+
+	return total;
+}
+
+static u64 esp_hist_bucket_hi(int b)
+{
+	return b ? 1ULL << b : 0;
+}
+
+u64 esp_hist_percentile(const u64 buckets[ESP_HIST_BUCKETS], u64 total,
+			u32 pp10k)
+{
+	u64 target, acc = 0;
+	int b;
+
+	if (!total)
+		return 0;
+
+	target = div64_u64(total * pp10k + 9999, 10000);
+	for (b = 0; b < ESP_HIST_BUCKETS; b++) {
+		acc += buckets[b];
+		if (acc >= target)
+			return esp_hist_bucket_hi(b);
+	}
+
+	return esp_hist_bucket_hi(ESP_HIST_BUCKETS - 1);
+}
+
+static int esp_hist_summary_show(struct seq_file *m, void *v)
+{
+	u64 buckets[ESP_HIST_BUCKETS];
+	u64 total, sum_ns;
+	int stage;
+
+	seq_printf(m, "%-12s %12s %10s %10s %10s %10s\n",
+		   "stage", "count", "avg_ns", "p50_ns", "p99_ns", "p999_ns");
+
+	for (stage = 0; stage < ESP_HIST_MAX; stage++) {
+		total = esp_hist_fold(stage, buckets, &sum_ns);
+		seq_printf(m, "%-12s %12llu %10llu %10llu %10llu %10llu\n",
+			   esp_hist_names[stage], total,
+			   total ? div64_u64(sum_ns, total) : 0,
+			   esp_hist_percentile(buckets, total, 5000),
+			   esp_hist_percentile(buckets, total, 9900),
+			   esp_hist_percentile(buckets, total, 9990));
+	}
+
+	return 0;
+}
+
+static int esp_hist_stage_show(struct seq_file *m, void *v)
+{
+	enum esp_hist_stage stage = (uintptr_t)m->private;
+	u64 buckets[ESP_HIST_BUCKETS];
+	u64 total, sum_ns;
+	int b;
+
+	total = esp_hist_fold(stage, buckets, &sum_ns);
+
+	seq_printf(m, "%12s %12s %12s\n", "from_ns", "to_ns", "count");
+	for (b = 0; b < ESP_HIST_BUCKETS; b++) {
+		if (!buckets[b])
+			continue;
+		seq_printf(m, "%12llu %12llu %12llu\n",
+			   b ? esp_hist_bucket_hi(b - 1) : 0,
+			   esp_hist_bucket_hi(b), buckets[b]);
+	}
+	seq_printf(m, "total %llu\n", total);
+
+	return 0;
+}
+
+static int esp_hist_summary_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, esp_hist_summary_show, inode->i_private);
+}
+
+static int esp_hist_stage_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, esp_hist_stage_show, inode->i_private);
+}
+
+static ssize_t esp_hist_reset_write(struct file *file, const char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	esp_hist_reset();
+	return count;
+}
+
+static const struct file_operations esp_hist_summary_fops = {
+	.owner		= THIS_MODULE,
+	.open		= esp_hist_summary_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static const struct file_operations esp_hist_stage_fops = {
+	.owner		= THIS_MODULE,
+	.open		= esp_hist_stage_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static const struct file_operations esp_hist_reset_fops = {
+	.owner		= THIS_MODULE,
+	.open		= simple_open,
+	.write		= esp_hist_reset_write,
+};
+
+/* Files are removed along with the parent directory */
+void esp_hist_init(struct dentry *parent)
+{
+	struct dentry *dir;
+	int stage;
+
+	esp_hist_reset();
+
+	if (IS_ERR_OR_NULL(parent))
+		return;
+
+	dir = debugfs_create_dir("latency", parent);
+	if (IS_ERR_OR_NULL(dir))
+		return;
+
+	debugfs_create_file("summary", 0444, dir, NULL, &esp_hist_summary_fops);
+	debugfs_create_file("reset", 0200, dir, NULL, &esp_hist_reset_fops);
+	for (stage = 0; stage < ESP_HIST_MAX; stage++)
+		debugfs_create_file(esp_hist_names[stage], 0444, dir,
+				    (void *)(uintptr_t)stage,
+				    &esp_hist_stage_fops);
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+#ifndef __ESP_HIST__H__
+#define __ESP_HIST__H__
+
+#include <linux/types.h>
+#include <linux/timekeeping.h>
+
+struct dentry;
+
+/* Datapath stages timed by the latency histograms. Keep esp_hist_names[]
+ * in esp_hist.c in the same order. */
+enum esp_hist_stage {
+	ESP_HIST_TX_XMIT,	/* ndo_start_xmit -> frame on transport tx_q */
+	ESP_HIST_TX_QUEUE,	/* transport tx_q enqueue -> TX thread dequeue */
+	ESP_HIST_TX_CREDIT,	/* wait for slave RX buffer credit */
+	ESP_HIST_TX_WRITE,	/* CMD53 write of one aggregate */
+	ESP_HIST_RX_CLAIM,	/* claim SDIO host for a read */
+	ESP_HIST_RX_LEN,	/* read pending length + get RX buffer */
+	ESP_HIST_RX_XFER,	/* CMD53 read of the pending bytes */
+	ESP_HIST_RX_DELIVER,	/* read start -> netif_rx */
+	ESP_HIST_RAW_TP_RTT,	/* raw TP echo probe round trip */
+	ESP_HIST_MAX
+};
+
+/* Bucket n counts samples in [2^(n-1), 2^n) ns; bucket 0 is 0 ns and the
+ * last bucket also takes everything above 2^30 ns (~1 s). */
+#define ESP_HIST_BUCKETS	32
+
+void esp_hist_add(enum esp_hist_stage stage, u64 delta_ns);
+
+static inline void esp_hist_since(enum esp_hist_stage stage, u64 start_ns)
+{
+	if (start_ns)
+		esp_hist_add(stage, ktime_get_ns() - start_ns);
+}
+
+/* Upper bound (ns) of the bucket holding the percentile @pp10k (parts per
+ * 10000) of a log2 histogram laid out like the above */
+u64 esp_hist_percentile(const u64 buckets[ESP_HIST_BUCKETS], u64 total,
+			u32 pp10k);
+
+void esp_hist_reset(void);
+void esp_hist_init(struct dentry *parent);
+
+#endif
@@ -21,6 +21,7 @@
 #ifndef __ESP_IF__H_
 #define __ESP_IF__H_
 
+#include <linux/ethtool.h>
 #include "esp.h"
 
 struct esp_if_ops {
@@ -29,6 +30,19 @@ struct esp_if_ops {
 	int (*write)(struct esp_adapter *adapter, struct sk_buff *skb);
 	struct sk_buff* (*alloc_skb)(u32 len);
 	int (*deinit)(struct esp_adapter *adapter);
+
+	/* ethtool -S/-g/-G; optional, shared by all netdevs of the adapter */
+	int (*get_sset_count)(struct esp_adapter *adapter);
+	void (*get_strings)(struct esp_adapter *adapter, u8 *data);
+	void (*get_stats)(struct esp_adapter *adapter, u64 *data);
+	void (*get_ringparam)(struct esp_adapter *adapter,
+			struct ethtool_ringparam *ring);
+	int (*set_ringparam)(struct esp_adapter *adapter,
+			const struct ethtool_ringparam *ring);
+
+	/* Largest frame, header included, one write may carry; optional,
+	 * ETH_DATA_LEN payloads are assumed without it */
+	u32 (*max_tx_len)(struct esp_adapter *adapter);
 };
 
 int esp_init_interface_layer(struct esp_adapter *adapter);
@@ -54,6 +54,19 @@ static inline void ether_addr_copy(u8 *dst, const u8 *src)
     alloc_netdev(size, name, type, setup)
 #endif
 
+/* Trailing ndo_select_queue() arguments */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+  #define ESP_SELECT_QUEUE_ARGS struct net_device *sb_dev
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+  #define ESP_SELECT_QUEUE_ARGS struct net_device *sb_dev, \
+    select_queue_fallback_t fallback
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
+  #define ESP_SELECT_QUEUE_ARGS void *accel_priv, \
+    select_queue_fallback_t fallback
+#else
+  #define ESP_SELECT_QUEUE_ARGS void *accel_priv
+#endif
+
 
 
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(4, 5, 0))
@@ -74,6 +87,10 @@ static inline void ether_addr_copy(u8 *dst, const u8 *src)
 
 
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 12, 0)
+  #define kvmalloc(size, flags) vmalloc(size)
+#endif
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 13, 0)
 static inline void *skb_put_data(struct sk_buff *skb, const void *data,
 				 unsigned int len)
@@ -109,12 +126,38 @@ static inline void eth_hw_addr_set(struct net_device *dev, const u8 *addr)
 #define do_exit(code)	kthread_complete_and_exit(NULL, code)
 #endif
 
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 17, 0))
+    #define ETHTOOL_GET_RINGPARAM_PROTOTYPE() \
+        void esp_get_ringparam(struct net_device *ndev, \
+                struct ethtool_ringparam *ring)
+    #define ETHTOOL_SET_RINGPARAM_PROTOTYPE() \
+        int esp_set_ringparam(struct net_device *ndev, \
+                struct ethtool_ringparam *ring)
+#else
+    #define ETHTOOL_GET_RINGPARAM_PROTOTYPE() \
+        void esp_get_ringparam(struct net_device *ndev, \
+                struct ethtool_ringparam *ring, \
+                struct kernel_ethtool_ringparam *kernel_ring, \
+                struct netlink_ext_ack *extack)
+    #define ETHTOOL_SET_RINGPARAM_PROTOTYPE() \
+        int esp_set_ringparam(struct net_device *ndev, \
+                struct ethtool_ringparam *ring, \
+                struct kernel_ethtool_ringparam *kernel_ring, \
+                struct netlink_ext_ack *extack)
+#endif
+
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(6, 4, 0))
 #define CLASS_CREATE(x)	class_create(THIS_MODULE, x);
 #else
 #define CLASS_CREATE(x)	class_create(x);
 #endif
 
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(6, 8, 0))
+#define ESP_EVENTFD_SIGNAL(ctx)	eventfd_signal(ctx, 1)
+#else
+#define ESP_EVENTFD_SIGNAL(ctx)	eventfd_signal(ctx)
+#endif
+
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(6, 1, 91))
 #define spi_alloc_host(x,y) spi_alloc_master(x,y)
 #endif
@@ -128,4 +171,22 @@ static inline void eth_hw_addr_set(struct net_device *dev, const u8 *addr)
   #define del_timer timer_delete_sync
 #endif
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+  #define ESP_HRTIMER_SETUP(timer, fn, clock, mode) \
+	hrtimer_setup(timer, fn, clock, mode)
+#else
+  #define ESP_HRTIMER_SETUP(timer, fn, clock, mode) \
+	do { \
+		hrtimer_init(timer, clock, mode); \
+		(timer)->function = fn; \
+	} while (0)
+#endif
+
+/* Native XDP on the STA/AP netdevs, see esp_xdp.c */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 18, 0))
+  #define ESP_XDP_SUPPORT 1
+#else
+  #define ESP_XDP_SUPPORT 0
+#endif
+
 #endif
@@ -15,13 +15,14 @@
 #include <linux/uaccess.h>
 
 #include "esp_rb.h"
+#include "esp_kernel_port.h"
 
 int esp_rb_init(esp_rb_t *rb, size_t sz)
 {
 	esp_dbg("%u\n", __LINE__);
 	init_waitqueue_head(&(rb->wq));
 
-	rb->buf = kmalloc(sz, GFP_KERNEL);
+	rb->buf = kvmalloc(sz, GFP_KERNEL);
 	if (!rb->buf) {
 		esp_err("Failed to allocate memory for rb\n");
 		return -ENOMEM;
@@ -162,7 +163,7 @@ int esp_rb_write_by_kernel(esp_rb_t *rb, const char *buf, size_t sz)
 
 void esp_rb_cleanup(esp_rb_t *rb)
 {
-	kfree(rb->buf);
+	kvfree(rb->buf);
 	rb->buf = rb->end = rb->rp = rb->wp = NULL;
 	rb->size = 0;
 	esp_verbose("\n");
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+/* Recycled RX bus buffers and copybreak.
+ *
+ * Each transport reads from the slave into a buffer sized for the largest
+ * transfer: SPI_BUF_SIZE per SPI transaction, up to the E2H aggregate size
+ * per SDIO read. Those buffers come from a small per-transport free list
+ * and go back to it once the frames are out, so the bus path does not
+ * allocate them per read.
+ *
+ * A buffer holding a single frame of at least rx_copybreak bytes, and at
+ * least half the buffer, goes up the stack as is; the pool allocates a
+ * replacement the next time it runs dry. Anything smaller is copied into a
+ * right-sized skb, so a 64 byte TCP ACK no longer pins an MTU sized (SPI)
+ * or aggregate sized (SDIO) buffer in a socket queue. Frames of an SDIO
+ * aggregate are always copied out, as before.
+ *
+ *   <debugfs>/<module>/rx_pool   reuse, alloc and copy counters
+ */
+
+#include "esp_utils.h"
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/fs.h>
+#include "esp.h"
+#include "esp_rxpool.h"
+
+static u32 rx_copybreak = 256;
+module_param(rx_copybreak, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(rx_copybreak, "Frames smaller than this are always copied out of the RX bus buffer");
+
+static atomic_t rx_pool_reused;
+static atomic_t rx_pool_allocs;
+static atomic_t rx_pool_alloc_fail;
+static atomic_t rx_pool_copied;
+static atomic_t rx_pool_handed_up;
+
+static struct sk_buff *esp_rx_pool_alloc(struct esp_rx_pool *pool, u32 len)
+{
+	struct sk_buff *skb;
+
+	skb = pool->alloc_skb(len);
+	if (!skb) {
+		atomic_inc(&rx_pool_alloc_fail);
+		return NULL;
+	}
+
+	atomic_inc(&rx_pool_allocs);
+	return skb;
+}
+
+int esp_rx_pool_init(struct esp_rx_pool *pool,
+		struct sk_buff *(*alloc_skb)(u32 len), u32 buf_size)
+{
+	struct sk_buff *skb;
+	int i;
+
+	skb_queue_head_init(&pool->free);
+	pool->alloc_skb = alloc_skb;
+	pool->buf_size = buf_size;
+
+	for (i = 0; i < ESP_RX_POOL_DEPTH; i++) {
+		skb = esp_rx_pool_alloc(pool, buf_size);
+		if (!skb) {
+			esp_rx_pool_deinit(pool);
+			return -ENOMEM;
+		}
+		skb_queue_tail(&pool->free, skb);
+	}
+
+	return 0;
+}
+
+void esp_rx_pool_deinit(struct esp_rx_pool *pool)
+{
+	skb_queue_purge(&pool->free);
+}
+
+struct sk_buff *esp_rx_pool_get(struct esp_rx_pool *pool, u32 len)
+{
+	struct sk_buff *skb;
+
+	skb = skb_dequeue(&pool->free);
+	if (skb && skb_tailroom(skb) >= len) {
+		atomic_inc(&rx_pool_reused);
+		return skb;
+	}
+
+	/* Read larger than the pooled buffers: replace them as they come by */
+	if (skb)
+		dev_kfree_skb_any(skb);
+	if (len > pool->buf_size)
+		pool->buf_size = len;
+
+	return esp_rx_pool_alloc(pool, pool->buf_size);
+}
+
+void esp_rx_pool_put(struct esp_rx_pool *pool, struct sk_buff *skb)
+{
+	if (!skb)
+		return;
+
+	if (skb_shared(skb) || skb_cloned(skb) || skb_is_nonlinear(skb) ||
+	    skb_queue_len(&pool->free) >= ESP_RX_POOL_DEPTH) {
+		dev_kfree_skb_any(skb);
+		return;
+	}
+
+	/* Bus buffers are only ever skb_put()/skb_trim()'d */
+	__skb_trim(skb, 0);
+	if (skb_tailroom(skb) < pool->buf_size) {
+		dev_kfree_skb_any(skb);
+		return;
+	}
+
+	memset(skb->cb, 0, sizeof(skb->cb));
+	skb_queue_tail(&pool->free, skb);
+}
+
+struct sk_buff *esp_rx_pool_copybreak(struct esp_rx_pool *pool,
+		struct sk_buff *skb)
+{
+	struct sk_buff *copy;
+	u32 len = skb->len;
+
+	if (len >= READ_ONCE(rx_copybreak) && len >= pool->buf_size / 2) {
+		atomic_inc(&rx_pool_handed_up);
+		return skb;
+	}
+
+	/* Not the transport allocator: SPI rounds everything up to a full
+	 * transfer, and the copy is never used for DMA */
+	copy = netdev_alloc_skb(NULL, len);
+	if (!copy) {
+		/* Better an oversized skb than a dropped frame */
+		atomic_inc(&rx_pool_alloc_fail);
+		atomic_inc(&rx_pool_handed_up);
+		return skb;
+	}
+
+	skb_put_data(copy, skb->data, len);
+	((struct esp_skb_cb *)copy->cb)->tstamp =
+		((struct esp_skb_cb *)skb->cb)->tstamp;
+	atomic_inc(&rx_pool_copied);
+
+	esp_rx_pool_put(pool, skb);
+	return copy;
+}
+
+static int esp_rx_pool_show(struct seq_file *m, void *v)
+{
+	seq_printf(m, "rx_copybreak %u\n", READ_ONCE(rx_copybreak));
+	seq_printf(m, "reused %u\n", atomic_read(&rx_pool_reused));
+	seq_printf(m, "allocs %u\n", atomic_read(&rx_pool_allocs));
+	seq_printf(m, "alloc_fail %u\n", atomic_read(&rx_pool_alloc_fail));
+	seq_printf(m, "copied %u\n", atomic_read(&rx_pool_copied));
+	seq_printf(m, "handed_up %u\n", atomic_read(&rx_pool_handed_up));
+	return 0;
+}
+
+static int esp_rx_pool_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, esp_rx_pool_show, inode->i_private);
+}
+
+static const struct file_operations esp_rx_pool_fops = {
+	.owner		= THIS_MODULE,
+	.open		= esp_rx_pool_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/* Removed along with the parent directory */
+void esp_rx_pool_debugfs_init(struct dentry *parent)
+{
+	if (IS_ERR_OR_NULL(parent))
+		return;
+
+	debugfs_create_file("rx_pool", 0444, parent, NULL, &esp_rx_pool_fops);
+}
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+#ifndef __ESP_RXPOOL__H__
+#define __ESP_RXPOOL__H__
+
+#include <linux/skbuff.h>
+
+struct dentry;
+
+/* Bus buffers kept per transport */
+#define ESP_RX_POOL_DEPTH	4
+
+struct esp_rx_pool {
+	struct sk_buff_head	free;
+	/* Transport's if_ops->alloc_skb, for its alignment */
+	struct sk_buff		*(*alloc_skb)(u32 len);
+	/* Grows to the largest bus read seen */
+	u32			buf_size;
+};
+
+void esp_rx_pool_debugfs_init(struct dentry *parent);
+/* Pre-allocates ESP_RX_POOL_DEPTH buffers of @buf_size */
+int esp_rx_pool_init(struct esp_rx_pool *pool,
+		struct sk_buff *(*alloc_skb)(u32 len), u32 buf_size);
+void esp_rx_pool_deinit(struct esp_rx_pool *pool);
+/* Empty skb with at least @len bytes of tailroom, NULL if out of memory */
+struct sk_buff *esp_rx_pool_get(struct esp_rx_pool *pool, u32 len);
+/* Give a buffer back; anything that cannot be reused is freed */
+void esp_rx_pool_put(struct esp_rx_pool *pool, struct sk_buff *skb);
+/* @skb is a pool buffer trimmed to one frame. Returns the skb to hand up:
+ * @skb itself for a large frame, or a right-sized copy, @skb going back to
+ * the pool. */
+struct sk_buff *esp_rx_pool_copybreak(struct esp_rx_pool *pool,
+		struct sk_buff *skb);
+
+#endif
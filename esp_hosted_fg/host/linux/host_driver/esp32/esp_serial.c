@@ -28,6 +28,11 @@
 #include <linux/kthread.h>
 #include <linux/delay.h>
 #include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/eventfd.h>
+#include <linux/workqueue.h>
+#include <linux/log2.h>
 
 #include "esp.h"
 #include "esp_rb.h"
@@ -35,11 +40,12 @@
 #include "esp_kernel_port.h"
 #include "esp_if.h"
 #include "esp_serial.h"
+#include "esp_serial_ring.h"
 
 #define ESP_SERIAL_MAJOR      221
 #define ESP_SERIAL_MINOR_MAX  1
-#define ESP_RX_RB_SIZE        8192
-#define ESP_SERIAL_MAX_TX     (8192-(H_ESP_PAYLOAD_HEADER_OFFSET+8))
+/* Must hold a complete reassembled message, see SERIAL_REASM_MAX_LEN */
+#define ESP_RX_RB_SIZE        (128 * 1024)
 
 static struct esp_serial_devs {
 	struct device* dev;
@@ -48,10 +54,26 @@ static struct esp_serial_devs {
 	esp_rb_t rb;
 	void *priv;
 	struct mutex lock;
+
+	/* Optional mmap()ed ring, see esp_serial_ring.h */
+	struct esp_serial_ring_hdr *ring;
+	size_t ring_len;
+	u8 ring_mapped;     /* RX goes to ring only once user mapped it */
+	u8 *ring_rx;
+	u8 *ring_tx;
+	/* Driver private copies. Never trust sizes or own indices in shared page */
+	u32 rx_size;
+	u32 tx_size;
+	u32 rx_head;
+	u32 tx_tail;        /* written by tx_work only, once ring is set up */
+	u8 tx_failed;       /* record at tx_tail could not be sent */
+	struct eventfd_ctx *evfd;
+	struct work_struct tx_work;
 } devs[ESP_SERIAL_MINOR_MAX];
 
 static uint8_t serial_init_done;
 static atomic_t ref_count_open;
+static u16 serial_tx_seq_num;
 
 static ssize_t esp_serial_read(struct file *file, char __user *user_buffer, size_t size, loff_t *offset)
 {
@@ -73,38 +95,28 @@ static ssize_t esp_serial_read(struct file *file, char __user *user_buffer, size
 	return ret_size;
 }
 
-static ssize_t esp_serial_write(struct file *file, const char __user *user_buffer, size_t size, loff_t * offset)
+/* Send one serial message, fragmenting it if needed.
+ * buf is a user pointer if from_user is set, kernel pointer otherwise.
+ * Returns number of bytes sent or negative error */
+static ssize_t esp_serial_tx_msg(struct esp_serial_devs *dev, const u8 *buf,
+		size_t size, bool from_user)
 {
 	struct esp_payload_header *hdr = NULL;
 	u8 *tx_buf = NULL;
-	struct esp_serial_devs *dev = NULL;
 	struct sk_buff *tx_skb = NULL;
 	int ret = 0;
 	size_t total_len = 0;
 	size_t frag_len = 0;
 	u32 left_len = size;
-	static u16 seq_num = 0;
 	u8 flag = 0;
-	u8 *pos;
-	struct esp_adapter *adapter = NULL;
-
-	if (size > ESP_SERIAL_MAX_TX) {
-		esp_err("Exceed max tx buffer size [%zu]\n", size);
-		return 0;
-	}
-
-	seq_num++;
-	dev = (struct esp_serial_devs *) file->private_data;
-
-	/* Check if slave connection is still active */
-	if (!dev || !dev->priv) {
-		esp_warn("slave disconnected, write aborted\n");
-		return -ENODEV;
-	}
+	const u8 *pos = buf;
+	struct esp_adapter *adapter = dev->priv;
+	/* Announce total length in first fragment, if slave supports it */
+	u8 prefix_len = ((size > ETH_DATA_LEN) &&
+			(adapter->serial_caps & ESP_SERIAL_CAP_TOTAL_LEN)) ?
+			ESP_SERIAL_TOTAL_LEN_SIZE : 0;
 
-	adapter = dev->priv;
-
-	pos = (u8 *) user_buffer;
+	serial_tx_seq_num++;
 
 	do {
 		if (atomic_read(&(adapter->state)) < ESP_CONTEXT_READY) {
@@ -119,15 +131,15 @@ static ssize_t esp_serial_write(struct file *file, const char __user *user_buffe
 		 *  - Fragment large packets into multiple 1500 byte packets
 		 *  - MORE_FRAGMENT bit in flag tells if there are more fragments expected
 		 **/
-		if (left_len > ETH_DATA_LEN) {
-			frag_len = ETH_DATA_LEN;
+		if (left_len + prefix_len > ETH_DATA_LEN) {
+			frag_len = ETH_DATA_LEN - prefix_len;
 			flag = MORE_FRAGMENT;
 		} else {
 			frag_len = left_len;
 			flag = 0;
 		}
 
-		total_len = frag_len + sizeof(struct esp_payload_header);
+		total_len = prefix_len + frag_len + sizeof(struct esp_payload_header);
 
 		tx_skb = adapter->if_ops->alloc_skb(total_len);
 		if (!tx_skb) {
@@ -143,18 +155,32 @@ static ssize_t esp_serial_write(struct file *file, const char __user *user_buffe
 
 		hdr->if_type = ESP_SERIAL_IF;
 		hdr->if_num = dev->dev_index;
-		hdr->len = cpu_to_le16(frag_len);
-		hdr->seq_num = cpu_to_le16(seq_num);
+		hdr->len = cpu_to_le16(prefix_len + frag_len);
+		hdr->seq_num = cpu_to_le16(serial_tx_seq_num);
 		hdr->offset = cpu_to_le16(sizeof(struct esp_payload_header));
 		hdr->flags |= flag;
 
-		ret = copy_from_user(tx_buf + hdr->offset, pos, frag_len);
-		if (ret) {
-			dev_kfree_skb(tx_skb);
-			esp_err("Error copying buffer to send serial data\n");
-			return (size - left_len);
+		if (prefix_len) {
+			hdr->flags |= FLAG_FRAG_TOTAL_LEN;
+			tx_buf[hdr->offset] = size & 0xFF;
+			tx_buf[hdr->offset + 1] = (size >> 8) & 0xFF;
+			tx_buf[hdr->offset + 2] = (size >> 16) & 0xFF;
+			tx_buf[hdr->offset + 3] = (size >> 24) & 0xFF;
+			tx_buf += prefix_len;
+		}
+
+		if (from_user) {
+			ret = copy_from_user(tx_buf + hdr->offset,
+					(const void __user *) pos, frag_len);
+			if (ret) {
+				dev_kfree_skb(tx_skb);
+				esp_err("Error copying buffer to send serial data\n");
+				return (size - left_len);
+			}
+		} else {
+			memcpy(tx_buf + hdr->offset, pos, frag_len);
 		}
-		esp_hex_dump_dbg("esp_serial_tx: ", pos, frag_len);
+		esp_hex_dump_dbg("esp_serial_tx: ", tx_buf + hdr->offset, frag_len);
 
 		ret = esp_send_packet(adapter, tx_skb);
 		if (ret) {
@@ -164,17 +190,296 @@ static ssize_t esp_serial_write(struct file *file, const char __user *user_buffe
 
 		left_len -= frag_len;
 		pos += frag_len;
+		prefix_len = 0;
 	} while(left_len);
 
 	return size;
 }
 
-static long esp_serial_ioctl (struct file *file, unsigned int cmd, unsigned long arg)
+static ssize_t esp_serial_write(struct file *file, const char __user *user_buffer, size_t size, loff_t * offset)
+{
+	struct esp_serial_devs *dev = NULL;
+
+	if (size > ESP_SERIAL_MAX_TX) {
+		esp_err("Exceed max tx buffer size [%zu]\n", size);
+		return 0;
+	}
+
+	dev = (struct esp_serial_devs *) file->private_data;
+
+	/* Check if slave connection is still active */
+	if (!dev || !dev->priv) {
+		esp_warn("slave disconnected, write aborted\n");
+		return -ENODEV;
+	}
+
+	return esp_serial_tx_msg(dev, (const u8 *) user_buffer, size, true);
+}
+
+/* Append received bytes to RX ring. Whole chunk is dropped if it doesn't fit,
+ * as a partial write would break the TLV stream for the reader */
+static int esp_serial_ring_rx(struct esp_serial_devs *dev, const char *data, size_t len)
+{
+	struct esp_serial_ring_hdr *hdr = dev->ring;
+	u32 tail = smp_load_acquire(&hdr->rx_tail);
+	u32 used = dev->rx_head - tail;
+	u32 off, first;
+
+	if (used > dev->rx_size || len > dev->rx_size - used) {
+		WRITE_ONCE(hdr->rx_dropped, hdr->rx_dropped + len);
+		esp_err("RX ring full, no space to receive. Dropping packet\n");
+		return -ENOSPC;
+	}
+
+	off = dev->rx_head & (dev->rx_size - 1);
+	first = min_t(u32, len, dev->rx_size - off);
+	memcpy(dev->ring_rx + off, data, first);
+	memcpy(dev->ring_rx, data + first, len - first);
+
+	dev->rx_head += len;
+	smp_store_release(&hdr->rx_head, dev->rx_head);
+
+	wake_up_interruptible(&dev->rb.wq);
+	if (dev->evfd)
+		ESP_EVENTFD_SIGNAL(dev->evfd);
+
+	return len;
+}
+
+/* Only consumer of the TX ring. Runs without dev->lock, so RX isn't held up
+ * while messages are sent: the ring can't go away under it, as
+ * esp_serial_ring_free() cancels this work before freeing it */
+static void esp_serial_ring_tx_work(struct work_struct *work)
+{
+	struct esp_serial_devs *dev = container_of(work, struct esp_serial_devs, tx_work);
+	struct esp_serial_ring_hdr *hdr = NULL;
+	u8 *ring_tx = NULL;
+	u32 head, tail, off, len, rec_len, tx_size;
+	ssize_t ret;
+
+	mutex_lock(&dev->lock);
+	hdr = dev->ring;
+	ring_tx = dev->ring_tx;
+	tx_size = dev->tx_size;
+	tail = dev->tx_tail;
+	mutex_unlock(&dev->lock);
+	if (!hdr)
+		return;
+
+	/* Kicked again: retry the record which failed, if any */
+	WRITE_ONCE(dev->tx_failed, 0);
+
+	/* While draining, user need not kick */
+	WRITE_ONCE(hdr->tx_need_kick, 0);
+
+	while (1) {
+		head = smp_load_acquire(&hdr->tx_head);
+
+		if (head == tail) {
+			/* Re-arm kick and re-check, else a record published
+			 * just before need_kick was set could be left behind */
+			WRITE_ONCE(hdr->tx_need_kick, 1);
+			smp_mb();
+			if (READ_ONCE(hdr->tx_head) == tail) {
+				/* Drained: writers waiting for POLLOUT */
+				wake_up_interruptible(&dev->rb.wq);
+				break;
+			}
+			WRITE_ONCE(hdr->tx_need_kick, 0);
+			continue;
+		}
+
+		if (head - tail > tx_size) {
+			esp_err("TX ring indices corrupted [%u:%u], resetting\n", head, tail);
+			tail = head;
+			goto advance;
+		}
+
+		off = tail & (tx_size - 1);
+		len = READ_ONCE(*(u32 *)(ring_tx + off));
+
+		if (len == ESP_SERIAL_RING_PAD) {
+			tail += tx_size - off;
+			goto advance;
+		}
+
+		/* Record not within what was published: the next one can't be
+		 * found either */
+		rec_len = ESP_SERIAL_RING_ALIGN(ESP_SERIAL_RING_REC_HDR_LEN + len);
+		if (!len || len > tx_size ||
+		    rec_len > tx_size - off || rec_len > head - tail) {
+			esp_err("Invalid TX ring record len[%u], dropping pending data\n", len);
+			tail = head;
+			goto advance;
+		}
+
+		if (len > ESP_SERIAL_MAX_TX) {
+			esp_err("TX ring record len[%u] exceeds max, skipped\n", len);
+		} else {
+			ret = esp_serial_tx_msg(dev, ring_tx + off + ESP_SERIAL_RING_REC_HDR_LEN,
+					len, false);
+			if (ret != len) {
+				/* Leave record at tail for next kick, user sees
+				 * POLLERR and tx_errors */
+				esp_err("TX ring record send failed: %zd\n", ret);
+				WRITE_ONCE(hdr->tx_errors, hdr->tx_errors + 1);
+				WRITE_ONCE(dev->tx_failed, 1);
+				WRITE_ONCE(hdr->tx_need_kick, 1);
+				wake_up_interruptible(&dev->rb.wq);
+				break;
+			}
+		}
+		tail += rec_len;
+advance:
+		WRITE_ONCE(dev->tx_tail, tail);
+		smp_store_release(&hdr->tx_tail, tail);
+	}
+}
+
+static int esp_serial_ring_enable(struct esp_serial_devs *dev, void __user *argp)
 {
-	esp_info("IOCTL unsupported %u\n", cmd);
+	struct esp_serial_ring_cfg cfg;
+	struct esp_serial_ring_hdr *hdr = NULL;
+	size_t len;
+
+	if (copy_from_user(&cfg, argp, sizeof(cfg)))
+		return -EFAULT;
+
+	if (!cfg.rx_size)
+		cfg.rx_size = ESP_SERIAL_RING_DEF_SIZE;
+	if (!cfg.tx_size)
+		cfg.tx_size = ESP_SERIAL_RING_DEF_SIZE;
+
+	if (!is_power_of_2(cfg.rx_size) || !is_power_of_2(cfg.tx_size) ||
+	    cfg.rx_size < ESP_SERIAL_RING_MIN_SIZE || cfg.rx_size > ESP_SERIAL_RING_MAX_SIZE ||
+	    cfg.tx_size < ESP_SERIAL_RING_MIN_SIZE || cfg.tx_size > ESP_SERIAL_RING_MAX_SIZE) {
+		esp_err("Invalid ring size rx[%u] tx[%u]\n", cfg.rx_size, cfg.tx_size);
+		return -EINVAL;
+	}
+
+	len = PAGE_ALIGN(PAGE_SIZE + cfg.rx_size + cfg.tx_size);
+
+	mutex_lock(&dev->lock);
+	if (dev->ring) {
+		mutex_unlock(&dev->lock);
+		return -EBUSY;
+	}
+
+	hdr = vmalloc_user(len);
+	if (!hdr) {
+		mutex_unlock(&dev->lock);
+		return -ENOMEM;
+	}
+
+	hdr->magic = ESP_SERIAL_RING_MAGIC;
+	hdr->version = ESP_SERIAL_RING_VERSION;
+	hdr->rx_size = cfg.rx_size;
+	hdr->tx_size = cfg.tx_size;
+	hdr->rx_off = PAGE_SIZE;
+	hdr->tx_off = PAGE_SIZE + cfg.rx_size;
+	hdr->tx_need_kick = 1;
+
+	dev->ring_len = len;
+	dev->ring_rx = (u8 *)hdr + hdr->rx_off;
+	dev->ring_tx = (u8 *)hdr + hdr->tx_off;
+	dev->rx_size = cfg.rx_size;
+	dev->tx_size = cfg.tx_size;
+	dev->rx_head = 0;
+	dev->tx_tail = 0;
+	dev->tx_failed = 0;
+	dev->ring = hdr;
+	mutex_unlock(&dev->lock);
+
+	cfg.map_size = len;
+	if (copy_to_user(argp, &cfg, sizeof(cfg)))
+		return -EFAULT;
+
+	esp_info("serial ring enabled rx[%u] tx[%u]\n", cfg.rx_size, cfg.tx_size);
 	return 0;
 }
 
+static int esp_serial_set_eventfd(struct esp_serial_devs *dev, void __user *argp)
+{
+	struct eventfd_ctx *ctx = NULL;
+	int32_t fd;
+
+	if (copy_from_user(&fd, argp, sizeof(fd)))
+		return -EFAULT;
+
+	/* negative fd unregisters */
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	}
+
+	mutex_lock(&dev->lock);
+	swap(dev->evfd, ctx);
+	mutex_unlock(&dev->lock);
+
+	if (ctx)
+		eventfd_ctx_put(ctx);
+
+	return 0;
+}
+
+static void esp_serial_ring_free(struct esp_serial_devs *dev)
+{
+	cancel_work_sync(&dev->tx_work);
+
+	mutex_lock(&dev->lock);
+	if (dev->evfd) {
+		eventfd_ctx_put(dev->evfd);
+		dev->evfd = NULL;
+	}
+	/* Pages stay alive while still mapped by user */
+	dev->ring_mapped = 0;
+	vfree(dev->ring);
+	dev->ring = NULL;
+	dev->ring_rx = dev->ring_tx = NULL;
+	dev->ring_len = 0;
+	mutex_unlock(&dev->lock);
+}
+
+static long esp_serial_ioctl (struct file *file, unsigned int cmd, unsigned long arg)
+{
+	struct esp_serial_devs *dev = (struct esp_serial_devs *) file->private_data;
+
+	if (!dev || !dev->priv)
+		return -ENODEV;
+
+	switch (cmd) {
+	case ESP_SERIAL_IOC_RING_ENABLE:
+		return esp_serial_ring_enable(dev, (void __user *) arg);
+	case ESP_SERIAL_IOC_SET_EVENTFD:
+		return esp_serial_set_eventfd(dev, (void __user *) arg);
+	case ESP_SERIAL_IOC_TX_KICK:
+		if (!READ_ONCE(dev->ring))
+			return -EINVAL;
+		schedule_work(&dev->tx_work);
+		return 0;
+	default:
+		esp_info("IOCTL unsupported %u\n", cmd);
+		return -ENOTTY;
+	}
+}
+
+static int esp_serial_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct esp_serial_devs *dev = (struct esp_serial_devs *) file->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret = -EINVAL;
+
+	mutex_lock(&dev->lock);
+	if (dev->ring && !vma->vm_pgoff && size <= dev->ring_len)
+		ret = remap_vmalloc_range(vma, dev->ring, 0);
+	if (!ret)
+		WRITE_ONCE(dev->ring_mapped, 1);
+	mutex_unlock(&dev->lock);
+
+	return ret;
+}
+
 static int esp_serial_open(struct inode *inode, struct file *file)
 {
 	struct esp_serial_devs *devs = NULL;
@@ -197,6 +502,11 @@ static int esp_serial_open(struct inode *inode, struct file *file)
 
 static int esp_serial_release(struct inode *inode, struct file *file)
 {
+	struct esp_serial_devs *dev = (struct esp_serial_devs *) file->private_data;
+
+	if (dev)
+		esp_serial_ring_free(dev);
+
 	if (atomic_read(&ref_count_open)) {
 		atomic_dec(&ref_count_open);
 	} else {
@@ -214,10 +524,20 @@ static unsigned int esp_serial_poll(struct file *file, poll_table *wait)
     mutex_lock(&dev->lock);
     poll_wait(file, &dev->rb.wq,  wait);
 
-    if (dev->rb.rp != dev->rb.wp) {
+    /* With a mapped ring, RX no longer goes to rb: whatever was left
+     * there from before must not keep POLLIN asserted */
+    if (!dev->ring_mapped && dev->rb.rp != dev->rb.wp) {
         mask |= (POLLIN | POLLRDNORM) ;   /* readable */
     }
-    if (get_free_space(&dev->rb)) {
+    if (dev->ring_mapped && dev->rx_head != READ_ONCE(dev->ring->rx_tail)) {
+        mask |= (POLLIN | POLLRDNORM) ;   /* ring readable */
+    }
+    if (dev->ring_mapped) {
+        if (READ_ONCE(dev->tx_tail) == READ_ONCE(dev->ring->tx_head))
+            mask |= (POLLOUT | POLLWRNORM) ;  /* TX ring drained */
+        if (READ_ONCE(dev->tx_failed))
+            mask |= POLLERR ;                 /* TX ring send failed */
+    } else if (get_free_space(&dev->rb)) {
         mask |= (POLLOUT | POLLWRNORM) ;  /* writable */
     }
 
@@ -232,6 +552,7 @@ const struct file_operations esp_serial_fops = {
 	.write = esp_serial_write,
 	.unlocked_ioctl = esp_serial_ioctl,
 	.poll = esp_serial_poll,
+	.mmap = esp_serial_mmap,
 	.release = esp_serial_release,
 };
 
@@ -249,6 +570,16 @@ int esp_serial_data_received(int dev_index, const char *data, size_t len)
 		return len;
 	}
 
+	if (READ_ONCE(devs[dev_index].ring_mapped)) {
+		mutex_lock(&devs[dev_index].lock);
+		if (devs[dev_index].ring_mapped) {
+			ret = esp_serial_ring_rx(&devs[dev_index], data, len);
+			mutex_unlock(&devs[dev_index].lock);
+			return ret;
+		}
+		mutex_unlock(&devs[dev_index].lock);
+	}
+
 	while (ret_len != len) {
 		ret = esp_rb_write_by_kernel(&devs[dev_index].rb,
 				data+ret_len, (len-ret_len));
@@ -305,6 +636,7 @@ int esp_serial_init(void *priv)
 		esp_rb_init(&devs[i].rb, ESP_RX_RB_SIZE);
 		devs[i].priv = priv;
 		mutex_init(&devs[i].lock);
+		INIT_WORK(&devs[i].tx_work, esp_serial_ring_tx_work);
 	}
 
 	serial_init_done = 1;
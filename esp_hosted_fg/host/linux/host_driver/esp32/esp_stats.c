@@ -10,90 +10,370 @@
 
 #include <linux/timer.h>
 #include <linux/kthread.h>
+#include <linux/delay.h>
+#include <linux/log2.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+#include "esp_hist.h"
+
+/* Raw TP results, kept until the next test starts or reset is written:
+ *
+ *   <debugfs>/<module>/raw_tp/results   one line per frame size step
+ *   <debugfs>/<module>/raw_tp/reset     write anything to clear
+ *
+ * In echo mode every host frame carries a probe the slave sends back
+ * unchanged; one probe is in flight at a time (ping-pong) and its round
+ * trip goes to the step and to the raw_tp_rtt latency histogram.
+ */
 
 #define BYTES_TO_KBITS(x)    ((x*8)/1024)
 
+#define RAW_TP_MIN_SIZE          64
+#define RAW_TP_STEPS_MAX         16
+#define RAW_TP_ECHO_TIMEOUT_MS   1000
+#define RAW_TP_PROBE_MAGIC       0x50545452	/* "RTTP" */
+
+static u32 raw_tp_size = TEST_RAW_TP__BUF_SIZE;
+module_param(raw_tp_size, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(raw_tp_size, "Raw TP: payload bytes of host frames");
+
+static u32 raw_tp_sweep;
+module_param(raw_tp_sweep, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(raw_tp_sweep, "Raw TP: step host frame size from 64 through MTU up to the transport maximum");
+
+static u32 raw_tp_step_sec = 5;
+module_param(raw_tp_step_sec, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(raw_tp_step_sec, "Raw TP: seconds per frame size in a sweep");
+
+static u32 raw_tp_pace_us;
+module_param(raw_tp_pace_us, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(raw_tp_pace_us, "Raw TP: gap between host frames in us, 0 to send back to back");
+
+/* Start of every host frame payload */
+struct raw_tp_probe {
+	__le32 magic;
+	__le32 seq;
+	__le64 tx_ns;
+} __packed;
+
+struct raw_tp_step {
+	u32 size;
+	u64 start_ns;
+	u64 end_ns;
+	u64 tx_frames;
+	u64 tx_bytes;
+	u64 tx_fail;
+	u64 rx_frames;
+	u64 rx_bytes;
+	u64 echo_lost;
+	u64 rtt_min_ns;
+	u64 rtt_max_ns;
+	u64 rtt_sum_ns;
+	u64 rtt_bucket[ESP_HIST_BUCKETS];
+};
+
 static struct task_struct *raw_tp_tx_thread;
 static int test_raw_tp;
-static int test_raw_tp__host_to_esp;
+/* ESP_TEST_RAW_TP* bits of the running test */
+static u8 test_raw_tp_cap;
 static struct timer_list log_raw_tp_stats_timer;
 static u8 log_raw_tp_stats_timer_running;
-static unsigned long test_raw_tp_len;
 static u32 raw_tp_timer_count;
 static u8 traffic_open_init_done;
 static struct completion traffic_open;
 
+/* Protects the steps and the per second window below */
+static DEFINE_SPINLOCK(raw_tp_lock);
+static struct raw_tp_step raw_tp_steps[RAW_TP_STEPS_MAX];
+static u32 raw_tp_nr_steps;
+static unsigned long raw_tp_win_tx;
+static unsigned long raw_tp_win_rx;
+static u64 raw_tp_win_rtt_ns;
+static u32 raw_tp_win_rtt_count;
+
+static DECLARE_COMPLETION(raw_tp_echo);
+static u32 raw_tp_echo_seq;
+
+static const char *raw_tp_mode_name(u8 cap)
+{
+	if (cap & ESP_TEST_RAW_TP__ECHO)
+		return "echo";
+	if (cap & ESP_TEST_RAW_TP__BIDIR)
+		return "bidir";
+	if (cap & ESP_TEST_RAW_TP__ESP_TO_HOST)
+		return "esp_to_host";
+	return "host_to_esp";
+}
+
+static bool raw_tp_host_sends(u8 cap)
+{
+	return !(cap & ESP_TEST_RAW_TP__ESP_TO_HOST) ||
+		(cap & ESP_TEST_RAW_TP__BIDIR);
+}
+
+static bool raw_tp_host_counts_rx(u8 cap)
+{
+	return cap & (ESP_TEST_RAW_TP__ESP_TO_HOST | ESP_TEST_RAW_TP__BIDIR |
+			ESP_TEST_RAW_TP__ECHO);
+}
+
+/* Largest payload of one host test frame */
+static u32 raw_tp_max_size(struct esp_adapter *adapter)
+{
+	u32 len;
+
+	if (!adapter->if_ops->max_tx_len)
+		return ETH_DATA_LEN;
+
+	len = adapter->if_ops->max_tx_len(adapter);
+	len = min_t(u32, len, U16_MAX);
+
+	return len - sizeof(struct esp_payload_header) - SKB_DATA_ADDR_ALIGNMENT;
+}
+
+/* 64, 128, ... 1024, MTU, 2048, ... up to @max_size; 0 once past it */
+static u32 raw_tp_next_size(u32 size, u32 max_size)
+{
+	u32 next;
+
+	if (size >= max_size)
+		return 0;
+
+	next = roundup_pow_of_two(size + 1);
+	if (size < ETH_DATA_LEN && next > ETH_DATA_LEN)
+		next = ETH_DATA_LEN;
+
+	return min(next, max_size);
+}
+
+static struct raw_tp_step *raw_tp_cur_step(void)
+{
+	return raw_tp_nr_steps ? &raw_tp_steps[raw_tp_nr_steps - 1] : NULL;
+}
+
+/* Close the current step and open one for @size; false if out of slots */
+static bool raw_tp_step_begin(u32 size)
+{
+	struct raw_tp_step *step;
+	u64 now = ktime_get_ns();
+	bool ok = false;
+
+	spin_lock_bh(&raw_tp_lock);
+	step = raw_tp_cur_step();
+	if (step && !step->end_ns)
+		step->end_ns = now;
+
+	if (raw_tp_nr_steps < RAW_TP_STEPS_MAX) {
+		step = &raw_tp_steps[raw_tp_nr_steps++];
+		memset(step, 0, sizeof(*step));
+		step->size = size;
+		step->start_ns = now;
+		ok = true;
+	}
+	spin_unlock_bh(&raw_tp_lock);
+
+	return ok;
+}
+
+static void raw_tp_step_end(void)
+{
+	struct raw_tp_step *step;
+
+	spin_lock_bh(&raw_tp_lock);
+	step = raw_tp_cur_step();
+	if (step && !step->end_ns)
+		step->end_ns = ktime_get_ns();
+	spin_unlock_bh(&raw_tp_lock);
+}
+
+static void raw_tp_steps_clear(void)
+{
+	spin_lock_bh(&raw_tp_lock);
+	raw_tp_nr_steps = 0;
+	raw_tp_win_tx = raw_tp_win_rx = 0;
+	raw_tp_win_rtt_ns = 0;
+	raw_tp_win_rtt_count = 0;
+	spin_unlock_bh(&raw_tp_lock);
+}
+
 static void log_raw_tp_stats_timer_cb(struct timer_list *timer)
 {
-	unsigned long actual_bandwidth = 0;
+	unsigned long tx, rx;
+	u64 rtt_ns;
+	u32 rtt_count;
 
 	/* Don't re-arm once cleanup cleared the flag (else timer outlives unload). */
 	if (!log_raw_tp_stats_timer_running)
 		return;
 
 	mod_timer(&log_raw_tp_stats_timer, jiffies + msecs_to_jiffies(1000));
-	actual_bandwidth = BYTES_TO_KBITS(test_raw_tp_len);
-	printk("%u-%u sec       %lu kbits/sec\n\r",
-			raw_tp_timer_count,
-			raw_tp_timer_count + 1, actual_bandwidth);
+
+	spin_lock_bh(&raw_tp_lock);
+	tx = raw_tp_win_tx;
+	rx = raw_tp_win_rx;
+	rtt_ns = raw_tp_win_rtt_ns;
+	rtt_count = raw_tp_win_rtt_count;
+	raw_tp_win_tx = raw_tp_win_rx = 0;
+	raw_tp_win_rtt_ns = 0;
+	raw_tp_win_rtt_count = 0;
+	spin_unlock_bh(&raw_tp_lock);
+
+	if (test_raw_tp_cap & ESP_TEST_RAW_TP__ECHO)
+		printk("%u-%u sec       %u echoes, rtt avg %llu us\n\r",
+				raw_tp_timer_count, raw_tp_timer_count + 1, rtt_count,
+				rtt_count ? div_u64(rtt_ns, rtt_count) / NSEC_PER_USEC : 0);
+	else if (test_raw_tp_cap & ESP_TEST_RAW_TP__BIDIR)
+		printk("%u-%u sec       tx %lu rx %lu kbits/sec\n\r",
+				raw_tp_timer_count, raw_tp_timer_count + 1,
+				BYTES_TO_KBITS(tx), BYTES_TO_KBITS(rx));
+	else
+		printk("%u-%u sec       %lu kbits/sec\n\r",
+				raw_tp_timer_count, raw_tp_timer_count + 1,
+				BYTES_TO_KBITS(raw_tp_host_sends(test_raw_tp_cap) ? tx : rx));
 
 	raw_tp_timer_count++;
-	test_raw_tp_len = 0;
 }
 
-static int raw_tp_tx_process(void *data)
+static int raw_tp_send(struct esp_adapter *adapter, u32 size, u32 seq)
 {
-	int ret = 0;
 	struct sk_buff *tx_skb = NULL;
 	struct esp_payload_header *payload_header = NULL;
-	struct esp_adapter *adapter = esp_get_adapter();
-	u8 pad_len = 0;
-	u16 total_len = 0;
+	struct raw_tp_probe probe;
+	struct raw_tp_step *step;
+	u32 pad_len = 0;
+	u32 total_len = 0;
+	int ret;
 
 	pad_len = sizeof(struct esp_payload_header);
-	total_len = TEST_RAW_TP__BUF_SIZE + pad_len;
+	total_len = size + pad_len;
 	pad_len += SKB_DATA_ADDR_ALIGNMENT - (total_len % SKB_DATA_ADDR_ALIGNMENT);
 	/* recompute so the skb holds header(pad_len) + payload, not just payload */
-	total_len = TEST_RAW_TP__BUF_SIZE + pad_len;
+	total_len = size + pad_len;
+
+	tx_skb = adapter->if_ops->alloc_skb(total_len);
+	if (!tx_skb) {
+		esp_err("%u esp_alloc_skb failed\n", __LINE__);
+		msleep(10);
+		return -ENOMEM;
+	}
+	skb_put(tx_skb, total_len);
+	memset(tx_skb->data, 0, total_len);
+
+	payload_header = (struct esp_payload_header *) tx_skb->data;
+
+	payload_header->if_type = ESP_TEST_IF;
+	payload_header->if_num = 0;
+	payload_header->len = cpu_to_le16(size);
+	payload_header->offset = cpu_to_le16(pad_len);
+	/* before the checksum, which covers the header */
+	esp_stamp_tx_seq(payload_header);
+
+	probe.magic = cpu_to_le32(RAW_TP_PROBE_MAGIC);
+	probe.seq = cpu_to_le32(seq);
+	probe.tx_ns = cpu_to_le64(ktime_get_ns());
+	memcpy(tx_skb->data + pad_len, &probe, sizeof(probe));
+
+	if (adapter->capabilities & ESP_CHECKSUM_ENABLED) {
+		payload_header->checksum =
+			cpu_to_le16(compute_checksum(tx_skb->data, total_len));
+	}
+
+	ret = esp_send_packet(adapter, tx_skb);
+
+	spin_lock_bh(&raw_tp_lock);
+	step = raw_tp_cur_step();
+	if (step) {
+		if (ret) {
+			step->tx_fail++;
+		} else {
+			step->tx_frames++;
+			step->tx_bytes += size;
+		}
+	}
+	if (!ret)
+		raw_tp_win_tx += size;
+	spin_unlock_bh(&raw_tp_lock);
+
+	return ret;
+}
+
+static void raw_tp_wait_echo(void)
+{
+	struct raw_tp_step *step;
+
+	if (wait_for_completion_timeout(&raw_tp_echo,
+				msecs_to_jiffies(RAW_TP_ECHO_TIMEOUT_MS)))
+		return;
+
+	spin_lock_bh(&raw_tp_lock);
+	step = raw_tp_cur_step();
+	if (step)
+		step->echo_lost++;
+	spin_unlock_bh(&raw_tp_lock);
+}
+
+static int raw_tp_tx_process(void *data)
+{
+	int ret = 0;
+	struct esp_adapter *adapter = esp_get_adapter();
+	bool echo = test_raw_tp_cap & ESP_TEST_RAW_TP__ECHO;
+	u32 max_size = raw_tp_max_size(adapter);
+	u32 size, seq = 0;
+	u64 step_end;
+
+	if (raw_tp_sweep)
+		size = min_t(u32, RAW_TP_MIN_SIZE, max_size);
+	else
+		size = clamp_t(u32, raw_tp_size, sizeof(struct raw_tp_probe), max_size);
 
 	msleep(2000);
 
-	while (!kthread_should_stop()) {
+	raw_tp_step_begin(size);
+	step_end = ktime_get_ns() + (u64)raw_tp_step_sec * NSEC_PER_SEC;
 
-		if (esp_is_tx_queue_paused()) {
+	while (!kthread_should_stop()) {
 
-			tx_skb = adapter->if_ops->alloc_skb(total_len);
-			if (!tx_skb) {
-				esp_err("%u esp_alloc_skb failed\n", __LINE__);
-				msleep(10);
-				continue;
+		if (raw_tp_sweep && ktime_get_ns() >= step_end) {
+			size = raw_tp_next_size(size, max_size);
+			if (!size || !raw_tp_step_begin(size)) {
+				raw_tp_step_end();
+				esp_info("raw tp size sweep done\n");
+				break;
 			}
-			skb_put(tx_skb, total_len);
-			memset(tx_skb->data, 0, total_len);
-
-			payload_header = (struct esp_payload_header *) tx_skb->data;
-			memset(payload_header, 0, pad_len);
+			step_end = ktime_get_ns() + (u64)raw_tp_step_sec * NSEC_PER_SEC;
+		}
 
-			payload_header->if_type = ESP_TEST_IF;
-			payload_header->if_num = 0;
-			payload_header->len = cpu_to_le16(TEST_RAW_TP__BUF_SIZE);
-			payload_header->offset = cpu_to_le16(pad_len);
+		if (esp_is_tx_queue_paused()) {
 
-			if (adapter->capabilities & ESP_CHECKSUM_ENABLED) {
-				payload_header->checksum =
-					cpu_to_le16(compute_checksum(tx_skb->data,
-							TEST_RAW_TP__BUF_SIZE + pad_len));
+			seq++;
+			if (echo) {
+				reinit_completion(&raw_tp_echo);
+				WRITE_ONCE(raw_tp_echo_seq, seq);
 			}
 
-			ret = esp_send_packet(esp_get_adapter(), tx_skb);
-			if(!ret)
-				test_raw_tp_len += TEST_RAW_TP__BUF_SIZE;
+			ret = raw_tp_send(adapter, size, seq);
+			if (!ret && echo)
+				raw_tp_wait_echo();
+
+			if (raw_tp_pace_us)
+				usleep_range(raw_tp_pace_us,
+						raw_tp_pace_us + raw_tp_pace_us / 8 + 1);
 
 		} else {
 			if (traffic_open_init_done)
 				wait_for_completion_interruptible(&traffic_open);
 		}
 	}
+
+	/* Sweep over: results stay in debugfs until the test is stopped */
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+	}
+
 	esp_info("raw tp tx thrd stopped\n");
 	return 0;
 }
@@ -104,16 +384,23 @@ static void process_raw_tp_flags(void)
 
 	if (test_raw_tp) {
 
+		raw_tp_steps_clear();
+
 		timer_setup(&log_raw_tp_stats_timer, log_raw_tp_stats_timer_cb, 0);
 		mod_timer(&log_raw_tp_stats_timer, jiffies + msecs_to_jiffies(1000));
 		log_raw_tp_stats_timer_running = 1;
 
-		if (test_raw_tp__host_to_esp) {
+		if (raw_tp_host_sends(test_raw_tp_cap)) {
 
 			raw_tp_tx_thread = kthread_run(raw_tp_tx_process, NULL, "raw tp thrd");
-			if (!raw_tp_tx_thread)
+			if (IS_ERR(raw_tp_tx_thread)) {
 				esp_err("Failed to create send traffic thread\n");
+				raw_tp_tx_thread = NULL;
+			}
 
+		} else {
+			/* Slave paces ESP->Host, one step for the whole test */
+			raw_tp_step_begin(0);
 		}
 		if (!traffic_open_init_done) {
 			init_completion(&traffic_open);
@@ -123,16 +410,16 @@ static void process_raw_tp_flags(void)
 }
 
 
-static void start_test_raw_tp(int raw_tp__host_to_esp)
+static void start_test_raw_tp(u8 cap)
 {
 	test_raw_tp = 1;
-	test_raw_tp__host_to_esp = raw_tp__host_to_esp;
+	test_raw_tp_cap = cap;
 }
 
 static void stop_test_raw_tp(void)
 {
 	test_raw_tp = 0;
-	test_raw_tp__host_to_esp = 0;
+	test_raw_tp_cap = 0;
 }
 
 void esp_raw_tp_queue_resume(void)
@@ -142,6 +429,33 @@ void esp_raw_tp_queue_resume(void)
 			complete_all(&traffic_open);
 }
 
+void esp_raw_tp_start(struct esp_adapter *adapter, u32 mode)
+{
+	u8 cap = ESP_TEST_RAW_TP;
+
+	switch (mode) {
+	case 0:
+		return;
+	case ESP_PRIV_CMD_RAW_TP_HOST_TO_ESP:
+		break;
+	case ESP_PRIV_CMD_RAW_TP_ESP_TO_HOST:
+		cap |= ESP_TEST_RAW_TP__ESP_TO_HOST;
+		break;
+	case ESP_PRIV_CMD_RAW_TP_ECHO:
+		cap |= ESP_TEST_RAW_TP__ECHO;
+		break;
+	case ESP_PRIV_CMD_RAW_TP_BIDIR:
+		cap |= ESP_TEST_RAW_TP__BIDIR;
+		break;
+	default:
+		esp_warn("raw_tp_mode %u not supported\n", mode);
+		return;
+	}
+
+	esp_send_priv_command(adapter, (u8) mode);
+	process_test_capabilities(cap);
+}
+
 void test_raw_tp_cleanup(void)
 {
 	int ret = 0;
@@ -159,6 +473,8 @@ void test_raw_tp_cleanup(void)
 			complete_all(&traffic_open);
 
 	if (raw_tp_tx_thread) {
+		/* Don't make kthread_stop() sit out an echo timeout */
+		complete(&raw_tp_echo);
 		ret = kthread_stop(raw_tp_tx_thread);
 		if(ret) {
 			msleep(10);
@@ -169,13 +485,161 @@ void test_raw_tp_cleanup(void)
 
 		raw_tp_tx_thread = 0;
 	}
+
+	raw_tp_step_end();
+}
+
+void update_test_raw_tp_rx_stats(const u8 *data, u16 len)
+{
+	struct raw_tp_probe probe;
+	struct raw_tp_step *step;
+	bool echoed = false;
+	u64 rtt_ns = 0;
+
+	if (!test_raw_tp || !raw_tp_host_counts_rx(test_raw_tp_cap))
+		return;
+
+	if ((test_raw_tp_cap & ESP_TEST_RAW_TP__ECHO) && len >= sizeof(probe)) {
+		memcpy(&probe, data, sizeof(probe));
+		if (le32_to_cpu(probe.magic) == RAW_TP_PROBE_MAGIC &&
+		    le32_to_cpu(probe.seq) == READ_ONCE(raw_tp_echo_seq)) {
+			rtt_ns = ktime_get_ns() - le64_to_cpu(probe.tx_ns);
+			echoed = true;
+		}
+	}
+
+	spin_lock_bh(&raw_tp_lock);
+	raw_tp_win_rx += len;
+	step = raw_tp_cur_step();
+	if (step) {
+		step->rx_frames++;
+		step->rx_bytes += len;
+	}
+	if (echoed) {
+		raw_tp_win_rtt_ns += rtt_ns;
+		raw_tp_win_rtt_count++;
+		if (step) {
+			step->rtt_bucket[min_t(u32, fls64(rtt_ns), ESP_HIST_BUCKETS - 1)]++;
+			step->rtt_sum_ns += rtt_ns;
+			if (!step->rtt_min_ns || rtt_ns < step->rtt_min_ns)
+				step->rtt_min_ns = rtt_ns;
+			if (rtt_ns > step->rtt_max_ns)
+				step->rtt_max_ns = rtt_ns;
+		}
+	}
+	spin_unlock_bh(&raw_tp_lock);
+
+	if (echoed) {
+		esp_hist_add(ESP_HIST_RAW_TP_RTT, rtt_ns);
+		complete(&raw_tp_echo);
+	}
+}
+
+static u64 raw_tp_kbps(u64 bytes, u64 ns)
+{
+	return ns ? div64_u64(bytes * 8 * NSEC_PER_MSEC, ns) : 0;
 }
 
-void update_test_raw_tp_rx_stats(u16 len)
+static int raw_tp_results_show(struct seq_file *m, void *v)
 {
-	/* if traffic dir is esp to host, increment stats */
-	if (!test_raw_tp__host_to_esp)
-		test_raw_tp_len += len;
+	struct raw_tp_step step;
+	u64 rtt_count, ns;
+	u32 i, nr;
+	int b;
+
+	seq_printf(m, "# mode %s\n", test_raw_tp_cap ?
+			raw_tp_mode_name(test_raw_tp_cap) : "off");
+	seq_printf(m, "%6s %8s %10s %12s %6s %10s %12s %10s %10s %8s %10s %10s %10s %10s %10s %8s\n",
+		   "size", "time_ms", "tx_frames", "tx_bytes", "tx_err",
+		   "rx_frames", "rx_bytes", "tx_kbps", "rx_kbps",
+		   "rtt_n", "rtt_min_ns", "rtt_avg_ns", "rtt_p50_ns",
+		   "rtt_p99_ns", "rtt_max_ns", "lost");
+
+	spin_lock_bh(&raw_tp_lock);
+	nr = raw_tp_nr_steps;
+	spin_unlock_bh(&raw_tp_lock);
+
+	for (i = 0; i < nr; i++) {
+		spin_lock_bh(&raw_tp_lock);
+		step = raw_tp_steps[i];
+		spin_unlock_bh(&raw_tp_lock);
+
+		ns = (step.end_ns ? step.end_ns : ktime_get_ns()) - step.start_ns;
+		rtt_count = 0;
+		for (b = 0; b < ESP_HIST_BUCKETS; b++)
+			rtt_count += step.rtt_bucket[b];
+
+		seq_printf(m, "%6u %8llu %10llu %12llu %6llu %10llu %12llu %10llu %10llu %8llu %10llu %10llu %10llu %10llu %10llu %8llu\n",
+			   step.size, div_u64(ns, NSEC_PER_MSEC),
+			   step.tx_frames, step.tx_bytes, step.tx_fail,
+			   step.rx_frames, step.rx_bytes,
+			   raw_tp_kbps(step.tx_bytes, ns),
+			   raw_tp_kbps(step.rx_bytes, ns),
+			   rtt_count, step.rtt_min_ns,
+			   rtt_count ? div64_u64(step.rtt_sum_ns, rtt_count) : 0,
+			   esp_hist_percentile(step.rtt_bucket, rtt_count, 5000),
+			   esp_hist_percentile(step.rtt_bucket, rtt_count, 9900),
+			   step.rtt_max_ns, step.echo_lost);
+	}
+
+	return 0;
+}
+
+static int raw_tp_results_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, raw_tp_results_show, inode->i_private);
+}
+
+static ssize_t raw_tp_reset_write(struct file *file, const char __user *buf,
+				  size_t count, loff_t *ppos)
+{
+	struct raw_tp_step *step;
+	u32 size = 0;
+	bool running;
+
+	spin_lock_bh(&raw_tp_lock);
+	step = raw_tp_cur_step();
+	running = step && !step->end_ns;
+	if (running)
+		size = step->size;
+	spin_unlock_bh(&raw_tp_lock);
+
+	raw_tp_steps_clear();
+	/* Keep counting the size being sent */
+	if (running)
+		raw_tp_step_begin(size);
+
+	return count;
+}
+
+static const struct file_operations raw_tp_results_fops = {
+	.owner		= THIS_MODULE,
+	.open		= raw_tp_results_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static const struct file_operations raw_tp_reset_fops = {
+	.owner		= THIS_MODULE,
+	.open		= simple_open,
+	.write		= raw_tp_reset_write,
+};
+
+/* Files are removed along with the parent directory */
+void esp_raw_tp_init(struct dentry *parent)
+{
+	struct dentry *dir;
+
+	if (IS_ERR_OR_NULL(parent))
+		return;
+
+	dir = debugfs_create_dir("raw_tp", parent);
+	if (IS_ERR_OR_NULL(dir))
+		return;
+
+	debugfs_create_file("results", 0444, dir, NULL, &raw_tp_results_fops);
+	debugfs_create_file("reset", 0200, dir, NULL, &raw_tp_reset_fops);
 }
 #endif
 
@@ -184,13 +648,9 @@ void process_test_capabilities(u8 cap)
 #if TEST_RAW_TP
 	esp_info("ESP peripheral RAW TP capabilities: 0x%x\n", cap);
 	if ((cap & ESP_TEST_RAW_TP) == ESP_TEST_RAW_TP) {
-		if ((cap & ESP_TEST_RAW_TP__ESP_TO_HOST) == ESP_TEST_RAW_TP__ESP_TO_HOST) {
-			start_test_raw_tp(ESP_TEST_RAW_TP__RX);
-			esp_info("start testing of ESP->Host raw throughput\n");
-		} else {
-			start_test_raw_tp(ESP_TEST_RAW_TP__TX);
-			esp_info("start testing of Host->ESP raw throughput\n");
-		}
+		start_test_raw_tp(cap);
+		esp_info("start testing of raw throughput, mode %s\n",
+				raw_tp_mode_name(cap));
 	} else {
 		esp_info("stop raw throuput test if running\n");
 		stop_test_raw_tp();
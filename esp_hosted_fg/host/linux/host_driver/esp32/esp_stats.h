@@ -12,13 +12,13 @@
 
 #define TEST_RAW_TP__BUF_SIZE    1460
 
-#define ESP_TEST_RAW_TP__RX      0
-#define ESP_TEST_RAW_TP__TX      1
-
 void esp_raw_tp_queue_resume(void);
+/* Start the raw_tp_mode test (ESP_PRIV_CMD_RAW_TP_*) on the slave and host */
+void esp_raw_tp_start(struct esp_adapter *adapter, u32 mode);
+void esp_raw_tp_init(struct dentry *parent);
 #endif
 
 void test_raw_tp_cleanup(void);
-void update_test_raw_tp_rx_stats(u16 len);
+void update_test_raw_tp_rx_stats(const u8 *data, u16 len);
 
 #endif
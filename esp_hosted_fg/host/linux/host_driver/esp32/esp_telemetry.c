@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+/* Slave telemetry: the slave pushes struct esp_telemetry (adapter.h) every
+ * telemetry_interval_ms, the host keeps the latest one:
+ *
+ *   <debugfs>/<module>/telemetry/latest        "name value..." per line
+ *   <debugfs>/<module>/telemetry/raw           last record as received
+ *   <debugfs>/<module>/telemetry/interval_ms   read, or write to change
+ *
+ * Slave counters are cumulative since slave boot; compare two reads to get
+ * rates. uptime_ms going backwards means the slave rebooted.
+ */
+
+#include "esp_utils.h"
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/fs.h>
+#include <linux/uaccess.h>
+#include <linux/spinlock.h>
+#include <linux/jiffies.h>
+#include "esp_api.h"
+#include "esp_if.h"
+#include "esp_telemetry.h"
+
+static u32 telemetry_interval_ms = 10000;
+module_param(telemetry_interval_ms, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(telemetry_interval_ms, "Slave telemetry report interval in ms, 0 to disable");
+
+/* Protects the record and its bookkeeping */
+static DEFINE_SPINLOCK(telemetry_lock);
+static struct esp_telemetry telemetry_rec;
+static u16 telemetry_rec_len;
+static unsigned long telemetry_rx_jiffies;
+static u64 telemetry_records;
+
+static void esp_telemetry_send_interval(struct esp_adapter *adapter)
+{
+	struct esp_priv_telemetry_cmd *cmd;
+	struct esp_payload_header *hdr;
+	u16 offset = sizeof(struct esp_payload_header);
+	struct sk_buff *skb;
+
+	if (!adapter || !adapter->if_ops || !adapter->if_ops->alloc_skb)
+		return;
+
+	skb = adapter->if_ops->alloc_skb(offset + sizeof(*cmd));
+	if (!skb)
+		return;
+	skb_put(skb, offset + sizeof(*cmd));
+
+	hdr = (struct esp_payload_header *) skb->data;
+	memset(hdr, 0, offset);
+	hdr->if_type = ESP_PRIV_IF;
+	hdr->if_num = 0;
+	hdr->len = cpu_to_le16(sizeof(*cmd));
+	hdr->offset = cpu_to_le16(offset);
+	hdr->priv_pkt_type = ESP_PACKET_TYPE_COMMAND;
+
+	cmd = (struct esp_priv_telemetry_cmd *)(skb->data + offset);
+	cmd->cmd = ESP_PRIV_CMD_TELEMETRY;
+	cmd->interval_ms = cpu_to_le32(READ_ONCE(telemetry_interval_ms));
+
+	if (esp_send_packet(adapter, skb))
+		esp_err("Failed to send telemetry interval to slave\n");
+}
+
+void esp_telemetry_start(struct esp_adapter *adapter)
+{
+	if (!adapter || !adapter->telemetry_ver)
+		return;
+
+	esp_info("Slave telemetry v%u, every %u ms\n",
+			adapter->telemetry_ver, READ_ONCE(telemetry_interval_ms));
+	esp_telemetry_send_interval(adapter);
+}
+
+void esp_telemetry_process(const u8 *data, u16 len)
+{
+	if (!data || !len)
+		return;
+
+	spin_lock_bh(&telemetry_lock);
+	/* Older slaves send a prefix, newer ones may append fields */
+	memset(&telemetry_rec, 0, sizeof(telemetry_rec));
+	telemetry_rec_len = min_t(u16, len, sizeof(telemetry_rec));
+	memcpy(&telemetry_rec, data, telemetry_rec_len);
+	telemetry_rx_jiffies = jiffies;
+	telemetry_records++;
+	spin_unlock_bh(&telemetry_lock);
+}
+
+static void esp_telemetry_show_u16s(struct seq_file *m, const char *name,
+		const u16 *v, int n)
+{
+	int i;
+
+	seq_printf(m, "%s", name);
+	for (i = 0; i < n; i++)
+		seq_printf(m, " %u", le16_to_cpu(v[i]));
+	seq_putc(m, '\n');
+}
+
+static int esp_telemetry_latest_show(struct seq_file *m, void *v)
+{
+	struct esp_telemetry t;
+	unsigned long rx_jiffies;
+	u64 records;
+	u16 len;
+	int i;
+
+	spin_lock_bh(&telemetry_lock);
+	t = telemetry_rec;
+	len = telemetry_rec_len;
+	rx_jiffies = telemetry_rx_jiffies;
+	records = telemetry_records;
+	spin_unlock_bh(&telemetry_lock);
+
+	seq_printf(m, "records %llu\n", records);
+	if (!len)
+		return 0;
+
+	seq_printf(m, "age_ms %u\n", jiffies_to_msecs(jiffies - rx_jiffies));
+	seq_printf(m, "version %u\n", t.version);
+	seq_printf(m, "seq %u\n", le32_to_cpu(t.seq));
+	seq_printf(m, "uptime_ms %u\n", le32_to_cpu(t.uptime_ms));
+	seq_printf(m, "interval_ms %u\n", le32_to_cpu(t.interval_ms));
+	if (t.cpu_load_pct != 0xFF)
+		seq_printf(m, "cpu_load_pct %u\n", t.cpu_load_pct);
+
+	seq_printf(m, "heap_free %u\n", le32_to_cpu(t.heap_free));
+	seq_printf(m, "heap_min_free %u\n", le32_to_cpu(t.heap_min_free));
+	seq_printf(m, "heap_largest %u\n", le32_to_cpu(t.heap_largest));
+	seq_printf(m, "dma_free %u\n", le32_to_cpu(t.dma_free));
+
+	esp_telemetry_show_u16s(m, "to_host_q", t.to_host_q, ESP_TELEMETRY_QUEUES);
+	esp_telemetry_show_u16s(m, "to_host_q_peak", t.to_host_q_peak,
+			ESP_TELEMETRY_QUEUES);
+
+	seq_printf(m, "h2e_sta_out %u\n", le32_to_cpu(t.h2e_sta_out));
+	seq_printf(m, "h2e_sta_fail %u\n", le32_to_cpu(t.h2e_sta_fail));
+	seq_printf(m, "h2e_ap_out %u\n", le32_to_cpu(t.h2e_ap_out));
+	seq_printf(m, "h2e_ap_fail %u\n", le32_to_cpu(t.h2e_ap_fail));
+	seq_printf(m, "e2h_sta_in %u\n", le32_to_cpu(t.e2h_sta_in));
+	seq_printf(m, "wifi_tx_retries %u\n", le32_to_cpu(t.wifi_tx_retries));
+	seq_printf(m, "flowctrl_on %u\n", le32_to_cpu(t.flowctrl_on));
+	seq_printf(m, "flowctrl_off %u\n", le32_to_cpu(t.flowctrl_off));
+	seq_printf(m, "serial_rx %u\n", le32_to_cpu(t.serial_rx));
+	seq_printf(m, "serial_tx %u\n", le32_to_cpu(t.serial_tx));
+
+	seq_printf(m, "h2e_rx_drop %u\n", le32_to_cpu(t.h2e_rx_drop));
+	seq_printf(m, "e2h_drop %u\n", le32_to_cpu(t.e2h_drop));
+	seq_printf(m, "e2h_tx_fail %u\n", le32_to_cpu(t.e2h_tx_fail));
+	seq_printf(m, "e2h_aggr");
+	for (i = 0; i < ESP_TELEMETRY_AGGR_BUCKETS; i++)
+		seq_printf(m, " %u", le32_to_cpu(t.e2h_aggr[i]));
+	seq_putc(m, '\n');
+
+	for (i = 0; i < t.nr_tasks && i < ESP_TELEMETRY_MAX_TASKS; i++)
+		seq_printf(m, "task %.*s %u\n", ESP_TELEMETRY_TASK_NAME_LEN,
+				t.task[i].name, t.task[i].cpu_pct);
+
+	return 0;
+}
+
+static int esp_telemetry_latest_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, esp_telemetry_latest_show, inode->i_private);
+}
+
+static ssize_t esp_telemetry_raw_read(struct file *file, char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct esp_telemetry t;
+	u16 len;
+
+	spin_lock_bh(&telemetry_lock);
+	t = telemetry_rec;
+	len = telemetry_rec_len;
+	spin_unlock_bh(&telemetry_lock);
+
+	return simple_read_from_buffer(buf, count, ppos, &t, len);
+}
+
+static int esp_telemetry_interval_get(void *data, u64 *val)
+{
+	*val = READ_ONCE(telemetry_interval_ms);
+	return 0;
+}
+
+static int esp_telemetry_interval_set(void *data, u64 val)
+{
+	struct esp_adapter *adapter = esp_get_adapter();
+
+	if (val > U32_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(telemetry_interval_ms, val);
+
+	if (adapter && adapter->telemetry_ver &&
+	    atomic_read(&adapter->state) == ESP_CONTEXT_READY)
+		esp_telemetry_send_interval(adapter);
+
+	return 0;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(esp_telemetry_interval_fops, esp_telemetry_interval_get,
+		esp_telemetry_interval_set, "%llu\n");
+
+static const struct file_operations esp_telemetry_latest_fops = {
+	.owner		= THIS_MODULE,
+	.open		= esp_telemetry_latest_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static const struct file_operations esp_telemetry_raw_fops = {
+	.owner		= THIS_MODULE,
+	.open		= simple_open,
+	.read		= esp_telemetry_raw_read,
+	.llseek		= default_llseek,
+};
+
+/* Files are removed along with the parent directory */
+void esp_telemetry_init(struct dentry *parent)
+{
+	struct dentry *dir;
+
+	if (IS_ERR_OR_NULL(parent))
+		return;
+
+	dir = debugfs_create_dir("telemetry", parent);
+	if (IS_ERR_OR_NULL(dir))
+		return;
+
+	debugfs_create_file("latest", 0444, dir, NULL, &esp_telemetry_latest_fops);
+	debugfs_create_file("raw", 0444, dir, NULL, &esp_telemetry_raw_fops);
+	debugfs_create_file_unsafe("interval_ms", 0644, dir, NULL,
+			&esp_telemetry_interval_fops);
+}
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+#ifndef __ESP_TELEMETRY__H__
+#define __ESP_TELEMETRY__H__
+
+#include <linux/types.h>
+
+struct dentry;
+struct esp_adapter;
+
+void esp_telemetry_init(struct dentry *parent);
+/* Ask the slave for reports if its boot-up event advertised them */
+void esp_telemetry_start(struct esp_adapter *adapter);
+/* ESP_PRIV_EVENT_TELEMETRY event data */
+void esp_telemetry_process(const u8 *data, u16 len);
+
+#endif
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+/* Packet lifecycle tracepoints, e.g.
+ *   perf record -e 'esp_hosted_fg:*' -a
+ *   echo 1 > /sys/kernel/tracing/events/esp_hosted_fg/enable
+ *
+ * Frame events carry the payload header seq_num. The host numbers every
+ * H2E frame it sends and the slave every E2H frame (serial keeps its own
+ * fragment numbering); the slave logs seq at verbose level on its RX and TX
+ * paths, so a host trace line can be matched with the slave's log of the
+ * same frame. The host timestamp is the trace record's own.
+ *
+ * esp_hosted_ng has its own copy of these events. The two drivers are built
+ * as separate modules from separate trees, register different TRACE_SYSTEMs
+ * and NG has no seq_num (it uses 8-bit tags in reserved header bytes), so
+ * the classes are kept apart; keep event names and formats in step.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM esp_hosted_fg
+
+#if !defined(_ESP_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _ESP_TRACE_H_
+
+#include <linux/tracepoint.h>
+#include "adapter.h"
+
+TRACE_EVENT(esp_xmit,
+	TP_PROTO(u8 if_type, u8 if_num, u32 len),
+	TP_ARGS(if_type, if_num, len),
+	TP_STRUCT__entry(
+		__field(u8, if_type)
+		__field(u8, if_num)
+		__field(u32, len)
+	),
+	TP_fast_assign(
+		__entry->if_type = if_type;
+		__entry->if_num = if_num;
+		__entry->len = len;
+	),
+	TP_printk("if=%u/%u len=%u",
+		  __entry->if_type, __entry->if_num, __entry->len)
+);
+
+DECLARE_EVENT_CLASS(esp_frame,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h),
+	TP_STRUCT__entry(
+		__field(u8, if_type)
+		__field(u8, if_num)
+		__field(u8, flags)
+		__field(u16, len)
+		__field(u16, seq)
+	),
+	TP_fast_assign(
+		__entry->if_type = h->if_type;
+		__entry->if_num = h->if_num;
+		__entry->flags = h->flags;
+		__entry->len = le16_to_cpu(h->len);
+		__entry->seq = le16_to_cpu(h->seq_num);
+	),
+	TP_printk("if=%u/%u seq=%u len=%u flags=0x%x",
+		  __entry->if_type, __entry->if_num, __entry->seq,
+		  __entry->len, __entry->flags)
+);
+
+/* Frame put on a transport TX queue */
+TRACE_EVENT(esp_tx_enqueue,
+	TP_PROTO(const struct esp_payload_header *h, u8 prio, u32 pending),
+	TP_ARGS(h, prio, pending),
+	TP_STRUCT__entry(
+		__field(u8, if_type)
+		__field(u8, prio)
+		__field(u16, len)
+		__field(u16, seq)
+		__field(u32, pending)
+	),
+	TP_fast_assign(
+		__entry->if_type = h->if_type;
+		__entry->prio = prio;
+		__entry->len = le16_to_cpu(h->len);
+		__entry->seq = le16_to_cpu(h->seq_num);
+		__entry->pending = pending;
+	),
+	TP_printk("if=%u seq=%u len=%u prio=%u pending=%u",
+		  __entry->if_type, __entry->seq, __entry->len,
+		  __entry->prio, __entry->pending)
+);
+
+/* Frame copied into the TX aggregate being built */
+DEFINE_EVENT(esp_frame, esp_tx_aggr_add,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h)
+);
+
+/* TX aggregate built and about to be written */
+TRACE_EVENT(esp_tx_aggr,
+	TP_PROTO(u32 frames, u32 bytes, u64 build_ns),
+	TP_ARGS(frames, bytes, build_ns),
+	TP_STRUCT__entry(
+		__field(u32, frames)
+		__field(u32, bytes)
+		__field(u64, build_ns)
+	),
+	TP_fast_assign(
+		__entry->frames = frames;
+		__entry->bytes = bytes;
+		__entry->build_ns = build_ns;
+	),
+	TP_printk("frames=%u bytes=%u build_ns=%llu",
+		  __entry->frames, __entry->bytes, __entry->build_ns)
+);
+
+TRACE_EVENT(esp_tx_credit,
+	TP_PROTO(u32 needed, u64 wait_ns, bool ok),
+	TP_ARGS(needed, wait_ns, ok),
+	TP_STRUCT__entry(
+		__field(u32, needed)
+		__field(u64, wait_ns)
+		__field(bool, ok)
+	),
+	TP_fast_assign(
+		__entry->needed = needed;
+		__entry->wait_ns = wait_ns;
+		__entry->ok = ok;
+	),
+	TP_printk("needed=%u wait_ns=%llu ok=%d",
+		  __entry->needed, __entry->wait_ns, __entry->ok)
+);
+
+/* TX aggregate written to the bus */
+TRACE_EVENT(esp_tx_flush,
+	TP_PROTO(u32 bytes, u64 write_ns, int ret),
+	TP_ARGS(bytes, write_ns, ret),
+	TP_STRUCT__entry(
+		__field(u32, bytes)
+		__field(u64, write_ns)
+		__field(int, ret)
+	),
+	TP_fast_assign(
+		__entry->bytes = bytes;
+		__entry->write_ns = write_ns;
+		__entry->ret = ret;
+	),
+	TP_printk("bytes=%u write_ns=%llu ret=%d",
+		  __entry->bytes, __entry->write_ns, __entry->ret)
+);
+
+/* One bus read, possibly carrying several frames */
+TRACE_EVENT(esp_rx_read,
+	TP_PROTO(u32 bytes, u64 read_ns),
+	TP_ARGS(bytes, read_ns),
+	TP_STRUCT__entry(
+		__field(u32, bytes)
+		__field(u64, read_ns)
+	),
+	TP_fast_assign(
+		__entry->bytes = bytes;
+		__entry->read_ns = read_ns;
+	),
+	TP_printk("bytes=%u read_ns=%llu", __entry->bytes, __entry->read_ns)
+);
+
+/* Frame split out of a bus read */
+DEFINE_EVENT(esp_frame, esp_rx_frame,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h)
+);
+
+/* Frame handed to its interface (netdev, serial, HCI, events) */
+DEFINE_EVENT(esp_frame, esp_rx_dispatch,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h)
+);
+
+#endif /* _ESP_TRACE_H_ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE esp_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+#ifndef __ESP_WMM__H__
+#define __ESP_WMM__H__
+
+#include <linux/skbuff.h>
+#include "adapter.h"
+
+/* PRIO_Q_OTHERS of a transport: one FIFO per access category, drained by
+ * weighted round robin. Any context may enqueue; only the transport's TX
+ * thread may peek/dequeue. */
+struct esp_ac_queue {
+	struct sk_buff_head	q[ESP_NUM_AC];
+	/* Round robin position and frames left in its turn */
+	u8			cur;
+	u8			credit;
+};
+
+void esp_ac_queue_init(struct esp_ac_queue *acq);
+void esp_ac_queue_purge(struct esp_ac_queue *acq);
+/* Lane from skb->queue_mapping, set by ndo_select_queue; BE otherwise */
+void esp_ac_enqueue(struct esp_ac_queue *acq, struct sk_buff *skb);
+/* Next frame the scheduler picks; dequeue right after returns the same one */
+struct sk_buff *esp_ac_peek(struct esp_ac_queue *acq);
+struct sk_buff *esp_ac_dequeue(struct esp_ac_queue *acq);
+bool esp_ac_queue_empty(struct esp_ac_queue *acq);
+
+/* Access category of an outgoing Ethernet frame, from skb->priority when
+ * it carries an 802.1d tag (256..263), else from the IP DSCP. Leaves the
+ * 802.1d tag in skb->priority. */
+u16 esp_wmm_classify(struct sk_buff *skb);
+
+#endif
@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+/* Native XDP on the STA/AP netdevs:
+ *
+ *   ip link set dev wlan0 xdp obj filter.o sec xdp
+ *
+ * With a program attached, each received frame of that interface is copied
+ * from the transport buffer into a page fragment and run there. Only
+ * XDP_PASS builds an skb, around the same fragment, so dropped, bounced
+ * and redirected frames never get one. SDIO aggregates hand their frames
+ * over before any per-frame skb is allocated; a frame that arrives in a
+ * bus read of its own (SDIO, SPI, virt) already has one. Frames of one bus
+ * read share one softirq-like section and one redirect flush.
+ *
+ * XDP_TX and ndo_xdp_xmit frames go back to the slave through the normal
+ * H2E TX path of the interface.
+ *
+ * Without a program the RX path is unchanged.
+ */
+
+#include "esp_utils.h"
+#include <linux/netdevice.h>
+#include <linux/etherdevice.h>
+#include <linux/filter.h>
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <net/xdp.h>
+#include "esp_api.h"
+#include "esp_if.h"
+#include "esp_xdp.h"
+#include "esp_trace.h"
+
+#if ESP_XDP_SUPPORT
+
+#define ESP_XDP_SHINFO_SIZE   SKB_DATA_ALIGN(sizeof(struct skb_shared_info))
+/* Largest frame, Ethernet header included, one page fragment can take */
+#define ESP_XDP_MAX_FRAME     (PAGE_SIZE - XDP_PACKET_HEADROOM - ESP_XDP_SHINFO_SIZE)
+/* Room process_tx_packet() needs for the payload header and alignment */
+#define ESP_XDP_TX_HEADROOM   (sizeof(struct esp_payload_header) + SKB_DATA_ADDR_ALIGNMENT)
+
+int esp_xdp_init(struct esp_private *priv)
+{
+	int ret;
+
+	ret = xdp_rxq_info_reg(&priv->xdp_rxq, priv->ndev, 0, 0);
+	if (ret)
+		return ret;
+
+	ret = xdp_rxq_info_reg_mem_model(&priv->xdp_rxq, MEM_TYPE_PAGE_SHARED, NULL);
+	if (ret) {
+		xdp_rxq_info_unreg(&priv->xdp_rxq);
+		return ret;
+	}
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0))
+	xdp_set_features_flag(priv->ndev, NETDEV_XDP_ACT_BASIC |
+			NETDEV_XDP_ACT_REDIRECT | NETDEV_XDP_ACT_NDO_XMIT);
+#endif
+	return 0;
+}
+
+void esp_xdp_deinit(struct esp_private *priv)
+{
+	/* The program itself is released by unregister_netdev() */
+	xdp_rxq_info_unreg(&priv->xdp_rxq);
+}
+
+int esp_xdp_bpf(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	struct esp_private *priv = netdev_priv(ndev);
+	struct bpf_prog *old;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		if (bpf->prog && ndev->mtu + ETH_HLEN > ESP_XDP_MAX_FRAME) {
+			NL_SET_ERR_MSG_MOD(bpf->extack, "MTU too large for XDP");
+			return -EOPNOTSUPP;
+		}
+		old = rtnl_dereference(priv->xdp_prog);
+		rcu_assign_pointer(priv->xdp_prog, bpf->prog);
+		if (old)
+			bpf_prog_put(old);
+		esp_info("%s: XDP program %s\n", ndev->name,
+				bpf->prog ? "attached" : "detached");
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/* Copy an outgoing Ethernet frame into an skb the H2E path can send */
+static struct sk_buff *esp_xdp_tx_skb(struct esp_private *priv,
+		const void *data, u32 len)
+{
+	struct sk_buff *skb;
+
+	skb = priv->adapter->if_ops->alloc_skb(ESP_XDP_TX_HEADROOM + len);
+	if (!skb)
+		return NULL;
+
+	skb_reserve(skb, ESP_XDP_TX_HEADROOM);
+	skb_put_data(skb, data, len);
+	return skb;
+}
+
+/* Returns 0 if @skb was consumed by the H2E path */
+static int esp_xdp_tx(struct esp_private *priv, struct sk_buff *skb)
+{
+	if (esp_tx_frame(priv, skb) == NETDEV_TX_OK)
+		return 0;
+
+	/* TX paused: XDP has no queue to wait in */
+	priv->stats.tx_dropped++;
+	dev_kfree_skb_any(skb);
+	return -EBUSY;
+}
+
+int esp_xdp_xmit(struct net_device *ndev, int n, struct xdp_frame **frames,
+		u32 flags)
+{
+	struct esp_private *priv = netdev_priv(ndev);
+	struct sk_buff *skb;
+	int i;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (!priv->adapter || !priv->adapter->if_ops ||
+	    !priv->adapter->if_ops->alloc_skb)
+		return -ENETDOWN;
+
+	/* Frames not counted in the return value are freed by the caller */
+	for (i = 0; i < n; i++) {
+		if (frames[i]->len > ETH_FRAME_LEN)
+			break;
+
+		skb = esp_xdp_tx_skb(priv, frames[i]->data, frames[i]->len);
+		if (!skb)
+			break;
+
+		if (esp_xdp_tx(priv, skb))
+			break;
+
+		xdp_return_frame(frames[i]);
+	}
+
+	return i;
+}
+
+/* Wrap the fragment in an skb, keeping whatever the program did to it */
+static struct sk_buff *esp_xdp_build_skb(struct xdp_buff *xdp, u32 frag_size)
+{
+	struct sk_buff *skb;
+
+	skb = build_skb(xdp->data_hard_start, frag_size);
+	if (!skb)
+		return NULL;
+
+	skb_reserve(skb, xdp->data - xdp->data_hard_start);
+	skb_put(skb, xdp->data_end - xdp->data);
+	return skb;
+}
+
+void esp_xdp_batch_begin(struct esp_xdp_batch *batch)
+{
+	__skb_queue_head_init(&batch->pass);
+	__skb_queue_head_init(&batch->tx);
+	batch->active = false;
+	batch->redirected = false;
+}
+
+/* RX runs from a workqueue; XDP expects softirq-like context */
+static void esp_xdp_batch_enter(struct esp_xdp_batch *batch)
+{
+	local_bh_disable();
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0))
+	batch->bpf_net_ctx_set = bpf_net_ctx_set(&batch->bpf_net_ctx);
+#endif
+	rcu_read_lock();
+	batch->active = true;
+}
+
+void esp_xdp_batch_end(struct esp_xdp_batch *batch)
+{
+	struct esp_skb_cb *cb;
+	struct sk_buff *skb;
+
+	if (!batch->active)
+		return;
+
+	if (batch->redirected)
+		xdp_do_flush();
+
+	rcu_read_unlock();
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0))
+	bpf_net_ctx_clear(batch->bpf_net_ctx_set);
+#endif
+	local_bh_enable();
+	batch->active = false;
+
+	/* Handed on once BHs are back on */
+	while ((skb = __skb_dequeue(&batch->tx)) != NULL) {
+		cb = (struct esp_skb_cb *)skb->cb;
+		esp_xdp_tx(cb->priv, skb);
+	}
+
+	while ((skb = __skb_dequeue(&batch->pass)) != NULL) {
+		cb = (struct esp_skb_cb *)skb->cb;
+		esp_rx_deliver(cb->priv, skb, cb->rx_flags);
+	}
+}
+
+bool esp_xdp_rx(struct esp_adapter *adapter, const u8 *frame, u64 tstamp,
+		struct esp_xdp_batch *batch)
+{
+	struct esp_payload_header *header = (struct esp_payload_header *)frame;
+	struct esp_private *priv;
+	struct esp_skb_cb *cb;
+	struct sk_buff *skb;
+	struct bpf_prog *prog;
+	struct xdp_buff xdp;
+	u16 len, offset;
+	u32 frag_size;
+	u32 act;
+	u8 *buf;
+
+	if (header->if_type != ESP_STA_IF && header->if_type != ESP_AP_IF)
+		return false;
+
+	priv = get_priv_from_payload_header(header);
+	if (!priv || !rcu_access_pointer(priv->xdp_prog))
+		return false;
+
+	len = le16_to_cpu(header->len);
+	offset = le16_to_cpu(header->offset);
+	/* Leave malformed frames to the skb path, which rejects them */
+	if (!len || offset != H_ESP_PAYLOAD_HEADER_OFFSET)
+		return false;
+
+	trace_esp_rx_dispatch(header);
+
+	if (len > ESP_XDP_MAX_FRAME) {
+		priv->stats.rx_length_errors++;
+		priv->stats.rx_dropped++;
+		return true;
+	}
+
+	frag_size = SKB_DATA_ALIGN(XDP_PACKET_HEADROOM + len) + ESP_XDP_SHINFO_SIZE;
+	buf = netdev_alloc_frag(frag_size);
+	if (!buf) {
+		priv->stats.rx_dropped++;
+		return true;
+	}
+
+	/* The payload header ends up in the headroom, Ethernet data at
+	 * XDP_PACKET_HEADROOM; the checksum covers both */
+	memcpy(buf + XDP_PACKET_HEADROOM - offset, frame, offset + len);
+
+	if (adapter->capabilities & ESP_CHECKSUM_ENABLED) {
+		struct esp_payload_header *h;
+		u16 rx_checksum, checksum;
+
+		h = (struct esp_payload_header *)(buf + XDP_PACKET_HEADROOM - offset);
+		rx_checksum = le16_to_cpu(h->checksum);
+		h->checksum = 0;
+
+		checksum = compute_checksum((u8 *)h, offset + len);
+		if (checksum != rx_checksum) {
+			esp_info("cal_chksum[%u]!=rx_chksum[%u]\n", checksum, rx_checksum);
+			skb_free_frag(buf);
+			priv->stats.rx_errors++;
+			priv->stats.rx_dropped++;
+			return true;
+		}
+	}
+
+	xdp_init_buff(&xdp, frag_size, &priv->xdp_rxq);
+	xdp_prepare_buff(&xdp, buf, XDP_PACKET_HEADROOM, len, false);
+
+	if (!batch->active)
+		esp_xdp_batch_enter(batch);
+
+	prog = rcu_dereference(priv->xdp_prog);
+	act = prog ? bpf_prog_run_xdp(prog, &xdp) : XDP_PASS;
+
+	switch (act) {
+	case XDP_PASS:
+	case XDP_TX:
+		skb = esp_xdp_build_skb(&xdp, frag_size);
+		if (!skb) {
+			skb_free_frag(buf);
+			priv->stats.rx_dropped++;
+			break;
+		}
+		cb = (struct esp_skb_cb *)skb->cb;
+		cb->priv = priv;
+		if (act == XDP_TX) {
+			__skb_queue_tail(&batch->tx, skb);
+		} else {
+			cb->tstamp = tstamp;
+			cb->rx_flags = header->flags;
+			__skb_queue_tail(&batch->pass, skb);
+		}
+		break;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(priv->ndev, &xdp, prog)) {
+			trace_xdp_exception(priv->ndev, prog, act);
+			skb_free_frag(buf);
+			priv->stats.rx_dropped++;
+			break;
+		}
+		/* Flushed once for the whole batch */
+		batch->redirected = true;
+		priv->stats.rx_packets++;
+		priv->stats.rx_bytes += len;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(priv->ndev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(priv->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		skb_free_frag(buf);
+		priv->stats.rx_dropped++;
+		break;
+	}
+
+	return true;
+}
+
+#endif /* ESP_XDP_SUPPORT */
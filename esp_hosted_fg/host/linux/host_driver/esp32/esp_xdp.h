@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+#ifndef __ESP_XDP__H__
+#define __ESP_XDP__H__
+
+#include "esp.h"
+
+#if ESP_XDP_SUPPORT
+#include <linux/filter.h>
+
+/* Frames of one bus read. The first frame a program runs on enters
+ * softirq-like context, which is kept until esp_xdp_batch_end(): redirects
+ * are flushed once there, and XDP_PASS/XDP_TX frames handed on after it. */
+struct esp_xdp_batch {
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 11, 0))
+	struct bpf_net_context  bpf_net_ctx;
+	struct bpf_net_context  *bpf_net_ctx_set;
+#endif
+	struct sk_buff_head     pass;
+	struct sk_buff_head     tx;
+	bool                    active;
+	bool                    redirected;
+};
+
+int esp_xdp_init(struct esp_private *priv);
+void esp_xdp_deinit(struct esp_private *priv);
+int esp_xdp_bpf(struct net_device *ndev, struct netdev_bpf *bpf);
+int esp_xdp_xmit(struct net_device *ndev, int n, struct xdp_frame **frames,
+		u32 flags);
+void esp_xdp_batch_begin(struct esp_xdp_batch *batch);
+void esp_xdp_batch_end(struct esp_xdp_batch *batch);
+/* @frame is one de-aggregated frame, payload header first. Returns true if
+ * an XDP program took it (whatever the verdict); the caller still owns the
+ * buffer. false: no program, continue on the skb path. Must be called
+ * between esp_xdp_batch_begin() and esp_xdp_batch_end() of @batch. */
+bool esp_xdp_rx(struct esp_adapter *adapter, const u8 *frame, u64 tstamp,
+		struct esp_xdp_batch *batch);
+#else
+struct esp_xdp_batch {
+};
+
+static inline int esp_xdp_init(struct esp_private *priv) { return 0; }
+static inline void esp_xdp_deinit(struct esp_private *priv) { }
+static inline void esp_xdp_batch_begin(struct esp_xdp_batch *batch) { }
+static inline void esp_xdp_batch_end(struct esp_xdp_batch *batch) { }
+static inline bool esp_xdp_rx(struct esp_adapter *adapter, const u8 *frame,
+		u64 tstamp, struct esp_xdp_batch *batch)
+{
+	return false;
+}
+#endif
+
+#endif
@@ -7,9 +7,17 @@
 #include <linux/kernel.h>
 #include <linux/delay.h>
 #include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 #include <linux/etherdevice.h>
 #include <linux/netdevice.h>
 #include <linux/gpio.h>
+#include <linux/debugfs.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <net/ip.h>
 
 #include "esp.h"
 #include "esp_if.h"
@@ -18,15 +26,29 @@
 #include "esp_api.h"
 #include "esp_kernel_port.h"
 #include "esp_stats.h"
+#include "esp_hist.h"
+#include "esp_telemetry.h"
+#include "esp_rxpool.h"
+#include "esp_xdp.h"
+#include "esp_wmm.h"
+
+#define CREATE_TRACE_POINTS
+#include "esp_trace.h"
 
 #define SERIAL_REASM_MAX_DEVS 2
-#define SERIAL_REASM_MAX_LEN  12288
+/* Upper bound when slave announces total length (FLAG_FRAG_TOTAL_LEN) */
+#define SERIAL_REASM_MAX_LEN  (128 * 1024)
+/* Buffer size for slaves not sending total length */
+#define SERIAL_REASM_LEGACY_LEN  12288
 
 struct serial_reasm_state {
 	u8 *buf;
 	size_t len;
+	size_t size;
 	u16 last_seq;
 	bool active;
+	/* SERIAL_REASM_LEGACY_LEN bytes, kept across messages */
+	u8 *legacy_buf;
 };
 
 static struct serial_reasm_state serial_reasm[SERIAL_REASM_MAX_DEVS];
@@ -36,13 +58,26 @@ static void serial_reasm_reset(int if_num)
 	if (if_num < 0 || if_num >= SERIAL_REASM_MAX_DEVS) {
 		return;
 	}
-	kfree(serial_reasm[if_num].buf);
+	if (serial_reasm[if_num].buf != serial_reasm[if_num].legacy_buf)
+		kvfree(serial_reasm[if_num].buf);
 	serial_reasm[if_num].buf = NULL;
 	serial_reasm[if_num].len = 0;
+	serial_reasm[if_num].size = 0;
 	serial_reasm[if_num].last_seq = 0;
 	serial_reasm[if_num].active = false;
 }
 
+static void serial_reasm_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < SERIAL_REASM_MAX_DEVS; i++) {
+		serial_reasm_reset(i);
+		kvfree(serial_reasm[i].legacy_buf);
+		serial_reasm[i].legacy_buf = NULL;
+	}
+}
+
 /* Module parameters */
 /* You can hardcode the parameters if do not wish to pass them as argument to insmod */
 static int resetpin = MOD_PARAM_UNINITIALISED;
@@ -54,6 +89,7 @@ static int spi_handshake = MOD_PARAM_UNINITIALISED;
 static int spi_dataready = MOD_PARAM_UNINITIALISED;
 /* Raw throughput mode module param. */
 u32 raw_tp_mode = 0;
+static bool csum_offload = true;
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Amey Inamdar <amey.inamdar@espressif.com>");
@@ -71,6 +107,9 @@ MODULE_PARM_DESC(clockspeed, "SPI/SDIO bus clock freq (MHz)");
 module_param(raw_tp_mode, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 MODULE_PARM_DESC(raw_tp_mode, "Mode chosen to test raw throughput");
 
+module_param(csum_offload, bool, S_IRUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(csum_offload, "Use slave TCP/UDP checksum offload and GSO if the slave offers it");
+
 module_param(spi_bus, int, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 MODULE_PARM_DESC(spi_bus, "SPI: bus instance to use");
 
@@ -120,19 +159,51 @@ static int esp_hard_start_xmit(struct sk_buff *skb, struct net_device *ndev);
 static int esp_set_mac_address(struct net_device *ndev, void *addr);
 static struct net_device_stats* esp_get_stats(struct net_device *ndev);
 static void esp_set_rx_mode(struct net_device *ndev);
+static int esp_set_features(struct net_device *ndev, netdev_features_t features);
 static int process_tx_packet (struct sk_buff *skb);
 static NDO_TX_TIMEOUT_PROTOTYPE();
 int esp_send_packet(struct esp_adapter *adapter, struct sk_buff *skb);
 
+static void esp_get_drvinfo(struct net_device *ndev,
+		struct ethtool_drvinfo *info);
+static int esp_get_sset_count(struct net_device *ndev, int sset);
+static void esp_get_strings(struct net_device *ndev, u32 sset, u8 *data);
+static void esp_get_ethtool_stats(struct net_device *ndev,
+		struct ethtool_stats *stats, u64 *data);
+static ETHTOOL_GET_RINGPARAM_PROTOTYPE();
+static ETHTOOL_SET_RINGPARAM_PROTOTYPE();
+
+static const struct ethtool_ops esp_ethtool_ops = {
+	.get_drvinfo = esp_get_drvinfo,
+	.get_link = ethtool_op_get_link,
+	.get_sset_count = esp_get_sset_count,
+	.get_strings = esp_get_strings,
+	.get_ethtool_stats = esp_get_ethtool_stats,
+	.get_ringparam = esp_get_ringparam,
+	.set_ringparam = esp_set_ringparam,
+};
+
+static u16 esp_select_queue(struct net_device *ndev, struct sk_buff *skb,
+		ESP_SELECT_QUEUE_ARGS)
+{
+	return esp_wmm_classify(skb);
+}
+
 static const struct net_device_ops esp_netdev_ops = {
 	.ndo_open = esp_open,
 	.ndo_stop = esp_stop,
 	.ndo_start_xmit = esp_hard_start_xmit,
+	.ndo_select_queue = esp_select_queue,
 	.ndo_set_mac_address = esp_set_mac_address,
 	.ndo_validate_addr = eth_validate_addr,
 	.ndo_tx_timeout = esp_tx_timeout,
 	.ndo_get_stats = esp_get_stats,
 	.ndo_set_rx_mode = esp_set_rx_mode,
+	.ndo_set_features = esp_set_features,
+#if ESP_XDP_SUPPORT
+	.ndo_bpf = esp_xdp_bpf,
+	.ndo_xdp_xmit = esp_xdp_xmit,
+#endif
 };
 
 struct esp_adapter * esp_get_adapter(void)
@@ -167,6 +238,68 @@ static struct net_device_stats* esp_get_stats(struct net_device *ndev)
 	return &priv->stats;
 }
 
+static void esp_get_drvinfo(struct net_device *ndev,
+		struct ethtool_drvinfo *info)
+{
+	struct esp_private *priv = netdev_priv(ndev);
+
+	strscpy(info->driver, KBUILD_MODNAME, sizeof(info->driver));
+	if (priv->adapter && priv->adapter->dev)
+		strscpy(info->bus_info, dev_name(priv->adapter->dev),
+			sizeof(info->bus_info));
+}
+
+/* Transport counters are per adapter, so every netdev reports the same set */
+static int esp_get_sset_count(struct net_device *ndev, int sset)
+{
+	struct esp_private *priv = netdev_priv(ndev);
+	struct esp_if_ops *ops = priv->adapter ? priv->adapter->if_ops : NULL;
+
+	if (sset != ETH_SS_STATS || !ops || !ops->get_sset_count)
+		return -EOPNOTSUPP;
+
+	return ops->get_sset_count(priv->adapter);
+}
+
+static void esp_get_strings(struct net_device *ndev, u32 sset, u8 *data)
+{
+	struct esp_private *priv = netdev_priv(ndev);
+	struct esp_if_ops *ops = priv->adapter ? priv->adapter->if_ops : NULL;
+
+	if (sset == ETH_SS_STATS && ops && ops->get_strings)
+		ops->get_strings(priv->adapter, data);
+}
+
+static void esp_get_ethtool_stats(struct net_device *ndev,
+		struct ethtool_stats *stats, u64 *data)
+{
+	struct esp_private *priv = netdev_priv(ndev);
+	struct esp_if_ops *ops = priv->adapter ? priv->adapter->if_ops : NULL;
+
+	if (ops && ops->get_stats)
+		ops->get_stats(priv->adapter, data);
+}
+
+static ETHTOOL_GET_RINGPARAM_PROTOTYPE()
+{
+	struct esp_private *priv = netdev_priv(ndev);
+	struct esp_if_ops *ops = priv->adapter ? priv->adapter->if_ops : NULL;
+
+	if (ops && ops->get_ringparam)
+		ops->get_ringparam(priv->adapter, ring);
+}
+
+static ETHTOOL_SET_RINGPARAM_PROTOTYPE()
+{
+	struct esp_private *priv = netdev_priv(ndev);
+	struct esp_if_ops *ops = priv->adapter ? priv->adapter->if_ops : NULL;
+
+	if (!ops || !ops->set_ringparam)
+		return -EOPNOTSUPP;
+
+	return ops->set_ringparam(priv->adapter, ring);
+}
+
 static int esp_set_mac_address(struct net_device *ndev, void *data)
 {
 	struct esp_private *priv;
@@ -200,10 +333,139 @@ static void esp_set_rx_mode(struct net_device *ndev)
 {
 }
 
+/* Tell the slave which checksum work to do. RX verification costs slave
+ * CPU, so it is only asked for while some netdev has rxcsum on. @features
+ * replaces the current features of @ndev (ndo_set_features runs before
+ * they are updated). */
+static void esp_update_csum_offload(struct esp_adapter *adapter,
+		struct net_device *ndev, netdev_features_t features)
+{
+	u8 cmd[2] = { ESP_PRIV_CMD_CSUM_OFFLOAD, 0 };
+	netdev_features_t f;
+	int i;
+
+	if (!csum_offload || !adapter->csum_caps)
+		return;
+
+	for (i = 0; i < ESP_MAX_INTERFACE; i++) {
+		if (!adapter->priv[i] || !adapter->priv[i]->ndev)
+			continue;
+
+		f = adapter->priv[i]->ndev == ndev ? features :
+			adapter->priv[i]->ndev->features;
+		if (f & NETIF_F_RXCSUM)
+			cmd[1] |= ESP_CSUM_OFFLOAD_RX;
+		if (f & NETIF_F_CSUM_MASK)
+			cmd[1] |= ESP_CSUM_OFFLOAD_TX;
+	}
+
+	cmd[1] &= adapter->csum_caps;
+	esp_send_priv_data(adapter, cmd, sizeof(cmd));
+}
+
+static int esp_set_features(struct net_device *ndev, netdev_features_t features)
+{
+	struct esp_private *priv = netdev_priv(ndev);
+
+	if (priv->adapter &&
+	    ((ndev->features ^ features) & (NETIF_F_RXCSUM | NETIF_F_CSUM_MASK)))
+		esp_update_csum_offload(priv->adapter, ndev, features);
+
+	return 0;
+}
+
+/* The slave completes TCP/UDP checksums right after a plain IPv4 or IPv6
+ * header, see ESP_PRIV_CSUM_OFFLOAD */
+static bool esp_csum_offloadable(struct sk_buff *skb)
+{
+	int start = skb_checksum_start_offset(skb);
+	u8 proto;
+
+	if (skb_network_offset(skb) != ETH_HLEN)
+		return false;
+
+	if (skb->protocol == htons(ETH_P_IP)) {
+		if (ip_is_fragment(ip_hdr(skb)) ||
+		    start != ETH_HLEN + ip_hdrlen(skb))
+			return false;
+		proto = ip_hdr(skb)->protocol;
+	} else if (skb->protocol == htons(ETH_P_IPV6)) {
+		if (start != ETH_HLEN + sizeof(struct ipv6hdr))
+			return false;
+		proto = ipv6_hdr(skb)->nexthdr;
+	} else {
+		return false;
+	}
+
+	if (proto == IPPROTO_TCP)
+		return skb->csum_offset == offsetof(struct tcphdr, check);
+	if (proto == IPPROTO_UDP)
+		return skb->csum_offset == offsetof(struct udphdr, check);
+
+	return false;
+}
+
+/* Leave CHECKSUM_PARTIAL only on frames the slave can complete */
+static int esp_tx_csum(struct sk_buff *skb)
+{
+	if (skb->ip_summed != CHECKSUM_PARTIAL || esp_csum_offloadable(skb))
+		return 0;
+
+	return skb_checksum_help(skb);
+}
+
+static bool esp_tx_busy(void)
+{
+	return netif_queue_stopped((const struct net_device *) adapter.priv[0]->ndev) ||
+	       netif_queue_stopped((const struct net_device *) adapter.priv[1]->ndev) ||
+	       is_host_sleeping();
+}
+
+/* GSO super-packet: cut into MTU sized frames here, behind a single TX
+ * queue check, and let the slave fill in each segment's checksum. The
+ * transport's pending headroom absorbs one super-packet past the pause
+ * threshold. */
+static int esp_xmit_gso(struct esp_private *priv, struct sk_buff *skb)
+{
+	struct sk_buff *segs, *seg, *next;
+	netdev_features_t features;
+
+	if (esp_tx_busy())
+		return NETDEV_TX_BUSY;
+
+	/* Linear segments, checksums left partial */
+	features = priv->ndev->features & ~(NETIF_F_GSO_MASK | NETIF_F_SG);
+	segs = skb_gso_segment(skb, features);
+	if (IS_ERR_OR_NULL(segs)) {
+		priv->stats.tx_dropped++;
+		dev_kfree_skb_any(skb);
+		return NETDEV_TX_OK;
+	}
+	consume_skb(skb);
+
+	for (seg = segs; seg; seg = next) {
+		next = seg->next;
+		seg->next = NULL;
+
+		if (esp_tx_csum(seg)) {
+			priv->stats.tx_dropped++;
+			dev_kfree_skb_any(seg);
+			continue;
+		}
+
+		((struct esp_skb_cb *)seg->cb)->priv = priv;
+		process_tx_packet(seg);
+	}
+
+	return NETDEV_TX_OK;
+}
+
 static int esp_hard_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 {
 	struct esp_private *priv = NULL;
 	struct esp_skb_cb *cb = NULL;
+	u64 start_ns = ktime_get_ns();
+	int ret;
 
 	if (!ndev) {
 		dev_kfree_skb(skb);
@@ -217,6 +479,15 @@ static int esp_hard_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		return NETDEV_TX_OK;
 	}
 
+	trace_esp_xmit(priv->if_type, priv->if_num, skb->len);
+
+	if (skb_is_gso(skb)) {
+		ret = esp_xmit_gso(priv, skb);
+		if (ret == NETDEV_TX_OK)
+			esp_hist_since(ESP_HIST_TX_XMIT, start_ns);
+		return ret;
+	}
+
 	if (!skb->len || (skb->len > ETH_FRAME_LEN)) {
 		esp_err("tx len[%d], max_len[%d]\n", skb->len, ETH_FRAME_LEN);
 		priv->stats.tx_dropped++;
@@ -224,10 +495,24 @@ static int esp_hard_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		return NETDEV_TX_OK;
 	}
 
+	if (esp_tx_busy())
+		return NETDEV_TX_BUSY;
+
+	/* Transports send the linear part only */
+	if (esp_tx_csum(skb) || skb_linearize(skb)) {
+		priv->stats.tx_dropped++;
+		dev_kfree_skb(skb);
+		return NETDEV_TX_OK;
+	}
+
 	cb = (struct esp_skb_cb *) skb->cb;
 	cb->priv = priv;
 
-	return process_tx_packet(skb);
+	ret = process_tx_packet(skb);
+	if (ret == NETDEV_TX_OK)
+		esp_hist_since(ESP_HIST_TX_XMIT, start_ns);
+
+	return ret;
 }
 
 u8 esp_is_bt_supported_over_sdio(u32 cap)
@@ -255,7 +540,7 @@ __weak void esp_hci_rx(struct esp_adapter *adapter, struct sk_buff *skb)
 		dev_kfree_skb_any(skb);
 }
 
-static struct esp_private * get_priv_from_payload_header(struct esp_payload_header *header)
+struct esp_private * get_priv_from_payload_header(struct esp_payload_header *header)
 {
 	struct esp_private *priv = NULL;
 	u8 i = 0;
@@ -295,6 +580,7 @@ static int process_tx_packet (struct sk_buff *skb)
 	u16 len = 0;
 	u16 total_len = 0;
 	u8 *pos = NULL;
+	bool csum_partial;
 
 	if (unlikely(!skb))
 		return NETDEV_TX_OK;
@@ -309,16 +595,8 @@ static int process_tx_packet (struct sk_buff *skb)
 
 	priv = cb->priv;
 
-	if (netif_queue_stopped((const struct net_device *) adapter.priv[0]->ndev) ||
-	    netif_queue_stopped((const struct net_device *) adapter.priv[1]->ndev)) {
-		return NETDEV_TX_BUSY;
-	}
-
-	if (is_host_sleeping()) {
-		return NETDEV_TX_BUSY;
-	}
-
 	len = skb->len;
+	csum_partial = (skb->ip_summed == CHECKSUM_PARTIAL);
 
 	/* Create space for payload header */
 	pad_len = sizeof(struct esp_payload_header);
@@ -356,6 +634,7 @@ static int process_tx_packet (struct sk_buff *skb)
 		/* Populate new SKB */
 		skb_copy_from_linear_data(skb, pos, skb->len);
 		skb_put(new_skb, skb->len + pad_len);
+		skb_set_queue_mapping(new_skb, skb_get_queue_mapping(skb));
 
 		/* Replace old SKB */
 		dev_kfree_skb_any(skb);
@@ -373,6 +652,8 @@ static int process_tx_packet (struct sk_buff *skb)
 	payload_header->if_num = priv->if_num;
 	payload_header->len = cpu_to_le16(len);
 	payload_header->offset = cpu_to_le16(pad_len);
+	if (csum_partial)
+		payload_header->flags |= FLAG_CSUM_PARTIAL;
 
 	if (!stop_data) {
 		ret = esp_send_packet(priv->adapter, skb);
@@ -390,6 +671,29 @@ static int process_tx_packet (struct sk_buff *skb)
 
 	return 0;
 }
+
+int esp_tx_frame(struct esp_private *priv, struct sk_buff *skb)
+{
+	if (esp_tx_busy())
+		return NETDEV_TX_BUSY;
+
+	((struct esp_skb_cb *)skb->cb)->priv = priv;
+	return process_tx_packet(skb);
+}
+
+/* Settings the slave forgets when it restarts, so sent after every
+ * boot-up event */
+static void esp_send_priv_config(struct esp_adapter *adapter)
+{
+	/* Let slave send serial fragments with total length */
+	if (adapter->serial_caps & ESP_SERIAL_CAP_TOTAL_LEN)
+		esp_send_priv_command(adapter, ESP_PRIV_CMD_SERIAL_TOTAL_LEN);
+
+	esp_telemetry_start(adapter);
+
+	esp_update_csum_offload(adapter, NULL, 0);
+}
+
 void process_capabilities(u8 cap)
 {
 	struct esp_adapter *adapter = esp_get_adapter();
@@ -417,6 +721,8 @@ void process_capabilities(u8 cap)
 	} else {
 		esp_info("No BT support in capabilities (0x%x)\n", cap);
 	}
+
+	esp_send_priv_config(adapter);
 }
 
 static void process_event(u8 *evt_buf, u16 len)
@@ -439,6 +745,12 @@ static void process_event(u8 *evt_buf, u16 len)
 
 		process_init_event(event->event_data, event->event_len);
 
+	} else if (event->event_type == ESP_PRIV_EVENT_TELEMETRY) {
+
+		if (len > sizeof(*event))
+			esp_telemetry_process(event->event_data,
+					min_t(u16, event->event_len, len - sizeof(*event)));
+
 	} else {
 		esp_warn("Drop unknown event\n");
 	}
@@ -476,7 +788,24 @@ static void esp_events_work(struct work_struct *work)
 	}
 }
 
-/* Dispatch one validated frame; consumes skb. */
+/* Hand an Ethernet frame to the stack on @priv's netdev */
+void esp_rx_deliver(struct esp_private *priv, struct sk_buff *skb, u8 flags)
+{
+	skb->dev = priv->ndev;
+	skb->protocol = eth_type_trans(skb, priv->ndev);
+	if ((flags & FLAG_CSUM_VALID) && (priv->ndev->features & NETIF_F_RXCSUM))
+		skb->ip_summed = CHECKSUM_UNNECESSARY;
+	else
+		skb->ip_summed = CHECKSUM_NONE;
+
+	priv->stats.rx_bytes += skb->len;
+	esp_hist_since(ESP_HIST_RX_DELIVER,
+		       ((struct esp_skb_cb *)skb->cb)->tstamp);
+	/* Forward skb to kernel */
+	netif_rx_ni(skb);
+	priv->stats.rx_packets++;
+}
+
 static void process_skb(struct sk_buff *skb, u16 len, u16 offset)
 {
 	struct esp_private *priv = NULL;
@@ -484,13 +813,26 @@ static void process_skb(struct sk_buff *skb, u16 len, u16 offset)
 	u16 rx_checksum = 0, checksum = 0;
 	int ret = 0, ret_len = 0;
 	struct esp_adapter *adapter = esp_get_adapter();
+	struct esp_xdp_batch xdp_batch;
+	bool xdp_taken;
 
 	if (!skb)
 		return;
 
 	payload_header = (struct esp_payload_header *) skb->data;
 
+	/* Frames that reached us in an skb of their own: a batch of one */
+	esp_xdp_batch_begin(&xdp_batch);
+	xdp_taken = esp_xdp_rx(adapter, skb->data,
+			((struct esp_skb_cb *)skb->cb)->tstamp, &xdp_batch);
+	esp_xdp_batch_end(&xdp_batch);
+	if (xdp_taken) {
+		dev_kfree_skb_any(skb);
+		return;
+	}
+
 	UPDATE_HEADER_RX_PKT_NO(payload_header);
+	trace_esp_rx_dispatch(payload_header);
 
 	if ((payload_header->flags & FLAG_WAKEUP_PKT) && (len<1500)) {
 		esp_hex_dump_dbg("Wake up rx: ", skb->data, (len+offset)>64? 64: (len+offset));
@@ -515,6 +857,8 @@ static void process_skb(struct sk_buff *skb, u16 len, u16 offset)
 		u16 seq = le16_to_cpu(payload_header->seq_num);
 		bool more = (payload_header->flags & MORE_FRAGMENT);
 		int if_num = payload_header->if_num;
+		u8 *data;
+		u16 data_len;
 
 		if (if_num >= SERIAL_REASM_MAX_DEVS) {
 			esp_err("serial if_num out of range: %d\n", if_num);
@@ -523,17 +867,17 @@ static void process_skb(struct sk_buff *skb, u16 len, u16 offset)
 		}
 
 		if (!more && !serial_reasm[if_num].active) {
-		do {
-			ret = esp_serial_data_received(payload_header->if_num,
-					(skb->data + offset + ret_len), (len - ret_len));
-			if (ret < 0) {
-				esp_err("Failed to process data for iface type %d\n",
-						payload_header->if_num);
-				break;
-			}
-			ret_len += ret;
-		} while (ret_len < len);
-		dev_kfree_skb_any(skb);
+			do {
+				ret = esp_serial_data_received(payload_header->if_num,
+						(skb->data + offset + ret_len), (len - ret_len));
+				if (ret < 0) {
+					esp_err("Failed to process data for iface type %d\n",
+							payload_header->if_num);
+					break;
+				}
+				ret_len += ret;
+			} while (ret_len < len);
+			dev_kfree_skb_any(skb);
 			return;
 		}
 
@@ -544,37 +888,60 @@ static void process_skb(struct sk_buff *skb, u16 len, u16 offset)
 			serial_reasm_reset(if_num);
 		}
 
-		if (serial_reasm[if_num].len + len > SERIAL_REASM_MAX_LEN) {
-			esp_err("serial reasm overflow: %zu + %zu > %zu, dropping\n",
-					serial_reasm[if_num].len, (size_t)len,
-					(size_t)SERIAL_REASM_MAX_LEN);
-			serial_reasm_reset(if_num);
-			dev_kfree_skb_any(skb);
-			return;
-		}
+		data = skb->data + offset;
+		data_len = len;
+
+		/* First fragment: pick the reassembly buffer. Messages not
+		 * announcing their length, or small enough, reuse the legacy
+		 * buffer; only larger announced totals get their own */
+		if (!serial_reasm[if_num].active) {
+			size_t size = SERIAL_REASM_LEGACY_LEN;
+
+			if (payload_header->flags & FLAG_FRAG_TOTAL_LEN) {
+				if (data_len < ESP_SERIAL_TOTAL_LEN_SIZE) {
+					esp_err("serial reasm: short first fragment %u\n", data_len);
+					dev_kfree_skb_any(skb);
+					return;
+				}
+				size = data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+				data += ESP_SERIAL_TOTAL_LEN_SIZE;
+				data_len -= ESP_SERIAL_TOTAL_LEN_SIZE;
+
+				if (size < data_len || size > SERIAL_REASM_MAX_LEN) {
+					esp_err("serial reasm: invalid total len %zu, dropping\n", size);
+					dev_kfree_skb_any(skb);
+					return;
+				}
+			}
 
-		if (serial_reasm[if_num].buf) {
-			u8 *tmp = krealloc(serial_reasm[if_num].buf,
-						serial_reasm[if_num].len + len, GFP_KERNEL);
-			if (!tmp) {
-				esp_err("serial reasm realloc failed\n");
-				serial_reasm_reset(if_num);
-				dev_kfree_skb_any(skb);
-				return;
+			if (size <= SERIAL_REASM_LEGACY_LEN) {
+				if (!serial_reasm[if_num].legacy_buf)
+					serial_reasm[if_num].legacy_buf =
+						kvmalloc(SERIAL_REASM_LEGACY_LEN, GFP_KERNEL);
+				serial_reasm[if_num].buf = serial_reasm[if_num].legacy_buf;
+			} else {
+				serial_reasm[if_num].buf = kvmalloc(size, GFP_KERNEL);
 			}
-			serial_reasm[if_num].buf = tmp;
-		} else {
-			serial_reasm[if_num].buf = kmalloc(len, GFP_KERNEL);
 			if (!serial_reasm[if_num].buf) {
-				esp_err("serial reasm alloc failed\n");
+				esp_err("serial reasm alloc of %zu failed\n", size);
 				dev_kfree_skb_any(skb);
 				return;
 			}
+			serial_reasm[if_num].size = size;
+		}
+
+		if (serial_reasm[if_num].len + data_len > serial_reasm[if_num].size) {
+			esp_err("serial reasm overflow: %zu + %zu > %zu, dropping\n",
+					serial_reasm[if_num].len, (size_t)data_len,
+					serial_reasm[if_num].size);
+			serial_reasm_reset(if_num);
+			dev_kfree_skb_any(skb);
+			return;
 		}
 
 		memcpy(serial_reasm[if_num].buf + serial_reasm[if_num].len,
-		       skb->data + offset, len);
-		serial_reasm[if_num].len += len;
+		       data, data_len);
+		serial_reasm[if_num].len += data_len;
 		serial_reasm[if_num].last_seq = seq;
 		serial_reasm[if_num].active = more;
 
@@ -605,14 +972,7 @@ static void process_skb(struct sk_buff *skb, u16 len, u16 offset)
 			return;
 		}
 
-		skb->dev = priv->ndev;
-		skb->protocol = eth_type_trans(skb, priv->ndev);
-		skb->ip_summed = CHECKSUM_NONE;
-
-		priv->stats.rx_bytes += skb->len;
-		/* Forward skb to kernel */
-		netif_rx_ni(skb);
-		priv->stats.rx_packets++;
+		esp_rx_deliver(priv, skb, payload_header->flags);
 
 	} else if (payload_header->if_type == ESP_HCI_IF) {
 		esp_hci_rx(adapter, skb);
@@ -627,7 +987,7 @@ static void process_skb(struct sk_buff *skb, u16 len, u16 offset)
 
 	} else if (payload_header->if_type == ESP_TEST_IF) {
 		#if TEST_RAW_TP
-			update_test_raw_tp_rx_stats(len);
+			update_test_raw_tp_rx_stats(skb->data + offset, len);
 		#endif
 		dev_kfree_skb_any(skb);
 	} else {
@@ -719,7 +1079,7 @@ void esp_tx_pause(void)
     for (i = 0; i < ESP_MAX_INTERFACE; i++) {
         priv = adapter.priv[i];
         if (priv && priv->ndev && !netif_queue_stopped(priv->ndev)) {
-            netif_stop_queue(priv->ndev);
+            netif_tx_stop_all_queues(priv->ndev);
 			esp_verbose("TX queue paused on interface %d\n", i);
         }
     }
@@ -733,7 +1093,7 @@ void esp_tx_resume(void)
     for (i = 0; i < ESP_MAX_INTERFACE; i++) {
         priv = adapter.priv[i];
         if (priv && priv->ndev && netif_queue_stopped(priv->ndev)) {
-            netif_wake_queue(priv->ndev);
+            netif_tx_wake_all_queues(priv->ndev);
             esp_verbose("TX queue resumed on interface %d\n", i);
         }
     }
@@ -759,6 +1119,24 @@ static int esp_get_packets(struct esp_adapter *adapter)
 	return 0;
 }
 
+/* Number H2E frames so host traces and slave logs can be matched. Serial
+ * frames keep their own fragment sequence, and a frame already numbered (e.g.
+ * before its checksum was sealed) is left alone; 0 is never handed out. */
+void esp_stamp_tx_seq(struct esp_payload_header *header)
+{
+	static atomic_t tx_seq_num;
+	u16 seq;
+
+	if (header->if_type == ESP_SERIAL_IF || header->seq_num)
+		return;
+
+	do {
+		seq = (u16)atomic_inc_return(&tx_seq_num);
+	} while (!seq);
+
+	header->seq_num = cpu_to_le16(seq);
+}
+
 int esp_send_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 {
 	/* Free skb here too so error paths keep a single ownership rule. */
@@ -767,9 +1145,41 @@ int esp_send_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 		return -EINVAL;
 	}
 
+	if (skb && skb->len >= sizeof(struct esp_payload_header))
+		esp_stamp_tx_seq((struct esp_payload_header *)skb->data);
+
 	return adapter->if_ops->write(adapter, skb);
 }
 
+void esp_send_priv_data(struct esp_adapter *adapter, const u8 *data, u16 len)
+{
+	struct sk_buff *skb;
+	struct esp_payload_header *hdr;
+	u16 offset = sizeof(struct esp_payload_header);
+
+	if (!adapter || !adapter->if_ops || !adapter->if_ops->alloc_skb || !len)
+		return;
+	skb = adapter->if_ops->alloc_skb(offset + len);
+	if (!skb)
+		return;
+	skb_put(skb, offset + len);
+	hdr = (struct esp_payload_header *) skb->data;
+	memset(hdr, 0, offset);
+	hdr->if_type = ESP_PRIV_IF;
+	hdr->if_num = 0;
+	hdr->len = cpu_to_le16(len);
+	hdr->offset = cpu_to_le16(offset);
+	hdr->priv_pkt_type = ESP_PACKET_TYPE_COMMAND;
+	memcpy(skb->data + offset, data, len);
+	if (esp_send_packet(adapter, skb))
+		esp_err("Failed to send priv command %u to slave\n", data[0]);
+}
+
+void esp_send_priv_command(struct esp_adapter *adapter, u8 cmd)
+{
+	esp_send_priv_data(adapter, &cmd, 1);
+}
+
 static int insert_priv_to_adapter(struct esp_private *priv)
 {
 	int i = 0;
@@ -815,6 +1225,7 @@ static int esp_init_net_dev(struct net_device *ndev, struct esp_private *priv)
 
 	/* Set netdev */
 	ndev->netdev_ops = &esp_netdev_ops;
+	ndev->ethtool_ops = &esp_ethtool_ops;
 
 #if 0
 	/* Set MTU to account for our headers */
@@ -826,6 +1237,14 @@ static int esp_init_net_dev(struct net_device *ndev, struct esp_private *priv)
 
 	eth_hw_addr_set(ndev, priv->mac_address);
 
+	if (csum_offload && (adapter.csum_caps & ESP_CSUM_OFFLOAD_RX))
+		ndev->hw_features |= NETIF_F_RXCSUM;
+	/* TSO is segmented in esp_xmit_gso(), so it rides on TX checksum */
+	if (csum_offload && (adapter.csum_caps & ESP_CSUM_OFFLOAD_TX))
+		ndev->hw_features |= NETIF_F_IP_CSUM | NETIF_F_IPV6_CSUM |
+			NETIF_F_SG | NETIF_F_TSO | NETIF_F_TSO6;
+	ndev->features |= ndev->hw_features;
+
 	/* Register netdev */
 	ret = register_netdev(ndev);
 	if (ret) {
@@ -849,12 +1268,13 @@ static int esp_add_interface(struct esp_adapter *adapter, u8 if_type, u8 if_num,
 	struct esp_private *priv = NULL;
 	int ret = 0;
 
+	/* One TX queue per access category */
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0))
 	ndev = alloc_netdev_mqs(sizeof(struct esp_private), name,
-			NET_NAME_ENUM, ether_setup, 1, 1);
+			NET_NAME_ENUM, ether_setup, ESP_NUM_AC, 1);
 #else
 	ndev = alloc_netdev_mqs(sizeof(struct esp_private), name,
-			ether_setup, 1, 1);
+			ether_setup, ESP_NUM_AC, 1);
 #endif
 
 	if (!ndev) {
@@ -871,9 +1291,16 @@ static int esp_add_interface(struct esp_adapter *adapter, u8 if_type, u8 if_num,
 		goto error_exit;
 	}
 
+	ret = esp_xdp_init(priv);
+	if (ret) {
+		esp_err("Init XDP failed\n");
+		goto error_exit;
+	}
+
 	ret = esp_init_net_dev(ndev, priv);
 	if (ret) {
 		esp_err("Init netdev failed\n");
+		esp_xdp_deinit(priv);
 		goto error_exit;
 	}
 
@@ -890,17 +1317,19 @@ error_exit:
 static void esp_remove_network_interfaces(struct esp_adapter *adapter)
 {
 	if (adapter->priv[0] && adapter->priv[0]->ndev) {
-		netif_stop_queue(adapter->priv[0]->ndev);
+		netif_tx_stop_all_queues(adapter->priv[0]->ndev);
 	unregister_inetaddr_notifier(&(adapter->priv[0]->nb));
 		unregister_netdev(adapter->priv[0]->ndev);
+		esp_xdp_deinit(adapter->priv[0]);
 		free_netdev(adapter->priv[0]->ndev);
 		adapter->priv[0] = NULL;
 	}
 
 	if (adapter->priv[1] && adapter->priv[1]->ndev) {
-		netif_stop_queue(adapter->priv[1]->ndev);
+		netif_tx_stop_all_queues(adapter->priv[1]->ndev);
 	unregister_inetaddr_notifier(&(adapter->priv[1]->nb));
 		unregister_netdev(adapter->priv[1]->ndev);
+		esp_xdp_deinit(adapter->priv[1]);
 		free_netdev(adapter->priv[1]->ndev);
 		adapter->priv[1] = NULL;
 	}
@@ -1070,10 +1499,19 @@ static int __init esp_init(void)
 	if (!adapter)
 		return -EFAULT;
 
+	adapter->debugfs_dir = debugfs_create_dir(KBUILD_MODNAME, NULL);
+	esp_hist_init(adapter->debugfs_dir);
+	esp_telemetry_init(adapter->debugfs_dir);
+	esp_rx_pool_debugfs_init(adapter->debugfs_dir);
+#if TEST_RAW_TP
+	esp_raw_tp_init(adapter->debugfs_dir);
+#endif
+
 	/* Init transport layer */
 	ret = esp_init_interface_layer(adapter);
 
 	if (ret != 0) {
+		debugfs_remove_recursive(adapter->debugfs_dir);
 		deinit_adapter();
 	}
 
@@ -1096,6 +1534,10 @@ static void __exit esp_exit(void)
 #endif
 
 	esp_deinit_interface_layer();
+	serial_reasm_cleanup();
+
+	debugfs_remove_recursive(adapter.debugfs_dir);
+	adapter.debugfs_dir = NULL;
 
 	deinit_adapter();
 
@@ -17,17 +17,23 @@
 #include <linux/kthread.h>
 #include <linux/ktime.h>
 #include "esp_stats.h"
+#include "esp_hist.h"
+#include "esp_xdp.h"
+#include "esp_trace.h"
 #include "esp_utils.h"
 #include "esp_fw_verify.h"
 #include "esp_kernel_port.h"
 
 extern u32 raw_tp_mode;
 #define MAX_WRITE_RETRIES       200    /* per credit probe */
-#define TX_MAX_PENDING_COUNT    1000   /* high-water */
+#define TX_MAX_PENDING_COUNT    1000   /* default high-water */
+#define TX_PENDING_COUNT_MIN    16     /* ethtool -G tx bounds */
+#define TX_PENDING_COUNT_MAX    8192
 #define TX_PENDING_HEADROOM     64     /* stop-queue slack */
-#define TX_HARD_PENDING_COUNT   (TX_MAX_PENDING_COUNT + TX_PENDING_HEADROOM) /* backstop */
-#define TX_RESUME_THRESHOLD     (TX_MAX_PENDING_COUNT/5)
-#define TX_MAX_PENDING_BYTES    (2 * 1024 * 1024)   /* H2E byte ceiling */
+#define TX_HARD_PENDING_COUNT   (READ_ONCE(tx_max_pending) + TX_PENDING_HEADROOM) /* backstop */
+#define TX_RESUME_THRESHOLD     (READ_ONCE(tx_max_pending)/5)
+#define TX_MAX_PENDING_BYTES    (2 * 1024 * 1024)   /* default H2E byte ceiling */
+#define TX_PENDING_BYTES_MIN    (64 * 1024)
 #define H2E_CREDIT_WAIT_MS      12                  /* bulk wait bound */
 #define H2E_CREDIT_WAIT_CTRL_MS 200                 /* control wait bound */
 #define H2E_NO_CREDIT_WEDGE     8                   /* repeated timeout threshold */
@@ -53,15 +59,34 @@ struct esp_sdio_context sdio_context;
 static atomic_t tx_pending;
 static atomic_t tx_pending_bytes;	/* in-flight H2E bytes; hard memory ceiling */
 static atomic_t queue_items[MAX_PRIORITY_QUEUES];
-#ifdef ESP_DEBUG_STATS
+
+/* Runtime TX limits. ethtool -G tx sets tx_max_pending. ethtool has no ring
+ * field for a byte budget or an aggregate size, so those two are writable
+ * module parameters; both are reported by ethtool -g/-S. */
+static u32 tx_max_pending = TX_MAX_PENDING_COUNT;
+static uint tx_max_pending_bytes = TX_MAX_PENDING_BYTES;
+module_param(tx_max_pending_bytes, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(tx_max_pending_bytes, "H2E bytes queued before TX is refused");
+static uint tx_aggr_limit;
+module_param(tx_aggr_limit, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(tx_aggr_limit, "H2E aggregate size cap in bytes, 0 = slave buffer size");
+
+/* Transport counters, monotonic since probe; exported through ethtool -S */
 static atomic_t h2e_host_drop_no_credit;	/* aggregates dropped: slave credit-saturated */
 static atomic_t h2e_host_tx_queued;
 static atomic_t h2e_host_tx_sent;
+static atomic_t h2e_host_tx_aggr_frames;	/* frames carried by sent aggregates */
 static atomic_t h2e_host_drop_queue_full;
 static atomic_t h2e_host_drop_invalid;
 static atomic_t h2e_host_drop_truncated;
 static atomic_t h2e_host_no_credit_waits;
 static atomic_t h2e_host_write_fail;
+static atomic_t e2h_host_reads;
+static atomic_t e2h_host_rx_frames;
+static atomic_t e2h_host_rx_aggr;		/* reads carrying more than one frame */
+static atomic_t e2h_host_read_fail;
+static atomic_t e2h_host_drop_invalid;
+#ifdef ESP_DEBUG_STATS
 static unsigned long h2e_host_stats_jiffies;
 static u64 h2e_host_time_write_us;
 static u64 h2e_host_time_credit_us;
@@ -80,30 +105,6 @@ int esp_validate_chipset(struct esp_adapter *adapter, u8 chipset);
 int esp_sdio_rxq_only;
 int is_host_sleeping(void) { return host_sleep; }
 
-static void esp_send_raw_tp_command(struct esp_adapter *adapter, u8 cmd)
-{
-	struct sk_buff *skb;
-	struct esp_payload_header *hdr;
-	u16 offset = sizeof(struct esp_payload_header);
-
-	if (!adapter || !adapter->if_ops || !adapter->if_ops->alloc_skb)
-		return;
-	skb = adapter->if_ops->alloc_skb(offset + 1);
-	if (!skb)
-		return;
-	skb_put(skb, offset + 1);
-	hdr = (struct esp_payload_header *) skb->data;
-	memset(hdr, 0, offset);
-	hdr->if_type = ESP_PRIV_IF;
-	hdr->if_num = 0;
-	hdr->len = cpu_to_le16(1);
-	hdr->offset = cpu_to_le16(offset);
-	hdr->priv_pkt_type = ESP_PACKET_TYPE_COMMAND;
-	skb->data[offset] = cmd;
-	if (esp_send_packet(adapter, skb))
-		esp_err("Failed to send raw-tp command %u to slave\n", cmd);
-}
-
 /* Parse boot TLVs and start datapath. */
 int process_init_event(u8 *evt_buf, u8 len)
 {
@@ -116,6 +117,11 @@ int process_init_event(u8 *evt_buf, u8 len)
 	if (!evt_buf || !adapter)
 		return -1;
 
+	adapter->serial_caps = 0;
+	adapter->telemetry_ver = 0;
+	adapter->csum_caps = 0;
+	adapter->hci_batch_caps = 0;
+
 	pos = evt_buf;
 	/* Parse boot TLVs; unknown tags are ignored. */
 	while (len_left) {
@@ -163,6 +169,22 @@ int process_init_event(u8 *evt_buf, u8 len)
 		case ESP_PRIV_CUSTOM_STR:
 			esp_info("TLV[%u] custom_str: %.*s\n", tag, (int)tag_len, pos + 2);
 			break;
+		case ESP_PRIV_SERIAL_CAPS:
+			adapter->serial_caps = *(pos + 2);
+			esp_info("TLV[%u] serial_caps: 0x%x\n", tag, adapter->serial_caps);
+			break;
+		case ESP_PRIV_TELEMETRY:
+			adapter->telemetry_ver = *(pos + 2);
+			esp_info("TLV[%u] telemetry: v%u\n", tag, adapter->telemetry_ver);
+			break;
+		case ESP_PRIV_CSUM_OFFLOAD:
+			adapter->csum_caps = *(pos + 2);
+			esp_info("TLV[%u] csum_offload: 0x%x\n", tag, adapter->csum_caps);
+			break;
+		case ESP_PRIV_HCI_BATCH:
+			adapter->hci_batch_caps = *(pos + 2);
+			esp_info("TLV[%u] hci_batch: 0x%x\n", tag, adapter->hci_batch_caps);
+			break;
 		case ESP_PRIV_RX_BUF_CONFIG:
 			if (tag_len == sizeof(struct esp_priv_rx_buf_config)) {
 				const struct esp_priv_rx_buf_config *cfg =
@@ -215,66 +237,179 @@ int process_init_event(u8 *evt_buf, u8 len)
 	process_capabilities(adapter->capabilities);
 
 #if TEST_RAW_TP
-	if (raw_tp_mode != 0) {
-		u8 raw_tp_cap = ESP_TEST_RAW_TP;
-
-		esp_send_raw_tp_command(adapter, (u8) raw_tp_mode);
-		if (raw_tp_mode == ESP_PRIV_CMD_RAW_TP_ESP_TO_HOST)
-			raw_tp_cap |= ESP_TEST_RAW_TP__ESP_TO_HOST;
-		process_test_capabilities(raw_tp_cap);
-	}
+	esp_raw_tp_start(adapter, raw_tp_mode);
 #endif
 	return 0;
 }
 
-#ifdef ESP_DEBUG_STATS
 #define H2E_HOST_STATS_INC(counter) atomic_inc(&(counter))
+#define H2E_HOST_STATS_ADD(counter, n) atomic_add((n), &(counter))
+
+#ifdef ESP_DEBUG_STATS
 #define H2E_HOST_STATS_TIME_ADD(counter, start_time) \
 	do { \
 		(counter) += ktime_to_us(ktime_sub(ktime_get(), start_time)); \
 	} while (0)
 
+/* Counters are cumulative (ethtool -S reads them too); only the
+ * per-aggregate averages are per 5 s window. */
 static void print_h2e_host_stats(void)
 {
+	static int last_sent;
 	unsigned long now = jiffies;
+	int sent, win_sent;
 
 	if (time_before(now, h2e_host_stats_jiffies + 5 * HZ))
 		return;
 
 	h2e_host_stats_jiffies = now;
-	int sent = atomic_read(&h2e_host_tx_sent);
-	if (atomic_read(&h2e_host_tx_queued) ||
-	    sent ||
+	sent = atomic_read(&h2e_host_tx_sent);
+	win_sent = sent - last_sent;
+	last_sent = sent;
+	if (win_sent ||
 	    atomic_read(&h2e_host_drop_queue_full) ||
-	    atomic_read(&h2e_host_drop_invalid) ||
-	    atomic_read(&h2e_host_drop_truncated) ||
-	    atomic_read(&h2e_host_no_credit_waits) ||
 	    atomic_read(&h2e_host_drop_no_credit) ||
 	    atomic_read(&h2e_host_write_fail)) {
-		u64 avg_write = sent ? (h2e_host_time_write_us / sent) : 0;
-		u64 avg_credit = sent ? (h2e_host_time_credit_us / sent) : 0;
-		u64 avg_aggr = sent ? (h2e_host_time_aggr_us / sent) : 0;
+		u64 avg_write = win_sent ? (h2e_host_time_write_us / win_sent) : 0;
+		u64 avg_credit = win_sent ? (h2e_host_time_credit_us / win_sent) : 0;
+		u64 avg_aggr = win_sent ? (h2e_host_time_aggr_us / win_sent) : 0;
 		h2e_host_time_write_us = 0;
 		h2e_host_time_credit_us = 0;
 		h2e_host_time_aggr_us = 0;
-		esp_info("H2E host stats: queued=%d sent=%d qfull=%d invalid=%d truncated=%d no_credit=%d nc_drop=%d write_fail=%d avg_us(write/credit/aggr)=%llu/%llu/%llu\n",
-			 atomic_xchg(&h2e_host_tx_queued, 0),
-			 atomic_xchg(&h2e_host_tx_sent, 0),
-			 atomic_xchg(&h2e_host_drop_queue_full, 0),
-			 atomic_xchg(&h2e_host_drop_invalid, 0),
-			 atomic_xchg(&h2e_host_drop_truncated, 0),
-			 atomic_xchg(&h2e_host_no_credit_waits, 0),
-			 atomic_xchg(&h2e_host_drop_no_credit, 0),
-			 atomic_xchg(&h2e_host_write_fail, 0),
+		esp_info("H2E host stats (total): queued=%d sent=%d qfull=%d invalid=%d truncated=%d no_credit=%d nc_drop=%d write_fail=%d avg_us(write/credit/aggr)=%llu/%llu/%llu\n",
+			 atomic_read(&h2e_host_tx_queued),
+			 sent,
+			 atomic_read(&h2e_host_drop_queue_full),
+			 atomic_read(&h2e_host_drop_invalid),
+			 atomic_read(&h2e_host_drop_truncated),
+			 atomic_read(&h2e_host_no_credit_waits),
+			 atomic_read(&h2e_host_drop_no_credit),
+			 atomic_read(&h2e_host_write_fail),
 			 avg_write, avg_credit, avg_aggr);
 	}
 }
 #else
-#define H2E_HOST_STATS_INC(counter) do { } while (0)
 #define H2E_HOST_STATS_TIME_ADD(counter, start_time) do { } while (0)
 static inline void print_h2e_host_stats(void) { }
 #endif
 
+struct esp_sdio_ethtool_stat {
+	const char *name;
+	atomic_t *val;
+};
+
+static const struct esp_sdio_ethtool_stat esp_sdio_ethtool_stats[] = {
+	{ "h2e_tx_queued",		&h2e_host_tx_queued },
+	{ "h2e_tx_aggr_sent",		&h2e_host_tx_sent },
+	{ "h2e_tx_aggr_frames",		&h2e_host_tx_aggr_frames },
+	{ "h2e_drop_queue_full",	&h2e_host_drop_queue_full },
+	{ "h2e_drop_invalid",		&h2e_host_drop_invalid },
+	{ "h2e_drop_truncated",		&h2e_host_drop_truncated },
+	{ "h2e_no_credit_waits",	&h2e_host_no_credit_waits },
+	{ "h2e_drop_no_credit",		&h2e_host_drop_no_credit },
+	{ "h2e_write_fail",		&h2e_host_write_fail },
+	{ "e2h_reads",			&e2h_host_reads },
+	{ "e2h_rx_frames",		&e2h_host_rx_frames },
+	{ "e2h_rx_aggr",		&e2h_host_rx_aggr },
+	{ "e2h_read_fail",		&e2h_host_read_fail },
+	{ "e2h_drop_invalid",		&e2h_host_drop_invalid },
+	/* gauges */
+	{ "tx_pending",			&tx_pending },
+	{ "tx_pending_bytes",		&tx_pending_bytes },
+	{ "tx_q_serial",		&queue_items[PRIO_Q_SERIAL] },
+	{ "tx_q_bt",			&queue_items[PRIO_Q_BT] },
+	{ "tx_q_others",		&queue_items[PRIO_Q_OTHERS] },
+};
+
+/* Gauges that aren't atomics, appended after the table */
+static const char * const esp_sdio_ethtool_sizes[] = {
+	"h2e_aggr_size",
+	"e2h_aggr_size",
+};
+
+/* Slave's H2E receive buffer: the credit unit and the largest aggregate */
+static u32 esp_sdio_slave_buf_size(void)
+{
+	return sdio_context.slave_rx_buf_size ?
+		sdio_context.slave_rx_buf_size : ESP_HOST_TX_AGGR_SIZE;
+}
+
+/* Aggregate size actually used by tx_process */
+static u32 esp_sdio_tx_aggr_size(void)
+{
+	u32 buf_size = esp_sdio_slave_buf_size();
+	u32 limit = READ_ONCE(tx_aggr_limit);
+
+	if (!limit || limit > buf_size)
+		return buf_size;
+
+	return max_t(u32, limit, ESP_BLOCK_SIZE);
+}
+
+static u32 esp_sdio_max_tx_len(struct esp_adapter *adapter)
+{
+	return esp_sdio_tx_aggr_size();
+}
+
+static int esp_sdio_get_sset_count(struct esp_adapter *adapter)
+{
+	return ARRAY_SIZE(esp_sdio_ethtool_stats) +
+		ARRAY_SIZE(esp_sdio_ethtool_sizes);
+}
+
+static void esp_sdio_get_strings(struct esp_adapter *adapter, u8 *data)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(esp_sdio_ethtool_stats); i++) {
+		strscpy(data, esp_sdio_ethtool_stats[i].name, ETH_GSTRING_LEN);
+		data += ETH_GSTRING_LEN;
+	}
+	for (i = 0; i < ARRAY_SIZE(esp_sdio_ethtool_sizes); i++) {
+		strscpy(data, esp_sdio_ethtool_sizes[i], ETH_GSTRING_LEN);
+		data += ETH_GSTRING_LEN;
+	}
+}
+
+static void esp_sdio_get_stats(struct esp_adapter *adapter, u64 *data)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(esp_sdio_ethtool_stats); i++)
+		*data++ = (u32)atomic_read(esp_sdio_ethtool_stats[i].val);
+	*data++ = esp_sdio_tx_aggr_size();
+	*data++ = sdio_context.e2h_aggr_size ?
+		sdio_context.e2h_aggr_size : ESP_RX_BUFFER_SIZE;
+}
+
+/* Only the TX side is host-tunable; the E2H ring lives on the slave */
+static void esp_sdio_get_ringparam(struct esp_adapter *adapter,
+				   struct ethtool_ringparam *ring)
+{
+	ring->tx_max_pending = TX_PENDING_COUNT_MAX;
+	ring->tx_pending = READ_ONCE(tx_max_pending);
+}
+
+static int esp_sdio_set_ringparam(struct esp_adapter *adapter,
+				  const struct ethtool_ringparam *ring)
+{
+	if (ring->rx_pending || ring->rx_mini_pending || ring->rx_jumbo_pending)
+		return -EINVAL;
+	if (ring->tx_pending < TX_PENDING_COUNT_MIN ||
+	    ring->tx_pending > TX_PENDING_COUNT_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(tx_max_pending, ring->tx_pending);
+	esp_info("TX pending high-water set to %u\n", ring->tx_pending);
+
+	/* Lowering the limit takes effect on the next write_packet; raising
+	 * it must release a queue paused at the old high-water mark. */
+	if (atomic_read(&tx_pending) < TX_RESUME_THRESHOLD)
+		esp_tx_resume();
+
+	return 0;
+}
+
 static const struct sdio_device_id esp_devices[] = {
 	{ SDIO_DEVICE(ESP_VENDOR_ID_1, ESP_DEVICE_ID_ESP32_1) },
 	{ SDIO_DEVICE(ESP_VENDOR_ID_1, ESP_DEVICE_ID_ESP32_2) },
@@ -495,6 +630,7 @@ static void esp_remove(struct sdio_func *func)
 	if (context) {
 		for (prio_q_idx = 0; prio_q_idx < MAX_PRIORITY_QUEUES; prio_q_idx++)
 			skb_queue_purge(&(sdio_context.tx_q[prio_q_idx]));
+		esp_ac_queue_purge(&sdio_context.tx_data);
 		skb_queue_purge(&(sdio_context.rx_q));
 		atomic_set(&tx_pending, 0);
 		atomic_set(&tx_pending_bytes, 0);
@@ -523,6 +659,7 @@ static void esp_remove(struct sdio_func *func)
 		}
 		kfree(context->reg_buf);
 		kfree(context->rx_len_buf);
+		esp_rx_pool_deinit(&context->rx_pool);
 		memset(context, 0, sizeof(struct esp_sdio_context));
 	}
 	esp_dbg("ESP SDIO cleanup completed\n");
@@ -550,6 +687,12 @@ static struct esp_if_ops if_ops = {
 	.read		= read_packet,
 	.write		= write_packet,
 	.alloc_skb	= esp_sdio_alloc_skb,
+	.get_sset_count	= esp_sdio_get_sset_count,
+	.get_strings	= esp_sdio_get_strings,
+	.get_stats	= esp_sdio_get_stats,
+	.get_ringparam	= esp_sdio_get_ringparam,
+	.set_ringparam	= esp_sdio_set_ringparam,
+	.max_tx_len	= esp_sdio_max_tx_len,
 };
 
 static int get_firmware_data(struct esp_sdio_context *context)
@@ -665,9 +808,17 @@ static int init_context(struct esp_sdio_context *context)
 		skb_queue_head_init(&(sdio_context.tx_q[prio_q_idx]));
 		atomic_set(&queue_items[prio_q_idx], 0);
 	}
+	esp_ac_queue_init(&sdio_context.tx_data);
 	skb_queue_head_init(&(sdio_context.rx_q));
 	init_waitqueue_head(&sdio_context.tx_wq);
 
+	ret = esp_rx_pool_init(&context->rx_pool, esp_sdio_alloc_skb,
+			ESP_RX_BUFFER_SIZE);
+	if (ret) {
+		esp_err("Failed to allocate RX buffers\n");
+		return ret;
+	}
+
 	context->adapter->if_type = ESP_IF_TYPE_SDIO;
 
 	return ret;
@@ -723,10 +874,12 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	struct esp_sdio_context *context;
 	struct esp_payload_header *header;
 	u16 len, offset, frame_len, aligned_len, pos_in_aggr;
+	struct esp_xdp_batch xdp_batch;
+	/* Stage timestamps, fed to the latency histograms */
+	u64 _t0 = ktime_get_ns(), _t1 = 0, _t2 = 0;
 #ifdef ESP_DEBUG_STATS
 	/* RX cadence instrumentation (debug builds only): per-read claim/setup/xfer
 	 * split + preemption counters, printed once/sec at the end of the read. */
-	u64 _t0 = ktime_get_ns(), _t1 = 0, _t2 = 0;
 	static u64 _acc_big, _acc_rem;
 	u64 _tb;
 	unsigned long _nivcsw0 = 0, _nvcsw0 = 0;
@@ -748,9 +901,8 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	}
 
 	CLAIM_RX_HOST(context);
-#ifdef ESP_DEBUG_STATS
 	_t1 = ktime_get_ns();	/* after SDIO-host claim */
-#endif
+	esp_hist_add(ESP_HIST_RX_CLAIM, _t1 - _t0);
 
 	data_left = len_to_read = len_from_slave = num_blocks = 0;
 
@@ -758,6 +910,7 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	ret = esp_get_len_from_slave(context, &len_from_slave, RX_LOCK_NEEDED);
 
 	if (ret) {
+		atomic_inc(&e2h_host_read_fail);
 		if (ret == -EMSGSIZE)
 			atomic_set(&context->adapter->state, ESP_CONTEXT_DISABLED);
 		RELEASE_RX_HOST(context);
@@ -769,7 +922,7 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 		return NULL;
 	}
 
-	skb = context->adapter->if_ops->alloc_skb(len_from_slave);
+	skb = esp_rx_pool_get(&context->rx_pool, len_from_slave);
 
 	if (!skb) {
 		esp_err("SKB alloc failed\n");
@@ -779,11 +932,13 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 
 	skb_put(skb, len_from_slave);
 	pos = skb->data;
+	((struct esp_skb_cb *)skb->cb)->tstamp = _t0;
 
 	data_left = len_from_slave;
 
+	_t2 = ktime_get_ns();	/* after len-read + buffer get, before CMD53 xfers */
+	esp_hist_add(ESP_HIST_RX_LEN, _t2 - _t1);
 #ifdef ESP_DEBUG_STATS
-	_t2 = ktime_get_ns();	/* after len-read + alloc_skb, before CMD53 xfers */
 	_nivcsw0 = current->nivcsw;
 	_nvcsw0  = current->nvcsw;
 #endif
@@ -821,8 +976,9 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 
 		if (ret) {
 			esp_err("Failed to read data - %d [%u - %d]\n", ret, num_blocks, len_to_read);
+			atomic_inc(&e2h_host_read_fail);
 			atomic_set(&context->adapter->state, ESP_CONTEXT_DISABLED);
-			dev_kfree_skb(skb);
+			esp_rx_pool_put(&context->rx_pool, skb);
 			skb = NULL;
 			RELEASE_RX_HOST(context);
 			return NULL;
@@ -836,6 +992,9 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	} while (data_left > 0);
 
 	RELEASE_RX_HOST(context);
+	esp_hist_since(ESP_HIST_RX_XFER, _t2);
+	trace_esp_rx_read(len_from_slave, ktime_get_ns() - _t0);
+	atomic_inc(&e2h_host_reads);
 
 #ifdef ESP_DEBUG_STATS
 	esp_rx_cadence_account(_t0, _t1, _t2, _nivcsw0, _nvcsw0,
@@ -847,28 +1006,35 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	offset = le16_to_cpu(header->offset);
 
 	if (len == 0) {
-		dev_kfree_skb(skb);
+		esp_rx_pool_put(&context->rx_pool, skb);
 		return NULL;
 	}
 	if (len > ESP_RX_BUFFER_SIZE || !ESP_OFFSET_VALID(offset)) {
 		esp_err("Drop invalid pkt: len=%d offset=%d\n", len, offset);
-		dev_kfree_skb(skb);
+		atomic_inc(&e2h_host_drop_invalid);
+		esp_rx_pool_put(&context->rx_pool, skb);
 		return NULL;
 	}
 	frame_len = len + offset;
 	if (frame_len > len_from_slave) {
 		esp_err("Drop truncated pkt: len=%d offset=%d total=%d\n",
 			len, offset, len_from_slave);
-		dev_kfree_skb(skb);
+		atomic_inc(&e2h_host_drop_invalid);
+		esp_rx_pool_put(&context->rx_pool, skb);
 		return NULL;
 	}
 	aligned_len = (frame_len + 3) & ~3;
 	if (aligned_len >= len_from_slave) {
 		if (frame_len < skb->len)
 			skb_trim(skb, frame_len);
-		return skb;
+		atomic_inc(&e2h_host_rx_frames);
+		trace_esp_rx_frame(header);
+		return esp_rx_pool_copybreak(&context->rx_pool, skb);
 	}
 
+	atomic_inc(&e2h_host_rx_aggr);
+
+	esp_xdp_batch_begin(&xdp_batch);
 	pos_in_aggr = 0;
 	while (pos_in_aggr + sizeof(*header) <= len_from_slave) {
 		struct sk_buff *frame_skb = NULL;
@@ -881,6 +1047,7 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 		if (len > ESP_RX_BUFFER_SIZE || !ESP_OFFSET_VALID(offset)) {
 			esp_err("Drop invalid aggregate pkt: len=%d offset=%d pos=%d\n",
 				len, offset, pos_in_aggr);
+			atomic_inc(&e2h_host_drop_invalid);
 			break;
 		}
 		frame_len = len + offset;
@@ -888,9 +1055,19 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 		if (pos_in_aggr + frame_len > len_from_slave) {
 			esp_err("Drop truncated aggregate pkt: len=%d offset=%d pos=%d total=%d\n",
 				len, offset, pos_in_aggr, len_from_slave);
+			atomic_inc(&e2h_host_drop_invalid);
 			break;
 		}
 
+		trace_esp_rx_frame(header);
+
+		/* XDP sees the frame in place, before any skb exists */
+		if (esp_xdp_rx(adapter, skb->data + pos_in_aggr, _t0, &xdp_batch)) {
+			atomic_inc(&e2h_host_rx_frames);
+			pos_in_aggr += aligned_len;
+			continue;
+		}
+
 		frame_skb = adapter->if_ops->alloc_skb(frame_len);
 		if (!frame_skb) {
 			esp_err("SKB alloc failed for aggregate frame\n");
@@ -898,14 +1075,43 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 		}
 		skb_put(frame_skb, frame_len);
 		memcpy(frame_skb->data, skb->data + pos_in_aggr, frame_len);
+		((struct esp_skb_cb *)frame_skb->cb)->tstamp = _t0;
 		skb_queue_tail(&(context->rx_q), frame_skb);
+		atomic_inc(&e2h_host_rx_frames);
 		pos_in_aggr += aligned_len;
 	}
+	esp_xdp_batch_end(&xdp_batch);
 
-	dev_kfree_skb(skb);
+	esp_rx_pool_put(&context->rx_pool, skb);
 	return skb_dequeue(&(context->rx_q));
 }
 
+/* PRIO_Q_OTHERS is split per access category */
+static void sdio_tx_enqueue(struct esp_sdio_context *context, int prio,
+		struct sk_buff *skb)
+{
+	if (prio == PRIO_Q_OTHERS)
+		esp_ac_enqueue(&context->tx_data, skb);
+	else
+		skb_queue_tail(&context->tx_q[prio], skb);
+}
+
+static struct sk_buff *sdio_tx_peek(struct esp_sdio_context *context, int prio)
+{
+	if (prio == PRIO_Q_OTHERS)
+		return esp_ac_peek(&context->tx_data);
+
+	return skb_peek(&context->tx_q[prio]);
+}
+
+static struct sk_buff *sdio_tx_dequeue(struct esp_sdio_context *context, int prio)
+{
+	if (prio == PRIO_Q_OTHERS)
+		return esp_ac_dequeue(&context->tx_data);
+
+	return skb_dequeue(&context->tx_q[prio]);
+}
+
 static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 {
 	u32 max_pkt_size = ESP_RX_BUFFER_SIZE - sizeof(struct esp_payload_header);
@@ -938,7 +1144,8 @@ static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 	 * process_tx_packet's NETDEV_TX_BUSY gate. Byte cap counts the incoming skb. */
 	pending_bytes = atomic_read(&tx_pending_bytes);
 	if (atomic_read(&tx_pending) >= TX_HARD_PENDING_COUNT ||
-	    pending_bytes + skb->len > TX_MAX_PENDING_BYTES) {
+	    pending_bytes + skb->len > max_t(u32, READ_ONCE(tx_max_pending_bytes),
+					     TX_PENDING_BYTES_MIN)) {
 		esp_tx_pause();
 		H2E_HOST_STATS_INC(h2e_host_drop_queue_full);
 		dev_kfree_skb(skb);
@@ -964,12 +1171,14 @@ static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 	 * wake it. The consumer's wait condition reads queue_items, so the skb must
 	 * be visible in tx_q before queue_items goes positive (else a wakeup could
 	 * find the count set but the skb not yet queued). */
-	skb_queue_tail(&(sdio_context.tx_q[prio]), skb);
+	cb->tstamp = ktime_get_ns();
+	trace_esp_tx_enqueue(payload_header, prio, atomic_read(&tx_pending));
+	sdio_tx_enqueue(&sdio_context, prio, skb);
 	atomic_inc(&queue_items[prio]);
 
 	/* High-water: pause with headroom (skb kept), so further netdev skbs are
 	 * held in the qdisc - lossless. Resume in tx_process at TX_RESUME_THRESHOLD. */
-	if (atomic_read(&tx_pending) >= TX_MAX_PENDING_COUNT)
+	if (atomic_read(&tx_pending) >= READ_ONCE(tx_max_pending))
 		esp_tx_pause();
 
 	wake_up_interruptible(&sdio_context.tx_wq);
@@ -1036,14 +1245,17 @@ static int tx_process(void *data)
 	u32 consec_credit_timeouts = 0;	/* repeated no-credit drops => slave stall */
 	int prio = -1;
 	ktime_t aggr_start, credit_start, write_start;
+	u64 stage_ns;
 
 	context = adapter->if_context;
 	/* Bound the host TX aggregate by the slave's negotiated H2E recv-buffer size
 	 * (ESP_PRIV_RX_BUF_CONFIG). Falls back to the compile-time constant for an
-	 * old slave that omits the TLV (slave_rx_buf_size == 0). */
-	u32 tx_aggr_size = context->slave_rx_buf_size ?
-		context->slave_rx_buf_size : ESP_HOST_TX_AGGR_SIZE;
-	aggr_buf = kzalloc(tx_aggr_size, GFP_KERNEL);
+	 * old slave that omits the TLV (slave_rx_buf_size == 0). tx_aggr_limit can
+	 * shrink the aggregate at runtime; the buffer is sized for the maximum. */
+	u32 slave_buf_size = esp_sdio_slave_buf_size();
+	u32 tx_aggr_size;
+	u32 aggr_frames;
+	aggr_buf = kzalloc(slave_buf_size, GFP_KERNEL);
 	if (!aggr_buf)
 		return -ENOMEM;
 
@@ -1063,7 +1275,9 @@ static int tx_process(void *data)
 
 		aggr_start = ktime_get();
 		aggr_len = 0;
+		aggr_frames = 0;
 		aggr_has_ctrl = false;
+		tx_aggr_size = min(esp_sdio_tx_aggr_size(), slave_buf_size);
 		while (aggr_len < tx_aggr_size) {
 			prio = -1;
 			if (atomic_read(&queue_items[PRIO_Q_SERIAL]) > 0)
@@ -1076,7 +1290,7 @@ static int tx_process(void *data)
 			if (prio < 0)
 				break;
 
-			tx_skb = skb_peek(&(context->tx_q[prio]));
+			tx_skb = sdio_tx_peek(context, prio);
 			if (!tx_skb) {
 				atomic_dec(&queue_items[prio]);
 				continue;
@@ -1089,7 +1303,7 @@ static int tx_process(void *data)
 						le16_to_cpu(payload_header->len),
 						le16_to_cpu(payload_header->offset));
 					H2E_HOST_STATS_INC(h2e_host_drop_invalid);
-					tx_skb = skb_dequeue(&(context->tx_q[prio]));
+					tx_skb = sdio_tx_dequeue(context, prio);
 					if (tx_skb) {
 					atomic_dec(&queue_items[prio]);
 					if (atomic_read(&tx_pending))
@@ -1106,7 +1320,7 @@ static int tx_process(void *data)
 					esp_err("Drop truncated tx pkt: frame_len=%d skb_len=%d\n",
 						frame_len, tx_skb->len);
 					H2E_HOST_STATS_INC(h2e_host_drop_truncated);
-					tx_skb = skb_dequeue(&(context->tx_q[prio]));
+					tx_skb = sdio_tx_dequeue(context, prio);
 					if (tx_skb) {
 					atomic_dec(&queue_items[prio]);
 					if (atomic_read(&tx_pending))
@@ -1126,7 +1340,7 @@ static int tx_process(void *data)
 			if (aggr_len + len_to_send > tx_aggr_size)
 				break;
 
-			tx_skb = skb_dequeue(&(context->tx_q[prio]));
+			tx_skb = sdio_tx_dequeue(context, prio);
 			if (!tx_skb)
 				continue;
 
@@ -1134,6 +1348,8 @@ static int tx_process(void *data)
 			if (atomic_read(&tx_pending))
 				atomic_dec(&tx_pending);
 			atomic_sub(tx_skb->len, &tx_pending_bytes);
+			esp_hist_since(ESP_HIST_TX_QUEUE,
+				       ((struct esp_skb_cb *)tx_skb->cb)->tstamp);
 			if (prio == PRIO_Q_SERIAL || prio == PRIO_Q_BT)
 				aggr_has_ctrl = true;
 
@@ -1147,11 +1363,13 @@ static int tx_process(void *data)
 #endif
 			}
 
+			trace_esp_tx_aggr_add(payload_header);
 			memcpy(aggr_buf + aggr_len, tx_skb->data, frame_len);
 			if (len_to_send > frame_len)
 				memset(aggr_buf + aggr_len + frame_len, 0,
 				       len_to_send - frame_len);
 			aggr_len += len_to_send;
+			aggr_frames++;
 			dev_kfree_skb(tx_skb);
 			tx_skb = NULL;
 			if (flush_after_pkt)
@@ -1173,10 +1391,12 @@ static int tx_process(void *data)
 			continue;
 		}
 		H2E_HOST_STATS_TIME_ADD(h2e_host_time_aggr_us, aggr_start);
+		trace_esp_tx_aggr(aggr_frames, aggr_len,
+				  ktime_to_ns(ktime_sub(ktime_get(), aggr_start)));
 
-		/* Credit unit = slave's H2E recv-buffer size (same source as tx_aggr_size
-		 * above) so the credit math can't desync from the aggregate cap. */
-		buf_needed = (aggr_len + tx_aggr_size - 1) / tx_aggr_size;
+		/* Credit unit = slave's H2E recv-buffer size, not tx_aggr_size: a
+		 * runtime-shrunk aggregate still occupies whole slave buffers. */
+		buf_needed = (aggr_len + slave_buf_size - 1) / slave_buf_size;
 
 			/*If SDIO slave buffer is available to write then only write data
 			else wait till buffer is available*/
@@ -1194,6 +1414,9 @@ static int tx_process(void *data)
 			} while (!kthread_should_stop() &&
 				 ktime_to_ms(ktime_sub(ktime_get(), credit_start)) < credit_wait_ms);
 			H2E_HOST_STATS_TIME_ADD(h2e_host_time_credit_us, credit_start);
+			stage_ns = ktime_to_ns(ktime_sub(ktime_get(), credit_start));
+			esp_hist_add(ESP_HIST_TX_CREDIT, stage_ns);
+			trace_esp_tx_credit(buf_needed, stage_ns, ret);
 			if (kthread_should_stop())
 				break;
 			/* Out of credit past the bound: drop the built aggregate so the TX
@@ -1240,6 +1463,9 @@ static int tx_process(void *data)
 			pos += len_to_send;
 		} while (data_left);
 		H2E_HOST_STATS_TIME_ADD(h2e_host_time_write_us, write_start);
+		stage_ns = ktime_to_ns(ktime_sub(ktime_get(), write_start));
+		esp_hist_add(ESP_HIST_TX_WRITE, stage_ns);
+		trace_esp_tx_flush(aggr_len, stage_ns, ret);
 
 		if (ret) {
 			/* drop the packet */
@@ -1249,6 +1475,7 @@ static int tx_process(void *data)
 			context->tx_buffer_count += buf_needed;
 			context->tx_buffer_count = context->tx_buffer_count % ESP_TX_BUFFER_MAX;
 			H2E_HOST_STATS_INC(h2e_host_tx_sent);
+			H2E_HOST_STATS_ADD(h2e_host_tx_aggr_frames, aggr_frames);
 			print_h2e_host_stats();
 		}
 
@@ -1366,6 +1593,7 @@ static int esp_probe(struct sdio_func *func,
 		ret = PTR_ERR(tx_thread);
 		tx_thread = NULL;
 		esp_err("Failed to create esp_sdio TX thread (%d)\n", ret);
+		esp_rx_pool_deinit(&context->rx_pool);
 		deinit_sdio_func(func);
 		return ret;
 	}
@@ -6,6 +6,8 @@
 
 #include <linux/wait.h>
 #include "esp.h"
+#include "esp_rxpool.h"
+#include "esp_wmm.h"
 
 /* Interrupt Status */
 #define ESP_SLAVE_BIT0_INT             BIT(0)
@@ -98,8 +100,12 @@
 struct esp_sdio_context {
 	struct esp_adapter     *adapter;
 	struct sdio_func       *func;
+	/* tx_q[PRIO_Q_OTHERS] stays empty: Wi-Fi data goes to tx_data */
 	struct sk_buff_head    tx_q[MAX_PRIORITY_QUEUES];
+	struct esp_ac_queue    tx_data;
 	struct sk_buff_head    rx_q;
+	/* Recycled buffers for the CMD53 reads */
+	struct esp_rx_pool     rx_pool;
 	wait_queue_head_t      tx_wq;
 	u32                    rx_byte_count;
 	u32                    rx_init_len;    /* bytes pending at probe time (stale from prev session) */
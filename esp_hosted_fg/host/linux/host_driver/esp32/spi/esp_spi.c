@@ -15,11 +15,14 @@
 #include "esp_serial.h"
 #include "esp_kernel_port.h"
 #include "esp_stats.h"
+#include "esp_hist.h"
 #include "esp_fw_verify.h"
 
 #define SPI_INITIAL_CLK_MHZ     10
 #define NUMBER_1M               1000000
-#define TX_RESUME_THRESHOLD     (TX_MAX_PENDING_COUNT/5)
+#define TX_PENDING_COUNT_MIN    16     /* ethtool -G tx bounds */
+#define TX_PENDING_COUNT_MAX    8192
+#define TX_RESUME_THRESHOLD     (READ_ONCE(tx_max_pending)/5)
 
 /* ESP in sdkconfig has CONFIG_IDF_FIRMWARE_CHIP_ID entry.
  * supported values of CONFIG_IDF_FIRMWARE_CHIP_ID are - */
@@ -58,8 +61,17 @@ volatile u8 data_path = 0;
 static struct esp_spi_context spi_context;
 static char hardware_type = ESP_PRIV_FIRMWARE_CHIP_UNRECOGNIZED;
 static atomic_t tx_pending;
+/* Runtime TX high-water, set with ethtool -G tx */
+static u32 tx_max_pending = TX_MAX_PENDING_COUNT;
 u8 first_esp_bootup_over;
 
+/* ethtool -S counters */
+static atomic_t spi_tx_drop_oversize;
+static atomic_t spi_tx_drop_closed;
+static atomic_t spi_xfer_fail;
+static atomic_t spi_rx_drop_invalid;
+static atomic_t spi_rx_drop_closed;
+
 #ifndef CONFIG_ESP_HOSTED_USE_WORKQUEUE
 struct task_struct *spi_thread;
 #endif
@@ -88,10 +100,106 @@ static struct sk_buff * esp_spi_alloc_skb(u32 len)
 	return skb;
 }
 
+static u32 esp_spi_max_tx_len(struct esp_adapter *adapter)
+{
+	return SPI_BUF_SIZE;
+}
+
+struct esp_spi_ethtool_stat {
+	const char *name;
+	atomic_t *val;
+};
+
+static const struct esp_spi_ethtool_stat esp_spi_ethtool_stats[] = {
+	{ "tx_drop_oversize",		&spi_tx_drop_oversize },
+	{ "tx_drop_closed",		&spi_tx_drop_closed },
+	{ "xfer_fail",			&spi_xfer_fail },
+	{ "rx_drop_invalid",		&spi_rx_drop_invalid },
+	{ "rx_drop_closed",		&spi_rx_drop_closed },
+	/* gauges */
+	{ "tx_pending",			&tx_pending },
+};
+
+/* Queue depths, appended after the table */
+static const char * const esp_spi_ethtool_queues[] = {
+	"tx_q_serial",
+	"tx_q_bt",
+	"tx_q_others",
+};
+
+static int esp_spi_get_sset_count(struct esp_adapter *adapter)
+{
+	return ARRAY_SIZE(esp_spi_ethtool_stats) +
+		ARRAY_SIZE(esp_spi_ethtool_queues);
+}
+
+static void esp_spi_get_strings(struct esp_adapter *adapter, u8 *data)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(esp_spi_ethtool_stats); i++) {
+		strscpy(data, esp_spi_ethtool_stats[i].name, ETH_GSTRING_LEN);
+		data += ETH_GSTRING_LEN;
+	}
+	for (i = 0; i < ARRAY_SIZE(esp_spi_ethtool_queues); i++) {
+		strscpy(data, esp_spi_ethtool_queues[i], ETH_GSTRING_LEN);
+		data += ETH_GSTRING_LEN;
+	}
+}
+
+static void esp_spi_get_stats(struct esp_adapter *adapter, u64 *data)
+{
+	u32 others = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(esp_spi_ethtool_stats); i++)
+		*data++ = (u32)atomic_read(esp_spi_ethtool_stats[i].val);
+
+	for (i = 0; i < ESP_NUM_AC; i++)
+		others += skb_queue_len(&spi_context.tx_data.q[i]);
+	*data++ = skb_queue_len(&spi_context.tx_q[PRIO_Q_SERIAL]);
+	*data++ = skb_queue_len(&spi_context.tx_q[PRIO_Q_BT]);
+	*data++ = others;
+}
+
+/* Only the TX side is host-tunable: every SPI transfer is one SPI_BUF_SIZE
+ * buffer each way, there is no RX ring to size */
+static void esp_spi_get_ringparam(struct esp_adapter *adapter,
+				  struct ethtool_ringparam *ring)
+{
+	ring->tx_max_pending = TX_PENDING_COUNT_MAX;
+	ring->tx_pending = READ_ONCE(tx_max_pending);
+}
+
+static int esp_spi_set_ringparam(struct esp_adapter *adapter,
+				 const struct ethtool_ringparam *ring)
+{
+	if (ring->rx_pending || ring->rx_mini_pending || ring->rx_jumbo_pending)
+		return -EINVAL;
+	if (ring->tx_pending < TX_PENDING_COUNT_MIN ||
+	    ring->tx_pending > TX_PENDING_COUNT_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(tx_max_pending, ring->tx_pending);
+	esp_info("TX pending high-water set to %u\n", ring->tx_pending);
+
+	/* Raising the limit must release a queue paused at the old one */
+	if (atomic_read(&tx_pending) < TX_RESUME_THRESHOLD)
+		esp_tx_resume();
+
+	return 0;
+}
+
 static struct esp_if_ops if_ops = {
 	.read		= read_packet,
 	.write		= write_packet,
 	.alloc_skb	= esp_spi_alloc_skb,
+	.get_sset_count	= esp_spi_get_sset_count,
+	.get_strings	= esp_spi_get_strings,
+	.get_stats	= esp_spi_get_stats,
+	.get_ringparam	= esp_spi_get_ringparam,
+	.set_ringparam	= esp_spi_set_ringparam,
+	.max_tx_len	= esp_spi_max_tx_len,
 };
 
 static DEFINE_MUTEX(spi_lock);
@@ -199,12 +307,14 @@ static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 	if (skb->len > max_pkt_size) {
 		esp_err("Drop pkt of len[%u] > max spi transport len[%u]\n",
 				skb->len, max_pkt_size);
+		atomic_inc(&spi_tx_drop_oversize);
 		dev_kfree_skb(skb);
 		return -EPERM;
 	}
 
 	if (!data_path) {
 		esp_verbose("datapath not yet open\n");
+		atomic_inc(&spi_tx_drop_closed);
 		dev_kfree_skb(skb);
 		return -EPERM;
 	}
@@ -218,14 +328,15 @@ static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 	}
 #endif
 	atomic_inc(&tx_pending);
+	((struct esp_skb_cb *)skb->cb)->tstamp = ktime_get_ns();
 	/* Enqueue SKB in tx_q */
 	if (h->if_type == ESP_SERIAL_IF) {
 		skb_queue_tail(&spi_context.tx_q[PRIO_Q_SERIAL], skb);
 	} else if (h->if_type == ESP_HCI_IF) {
 		skb_queue_tail(&spi_context.tx_q[PRIO_Q_BT], skb);
 	} else {
-		skb_queue_tail(&spi_context.tx_q[PRIO_Q_OTHERS], skb);
-		if (atomic_read(&tx_pending) >= TX_MAX_PENDING_COUNT) {
+		esp_ac_enqueue(&spi_context.tx_data, skb);
+		if (atomic_read(&tx_pending) >= READ_ONCE(tx_max_pending)) {
 			esp_tx_pause();
 		}
 	}
@@ -255,6 +366,7 @@ static void esp_spi_reinit_work(struct work_struct *work)
 		skb_queue_purge(&context->tx_q[prio_q_idx]);
 		skb_queue_purge(&context->rx_q[prio_q_idx]);
 	}
+	esp_ac_queue_purge(&context->tx_data);
 	atomic_set(&tx_pending, 0);
 
 	/* Re-init queues */
@@ -262,6 +374,7 @@ static void esp_spi_reinit_work(struct work_struct *work)
 		skb_queue_head_init(&context->tx_q[prio_q_idx]);
 		skb_queue_head_init(&context->rx_q[prio_q_idx]);
 	}
+	esp_ac_queue_init(&context->tx_data);
 
 	/* Remove and re-add card */
 	esp_remove_card(context->adapter);
@@ -271,6 +384,10 @@ static void esp_spi_reinit_work(struct work_struct *work)
 	}
 
 	atomic_set(&context->device_state, SPI_DEVICE_RUNNING);
+
+	/* Rebooted slave starts from defaults: BT and private config again,
+	 * as on first boot-up */
+	process_capabilities(context->adapter->capabilities);
 }
 
 int process_init_event(u8 *evt_buf, u8 len)
@@ -286,6 +403,10 @@ int process_init_event(u8 *evt_buf, u8 len)
 		return -1;
 
 	pos = evt_buf;
+	adapter->serial_caps = 0;
+	adapter->telemetry_ver = 0;
+	adapter->csum_caps = 0;
+	adapter->hci_batch_caps = 0;
 
 	while (len_left) {
 		tag_len = *(pos + 1);
@@ -297,6 +418,14 @@ int process_init_event(u8 *evt_buf, u8 len)
 			hardware_type = *(pos+2);
 		} else if (*pos == ESP_PRIV_TEST_RAW_TP) {
 			process_test_capabilities(*(pos + 2));
+		} else if (*pos == ESP_PRIV_SERIAL_CAPS) {
+			adapter->serial_caps = *(pos + 2);
+		} else if (*pos == ESP_PRIV_TELEMETRY) {
+			adapter->telemetry_ver = *(pos + 2);
+		} else if (*pos == ESP_PRIV_CSUM_OFFLOAD) {
+			adapter->csum_caps = *(pos + 2);
+		} else if (*pos == ESP_PRIV_HCI_BATCH) {
+			adapter->hci_batch_caps = *(pos + 2);
 		} else if (*pos == ESP_PRIV_FW_DATA) {
 			fw_p = (struct fw_version *)(pos + 2);
 			ret = process_fw_data(fw_p, tag_len);
@@ -357,6 +486,7 @@ static int process_rx_buf(struct sk_buff *skb)
 	struct esp_payload_header *header;
 	u16 len = 0;
 	u16 offset = 0;
+	u8 if_type;
 
 	if (!skb)
 		return -EINVAL;
@@ -365,7 +495,11 @@ static int process_rx_buf(struct sk_buff *skb)
 
 	esp_hex_dump_dbg("spi_rx: ", skb->data , min(skb->len, 32));
 
-	if (header->if_type >= ESP_MAX_IF) {
+	/* Header fields are read up front: copybreak below may hand the
+	 * original buffer back to the RX pool, leaving header dangling. */
+	if_type = header->if_type;
+	if (if_type >= ESP_MAX_IF) {
+		atomic_inc(&spi_rx_drop_invalid);
 		return -EINVAL;
 	}
 
@@ -381,6 +515,7 @@ static int process_rx_buf(struct sk_buff *skb)
 		esp_err("offset_rcv[%d] != exp[%d], drop\n",
 				(int)offset, (int)sizeof(struct esp_payload_header));
 		esp_hex_dump_dbg("wrong offset: ", skb->data , min(skb->len, 32));
+		atomic_inc(&spi_rx_drop_invalid);
 		return -EINVAL;
 	}
 
@@ -389,6 +524,7 @@ static int process_rx_buf(struct sk_buff *skb)
 	if (len > SPI_BUF_SIZE) {
 		esp_info("len[%u] > max[%u], drop\n", len, SPI_BUF_SIZE);
 		esp_hex_dump_dbg("wrong len: ", skb->data , 8);
+		atomic_inc(&spi_rx_drop_invalid);
 		return -EINVAL;
 	}
 
@@ -398,13 +534,16 @@ static int process_rx_buf(struct sk_buff *skb)
 
 	if (!data_path) {
 		esp_verbose("datapath closed\n");
+		atomic_inc(&spi_rx_drop_closed);
 		return -EPERM;
 	}
 
+	skb = esp_rx_pool_copybreak(&spi_context.rx_pool, skb);
+
 	/* enqueue skb for read_packet to pick it */
-	if (header->if_type == ESP_SERIAL_IF)
+	if (if_type == ESP_SERIAL_IF)
 		skb_queue_tail(&spi_context.rx_q[PRIO_Q_SERIAL], skb);
-	else if (header->if_type == ESP_HCI_IF)
+	else if (if_type == ESP_HCI_IF)
 		skb_queue_tail(&spi_context.rx_q[PRIO_Q_BT], skb);
 	else
 		skb_queue_tail(&spi_context.rx_q[PRIO_Q_OTHERS], skb);
@@ -415,13 +554,26 @@ static int process_rx_buf(struct sk_buff *skb)
 	return 0;
 }
 
+static void esp_spi_tx_done(struct sk_buff *tx_skb, bool dummy)
+{
+	if (!tx_skb)
+		return;
+
+	if (dummy)
+		esp_rx_pool_put(&spi_context.rx_pool, tx_skb);
+	else
+		dev_kfree_skb(tx_skb);
+}
+
 static void esp_spi_transaction(void)
 {
 	struct spi_transfer trans;
 	struct sk_buff *tx_skb = NULL, *rx_skb = NULL;
 	u8 *rx_buf;
 	int ret = 0;
+	u64 xfer_start;
 	volatile int rx_pending = 0;
+	bool tx_dummy = false;
 
 #if defined(CONFIG_ESP_HOSTED_USE_WORKQUEUE)
 	if (!mutex_trylock(&spi_lock)) {
@@ -456,7 +608,11 @@ static void esp_spi_transaction(void)
 		if (!tx_skb)
 			tx_skb = skb_dequeue(&spi_context.tx_q[PRIO_Q_BT]);
 		if (!tx_skb)
-			tx_skb = skb_dequeue(&spi_context.tx_q[PRIO_Q_OTHERS]);
+			tx_skb = esp_ac_dequeue(&spi_context.tx_data);
+
+		if (tx_skb)
+			esp_hist_since(ESP_HIST_TX_QUEUE,
+				       ((struct esp_skb_cb *)tx_skb->cb)->tstamp);
 
 		if (tx_skb && atomic_read(&tx_pending)) {
 			atomic_dec(&tx_pending);
@@ -507,7 +663,11 @@ static void esp_spi_transaction(void)
 #if ESP_PKT_NUM_DEBUG
 		struct esp_payload_header *h;
 #endif
-		tx_skb = spi_context.adapter->if_ops->alloc_skb(SPI_BUF_SIZE);
+		/* Dummy TX: borrow a transfer buffer, it goes back afterwards */
+		tx_skb = esp_rx_pool_get(&spi_context.rx_pool, SPI_BUF_SIZE);
+		if (!tx_skb)
+			goto out;
+		tx_dummy = true;
 		trans.tx_buf = skb_put(tx_skb, SPI_BUF_SIZE);
 		memset((void*)trans.tx_buf, 0, SPI_BUF_SIZE);
 
@@ -518,7 +678,11 @@ static void esp_spi_transaction(void)
 #endif
 	}
 
-	rx_skb = spi_context.adapter->if_ops->alloc_skb(SPI_BUF_SIZE);
+	rx_skb = esp_rx_pool_get(&spi_context.rx_pool, SPI_BUF_SIZE);
+	if (!rx_skb) {
+		esp_spi_tx_done(tx_skb, tx_dummy);
+		goto out;
+	}
 	rx_buf = skb_put(rx_skb, SPI_BUF_SIZE);
 	memset(rx_buf, 0, SPI_BUF_SIZE);
 	trans.rx_buf = rx_buf;
@@ -530,21 +694,24 @@ static void esp_spi_transaction(void)
 	}
 #endif
 
+	xfer_start = ktime_get_ns();
+	((struct esp_skb_cb *)rx_skb->cb)->tstamp = xfer_start;
 	ret = spi_sync_transfer(spi_context.esp_spi_dev, &trans, 1);
+	/* Full-duplex: one transfer is both the TX write and the RX read */
+	esp_hist_since(ESP_HIST_TX_WRITE, xfer_start);
 	if (ret) {
-		dev_kfree_skb(rx_skb);
-		dev_kfree_skb(tx_skb);
+		atomic_inc(&spi_xfer_fail);
+		esp_rx_pool_put(&spi_context.rx_pool, rx_skb);
+		esp_spi_tx_done(tx_skb, tx_dummy);
 		mutex_unlock(&spi_lock);
 		return;
 	}
 
 	if (process_rx_buf(rx_skb)) {
-		dev_kfree_skb(rx_skb);
+		esp_rx_pool_put(&spi_context.rx_pool, rx_skb);
 	}
 
-	if (tx_skb) {
-		dev_kfree_skb(tx_skb);
-	}
+	esp_spi_tx_done(tx_skb, tx_dummy);
 
 out:
 	mutex_unlock(&spi_lock);
@@ -554,7 +721,7 @@ out:
 	if (gpio_get_value(spi_context.dataready_gpio) ||
 		!skb_queue_empty(&spi_context.tx_q[PRIO_Q_SERIAL]) ||
 		!skb_queue_empty(&spi_context.tx_q[PRIO_Q_BT]) ||
-		!skb_queue_empty(&spi_context.tx_q[PRIO_Q_OTHERS])) {
+		!esp_ac_queue_empty(&spi_context.tx_data)) {
 		if (spi_context.spi_workqueue)
 			queue_work(spi_context.spi_workqueue, &spi_context.spi_work);
 	}
@@ -733,7 +900,7 @@ static int esp_spi_thread(void *data)
 			(gpio_get_value(context->dataready_gpio) ||
 			!skb_queue_empty(&context->tx_q[PRIO_Q_SERIAL]) ||
 			!skb_queue_empty(&context->tx_q[PRIO_Q_BT]) ||
-			!skb_queue_empty(&context->tx_q[PRIO_Q_OTHERS])) ||
+			!esp_ac_queue_empty(&context->tx_data)) ||
 			kthread_should_stop());
 
 		if (kthread_should_stop()) {
@@ -798,7 +965,15 @@ static int spi_init(void)
 		skb_queue_head_init(&spi_context.tx_q[prio_q_idx]);
 		skb_queue_head_init(&spi_context.rx_q[prio_q_idx]);
 	}
+	esp_ac_queue_init(&spi_context.tx_data);
 
+	status = esp_rx_pool_init(&spi_context.rx_pool, esp_spi_alloc_skb,
+			SPI_BUF_SIZE);
+	if (status) {
+		spi_exit();
+		esp_err("Failed to allocate SPI transfer buffers\n");
+		return status;
+	}
 
 	status = spi_dev_init(&spi_context);
 	if (status) {
@@ -842,6 +1017,7 @@ static void spi_exit(void)
 		skb_queue_purge(&spi_context.tx_q[prio_q_idx]);
 		skb_queue_purge(&spi_context.rx_q[prio_q_idx]);
 	}
+	esp_ac_queue_purge(&spi_context.tx_data);
 	atomic_set(&tx_pending, 0);
 #ifdef CONFIG_ESP_HOSTED_USE_WORKQUEUE
 	if (spi_context.spi_workqueue) {
@@ -856,6 +1032,9 @@ static void spi_exit(void)
 	}
 #endif
 
+	/* No transaction left to borrow from it */
+	esp_rx_pool_deinit(&spi_context.rx_pool);
+
 	esp_remove_card(spi_context.adapter);
 
 	if (test_bit(ESP_SPI_GPIO_HS_IRQ_DONE, &spi_context.spi_flags)) {
@@ -20,6 +20,8 @@
 
 #include <linux/wait.h>
 #include "esp.h"
+#include "esp_rxpool.h"
+#include "esp_wmm.h"
 
 #define SPI_BUF_SIZE            1600
 
@@ -42,8 +44,12 @@ enum spi_flags_e {
 struct esp_spi_context {
 	struct esp_adapter          *adapter;
 	struct spi_device          *esp_spi_dev;
+	/* tx_q[PRIO_Q_OTHERS] stays empty: Wi-Fi data goes to tx_data */
 	struct sk_buff_head        tx_q[MAX_PRIORITY_QUEUES];
+	struct esp_ac_queue        tx_data;
 	struct sk_buff_head        rx_q[MAX_PRIORITY_QUEUES];
+	/* Recycled SPI_BUF_SIZE transfer buffers */
+	struct esp_rx_pool         rx_pool;
 	wait_queue_head_t          spi_wq;
 	struct workqueue_struct    *spi_workqueue;
 	struct work_struct         spi_work;
@@ -0,0 +1,882 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+/*
+ * Virtual transport
+ *
+ * Emulates an ESP slave and the bus to it entirely in-kernel, so that the
+ * host datapath (netdev, serial, raw throughput test) can be exercised and
+ * benchmarked without hardware.
+ *
+ * The emulated slave:
+ *  - sends the boot-up ESP_PRIV_EVENT_INIT event with capabilities
+ *  - owns 'virt_credits' RX buffers. A host frame occupies one until the
+ *    slave has consumed it (sink) or sent it back (reflect)
+ *  - moves up to 'virt_aggr' frames per bus transaction
+ *  - charges every transaction 'virt_latency_us' plus its size at
+ *    'virt_bw_mbps' on a virtual bus clock
+ *
+ * With virt_mode=2 the slave side is not emulated here but left to a user
+ * space process, typically the network_adapter_sim build of the slave
+ * firmware, which talks to /dev/esp_virt with SDIO block semantics:
+ *  - read() returns the host frames of one host->slave transaction, each
+ *    starting with esp_payload_header and padded to 4 bytes
+ *  - write() takes one slave->host transaction in the same format
+ * The slave also sends the boot-up event itself in this mode.
+ */
+#include "esp_utils.h"
+
+#include <linux/module.h>
+#include <linux/kthread.h>
+#include <linux/delay.h>
+#include <linux/etherdevice.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/miscdevice.h>
+#include <linux/fs.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
+#include <linux/mm.h>
+#include "esp_virt.h"
+#include "esp_if.h"
+#include "esp_api.h"
+#include "esp_bt_api.h"
+#include "esp_serial.h"
+#include "esp_kernel_port.h"
+#include "esp_stats.h"
+#include "esp_hist.h"
+#include "esp_fw_verify.h"
+
+#define TX_RESUME_THRESHOLD     (TX_MAX_PENDING_COUNT/5)
+#define VIRT_MAX_AGGR           64
+/* Shorter bus delays are accumulated and slept in one go */
+#define VIRT_MIN_SLEEP_NS       (20 * NSEC_PER_USEC)
+#define VIRT_DEV_NAME           "esp_virt"
+/* Largest block the remote slave may write in one go */
+#define VIRT_MAX_BLOCK_SIZE     (32 * 1024)
+
+static uint virt_mode = VIRT_MODE_REFLECT;
+module_param(virt_mode, uint, S_IRUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(virt_mode, "Virtual: 0 = sink host frames, 1 = reflect them back, 2 = user space slave on /dev/esp_virt");
+
+static uint virt_bw_mbps;
+module_param(virt_bw_mbps, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(virt_bw_mbps, "Virtual: bus bandwidth in Mbit/s, 0 = unlimited");
+
+static uint virt_latency_us;
+module_param(virt_latency_us, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(virt_latency_us, "Virtual: fixed cost of one bus transaction in us");
+
+static uint virt_aggr = 8;
+module_param(virt_aggr, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(virt_aggr, "Virtual: max frames per bus transaction (1-64)");
+
+static uint virt_credits = 20;
+module_param(virt_credits, uint, S_IRUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(virt_credits, "Virtual: number of slave RX buffers");
+
+extern u32 raw_tp_mode;
+
+static struct esp_virt_context virt_context;
+static atomic_t tx_pending;
+static u8 first_esp_bootup_over;
+static bool virt_dev_registered;
+
+static struct sk_buff * esp_virt_alloc_skb(u32 len)
+{
+	struct sk_buff *skb = NULL;
+	u32 alloc_len;
+	u8 offset;
+
+	alloc_len = len + INTERFACE_HEADER_PADDING;
+
+	if (alloc_len < VIRT_BUF_SIZE)
+		alloc_len = VIRT_BUF_SIZE;
+
+	skb = netdev_alloc_skb(NULL, alloc_len);
+
+	if (skb) {
+		/* Align SKB data pointer */
+		offset = ((unsigned long)skb->data) & (SKB_DATA_ADDR_ALIGNMENT - 1);
+
+		if (offset)
+			skb_reserve(skb, INTERFACE_HEADER_PADDING - offset);
+	}
+
+	return skb;
+}
+
+static struct sk_buff * read_packet(struct esp_adapter *adapter)
+{
+	struct esp_virt_context *context;
+	struct sk_buff *skb = NULL;
+
+	if (!adapter || !adapter->if_context) {
+		esp_err("Invalid args\n");
+		return NULL;
+	}
+
+	context = adapter->if_context;
+
+	skb = skb_dequeue(&(context->rx_q[PRIO_Q_SERIAL]));
+	if (!skb)
+		skb = skb_dequeue(&(context->rx_q[PRIO_Q_BT]));
+	if (!skb)
+		skb = skb_dequeue(&(context->rx_q[PRIO_Q_OTHERS]));
+
+	return skb;
+}
+
+static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
+{
+	struct esp_payload_header *h;
+
+	if (!adapter || !adapter->if_context || !skb || !skb->data || !skb->len) {
+		esp_err("Invalid args\n");
+		dev_kfree_skb(skb);
+		return -EINVAL;
+	}
+
+	if (skb->len > VIRT_BUF_SIZE) {
+		esp_err("Drop pkt of len[%u] > max virt transport len[%u]\n",
+				skb->len, VIRT_BUF_SIZE);
+		dev_kfree_skb(skb);
+		return -EPERM;
+	}
+
+	if (atomic_read(&adapter->state) != ESP_CONTEXT_READY) {
+		esp_verbose("datapath not yet open\n");
+		dev_kfree_skb(skb);
+		return -EPERM;
+	}
+
+	h = (struct esp_payload_header *) skb->data;
+
+	atomic_inc(&tx_pending);
+	((struct esp_skb_cb *)skb->cb)->tstamp = ktime_get_ns();
+	if (h->if_type == ESP_SERIAL_IF) {
+		skb_queue_tail(&virt_context.tx_q[PRIO_Q_SERIAL], skb);
+	} else if (h->if_type == ESP_HCI_IF) {
+		skb_queue_tail(&virt_context.tx_q[PRIO_Q_BT], skb);
+	} else {
+		esp_ac_enqueue(&virt_context.tx_data, skb);
+		if (atomic_read(&tx_pending) >= TX_MAX_PENDING_COUNT)
+			esp_tx_pause();
+	}
+
+	wake_up_interruptible(&virt_context.virt_wq);
+
+	return 0;
+}
+
+#define VIRT_STAT(_name)	{ #_name, offsetof(struct esp_virt_stats, _name) }
+
+static const struct {
+	const char *name;
+	size_t offset;
+} virt_ethtool_stats[] = {
+	VIRT_STAT(tx_frames),
+	VIRT_STAT(tx_bytes),
+	VIRT_STAT(rx_frames),
+	VIRT_STAT(rx_bytes),
+	VIRT_STAT(transactions),
+	VIRT_STAT(sunk),
+	VIRT_STAT(dropped),
+	VIRT_STAT(no_credit),
+};
+
+static u32 esp_virt_max_tx_len(struct esp_adapter *adapter)
+{
+	return VIRT_BUF_SIZE;
+}
+
+static int esp_virt_get_sset_count(struct esp_adapter *adapter)
+{
+	/* plus the tx_pending and credits gauges */
+	return ARRAY_SIZE(virt_ethtool_stats) + 2;
+}
+
+static void esp_virt_get_strings(struct esp_adapter *adapter, u8 *data)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(virt_ethtool_stats); i++) {
+		strscpy(data, virt_ethtool_stats[i].name, ETH_GSTRING_LEN);
+		data += ETH_GSTRING_LEN;
+	}
+	strscpy(data, "tx_pending", ETH_GSTRING_LEN);
+	data += ETH_GSTRING_LEN;
+	strscpy(data, "credits", ETH_GSTRING_LEN);
+}
+
+static void esp_virt_get_stats(struct esp_adapter *adapter, u64 *data)
+{
+	struct esp_virt_stats stats;
+	int i;
+
+	spin_lock(&virt_context.lock);
+	stats = virt_context.stats;
+	spin_unlock(&virt_context.lock);
+
+	for (i = 0; i < ARRAY_SIZE(virt_ethtool_stats); i++)
+		*data++ = *(u64 *)((u8 *)&stats + virt_ethtool_stats[i].offset);
+	*data++ = atomic_read(&tx_pending);
+	*data++ = atomic_read(&virt_context.credits);
+}
+
+static struct esp_if_ops if_ops = {
+	.read		= read_packet,
+	.write		= write_packet,
+	.alloc_skb	= esp_virt_alloc_skb,
+	.get_sset_count	= esp_virt_get_sset_count,
+	.get_strings	= esp_virt_get_strings,
+	.get_stats	= esp_virt_get_stats,
+	.max_tx_len	= esp_virt_max_tx_len,
+};
+
+/* Account one transaction of @count frames, @bytes long, on the virtual bus
+ * clock and sleep once the caller is far enough ahead of it */
+static void virt_bus_xfer(struct esp_virt_context *context, bool to_slave,
+		u32 count, u32 bytes)
+{
+	u64 now = ktime_get_ns();
+	u64 cost = (u64)READ_ONCE(virt_latency_us) * NSEC_PER_USEC;
+	uint bw = READ_ONCE(virt_bw_mbps);
+	u64 ahead = 0;
+
+	if (bw)
+		cost += div_u64((u64)bytes * 8 * NSEC_PER_USEC, bw);
+
+	spin_lock(&context->lock);
+	if (context->bus_busy_until < now)
+		context->bus_busy_until = now;
+	context->bus_busy_until += cost;
+	if (context->bus_busy_until > now + VIRT_MIN_SLEEP_NS)
+		ahead = context->bus_busy_until - now;
+
+	context->stats.transactions++;
+	if (to_slave) {
+		context->stats.tx_frames += count;
+		context->stats.tx_bytes += bytes;
+	} else {
+		context->stats.rx_frames += count;
+		context->stats.rx_bytes += bytes;
+	}
+	spin_unlock(&context->lock);
+
+	if (ahead) {
+		u64 us = div_u64(ahead, NSEC_PER_USEC);
+
+		usleep_range(us, us + 10);
+	}
+}
+
+/* Stats are read as a whole by ethtool, bump them under the same lock */
+static void virt_stat_inc(struct esp_virt_context *context, u64 *stat)
+{
+	spin_lock(&context->lock);
+	(*stat)++;
+	spin_unlock(&context->lock);
+}
+
+static void virt_return_credit(struct esp_virt_context *context)
+{
+	atomic_inc(&context->credits);
+}
+
+/* Emulated slave: handle one frame received from host */
+static void virt_slave_rx(struct esp_virt_context *context, struct sk_buff *skb)
+{
+	struct esp_payload_header *h = (struct esp_payload_header *) skb->data;
+	u16 len = le16_to_cpu(h->len);
+	u16 offset = le16_to_cpu(h->offset);
+	struct ethhdr *eth;
+	u8 mac[ETH_ALEN];
+
+	if (offset != sizeof(struct esp_payload_header) || !len ||
+	    (offset + len) > skb->len) {
+		esp_hex_dump_dbg("virt bad frame: ", skb->data, min(skb->len, 32u));
+		virt_stat_inc(context, &context->stats.dropped);
+		goto consumed;
+	}
+
+	if (virt_mode == VIRT_MODE_REMOTE) {
+		if (!test_bit(0, &context->remote_open))
+			goto sink;
+		/* Buffer stays in use until the remote slave read() it */
+		skb_trim(skb, offset + len);
+		skb_queue_tail(&context->remote_q, skb);
+		return;
+	}
+
+	if (virt_mode != VIRT_MODE_REFLECT)
+		goto sink;
+
+	switch (h->if_type) {
+	case ESP_STA_IF:
+	case ESP_AP_IF:
+		if (len < ETH_HLEN)
+			goto sink;
+		eth = (struct ethhdr *)(skb->data + offset);
+		ether_addr_copy(mac, eth->h_dest);
+		ether_addr_copy(eth->h_dest, eth->h_source);
+		ether_addr_copy(eth->h_source, mac);
+		/* fall through */
+	case ESP_TEST_IF:
+		h->flags = 0;
+		h->checksum = 0;
+		skb_trim(skb, offset + len);
+		/* Buffer stays in use until sent back */
+		skb_queue_tail(&context->reflect_q, skb);
+		return;
+	default:
+		break;
+	}
+
+sink:
+	if (h->if_type == ESP_PRIV_IF && h->priv_pkt_type == ESP_PACKET_TYPE_COMMAND)
+		esp_verbose("virt: priv command %u\n", skb->data[offset]);
+	virt_stat_inc(context, &context->stats.sunk);
+consumed:
+	dev_kfree_skb_any(skb);
+	virt_return_credit(context);
+}
+
+static struct sk_buff * virt_dequeue_tx(struct esp_virt_context *context)
+{
+	struct sk_buff *skb;
+
+	skb = skb_dequeue(&context->tx_q[PRIO_Q_SERIAL]);
+	if (!skb)
+		skb = skb_dequeue(&context->tx_q[PRIO_Q_BT]);
+	if (!skb)
+		skb = esp_ac_dequeue(&context->tx_data);
+	if (skb)
+		esp_hist_since(ESP_HIST_TX_QUEUE,
+			       ((struct esp_skb_cb *)skb->cb)->tstamp);
+
+	return skb;
+}
+
+/* One host->slave and one slave->host transaction */
+static void virt_transaction(struct esp_virt_context *context)
+{
+	struct sk_buff_head batch;
+	struct sk_buff *skb;
+	u32 aggr = clamp_t(u32, READ_ONCE(virt_aggr), 1, VIRT_MAX_AGGR);
+	u32 count = 0, bytes = 0;
+
+	__skb_queue_head_init(&batch);
+
+	/* Host -> slave, limited by free slave buffers */
+	while (count < aggr) {
+		if (!atomic_read(&context->credits)) {
+			virt_stat_inc(context, &context->stats.no_credit);
+			break;
+		}
+
+		skb = virt_dequeue_tx(context);
+		if (!skb)
+			break;
+
+		atomic_dec(&context->credits);
+		count++;
+		bytes += skb->len;
+		__skb_queue_tail(&batch, skb);
+
+		if (atomic_dec_if_positive(&tx_pending) < TX_RESUME_THRESHOLD)
+			esp_tx_resume();
+		#if TEST_RAW_TP
+			esp_raw_tp_queue_resume();
+		#endif
+	}
+
+	if (count) {
+		virt_bus_xfer(context, true, count, bytes);
+
+		while ((skb = __skb_dequeue(&batch)))
+			virt_slave_rx(context, skb);
+
+		if (virt_mode == VIRT_MODE_REMOTE)
+			wake_up_interruptible(&context->remote_wq);
+	}
+
+	/* Slave -> host, aggregated into one rx indication */
+	count = 0;
+	bytes = 0;
+	while (count < aggr) {
+		skb = skb_dequeue(&context->reflect_q);
+		if (!skb)
+			break;
+
+		count++;
+		bytes += skb->len;
+		__skb_queue_tail(&batch, skb);
+	}
+
+	if (!count)
+		return;
+
+	virt_bus_xfer(context, false, count, bytes);
+
+	while ((skb = __skb_dequeue(&batch))) {
+		skb_queue_tail(&context->rx_q[PRIO_Q_OTHERS], skb);
+		virt_return_credit(context);
+	}
+
+	esp_process_new_packet_intr(context->adapter);
+}
+
+static bool virt_has_work(struct esp_virt_context *context)
+{
+	if (!skb_queue_empty(&context->reflect_q))
+		return true;
+
+	if (!atomic_read(&context->credits))
+		return false;
+
+	return !skb_queue_empty(&context->tx_q[PRIO_Q_SERIAL]) ||
+	       !skb_queue_empty(&context->tx_q[PRIO_Q_BT]) ||
+	       !esp_ac_queue_empty(&context->tx_data);
+}
+
+static int esp_virt_thread(void *data)
+{
+	struct esp_virt_context *context = &virt_context;
+
+	esp_info("esp virt thread created\n");
+
+	while (!kthread_should_stop()) {
+
+		wait_event_interruptible(context->virt_wq,
+			virt_has_work(context) || kthread_should_stop());
+
+		if (kthread_should_stop())
+			break;
+
+		if (atomic_read(&context->adapter->state) != ESP_CONTEXT_READY) {
+			msleep(100);
+			continue;
+		}
+
+		virt_transaction(context);
+		cond_resched();
+	}
+	esp_info("esp virt thread cleared\n");
+	return 0;
+}
+
+static u8 *virt_add_tag(u8 *pos, u8 tag, u8 val)
+{
+	*pos++ = tag;
+	*pos++ = 1;
+	*pos++ = val;
+	return pos;
+}
+
+/* Emulated slave boot-up: same event a real slave sends on reset */
+static int virt_send_boot_event(struct esp_virt_context *context)
+{
+	struct esp_payload_header *header;
+	struct esp_priv_event *event;
+	struct sk_buff *skb;
+	u8 *pos;
+	u16 len;
+
+	skb = esp_virt_alloc_skb(VIRT_BUF_SIZE);
+	if (!skb)
+		return -ENOMEM;
+
+	header = skb_put_zero(skb, sizeof(struct esp_payload_header));
+	event = skb_put_zero(skb, VIRT_BUF_SIZE - sizeof(struct esp_payload_header));
+
+	event->event_type = ESP_PRIV_EVENT_INIT;
+	pos = event->event_data;
+	pos = virt_add_tag(pos, ESP_PRIV_CAPABILITY, ESP_WLAN_SPI_SUPPORT);
+	pos = virt_add_tag(pos, ESP_PRIV_FIRMWARE_CHIP_ID, ESP_FIRMWARE_CHIP_ESP32C6);
+	pos = virt_add_tag(pos, ESP_PRIV_TEST_RAW_TP, 0);
+	pos = virt_add_tag(pos, ESP_PRIV_SERIAL_CAPS, ESP_SERIAL_CAP_TOTAL_LEN);
+	event->event_len = pos - event->event_data;
+
+	len = sizeof(struct esp_priv_event) + event->event_len;
+	header->if_type = ESP_PRIV_IF;
+	header->len = cpu_to_le16(len);
+	header->offset = cpu_to_le16(sizeof(struct esp_payload_header));
+	header->priv_pkt_type = ESP_PACKET_TYPE_EVENT;
+	skb_trim(skb, sizeof(struct esp_payload_header) + len);
+
+	skb_queue_tail(&context->rx_q[PRIO_Q_OTHERS], skb);
+	esp_process_new_packet_intr(context->adapter);
+
+	return 0;
+}
+
+static int virt_dev_open(struct inode *inode, struct file *file)
+{
+	struct esp_virt_context *context = &virt_context;
+
+	if (test_and_set_bit(0, &context->remote_open))
+		return -EBUSY;
+
+	file->private_data = context;
+	esp_info("virt: remote slave attached\n");
+
+	return nonseekable_open(inode, file);
+}
+
+static int virt_dev_release(struct inode *inode, struct file *file)
+{
+	struct esp_virt_context *context = file->private_data;
+
+	clear_bit(0, &context->remote_open);
+
+	/* Frames the slave did not fetch free their buffers */
+	mutex_lock(&context->remote_lock);
+	while (!skb_queue_empty(&context->remote_q)) {
+		dev_kfree_skb(skb_dequeue(&context->remote_q));
+		virt_return_credit(context);
+	}
+	mutex_unlock(&context->remote_lock);
+	wake_up_interruptible(&context->virt_wq);
+
+	esp_info("virt: remote slave detached\n");
+
+	return 0;
+}
+
+/* Host -> slave: one transaction worth of frames, 4 byte aligned */
+static ssize_t virt_dev_read(struct file *file, char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct esp_virt_context *context = file->private_data;
+	struct sk_buff *skb;
+	size_t done = 0, aligned;
+	int ret = 0;
+
+	while (skb_queue_empty(&context->remote_q)) {
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(context->remote_wq,
+				!skb_queue_empty(&context->remote_q));
+		if (ret)
+			return ret;
+	}
+
+	mutex_lock(&context->remote_lock);
+	while ((skb = skb_peek(&context->remote_q))) {
+		aligned = ALIGN(skb->len, 4);
+		if (done + aligned > count)
+			break;
+
+		if (copy_to_user(buf + done, skb->data, skb->len) ||
+		    clear_user(buf + done + skb->len, aligned - skb->len)) {
+			ret = -EFAULT;
+			break;
+		}
+		done += aligned;
+
+		dev_kfree_skb(skb_dequeue(&context->remote_q));
+		virt_return_credit(context);
+	}
+	mutex_unlock(&context->remote_lock);
+
+	if (done)
+		wake_up_interruptible(&context->virt_wq);
+	else if (!ret)
+		ret = -EMSGSIZE;
+
+	return done ? done : ret;
+}
+
+/* Slave -> host: split one block into frames */
+static ssize_t virt_dev_write(struct file *file, const char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct esp_virt_context *context = file->private_data;
+	struct esp_payload_header *h;
+	struct sk_buff *skb;
+	u32 frames = 0, bytes = 0;
+	size_t pos = 0;
+	u16 len, offset;
+	u8 *block;
+
+	if (!count || count > VIRT_MAX_BLOCK_SIZE)
+		return -EMSGSIZE;
+
+	block = kvmalloc(count, GFP_KERNEL);
+	if (!block)
+		return -ENOMEM;
+
+	if (copy_from_user(block, buf, count)) {
+		kvfree(block);
+		return -EFAULT;
+	}
+
+	while (pos + sizeof(struct esp_payload_header) <= count) {
+		h = (struct esp_payload_header *)(block + pos);
+		len = le16_to_cpu(h->len);
+		offset = le16_to_cpu(h->offset);
+
+		/* Zero length header terminates the block */
+		if (!len)
+			break;
+
+		if (offset != sizeof(struct esp_payload_header) ||
+		    pos + offset + len > count) {
+			esp_hex_dump_dbg("virt bad block: ", block + pos, 32);
+			virt_stat_inc(context, &context->stats.dropped);
+			break;
+		}
+
+		skb = esp_virt_alloc_skb(offset + len);
+		if (!skb)
+			break;
+		skb_put_data(skb, block + pos, offset + len);
+
+		if (h->if_type == ESP_SERIAL_IF)
+			skb_queue_tail(&context->rx_q[PRIO_Q_SERIAL], skb);
+		else if (h->if_type == ESP_HCI_IF)
+			skb_queue_tail(&context->rx_q[PRIO_Q_BT], skb);
+		else
+			skb_queue_tail(&context->rx_q[PRIO_Q_OTHERS], skb);
+
+		frames++;
+		bytes += offset + len;
+		pos += ALIGN(offset + len, 4);
+	}
+	kvfree(block);
+
+	if (frames) {
+		virt_bus_xfer(context, false, frames, bytes);
+		esp_process_new_packet_intr(context->adapter);
+	}
+
+	return count;
+}
+
+static unsigned int virt_dev_poll(struct file *file, poll_table *wait)
+{
+	struct esp_virt_context *context = file->private_data;
+	unsigned int mask = POLLOUT | POLLWRNORM;
+
+	poll_wait(file, &context->remote_wq, wait);
+
+	if (!skb_queue_empty(&context->remote_q))
+		mask |= POLLIN | POLLRDNORM;
+
+	return mask;
+}
+
+static const struct file_operations virt_dev_fops = {
+	.owner          = THIS_MODULE,
+	.open           = virt_dev_open,
+	.release        = virt_dev_release,
+	.read           = virt_dev_read,
+	.write          = virt_dev_write,
+	.poll           = virt_dev_poll,
+};
+
+static struct miscdevice virt_miscdev = {
+	.minor          = MISC_DYNAMIC_MINOR,
+	.name           = VIRT_DEV_NAME,
+	.fops           = &virt_dev_fops,
+};
+
+int process_init_event(u8 *evt_buf, u8 len)
+{
+	u8 len_left = len, tag_len;
+	u8 *pos;
+	struct esp_adapter *adapter = esp_get_adapter();
+	struct fw_version *fw_p;
+	int ret = 0;
+
+	if (!evt_buf)
+		return -1;
+
+	pos = evt_buf;
+	adapter->serial_caps = 0;
+	adapter->telemetry_ver = 0;
+	adapter->csum_caps = 0;
+	adapter->hci_batch_caps = 0;
+
+	while (len_left) {
+		tag_len = *(pos + 1);
+		esp_info("EVENT: %d\n", *pos);
+		if (*pos == ESP_PRIV_CAPABILITY) {
+			adapter->capabilities = *(pos + 2);
+		} else if (*pos == ESP_PRIV_FIRMWARE_CHIP_ID) {
+			esp_info("Virtual slave, emulated chip id %u\n", *(pos + 2));
+		} else if (*pos == ESP_PRIV_TEST_RAW_TP) {
+			process_test_capabilities(*(pos + 2));
+		} else if (*pos == ESP_PRIV_SERIAL_CAPS) {
+			adapter->serial_caps = *(pos + 2);
+		} else if (*pos == ESP_PRIV_TELEMETRY) {
+			adapter->telemetry_ver = *(pos + 2);
+		} else if (*pos == ESP_PRIV_CSUM_OFFLOAD) {
+			adapter->csum_caps = *(pos + 2);
+		} else if (*pos == ESP_PRIV_HCI_BATCH) {
+			adapter->hci_batch_caps = *(pos + 2);
+		} else if (*pos == ESP_PRIV_FW_DATA) {
+			fw_p = (struct fw_version *)(pos + 2);
+			process_fw_data(fw_p, tag_len);
+		} else if (*pos == ESP_PRIV_RX_BUF_CONFIG ||
+			   *pos == ESP_PRIV_CUSTOM_STR) {
+			/* Informational only, frames always fit VIRT_BUF_SIZE */
+		} else {
+			esp_warn("Unsupported tag in event\n");
+		}
+		pos += (tag_len+2);
+		len_left -= (tag_len+2);
+	}
+
+	if (first_esp_bootup_over)
+		esp_remove_card(adapter);
+
+	ret = esp_add_card(adapter);
+	if (ret) {
+		esp_err("Failed to add card\n");
+		return ret;
+	}
+	first_esp_bootup_over = 1;
+
+	process_capabilities(adapter->capabilities);
+#if TEST_RAW_TP
+	esp_raw_tp_start(adapter, raw_tp_mode);
+#endif
+	esp_info("Slave up event processed\n");
+
+	return 0;
+}
+
+static void virt_exit(void)
+{
+	struct esp_virt_stats *s = &virt_context.stats;
+	uint8_t prio_q_idx = 0;
+
+	if (!virt_context.adapter)
+		return;
+
+	atomic_set(&virt_context.adapter->state, ESP_CONTEXT_DISABLED);
+
+	if (virt_context.virt_thread) {
+		kthread_stop(virt_context.virt_thread);
+		virt_context.virt_thread = NULL;
+	}
+
+	for (prio_q_idx=0; prio_q_idx<MAX_PRIORITY_QUEUES; prio_q_idx++) {
+		skb_queue_purge(&virt_context.tx_q[prio_q_idx]);
+		skb_queue_purge(&virt_context.rx_q[prio_q_idx]);
+	}
+	esp_ac_queue_purge(&virt_context.tx_data);
+	skb_queue_purge(&virt_context.reflect_q);
+	atomic_set(&tx_pending, 0);
+
+	if (virt_dev_registered) {
+		misc_deregister(&virt_miscdev);
+		virt_dev_registered = false;
+	}
+	skb_queue_purge(&virt_context.remote_q);
+
+	esp_remove_card(virt_context.adapter);
+
+	if (virt_context.adapter->hcidev)
+		esp_deinit_bt(virt_context.adapter);
+
+	esp_info("virt: trans=%llu tx=%llu/%lluB rx=%llu/%lluB sunk=%llu drop=%llu no_credit=%llu\n",
+			s->transactions, s->tx_frames, s->tx_bytes, s->rx_frames,
+			s->rx_bytes, s->sunk, s->dropped, s->no_credit);
+
+	memset(&virt_context, 0, sizeof(virt_context));
+}
+
+static int virt_init(void)
+{
+	int status = 0;
+	uint8_t prio_q_idx = 0;
+
+	for (prio_q_idx=0; prio_q_idx<MAX_PRIORITY_QUEUES; prio_q_idx++) {
+		skb_queue_head_init(&virt_context.tx_q[prio_q_idx]);
+		skb_queue_head_init(&virt_context.rx_q[prio_q_idx]);
+	}
+	esp_ac_queue_init(&virt_context.tx_data);
+	skb_queue_head_init(&virt_context.reflect_q);
+	skb_queue_head_init(&virt_context.remote_q);
+	init_waitqueue_head(&virt_context.virt_wq);
+	init_waitqueue_head(&virt_context.remote_wq);
+	mutex_init(&virt_context.remote_lock);
+	spin_lock_init(&virt_context.lock);
+
+	atomic_set(&virt_context.credits, virt_credits ? virt_credits : 1);
+	atomic_set(&tx_pending, 0);
+	first_esp_bootup_over = 0;
+
+	esp_info("ESP: Virtual transport: mode[%s] bw[%u Mbps] latency[%u us] aggr[%u] credits[%u]\n",
+			virt_mode == VIRT_MODE_REMOTE ? "remote" :
+			virt_mode == VIRT_MODE_REFLECT ? "reflect" : "sink",
+			virt_bw_mbps, virt_latency_us, virt_aggr,
+			atomic_read(&virt_context.credits));
+
+	virt_context.virt_thread = kthread_run(esp_virt_thread, virt_context.adapter, "esp32_virt");
+	if (IS_ERR(virt_context.virt_thread)) {
+		esp_err("Failed to create esp32_virt thread\n");
+		virt_context.virt_thread = NULL;
+		virt_exit();
+		return -EFAULT;
+	}
+
+	status = esp_serial_init((void *) virt_context.adapter);
+	if (status != 0) {
+		virt_exit();
+		esp_err("Error initialising serial interface\n");
+		return status;
+	}
+
+	atomic_set(&virt_context.adapter->state, ESP_CONTEXT_READY);
+
+	if (virt_mode == VIRT_MODE_REMOTE) {
+		status = misc_register(&virt_miscdev);
+		if (status) {
+			esp_err("Failed to register /dev/%s\n", VIRT_DEV_NAME);
+			virt_exit();
+			return status;
+		}
+		virt_dev_registered = true;
+		esp_info("Waiting for slave on /dev/%s\n", VIRT_DEV_NAME);
+		return 0;
+	}
+
+	status = virt_send_boot_event(&virt_context);
+	if (status) {
+		virt_exit();
+		esp_err("Failed to send boot-up event\n");
+	}
+
+	return status;
+}
+
+int esp_init_interface_layer(struct esp_adapter *adapter)
+{
+	if (!adapter) {
+		esp_err("null adapter\n");
+		return -EINVAL;
+	}
+
+	memset(&virt_context, 0, sizeof(virt_context));
+
+	adapter->if_context = &virt_context;
+	adapter->if_ops = &if_ops;
+	adapter->if_type = ESP_IF_TYPE_VIRT;
+	virt_context.adapter = adapter;
+
+	return virt_init();
+}
+
+void esp_deinit_interface_layer(void)
+{
+	virt_exit();
+}
+
+int is_host_sleeping(void)
+{
+	return 0;
+}
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+#ifndef _ESP_VIRT_H_
+#define _ESP_VIRT_H_
+
+#include <linux/wait.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include "esp.h"
+#include "esp_wmm.h"
+
+#define VIRT_BUF_SIZE           1600
+
+/* What the emulated slave does with frames written by the host */
+enum virt_mode {
+	VIRT_MODE_SINK = 0,     /* consume and count */
+	VIRT_MODE_REFLECT,      /* send STA/AP/test frames back to host */
+	VIRT_MODE_REMOTE,       /* hand them to a slave process on /dev/esp_virt */
+};
+
+struct esp_virt_stats {
+	u64 tx_frames;
+	u64 tx_bytes;
+	u64 rx_frames;
+	u64 rx_bytes;
+	u64 transactions;
+	u64 sunk;
+	u64 dropped;
+	u64 no_credit;
+};
+
+struct esp_virt_context {
+	struct esp_adapter         *adapter;
+	/* tx_q[PRIO_Q_OTHERS] stays empty: Wi-Fi data goes to tx_data */
+	struct sk_buff_head        tx_q[MAX_PRIORITY_QUEUES];
+	struct esp_ac_queue        tx_data;
+	struct sk_buff_head        rx_q[MAX_PRIORITY_QUEUES];
+	/* Frames the emulated slave is about to send back */
+	struct sk_buff_head        reflect_q;
+	wait_queue_head_t          virt_wq;
+	struct task_struct         *virt_thread;
+	/* Frames waiting for the remote slave to read() them */
+	struct sk_buff_head        remote_q;
+	wait_queue_head_t          remote_wq;
+	struct mutex               remote_lock;
+	unsigned long              remote_open;
+	/* Slave RX buffers available to the host */
+	atomic_t                   credits;
+	/* Protects bus clock and stats */
+	spinlock_t                 lock;
+	/* Virtual bus clock, ns. Bus is busy until this point */
+	u64                        bus_busy_until;
+	struct esp_virt_stats      stats;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #define __PLATFORM_WRAPPER_H
 
 
+#include <stdint.h>
 #include <signal.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -172,6 +173,13 @@ void *hosted_timer_start(int duration, int type,
  */
 
 int hosted_timer_stop(void *timer_handle);
+
+/* hosted_get_time_ms returns monotonic time
+ * Returns
+ *      time in milliseconds, wraps around
+ */
+uint32_t hosted_get_time_ms(void);
+
 /*
  * serial_drv_open function opens driver interface.
  *
@@ -11,10 +11,15 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/select.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <unistd.h>
 #include "serial_if.h"
 #include "platform_wrapper.h"
 #include "ctrl_api.h"
 #include "esp_hosted_config.pb-c.h"
+#include "esp_serial_ring.h"
 #include <pthread.h>
 #include "string.h"
 #include <time.h>
@@ -36,8 +41,18 @@
 #define thread_handle_t pthread_t
 #define semaphore_handle_t sem_t
 
+#define SERIAL_RING_TX_TIMEOUT_MS  1000
+
 struct serial_drv_handle_t {
 	int file_desc;
+	/* Shared ring, NULL when driver doesn't support it */
+	struct esp_serial_ring_hdr *ring;
+	size_t ring_len;
+	uint8_t *ring_rx;
+	uint8_t *ring_tx;
+	uint32_t rx_size;
+	uint32_t tx_size;
+	uint32_t tx_head;
 };
 
 extern int errno;
@@ -140,6 +155,13 @@ int control_path_platform_init(struct serial_drv_handle_t* serial_drv_handle)
 		goto close;
 	}
 
+	/* discard anything already queued in shared ring */
+	if (serial_drv_handle->ring) {
+		__atomic_store_n(&serial_drv_handle->ring->rx_tail,
+			__atomic_load_n(&serial_drv_handle->ring->rx_head, __ATOMIC_ACQUIRE),
+			__ATOMIC_RELEASE);
+	}
+
 	do {
 		/* dummy read, discard data */
 		count = read(serial_drv_handle->file_desc,
@@ -492,8 +514,171 @@ void *hosted_timer_start(int duration, int type,
 	return timer_handle;
 }
 
+uint32_t hosted_get_time_ms(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1) {
+		printf("Failed to get current timestamp\n");
+		return 0;
+	}
+
+	return (uint32_t)((ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+}
+
 
 /* -------- Serial Drv ---------- */
+/* Map the RX/TX ring of /dev/esps0, if driver supports it.
+ * On failure, read()/write() on the device file continue to be used */
+static int serial_drv_ring_setup(struct serial_drv_handle_t *handle)
+{
+	struct esp_serial_ring_cfg cfg = {0};
+	struct esp_serial_ring_hdr *hdr = NULL;
+
+	/* Older drivers return 0 for any ioctl, leaving map_size untouched */
+	if (ioctl(handle->file_desc, ESP_SERIAL_IOC_RING_ENABLE, &cfg) || !cfg.map_size) {
+		return FAILURE;
+	}
+
+	hdr = mmap(NULL, cfg.map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			handle->file_desc, 0);
+	if (hdr == MAP_FAILED) {
+		perror("serial ring mmap:");
+		return FAILURE;
+	}
+
+	if (hdr->magic != ESP_SERIAL_RING_MAGIC ||
+	    hdr->version != ESP_SERIAL_RING_VERSION) {
+		printf("%s: unexpected ring magic/version\n", __func__);
+		munmap(hdr, cfg.map_size);
+		return FAILURE;
+	}
+
+	handle->ring = hdr;
+	handle->ring_len = cfg.map_size;
+	handle->rx_size = hdr->rx_size;
+	handle->tx_size = hdr->tx_size;
+	handle->ring_rx = (uint8_t *)hdr + hdr->rx_off;
+	handle->ring_tx = (uint8_t *)hdr + hdr->tx_off;
+	handle->tx_head = hdr->tx_head;
+
+	return SUCCESS;
+}
+
+/* Blocking read of up to 'len' bytes from RX ring */
+static int serial_drv_ring_read(struct serial_drv_handle_t *handle,
+		uint8_t *buf, int len)
+{
+	struct esp_serial_ring_hdr *hdr = handle->ring;
+	struct pollfd pfd = { .fd = handle->file_desc, .events = POLLIN };
+	uint32_t head, tail, avail, off, first;
+
+	while (1) {
+		head = __atomic_load_n(&hdr->rx_head, __ATOMIC_ACQUIRE);
+		tail = hdr->rx_tail;
+		avail = head - tail;
+		if (avail)
+			break;
+
+		/* Sleep only when ring is drained */
+		if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+			return -1;
+		}
+	}
+
+	if (avail > (uint32_t)len)
+		avail = len;
+
+	off = tail & (handle->rx_size - 1);
+	first = handle->rx_size - off;
+	if (first > avail)
+		first = avail;
+	memcpy(buf, handle->ring_rx + off, first);
+	memcpy(buf + first, handle->ring_rx, avail - first);
+
+	__atomic_store_n(&hdr->rx_tail, tail + avail, __ATOMIC_RELEASE);
+
+	return avail;
+}
+
+/* Queue one message into TX ring, kick the driver only if it asks for it */
+static int serial_drv_ring_write(struct serial_drv_handle_t *handle,
+		uint8_t *buf, int len)
+{
+	struct esp_serial_ring_hdr *hdr = handle->ring;
+	struct pollfd pfd = { .fd = handle->file_desc, .events = POLLOUT };
+	uint32_t rec_len = ESP_SERIAL_RING_ALIGN(ESP_SERIAL_RING_REC_HDR_LEN + len);
+	uint32_t head = handle->tx_head;
+	uint32_t tail, off, need;
+	int ret = 0;
+
+	off = head & (handle->tx_size - 1);
+	need = rec_len;
+	if (handle->tx_size - off < rec_len) {
+		/* record doesn't fit till ring end, pad and wrap */
+		need += handle->tx_size - off;
+	}
+
+	while (1) {
+		tail = __atomic_load_n(&hdr->tx_tail, __ATOMIC_ACQUIRE);
+		if (handle->tx_size - (head - tail) >= need)
+			break;
+
+		/* Ring full: make sure driver drains it, sleep till it has */
+		if (__atomic_load_n(&hdr->tx_need_kick, __ATOMIC_ACQUIRE) &&
+		    ioctl(handle->file_desc, ESP_SERIAL_IOC_TX_KICK)) {
+			return -1;
+		}
+
+		ret = poll(&pfd, 1, SERIAL_RING_TX_TIMEOUT_MS);
+		if (ret < 0 && errno != EINTR) {
+			return -1;
+		}
+		if (!ret) {
+			printf("%s: TX ring full\n", __func__);
+			return -1;
+		}
+		if (ret > 0 && (pfd.revents & POLLERR)) {
+			printf("%s: TX ring send failed, errors[%u]\n", __func__,
+				__atomic_load_n(&hdr->tx_errors, __ATOMIC_RELAXED));
+			return -1;
+		}
+	}
+
+	if (need != rec_len) {
+		*(uint32_t *)(handle->ring_tx + off) = ESP_SERIAL_RING_PAD;
+		head += handle->tx_size - off;
+		off = 0;
+	}
+
+	*(uint32_t *)(handle->ring_tx + off) = len;
+	memcpy(handle->ring_tx + off + ESP_SERIAL_RING_REC_HDR_LEN, buf, len);
+	head += rec_len;
+
+	handle->tx_head = head;
+	__atomic_store_n(&hdr->tx_head, head, __ATOMIC_RELEASE);
+
+	/* pairs with barrier in driver, between setting tx_need_kick and
+	 * re-checking tx_head */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&hdr->tx_need_kick, __ATOMIC_ACQUIRE)) {
+		if (ioctl(handle->file_desc, ESP_SERIAL_IOC_TX_KICK)) {
+			return -1;
+		}
+	}
+
+	return len;
+}
+
+static int serial_drv_read_bytes(struct serial_drv_handle_t *handle,
+		uint8_t *buf, int len)
+{
+	if (handle->ring)
+		return serial_drv_ring_read(handle, buf, len);
+
+	return read(handle->file_desc, buf, len);
+}
+
 struct serial_drv_handle_t* serial_drv_open(const char *transport)
 {
 	if (!transport) {
@@ -527,6 +712,10 @@ struct serial_drv_handle_t* serial_drv_open(const char *transport)
 		return NULL;
 	}
 
+	if (serial_drv_ring_setup(serial_drv_handle) == SUCCESS) {
+		printf("Using shared ring for %s\n", transport);
+	}
+
 	return serial_drv_handle;
 }
 
@@ -540,7 +729,14 @@ int serial_drv_write (struct serial_drv_handle_t *serial_drv_handle,
 		return FAILURE;
 	}
 
-	*out_count = write(serial_drv_handle->file_desc, buf, in_count);
+	/* Driver skips ring records above ESP_SERIAL_MAX_TX */
+	if (serial_drv_handle->ring && in_count <= ESP_SERIAL_MAX_TX &&
+	    ESP_SERIAL_RING_ALIGN(ESP_SERIAL_RING_REC_HDR_LEN + in_count) <=
+	    serial_drv_handle->tx_size) {
+		*out_count = serial_drv_ring_write(serial_drv_handle, buf, in_count);
+	} else {
+		*out_count = write(serial_drv_handle->file_desc, buf, in_count);
+	}
 	if (*out_count <= 0) {
 		perror("write: ");
 		return FAILURE;
@@ -556,6 +752,10 @@ int serial_drv_close(struct serial_drv_handle_t **serial_drv_handle)
 	    (*serial_drv_handle)->file_desc < 0) {
 		return FAILURE;
 	}
+	if ((*serial_drv_handle)->ring) {
+		munmap((*serial_drv_handle)->ring, (*serial_drv_handle)->ring_len);
+		(*serial_drv_handle)->ring = NULL;
+	}
 	if(close((*serial_drv_handle)->file_desc) < 0) {
 		perror("close:");
 		mem_free(*serial_drv_handle);
@@ -583,7 +783,7 @@ uint8_t * serial_drv_read(struct serial_drv_handle_t *serial_drv_handle,
 	const char* ep_name = CTRL_EP_NAME_RESP;
 	uint16_t init_read_len = SIZE_OF_TYPE + SIZE_OF_LENGTH + strlen(ep_name) +
 		SIZE_OF_TYPE + SIZE_OF_LENGTH;
-	uint8_t init_read_buf[init_read_len];
+	uint8_t init_read_buf[init_read_len + SIZE_OF_LENGTH_V2 - SIZE_OF_LENGTH];
 	uint8_t *buf = NULL;
 	uint32_t buf_len = 0;
 	/* Any of `CTRL_EP_NAME_EVENT` and `CTRL_EP_NAME_RESP` could be used,
@@ -599,6 +799,8 @@ uint8_t * serial_drv_read(struct serial_drv_handle_t *serial_drv_handle,
  *  ---------------------------------------------------------------------------
  *      1         |       2         | Endpoint Length |     1     |     2     |
  *  ---------------------------------------------------------------------------
+ *  For data type PROTO_PSER_TLV_T_DATA_V2, Data Length is 4 bytes, so
+ *  tlv_extra_hdr_len() more bytes are read before parsing.
  */
 
 	if (!serial_drv_handle ||
@@ -612,7 +814,7 @@ uint8_t * serial_drv_read(struct serial_drv_handle_t *serial_drv_handle,
 
 	total_read_len = 0;
 	do {
-		count = read(serial_drv_handle->file_desc,
+		count = serial_drv_read_bytes(serial_drv_handle,
 				(init_read_buf+total_read_len), (init_read_len-total_read_len));
 		if (count <= 0) {
 			perror("read fail:");
@@ -629,6 +831,17 @@ uint8_t * serial_drv_read(struct serial_drv_handle_t *serial_drv_handle,
 		goto free_bufs;
 	}
 
+	init_read_len += tlv_extra_hdr_len(init_read_buf);
+	while (total_read_len < init_read_len) {
+		count = serial_drv_read_bytes(serial_drv_handle,
+				(init_read_buf+total_read_len), (init_read_len-total_read_len));
+		if (count <= 0) {
+			perror("read fail:");
+			goto free_bufs;
+		}
+		total_read_len += count;
+	}
+
 	ret = parse_tlv(init_read_buf, &buf_len);
 	if ((ret != SUCCESS) || !buf_len) {
 		goto free_bufs;
@@ -643,7 +856,7 @@ uint8_t * serial_drv_read(struct serial_drv_handle_t *serial_drv_handle,
 
 	total_read_len = 0;
 	do {
-		count = read(serial_drv_handle->file_desc,
+		count = serial_drv_read_bytes(serial_drv_handle,
 				(buf+total_read_len), (buf_len-total_read_len));
 		if (count <= 0) {
 			perror("Fail to read serial data");
@@ -196,6 +196,12 @@ unsigned int msleep(unsigned int mseconds);
  */
 unsigned int sleep(unsigned int seconds);
 
+/* hosted_get_time_ms returns monotonic time
+ * Returns
+ *      time in milliseconds, wraps around
+ */
+uint32_t hosted_get_time_ms(void);
+
 /*
  * serial_drv_open function opens driver interface.
  *
@@ -221,6 +221,11 @@ unsigned int msleep(unsigned int mseconds) {
    return 0;
 }
 
+uint32_t hosted_get_time_ms(void)
+{
+	return (uint32_t)(osKernelSysTick() * portTICK_PERIOD_MS);
+}
+
 int hosted_get_semaphore(void * semaphore_handle, int timeout)
 {
 	semaphore_handle_t *sem_id = NULL;
@@ -492,6 +497,13 @@ uint8_t * serial_drv_read(struct serial_drv_handle_t *serial_drv_handle,
 		return NULL;
 	}
 
+	init_read_len += tlv_extra_hdr_len(read_buf);
+	if(rx_buf_len < init_read_len) {
+		mem_free(read_buf);
+		printf("Incomplete serial buff, return\n");
+		return NULL;
+	}
+
 	HOSTED_CALLOC(buf,init_read_len);
 
 	memcpy(buf, read_buf, init_read_len);
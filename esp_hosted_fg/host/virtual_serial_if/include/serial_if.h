@@ -13,23 +13,35 @@
 
 #define SIZE_OF_TYPE                1
 #define SIZE_OF_LENGTH              2
+#define SIZE_OF_LENGTH_V2           4
+
+#define PROTO_PSER_TLV_T_EPNAME     0x01
+#define PROTO_PSER_TLV_T_DATA       0x02
+#define PROTO_PSER_TLV_T_DATA_V2    0x03
 
 /*
  * The data written on serial driver file, `SERIAL_IF_FILE` from adapter.h
  * In TLV i.e. Type Length Value format, to transfer data between host and ESP32
  *  | type | length | value |
  * Types are 0x01 : for endpoint name
- *           0x02 : for data
- * length is respective value field's data length in 16 bits
+ *           0x02 : for data, length in 16 bits
+ *           0x03 : for data, length in 32 bits (data longer than 0xFFFF)
+ * length is respective value field's data length, little endian
  * value is actual data to be transferred
  */
-uint16_t compose_tlv(uint8_t* buf, uint8_t* data, uint16_t data_length);
+uint32_t compose_tlv(uint8_t* buf, uint8_t* data, uint32_t data_length);
 
 /* Parse the protobuf encoded data in format of tag, length and value
  * This will help application to decode protobuf payload and payload length
+ * For data type 0x03, data should hold tlv_extra_hdr_len() more bytes
  **/
 uint8_t parse_tlv(uint8_t* data, uint32_t* pro_len);
 
+/* Number of header bytes to be read, after the fixed 16 bit length
+ * header, before parse_tlv() could be called
+ **/
+uint32_t tlv_extra_hdr_len(uint8_t* data);
+
 /* Open the serial driver for serial operations
  **/
 int transport_pserial_open(void);
@@ -40,7 +52,7 @@ int transport_pserial_close(void);
 
 /* Send buffer with length as argument on transport as serial interface type
  **/
-int transport_pserial_send(uint8_t* data, uint16_t data_length);
+int transport_pserial_send(uint8_t* data, uint32_t data_length);
 
 /* Read and return number of bytes and buffer from serial interface
  **/
@@ -11,9 +11,6 @@
 #define FAILURE                          -1
 
 
-#define PROTO_PSER_TLV_T_EPNAME           0x01
-#define PROTO_PSER_TLV_T_DATA             0x02
-
 #ifdef MCU_SYS
 #define command_log(format, ...)          printf(format "\r", ##__VA_ARGS__);
 #else
@@ -37,16 +34,19 @@ struct serial_drv_handle_t* serial_handle = NULL;
  * In TLV i.e. Type Length Value format, to transfer data between host and ESP32
  *  | type | length | value |
  * Types are 0x01 : for endpoint name
- *           0x02 : for data
- * length is respective value field's data length in 16 bits
+ *           0x02 : for data, length in 16 bits
+ *           0x03 : for data, length in 32 bits
  * value is actual data to be transferred
+ *
+ * Data type 0x02 is used whenever length fits, so that older ESP firmware
+ * keeps working for usual messages.
  */
 
-uint16_t compose_tlv(uint8_t* buf, uint8_t* data, uint16_t data_length)
+uint32_t compose_tlv(uint8_t* buf, uint8_t* data, uint32_t data_length)
 {
 	char* ep_name = CTRL_EP_NAME_RESP;
 	uint16_t ep_length = strlen(ep_name);
-	uint16_t count = 0;
+	uint32_t count = 0;
 	buf[count] = PROTO_PSER_TLV_T_EPNAME;
 	count++;
 	buf[count] = (ep_length & 0xFF);
@@ -55,12 +55,25 @@ uint16_t compose_tlv(uint8_t* buf, uint8_t* data, uint16_t data_length)
 	count++;
 	strncpy((char *)&buf[count], ep_name, ep_length);
 	count = count + ep_length;
-	buf[count]= PROTO_PSER_TLV_T_DATA;
-	count++;
-	buf[count] = (data_length & 0xFF);
-	count++;
-	buf[count] = ((data_length >> 8) & 0xFF);
-	count++;
+	if (data_length > 0xFFFF) {
+		buf[count]= PROTO_PSER_TLV_T_DATA_V2;
+		count++;
+		buf[count] = (data_length & 0xFF);
+		count++;
+		buf[count] = ((data_length >> 8) & 0xFF);
+		count++;
+		buf[count] = ((data_length >> 16) & 0xFF);
+		count++;
+		buf[count] = ((data_length >> 24) & 0xFF);
+		count++;
+	} else {
+		buf[count]= PROTO_PSER_TLV_T_DATA;
+		count++;
+		buf[count] = (data_length & 0xFF);
+		count++;
+		buf[count] = ((data_length >> 8) & 0xFF);
+		count++;
+	}
 	memcpy(&buf[count], data, data_length);
 	count = count + data_length;
 	return count;
@@ -93,9 +106,16 @@ uint8_t parse_tlv(uint8_t* data, uint32_t* pro_len)
 					len++;
 					*pro_len = val_len;
 					return SUCCESS;
+				} else if (data[len] == PROTO_PSER_TLV_T_DATA_V2) {
+					len++;
+					*pro_len = (uint32_t)data[len] |
+						((uint32_t)data[len+1] << 8) |
+						((uint32_t)data[len+2] << 16) |
+						((uint32_t)data[len+3] << 24);
+					return SUCCESS;
 				} else {
-					command_log("Data Type not matched, exp %d, recvd %d\n",
-							PROTO_PSER_TLV_T_DATA, data[len]);
+					command_log("Data Type not matched, exp %d or %d, recvd %d\n",
+							PROTO_PSER_TLV_T_DATA, PROTO_PSER_TLV_T_DATA_V2, data[len]);
 				}
 			} else {
 				command_log("Endpoint Name not matched, exp [%s] or [%s], recvd [%s]\n",
@@ -113,6 +133,17 @@ uint8_t parse_tlv(uint8_t* data, uint32_t* pro_len)
 	return FAILURE;
 }
 
+uint32_t tlv_extra_hdr_len(uint8_t* data)
+{
+	uint32_t data_type_pos = SIZE_OF_TYPE + SIZE_OF_LENGTH +
+		strlen(CTRL_EP_NAME_RESP);
+
+	if (data[data_type_pos] == PROTO_PSER_TLV_T_DATA_V2)
+		return SIZE_OF_LENGTH_V2 - SIZE_OF_LENGTH;
+
+	return 0;
+}
+
 int transport_pserial_close(void)
 {
 	int ret = serial_drv_close(&serial_handle);
@@ -150,11 +181,11 @@ int transport_pserial_open(void)
 }
 
 
-int transport_pserial_send(uint8_t* data, uint16_t data_length)
+int transport_pserial_send(uint8_t* data, uint32_t data_length)
 {
 	char* ep_name = CTRL_EP_NAME_RESP;
 	int count = 0, ret = 0;
-	uint16_t buf_len = 0;
+	uint32_t buf_len = 0;
 	uint8_t *write_buf = NULL;
 
 /*
@@ -165,11 +196,11 @@ int transport_pserial_send(uint8_t* data, uint16_t data_length)
  *
  *  Bytes used per field as follows:
  * --------------------------------------------------------------------------------------------
- *       1        |        2        | Endpoint length |     1     |      2      | Data length |
+ *       1        |        2        | Endpoint length |     1     |    2 or 4   | Data length |
  * --------------------------------------------------------------------------------------------
  */
 	buf_len = SIZE_OF_TYPE + SIZE_OF_LENGTH + strlen(ep_name) +
-		SIZE_OF_TYPE + SIZE_OF_LENGTH + data_length;
+		SIZE_OF_TYPE + SIZE_OF_LENGTH_V2 + data_length;
 
 	HOSTED_CALLOC(write_buf,buf_len);
 
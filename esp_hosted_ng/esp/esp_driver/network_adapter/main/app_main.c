@@ -46,6 +46,7 @@
 
 #include "slave_bt.c"
 #include "stats.h"
+#include "wmm.h"
 #include "esp_mac.h"
 
 static const char TAG[] = "FW_MAIN";
@@ -144,6 +145,9 @@ static int wifi_tx_with_retry(wifi_interface_t wifi_if, uint8_t *payload,
             break;
         }
         H2E_STATS_INC(h2e_wifi_tx_retries);
+        if (wifi_if == ESP_IF_WIFI_STA) {
+            sta_info_count_tx_retry();
+        }
         usleep(WIFI_TX_RETRY_DELAY_US);
     } while (++retry < WIFI_TX_RETRY_COUNT);
 
@@ -160,8 +164,16 @@ static int wifi_tx_with_retry(wifi_interface_t wifi_if, uint8_t *payload,
 #define TO_HOST_QUEUE_SIZE      100
 #endif
 
+/* Per-AC lanes besides BE, which is to_host_queue[PRIO_Q_LOW] */
+#define TO_HOST_AC_QUEUE_SIZE   (TO_HOST_QUEUE_SIZE / 2)
+
 #define ETH_DATA_LEN            1500
 
+/* Wi-Fi data to the host, one lane per access category, drained by
+ * weighted round robin like the host's lanes towards us (wmm.c) */
+static QueueHandle_t to_host_ac_queue[ESP_NUM_AC];
+static struct wmm_sched to_host_wmm;
+
 uint8_t dev_mac[MAC_ADDR_LEN] = {0};
 
 #if CONFIG_ESP_SDIO_HOST_INTERFACE
@@ -193,9 +205,26 @@ static uint8_t get_capabilities()
     return cap;
 }
 
-#if CONFIG_ESP_SDIO_HOST_INTERFACE
+/* Top byte of the Ethernet CRC32 of the address, as ether_crc() on the host */
+static uint8_t mcast_hash_bucket(const uint8_t *mac_addr)
+{
+    uint32_t crc = 0xffffffff;
+    uint8_t octet;
+    int i, bit;
+
+    for (i = 0; i < MAC_ADDR_LEN; i++) {
+        octet = mac_addr[i];
+        for (bit = 0; bit < 8; bit++, octet >>= 1) {
+            crc = (crc << 1) ^ (((crc >> 31) ^ (octet & 1)) ? 0x04c11db7 : 0);
+        }
+    }
+
+    return crc >> 24;
+}
+
 uint8_t address_lookup(uint8_t *mac_addr)
 {
+    uint8_t bucket;
     int i;
 
     /*  ESP_LOG_BUFFER_HEXDUMP("Look up", mac_addr, MAC_ADDR_LEN, ESP_LOG_INFO);*/
@@ -203,6 +232,15 @@ uint8_t address_lookup(uint8_t *mac_addr)
         return 0;
     }
 
+    if (mac_list.mode == MCAST_FILTER_ALLMULTI) {
+        return 1;
+    }
+
+    if (mac_list.mode == MCAST_FILTER_HASH) {
+        bucket = mcast_hash_bucket(mac_addr);
+        return (mac_list.hash[bucket / 8] >> (bucket % 8)) & 1;
+    }
+
     for (i = 0; i < mac_list.count; i++) {
         /*      ESP_LOG_BUFFER_HEXDUMP("Against", mac_list.mac_addr[i], MAC_ADDR_LEN, ESP_LOG_INFO);*/
         if (memcmp(mac_list.mac_addr[i], mac_addr, MAC_ADDR_LEN) == 0) {
@@ -213,6 +251,24 @@ uint8_t address_lookup(uint8_t *mac_addr)
     return 0;
 }
 
+/* Multicast the host has not subscribed to; broadcast always goes up */
+static bool wlan_rx_mcast_unwanted(const uint8_t *frame, uint16_t len)
+{
+    static const uint8_t bcast[MAC_ADDR_LEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+    if (!mac_list.filter_rx || len < MAC_ADDR_LEN || !(frame[0] & 1)) {
+        return false;
+    }
+
+    if (memcmp(frame, bcast, MAC_ADDR_LEN) == 0) {
+        return false;
+    }
+
+    return !address_lookup((uint8_t *)frame);
+}
+
+#if CONFIG_ESP_SDIO_HOST_INTERFACE
+
 uint8_t is_wakeup_needed(interface_buffer_handle_t *buf_handle)
 {
     uint8_t *pos;
@@ -276,6 +332,18 @@ uint8_t is_wakeup_needed(interface_buffer_handle_t *buf_handle)
 }
 #endif
 
+static uint16_t to_host_data_waiting(void)
+{
+    uint16_t waiting = 0;
+    int ac;
+
+    for (ac = 0; ac < ESP_NUM_AC; ac++) {
+        waiting += uxQueueMessagesWaiting(to_host_ac_queue[ac]);
+    }
+
+    return waiting;
+}
+
 esp_err_t wlan_ap_rx_callback(void *buffer, uint16_t len, void *eb)
 {
     esp_err_t ret = ESP_OK;
@@ -298,7 +366,8 @@ esp_err_t wlan_ap_rx_callback(void *buffer, uint16_t len, void *eb)
 
     /* ESP_LOGI(TAG, "Slave -> Host: AP data packet\n"); */
     /* ESP_LOG_BUFFER_HEXDUMP("RX", buffer, len, ESP_LOG_INFO); */
-    ret = xQueueSend(to_host_queue[PRIO_Q_LOW], &buf_handle, portMAX_DELAY);
+    ret = xQueueSend(to_host_ac_queue[wmm_frame_ac(buffer, len)],
+                     &buf_handle, portMAX_DELAY);
 
     if (ret != pdTRUE) {
         ESP_LOGE(TAG, "Slave -> Host: Failed to send buffer\n");
@@ -328,6 +397,11 @@ esp_err_t wlan_sta_rx_callback(void *buffer, uint16_t len, void *eb)
     from_wlan_count++;
 #endif
 
+    if (wlan_rx_mcast_unwanted(buffer, len)) {
+        esp_wifi_internal_free_rx_buffer(eb);
+        return ESP_OK;
+    }
+
     buf_handle.if_type = ESP_STA_IF;
     buf_handle.if_num = 0;
     buf_handle.payload_len = len;
@@ -336,7 +410,8 @@ esp_err_t wlan_sta_rx_callback(void *buffer, uint16_t len, void *eb)
     buf_handle.priv_buffer_handle = eb;
     buf_handle.free_buf_handle = esp_wifi_internal_free_rx_buffer;
 
-    ret = xQueueSend(to_host_queue[PRIO_Q_LOW], &buf_handle, portMAX_DELAY);
+    ret = xQueueSend(to_host_ac_queue[wmm_frame_ac(buffer, len)],
+                     &buf_handle, portMAX_DELAY);
 
     if (ret != pdTRUE) {
         ESP_LOGE(TAG, "Slave -> Host: Failed to send buffer\n");
@@ -382,65 +457,51 @@ static void free_tx_buf_handle(interface_buffer_handle_t *buf_handle)
 }
 
 #ifdef CONFIG_ESP_SDIO_HOST_INTERFACE
-static void process_low_prio_tx_packets(uint16_t queued, uint8_t *aggr_buf)
+/* Packs frames from the front of @queue into the aggregate at @aggr_len,
+ * at most @max_frames of them. Frames are peeked and only dequeued once they
+ * fit, so nothing is ever requeued; this relies on send_task being the only
+ * consumer of the to-host queues. Small data frames keep the latency bypass:
+ * they travel on their own rather than join or wait for an aggregate.
+ * Returns how many frames left the queue, and sets @full once the next frame
+ * has to start a new transfer. */
+static uint16_t tx_aggr_pack(QueueHandle_t queue, uint16_t max_frames, bool data,
+                             uint8_t *aggr_buf, uint16_t *aggr_len, bool *full)
 {
     interface_buffer_handle_t buf_handle = {0};
-    uint16_t aggr_len = 0;
-    bool flush_after_pkt = false;
-
-    if (!queued) {
-        return;
-    }
-
-    if (!datapath) {
-        while (queued--) {
-            if (xQueueReceive(to_host_queue[PRIO_Q_LOW], &buf_handle, portMAX_DELAY)) {
-                process_tx_pkt(&buf_handle);
-            }
-        }
-        return;
-    }
-
-    if (!aggr_buf) {
-        if (xQueueReceive(to_host_queue[PRIO_Q_LOW], &buf_handle, portMAX_DELAY)) {
-            process_tx_pkt(&buf_handle);
-        }
-        return;
-    }
-
-    while (queued || uxQueueMessagesWaiting(to_host_queue[PRIO_Q_LOW])) {
-        struct esp_payload_header *header = NULL;
-        uint16_t frame_len = 0;
-        uint16_t aligned_len = 0;
-        uint16_t offset = sizeof(struct esp_payload_header);
-        TickType_t wait = queued ? portMAX_DELAY : 0;
-
-        if (!xQueueReceive(to_host_queue[PRIO_Q_LOW], &buf_handle, wait)) {
-            break;
-        }
-        if (queued) {
-            queued--;
-        }
+    struct esp_payload_header *header = NULL;
+    uint16_t offset = sizeof(struct esp_payload_header);
+    uint16_t frames = 0;
+    uint16_t frame_len, aligned_len;
+    bool flush_after_pkt;
 
+    while (frames < max_frames && xQueuePeek(queue, &buf_handle, 0)) {
         if (!buf_handle.payload || !buf_handle.payload_len ||
             buf_handle.payload_len + offset > SDIO_TX_AGGR_SIZE) {
+            xQueueReceive(queue, &buf_handle, 0);
+            frames++;
             free_tx_buf_handle(&buf_handle);
             continue;
         }
 
         frame_len = buf_handle.payload_len + offset;
         aligned_len = (frame_len + 3) & ~3;
-        flush_after_pkt = buf_handle.payload_len <= SDIO_TX_LATENCY_BYPASS_SIZE;
-        if (aggr_len && flush_after_pkt) {
-            xQueueSendToFront(to_host_queue[PRIO_Q_LOW], &buf_handle, 0);
+        flush_after_pkt = data &&
+            buf_handle.payload_len <= SDIO_TX_LATENCY_BYPASS_SIZE;
+
+        /* Starts the next transfer: leave it queued */
+        if (*aggr_len && (flush_after_pkt ||
+                          *aggr_len + aligned_len > SDIO_TX_AGGR_SIZE)) {
+            *full = true;
             break;
         }
-        if (aggr_len && aggr_len + aligned_len > SDIO_TX_AGGR_SIZE) {
-            xQueueSendToFront(to_host_queue[PRIO_Q_LOW], &buf_handle, 0);
+
+        if (!xQueueReceive(queue, &buf_handle, 0)) {
+            ESP_LOGE(TAG, "to-host queue peek/receive desync");
             break;
         }
+        frames++;
 
-        if (power_save_on && wow.magic_pkt) {
+        if (data && power_save_on && wow.magic_pkt) {
             if (is_wakeup_needed(&buf_handle)) {
                 ESP_LOGI(TAG, "Wakeup on Magic packet");
                 wake_host();
@@ -448,7 +509,7 @@ static void process_low_prio_tx_packets(uint16_t queued, uint8_t *aggr_buf)
             }
         }
 
-        header = (struct esp_payload_header *) (aggr_buf + aggr_len);
+        header = (struct esp_payload_header *) (aggr_buf + *aggr_len);
         memset(header, 0, sizeof(*header));
         header->if_type = buf_handle.if_type;
         header->if_num = buf_handle.if_num;
@@ -456,21 +517,53 @@ static void process_low_prio_tx_packets(uint16_t queued, uint8_t *aggr_buf)
         header->reserved2 = buf_handle.flag;
         header->offset = htole16(offset);
         header->packet_type = buf_handle.pkt_type;
-        memcpy(aggr_buf + aggr_len + offset, buf_handle.payload,
+        esp_stamp_tx_tag(header);
+        memcpy(aggr_buf + *aggr_len + offset, buf_handle.payload,
                buf_handle.payload_len);
         if (aligned_len > frame_len) {
-            memset(aggr_buf + aggr_len + frame_len, 0,
+            memset(aggr_buf + *aggr_len + frame_len, 0,
                    aligned_len - frame_len);
         }
 #if CONFIG_ESP_SDIO_CHECKSUM
-        header->checksum = htole16(compute_checksum(aggr_buf + aggr_len,
+        header->checksum = htole16(compute_checksum(aggr_buf + *aggr_len,
                                                     frame_len));
 #endif
-        aggr_len += aligned_len;
+        *aggr_len += aligned_len;
         free_tx_buf_handle(&buf_handle);
+
         if (flush_after_pkt) {
+            *full = true;
+            break;
+        }
+    }
+
+    return frames;
+}
+
+/* One SDIO transfer across all lanes: command responses and events first,
+ * then HCI, then Wi-Fi data in WMM order for the space that is left. */
+static void process_tx_aggr(uint8_t *aggr_buf)
+{
+    uint16_t aggr_len = 0;
+    uint16_t frames;
+    bool full = false;
+    int ac;
+
+    tx_aggr_pack(to_host_queue[PRIO_Q_HIGH], UINT16_MAX, false,
+                 aggr_buf, &aggr_len, &full);
+    if (!full) {
+        tx_aggr_pack(to_host_queue[PRIO_Q_MID], UINT16_MAX, false,
+                     aggr_buf, &aggr_len, &full);
+    }
+
+    /* Each AC gets what is left of its turn, then the next one fills in */
+    while (!full && (ac = wmm_sched_next(&to_host_wmm, to_host_ac_queue)) >= 0) {
+        frames = tx_aggr_pack(to_host_ac_queue[ac], to_host_wmm.credit, true,
+                              aggr_buf, &aggr_len, &full);
+        if (!frames) {
             break;
         }
+        wmm_sched_charge(&to_host_wmm, frames);
     }
 
     if (aggr_len) {
@@ -478,10 +571,26 @@ static void process_low_prio_tx_packets(uint16_t queued, uint8_t *aggr_buf)
             sdio_write_aggr(if_handle, aggr_buf, aggr_len);
         }
     }
-
 }
 #endif
 
+/* Number E2H frames in reserved1 (reserved2 carries the buffer flag) so the
+ * slave log can be matched with the host's esp_rx_frame trace. Call before
+ * the checksum is computed. */
+void esp_stamp_tx_tag(struct esp_payload_header *header)
+{
+    static portMUX_TYPE tx_tag_lock = portMUX_INITIALIZER_UNLOCKED;
+    static uint8_t tx_tag;
+
+    portENTER_CRITICAL(&tx_tag_lock);
+    header->reserved1 = ++tx_tag;
+    portEXIT_CRITICAL(&tx_tag_lock);
+
+    ESP_LOGV(TAG, "tx if=%u/%u type=%u tag=%u len=%u",
+             header->if_type, header->if_num, header->packet_type,
+             header->reserved1, le16toh(header->len));
+}
+
 esp_err_t send_to_host(uint8_t prio_q_idx, interface_buffer_handle_t *buf_handle)
 {
     return xQueueSend(to_host_queue[prio_q_idx], buf_handle, portMAX_DELAY);
@@ -498,6 +607,7 @@ void send_task(void* pvParameters)
     uint16_t high_prio_pkt_waiting = 0;
     uint16_t mid_prio_pkt_waiting = 0;
     uint16_t low_prio_pkt_waiting = 0;
+    int ac;
 #if CONFIG_ESP_SDIO_HOST_INTERFACE
     uint8_t *sdio_aggr_buf = heap_caps_malloc(SDIO_TX_AGGR_SIZE, MALLOC_CAP_DMA);
 
@@ -509,7 +619,18 @@ void send_task(void* pvParameters)
     while (1) {
         high_prio_pkt_waiting = uxQueueMessagesWaiting(to_host_queue[PRIO_Q_HIGH]);
         mid_prio_pkt_waiting = uxQueueMessagesWaiting(to_host_queue[PRIO_Q_MID]);
-        low_prio_pkt_waiting = uxQueueMessagesWaiting(to_host_queue[PRIO_Q_LOW]);
+        low_prio_pkt_waiting = to_host_data_waiting();
+
+#if CONFIG_ESP_SDIO_HOST_INTERFACE
+        if (sdio_aggr_buf && datapath) {
+            if (high_prio_pkt_waiting || mid_prio_pkt_waiting || low_prio_pkt_waiting) {
+                process_tx_aggr(sdio_aggr_buf);
+            } else {
+                vTaskDelay(1);
+            }
+            continue;
+        }
+#endif
 
         if (high_prio_pkt_waiting) {
             while (high_prio_pkt_waiting) {
@@ -522,14 +643,12 @@ void send_task(void* pvParameters)
             if (xQueueReceive(to_host_queue[PRIO_Q_MID], &buf_handle, portMAX_DELAY)) {
                 process_tx_pkt(&buf_handle);
             }
-        } else if (low_prio_pkt_waiting) {
-#if CONFIG_ESP_SDIO_HOST_INTERFACE
-            process_low_prio_tx_packets(low_prio_pkt_waiting, sdio_aggr_buf);
-#else
-            if (xQueueReceive(to_host_queue[PRIO_Q_LOW], &buf_handle, portMAX_DELAY)) {
+        } else if (low_prio_pkt_waiting &&
+                   (ac = wmm_sched_next(&to_host_wmm, to_host_ac_queue)) >= 0) {
+            if (xQueueReceive(to_host_ac_queue[ac], &buf_handle, portMAX_DELAY)) {
                 process_tx_pkt(&buf_handle);
             }
-#endif
+            wmm_sched_charge(&to_host_wmm, 1);
         } else {
             vTaskDelay(1);
         }
@@ -540,6 +659,8 @@ void process_priv_commamd(uint8_t if_type, uint8_t *payload, uint16_t payload_le
 {
     struct command_header *header = (struct command_header *) payload;
 
+    set_cur_cmd_seq(header->seq_num);
+
     switch (header->cmd_code) {
 
     case CMD_INIT_INTERFACE:
@@ -742,6 +863,9 @@ void process_rx_pkt(interface_buffer_handle_t *buf_handle)
 #endif
 
         payload = buf_handle->payload + pos + offset;
+        ESP_LOGV(TAG, "rx if=%u/%u type=%u tag=%u len=%u flags=0x%x",
+                 header->if_type, header->if_num, header->packet_type,
+                 header->reserved2, payload_len, header->flags);
         H2E_STATS_INC(h2e_rx_pkts);
         H2E_STATS_ADD(h2e_rx_bytes, payload_len);
 #if CONFIG_ESP_WLAN_DEBUG
@@ -973,6 +1097,17 @@ void app_main()
         assert(to_host_queue[prio_q_idx] != NULL);
     }
 
+    /* BE shares to_host_queue[PRIO_Q_LOW], so send_to_host(PRIO_Q_LOW) is BE */
+    for (prio_q_idx = 0; prio_q_idx < ESP_NUM_AC; prio_q_idx++) {
+        if (prio_q_idx == ESP_AC_BE) {
+            to_host_ac_queue[prio_q_idx] = to_host_queue[PRIO_Q_LOW];
+            continue;
+        }
+        to_host_ac_queue[prio_q_idx] = xQueueCreate(TO_HOST_AC_QUEUE_SIZE, sizeof(interface_buffer_handle_t));
+        assert(to_host_ac_queue[prio_q_idx] != NULL);
+    }
+    wmm_sched_init(&to_host_wmm);
+
     assert(xTaskCreate(recv_task, "recv_task", TASK_DEFAULT_STACK_SIZE, NULL, TASK_DEFAULT_PRIO, NULL) == pdTRUE);
     assert(xTaskCreate(send_task, "send_task", TASK_DEFAULT_STACK_SIZE, NULL, TASK_DEFAULT_PRIO, NULL) == pdTRUE);
 
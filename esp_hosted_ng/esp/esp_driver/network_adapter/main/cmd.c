@@ -30,6 +30,8 @@
 #include "esp_ota_ops.h"
 #include "esp_app_format.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 
 #define TAG "FW_CMD"
 
@@ -43,6 +45,8 @@ static uint8_t broadcast_mac[ETH_ALEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
 #define DUMMY_PASSPHRASE            "12345678"
 
 #define RESET_TIMEOUT             (5*1000)
+/* Host gives up on a command after 5 s */
+#define MGMT_TX_SEQ_MAX_AGE_MS    (5*1000)
 extern volatile uint8_t station_connected;
 extern volatile uint8_t association_ongoing;
 extern volatile uint8_t softap_started;
@@ -57,6 +61,44 @@ volatile uint8_t sta_init_flag;
 #define EAP_CODE_SUCCESS                    3
 #define EAP_CODE_FAILURE                    4
 
+/* Only touched from recv_task, which handles one command at a time */
+static uint16_t cur_cmd_seq;
+
+/* Unicast CMD_MGMT_TX is answered from the TX done callback. Remember the
+ * request seq_num per destination until then. */
+struct mgmt_tx_seq {
+    uint16_t seq;
+    uint8_t da[ETH_ALEN];
+    TickType_t queued;
+};
+static struct mgmt_tx_seq mgmt_tx_seqs[CMD_WINDOW];
+static portMUX_TYPE mgmt_tx_seq_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Link counters for EVENT_STA_INFO, cleared on connect */
+static volatile uint32_t sta_tx_retries;
+static volatile uint32_t sta_tx_failed;
+static volatile uint32_t sta_beacon_loss;
+static esp_timer_handle_t sta_info_timer;
+
+/* Scan results of a scan the host asked to batch (SCAN_REQ_BATCH_RESULTS)
+ * are packed into EVENT_SCAN_RESULT_BATCH, reporting each BSS once per
+ * frame type and channel. Filled from the Wi-Fi task, flushed from there
+ * or from the event loop at scan done. */
+#define SCAN_BATCH_MAX_LEN        MAX_ALLOWED_BUF_PAYLOAD_LEN
+#define SCAN_SEEN_MAX             64
+struct scan_seen {
+    uint8_t bssid[MAC_ADDR_LEN];
+    uint8_t channel;
+    /* Bit per frame subtype already reported */
+    uint16_t types;
+};
+static SemaphoreHandle_t scan_batch_lock;
+static bool scan_batching;
+static interface_buffer_handle_t scan_batch;
+static uint16_t scan_batch_len;
+static struct scan_seen scan_seen[SCAN_SEEN_MAX];
+static uint8_t scan_seen_count;
+
 static struct wpa_funcs wpa_cb;
 static struct wpa2_funcs *wpa2_cb;
 static esp_event_handler_instance_t instance_any_id;
@@ -84,6 +126,22 @@ extern struct wow_config wow;
 static const esp_partition_t* update_partition = NULL;
 static esp_ota_handle_t handle;
 
+/* OTA writes are acked once staged in RAM; a separate task flashes full
+ * buffers while the next one fills, so the host can keep several writes in
+ * flight. A flash failure is latched and fails every later write. */
+#define OTA_FLASH_BUF_SIZE        4096
+#define OTA_FLASH_BUF_COUNT       2
+struct ota_flash_buf {
+    uint16_t len;
+    uint8_t data[OTA_FLASH_BUF_SIZE];
+};
+static struct ota_flash_buf *ota_bufs;
+static QueueHandle_t ota_free_bufs;
+static QueueHandle_t ota_full_bufs;
+static struct ota_flash_buf *ota_fill;
+static volatile esp_err_t ota_flash_err;
+static bool ota_active;
+
 extern int wpa_parse_wpa_ie(const u8 *wpa_ie, size_t wpa_ie_len, wifi_wpa_ie_t *data);
 static inline void WPA_PUT_LE16(u8 *a, u16 val)
 {
@@ -108,6 +166,70 @@ static void esp_wifi_set_debug_log()
     esp_wifi_internal_set_log_level(WIFI_LOG_VERBOSE);
 }
 
+void set_cur_cmd_seq(uint16_t seq)
+{
+    cur_cmd_seq = seq;
+}
+
+static void mgmt_tx_seq_push(const uint8_t *da, uint16_t seq)
+{
+    TickType_t now = xTaskGetTickCount();
+    struct mgmt_tx_seq *slot = NULL;
+    int i;
+
+    if (!seq) {
+        return;
+    }
+
+    portENTER_CRITICAL(&mgmt_tx_seq_lock);
+    for (i = 0; i < CMD_WINDOW; i++) {
+        struct mgmt_tx_seq *e = &mgmt_tx_seqs[i];
+
+        /* Free, or stale: the host stopped waiting for it */
+        if (!e->seq || now - e->queued > pdMS_TO_TICKS(MGMT_TX_SEQ_MAX_AGE_MS)) {
+            slot = e;
+            break;
+        }
+    }
+    if (slot) {
+        slot->seq = seq;
+        memcpy(slot->da, da, ETH_ALEN);
+        slot->queued = now;
+    }
+    portEXIT_CRITICAL(&mgmt_tx_seq_lock);
+
+    if (!slot) {
+        ESP_LOGW(TAG, "No room for mgmt tx seq %u", seq);
+    }
+}
+
+/* Oldest request seq_num for frames to @da, 0 if none */
+static uint16_t mgmt_tx_seq_pop(const uint8_t *da)
+{
+    struct mgmt_tx_seq *oldest = NULL;
+    uint16_t seq = 0;
+    int i;
+
+    portENTER_CRITICAL(&mgmt_tx_seq_lock);
+    for (i = 0; i < CMD_WINDOW; i++) {
+        struct mgmt_tx_seq *e = &mgmt_tx_seqs[i];
+
+        if (!e->seq || memcmp(e->da, da, ETH_ALEN)) {
+            continue;
+        }
+        if (!oldest || (int32_t)(e->queued - oldest->queued) < 0) {
+            oldest = e;
+        }
+    }
+    if (oldest) {
+        seq = oldest->seq;
+        oldest->seq = 0;
+    }
+    portEXIT_CRITICAL(&mgmt_tx_seq_lock);
+
+    return seq;
+}
+
 static int send_command_resp(uint8_t if_type,
                              uint8_t cmd_code, uint8_t cmd_status,
                              uint8_t *data, uint32_t len, uint32_t offset)
@@ -137,6 +259,7 @@ static int send_command_resp(uint8_t if_type,
     header->cmd_status = cmd_status;
     header->cmd_code = cmd_code;
     header->len = len;
+    header->seq_num = cur_cmd_seq;
 
     buf_handle.if_type = if_type;
     buf_handle.if_num = 0;
@@ -343,6 +466,138 @@ int process_owe_assoc_resp(const u8 *rsn_ie, size_t rsn_len, const uint8_t *dh_i
     return 0;
 }
 
+/* false: this BSS was already reported with this frame type in the scan */
+static bool scan_seen_check(const uint8_t *bssid, uint8_t channel, uint8_t type)
+{
+    uint16_t bit = 1 << (type & 0xf);
+    struct scan_seen *e;
+    int i;
+
+    for (i = 0; i < scan_seen_count; i++) {
+        e = &scan_seen[i];
+        if (e->channel != channel || memcmp(e->bssid, bssid, MAC_ADDR_LEN)) {
+            continue;
+        }
+        if (e->types & bit) {
+            return false;
+        }
+        e->types |= bit;
+        return true;
+    }
+
+    /* Table full: report everything from here on */
+    if (scan_seen_count < SCAN_SEEN_MAX) {
+        e = &scan_seen[scan_seen_count++];
+        memcpy(e->bssid, bssid, MAC_ADDR_LEN);
+        e->channel = channel;
+        e->types = bit;
+    }
+
+    return true;
+}
+
+/* Caller holds scan_batch_lock */
+static void scan_batch_flush(void)
+{
+    struct scan_batch_event *event;
+
+    if (!scan_batch.payload) {
+        return;
+    }
+
+    event = (struct scan_batch_event *) scan_batch.payload;
+    scan_batch.payload_len = scan_batch_len;
+    event->header.len = htole16(scan_batch_len - sizeof(struct event_header));
+
+    if (send_command_event(&scan_batch) != pdTRUE) {
+        ESP_LOGE(TAG, "Slave -> Host: Failed to send scan batch\n");
+        free(scan_batch.payload);
+    }
+
+    memset(&scan_batch, 0, sizeof(scan_batch));
+    scan_batch_len = 0;
+}
+
+static void scan_batch_begin(bool enable)
+{
+    xSemaphoreTake(scan_batch_lock, portMAX_DELAY);
+    scan_batch_flush();
+    scan_batching = enable;
+    scan_seen_count = 0;
+    xSemaphoreGive(scan_batch_lock);
+}
+
+static void scan_batch_end(void)
+{
+    xSemaphoreTake(scan_batch_lock, portMAX_DELAY);
+    scan_batch_flush();
+    scan_batching = false;
+    xSemaphoreGive(scan_batch_lock);
+}
+
+/* true: the BSS is batched, or dropped as a duplicate. false: not batching,
+ * send it as a scan_event */
+static bool scan_batch_add(uint8_t type, uint8_t *frame, size_t len, uint8_t *sender,
+                           uint32_t rssi, uint8_t channel, uint64_t current_tsf)
+{
+    struct scan_batch_event *event;
+    struct scan_result_record *rec;
+    uint16_t rec_len = (sizeof(struct scan_result_record) + len + 3) & ~3;
+    bool handled = true;
+
+    if (!scan_batching ||
+        sizeof(struct scan_batch_event) + rec_len > SCAN_BATCH_MAX_LEN) {
+        return false;
+    }
+
+    xSemaphoreTake(scan_batch_lock, portMAX_DELAY);
+
+    if (!scan_batching) {
+        handled = false;
+        goto out;
+    }
+
+    if (!scan_seen_check(sender, channel, type)) {
+        goto out;
+    }
+
+    if (scan_batch.payload && scan_batch_len + rec_len > SCAN_BATCH_MAX_LEN) {
+        scan_batch_flush();
+    }
+
+    if (!scan_batch.payload) {
+        if (prepare_event(ESP_STA_IF, &scan_batch, SCAN_BATCH_MAX_LEN)) {
+            ESP_LOGE(TAG, "%s: Failed to prepare event buffer\n", __func__);
+            memset(&scan_batch, 0, sizeof(scan_batch));
+            handled = false;
+            goto out;
+        }
+        event = (struct scan_batch_event *) scan_batch.payload;
+        event->header.event_code = EVENT_SCAN_RESULT_BATCH;
+        event->header.status = 1;
+        scan_batch_len = sizeof(struct scan_batch_event);
+    }
+
+    event = (struct scan_batch_event *) scan_batch.payload;
+    rec = (struct scan_result_record *) (scan_batch.payload + scan_batch_len);
+    memcpy(rec->bssid, sender, MAC_ADDR_LEN);
+    rec->frame_type = type;
+    rec->channel = channel;
+    rec->rssi = htole32(rssi);
+    rec->tsf = htole64(current_tsf);
+    rec->frame_len = htole16(len);
+    memcpy(rec->frame, frame, len);
+    scan_batch_len += rec_len;
+
+    if (++event->count == UINT8_MAX) {
+        scan_batch_flush();
+    }
+
+out:
+    xSemaphoreGive(scan_batch_lock);
+    return handled;
+}
+
 static void handle_scan_event(void)
 {
     //uint32_t type = 0;
@@ -353,6 +608,9 @@ static void handle_scan_event(void)
     /*type = ~(1 << WLAN_FC_STYPE_BEACON) & ~(1 << WLAN_FC_STYPE_PROBE_RESP);*/
     /*esp_wifi_register_mgmt_frame_internal(type, 0);*/
 
+    /* Results go up before the scan done */
+    scan_batch_end();
+
     ret = prepare_event(ESP_STA_IF, &buf_handle, sizeof(struct event_header));
     if (ret) {
         ESP_LOGE(TAG, "%s: Failed to prepare event buffer\n", __func__);
@@ -583,6 +841,123 @@ static IRAM_ATTR void esp_wifi_tx_done_cb(uint8_t ifidx, uint8_t *data,
                                           uint16_t *len, bool txstatus)
 {
     if (ifidx == ESP_IF_WIFI_STA) {
+        if (!txstatus) {
+            sta_tx_failed++;
+        }
+    }
+}
+
+void sta_info_count_tx_retry(void)
+{
+    sta_tx_retries++;
+}
+
+/* Highest rate the link negotiated; there is no per-frame rate to report */
+static void sta_info_fill_rate(struct sta_info_event *event)
+{
+    wifi_phy_mode_t phymode = WIFI_PHY_MODE_11G;
+
+    esp_wifi_sta_get_negotiated_phymode(&phymode);
+
+    event->nss = 1;
+    event->bw_mhz = 20;
+
+    switch (phymode) {
+    case WIFI_PHY_MODE_HE20:
+        event->rate_mode = STA_INFO_RATE_HE;
+        event->mcs = 9;
+        break;
+    case WIFI_PHY_MODE_HT40:
+        event->bw_mhz = 40;
+        /* fall through */
+    case WIFI_PHY_MODE_HT20:
+        event->rate_mode = STA_INFO_RATE_HT;
+        event->mcs = 7;
+        break;
+    case WIFI_PHY_MODE_11B:
+        event->rate_mode = STA_INFO_RATE_LEGACY;
+        event->legacy_rate = htole16(110);
+        break;
+    case WIFI_PHY_MODE_LR:
+        event->rate_mode = STA_INFO_RATE_LEGACY;
+        event->legacy_rate = htole16(5);
+        break;
+    default:
+        /* 11g, 11a */
+        event->rate_mode = STA_INFO_RATE_LEGACY;
+        event->legacy_rate = htole16(540);
+        break;
+    }
+}
+
+static void sta_info_timer_cb(void *arg)
+{
+    interface_buffer_handle_t buf_handle = {0};
+    struct sta_info_event *event;
+    wifi_ap_record_t ap_info;
+    int8_t tx_power = 0;
+    esp_err_t ret;
+
+    if (!station_connected || esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return;
+    }
+    esp_wifi_get_max_tx_power(&tx_power);
+
+    ret = prepare_event(ESP_STA_IF, &buf_handle, sizeof(struct sta_info_event));
+    if (ret) {
+        ESP_LOGE(TAG, "%s: Failed to prepare event buffer\n", __func__);
+        return;
+    }
+
+    event = (struct sta_info_event *) buf_handle.payload;
+
+    event->header.event_code = EVENT_STA_INFO;
+    event->header.len = htole16(buf_handle.payload_len - sizeof(struct event_header));
+    event->header.status = 0;
+
+    memcpy(event->bssid, ap_info.bssid, MAC_ADDR_LEN);
+    event->rssi = ap_info.rssi;
+    event->tx_power = tx_power;
+    sta_info_fill_rate(event);
+    event->tx_retries = htole32(sta_tx_retries);
+    event->tx_failed = htole32(sta_tx_failed);
+    event->beacon_loss = htole32(sta_beacon_loss);
+
+    ret = send_command_event(&buf_handle);
+    if (ret != pdTRUE) {
+        ESP_LOGE(TAG, "Slave -> Host: Failed to send sta info event\n");
+        free(buf_handle.payload);
+    }
+}
+
+static void sta_info_start(void)
+{
+    esp_timer_create_args_t create_args = {
+        .callback = &sta_info_timer_cb,
+        .name = "sta_info",
+    };
+
+    if (!STA_INFO_INTERVAL_MS) {
+        return;
+    }
+
+    sta_tx_retries = 0;
+    sta_tx_failed = 0;
+    sta_beacon_loss = 0;
+
+    if (!sta_info_timer && esp_timer_create(&create_args, &sta_info_timer)) {
+        ESP_LOGE(TAG, "Failed to create sta info timer\n");
+        return;
+    }
+
+    esp_timer_stop(sta_info_timer);
+    esp_timer_start_periodic(sta_info_timer, STA_INFO_INTERVAL_MS * 1000);
+}
+
+static void sta_info_stop(void)
+{
+    if (sta_info_timer) {
+        esp_timer_stop(sta_info_timer);
     }
 }
 
@@ -619,6 +994,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             ESP_LOGE(TAG, "Failed to set rx cb\n");
         }
 
+        sta_info_start();
         break;
 
     case WIFI_EVENT_STA_DISCONNECTED:
@@ -635,11 +1011,16 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             sleep(1);
         }
 #endif
+        sta_info_stop();
         handle_sta_disconnected_event((wifi_event_sta_disconnected_t*) event_data, wakeup_flag);
         station_connected = 0;
         /*esp_wifi_internal_reg_rxcb(ESP_IF_WIFI_STA, NULL);*/
         break;
 
+    case WIFI_EVENT_STA_BEACON_TIMEOUT:
+        sta_beacon_loss++;
+        break;
+
     case WIFI_EVENT_SCAN_DONE:
         ESP_LOGI(TAG, "wifi scanning done");
         handle_scan_event();
@@ -657,6 +1038,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
 
     case WIFI_EVENT_STA_STOP:
         ESP_LOGI(TAG, "Station stop");
+        sta_info_stop();
         sta_init_flag = 0;
         break;
 
@@ -748,6 +1130,10 @@ static int sta_rx_probe(uint8_t type, uint8_t *frame, size_t len, uint8_t *sende
     ESP_LOG_BUFFER_HEXDUMP("MAC", sender, MAC_ADDR_LEN, ESP_LOG_INFO);
     */
 
+    if (scan_batch_add(type, frame, len, sender, rssi, channel, current_tsf)) {
+        return ESP_OK;
+    }
+
     ret = prepare_event(ESP_STA_IF, &buf_handle, sizeof(struct scan_event) + len);
     if (ret) {
         ESP_LOGE(TAG, "%s: Failed to prepare event buffer\n", __func__);
@@ -1024,6 +1410,11 @@ esp_err_t initialise_wifi(void)
 
     esp_wifi_set_debug_log();
 
+    if (!scan_batch_lock) {
+        scan_batch_lock = xSemaphoreCreateMutex();
+        assert(scan_batch_lock);
+    }
+
     /* Register to get events from wifi driver */
     esp_create_wifi_event_loop();
     /* Register callback functions with wifi driver */
@@ -1098,6 +1489,8 @@ int process_start_scan(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
     }
 
     if (sta_init_flag || softap_started) {
+        scan_batch_begin(scan_req->flags & SCAN_REQ_BATCH_RESULTS);
+
         /* Trigger scan */
         if (config_present) {
             ret = esp_wifi_scan_start(&params, false);
@@ -1108,6 +1501,7 @@ int process_start_scan(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
         if (ret) {
             ESP_LOGI(TAG, "Scan failed ret=[0x%x]\n", ret);
             cmd_status = CMD_RESPONSE_FAIL;
+            scan_batch_end();
 
             /* Reset frame registration */
             esp_wifi_register_mgmt_frame_internal(0, 0);
@@ -1136,10 +1530,29 @@ int process_set_mcast_mac_list(uint8_t if_type, uint8_t *payload, uint16_t paylo
 
     cmd_mcast_mac_list = (struct cmd_set_mcast_mac_addr *) payload;
 
+    /* Stop filtering on RX while the filter is rewritten */
+    mac_list.filter_rx = false;
+
     mac_list.count = cmd_mcast_mac_list->count;
+    if (mac_list.count > MAX_MULTICAST_ADDR_COUNT) {
+        mac_list.count = MAX_MULTICAST_ADDR_COUNT;
+    }
     memcpy(mac_list.mac_addr, cmd_mcast_mac_list->mcast_addr,
            sizeof(mac_list.mac_addr));
 
+    if (payload_len >= sizeof(struct cmd_set_mcast_mac_addr)) {
+        mac_list.mode = cmd_mcast_mac_list->mode;
+        memcpy(mac_list.hash, cmd_mcast_mac_list->mcast_hash,
+               sizeof(mac_list.hash));
+        mac_list.filter_rx = true;
+    } else {
+        /* Older host: exact list, wakeup only */
+        mac_list.mode = MCAST_FILTER_LIST;
+    }
+
+    ESP_LOGI(TAG, "Multicast filter: mode %u, %u addresses",
+             mac_list.mode, mac_list.count);
+
     /*ESP_LOG_BUFFER_HEXDUMP("MAC Filter", (uint8_t *) &mac_list, sizeof(mac_list), ESP_LOG_INFO);*/
 
     ret = send_command_resp(if_type, CMD_SET_MCAST_MAC_ADDR, CMD_RESPONSE_SUCCESS, NULL, 0, 0);
@@ -1241,11 +1654,117 @@ int process_reg_set(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
     return send_command_resp(if_type, CMD_SET_REG_DOMAIN, CMD_RESPONSE_SUCCESS, (uint8_t *)cmd->country_code, sizeof(cmd->country_code), 0);
 }
 
+static void ota_flash_task(void *arg)
+{
+    struct ota_flash_buf *buf;
+    esp_err_t ret;
+
+    for (;;) {
+        if (xQueueReceive(ota_full_bufs, &buf, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        if (ota_flash_err == ESP_OK) {
+            ret = esp_ota_write(handle, buf->data, buf->len);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "OTA update failed in OTA Write (%s)", esp_err_to_name(ret));
+                ota_flash_err = ret;
+            }
+        }
+
+        buf->len = 0;
+        xQueueSend(ota_free_bufs, &buf, portMAX_DELAY);
+    }
+}
+
+static int ota_flash_init(void)
+{
+    struct ota_flash_buf *buf;
+    int i;
+
+    if (ota_bufs) {
+        return 0;
+    }
+
+    ota_bufs = calloc(OTA_FLASH_BUF_COUNT, sizeof(struct ota_flash_buf));
+    ota_free_bufs = xQueueCreate(OTA_FLASH_BUF_COUNT, sizeof(struct ota_flash_buf *));
+    ota_full_bufs = xQueueCreate(OTA_FLASH_BUF_COUNT, sizeof(struct ota_flash_buf *));
+
+    if (!ota_bufs || !ota_free_bufs || !ota_full_bufs ||
+        xTaskCreate(ota_flash_task, "ota_flash_task", TASK_DEFAULT_STACK_SIZE,
+                    NULL, TASK_DEFAULT_PRIO - 1, NULL) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed to set up OTA flash buffers");
+        if (ota_free_bufs) {
+            vQueueDelete(ota_free_bufs);
+        }
+        if (ota_full_bufs) {
+            vQueueDelete(ota_full_bufs);
+        }
+        free(ota_bufs);
+        ota_bufs = NULL;
+        ota_free_bufs = ota_full_bufs = NULL;
+        return -1;
+    }
+
+    for (i = 0; i < OTA_FLASH_BUF_COUNT; i++) {
+        buf = &ota_bufs[i];
+        xQueueSend(ota_free_bufs, &buf, 0);
+    }
+
+    return 0;
+}
+
+/* Hands the partly filled buffer to the flash task and waits for it to
+ * finish everything queued. Returns the first flash error, if any. */
+static esp_err_t ota_flash_sync(void)
+{
+    struct ota_flash_buf *bufs[OTA_FLASH_BUF_COUNT];
+    int i;
+
+    if (!ota_fill) {
+        return ota_flash_err;
+    }
+
+    if (ota_fill->len) {
+        xQueueSend(ota_full_bufs, &ota_fill, portMAX_DELAY);
+    } else {
+        xQueueSend(ota_free_bufs, &ota_fill, portMAX_DELAY);
+    }
+    ota_fill = NULL;
+
+    /* Idle once every buffer is back */
+    for (i = 0; i < OTA_FLASH_BUF_COUNT; i++) {
+        xQueueReceive(ota_free_bufs, &bufs[i], portMAX_DELAY);
+    }
+    for (i = 0; i < OTA_FLASH_BUF_COUNT; i++) {
+        xQueueSend(ota_free_bufs, &bufs[i], 0);
+    }
+
+    return ota_flash_err;
+}
+
+static void ota_flash_abort(void)
+{
+    ota_flash_sync();
+    if (ota_active) {
+        esp_ota_abort(handle);
+        ota_active = false;
+    }
+}
+
 int process_ota_start(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
 {
     uint16_t cmd_status = CMD_RESPONSE_SUCCESS;
     esp_err_t ret = ESP_OK;
 
+    if (ota_flash_init()) {
+        cmd_status = CMD_RESPONSE_FAIL;
+        goto send_resp;
+    }
+
+    /* A previous update the host gave up on */
+    ota_flash_abort();
+
     update_partition = esp_ota_get_next_update_partition(NULL);
     if (update_partition == NULL) {
         ESP_LOGE(TAG, "Failed to get next update partition");
@@ -1260,6 +1779,11 @@ int process_ota_start(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
         goto send_resp;
     }
 
+    ota_active = true;
+    ota_flash_err = ESP_OK;
+    verify_ota = false;
+    xQueueReceive(ota_free_bufs, &ota_fill, portMAX_DELAY);
+
     ESP_LOGI(TAG, "ESP OTA begin start");
 
 send_resp:
@@ -1284,31 +1808,58 @@ int verify_ota_image_header(char *binary_image)
 
 int process_ota_write(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
 {
-    esp_err_t ret = ESP_OK;
     struct cmd_ota_update_request *cmd;
     uint8_t cmd_status = CMD_RESPONSE_SUCCESS;
+    uint16_t len, n;
+    uint8_t *data;
 
     cmd = (struct cmd_ota_update_request *)(payload);
 
+    if (!ota_active || !ota_fill || ota_flash_err != ESP_OK) {
+        goto fail;
+    }
+
+    if (payload_len < sizeof(*cmd) ||
+        cmd->ota_binary_len > payload_len - sizeof(*cmd)) {
+        ESP_LOGE(TAG, "OTA write of %u bytes in %u byte command",
+                 cmd->ota_binary_len, payload_len);
+        ota_flash_err = ESP_ERR_INVALID_SIZE;
+        goto fail;
+    }
+
     if (!verify_ota) {
-        ret = verify_ota_image_header(cmd->ota_binary);
-        if (ret != 0) {
+        if (verify_ota_image_header(cmd->ota_binary) != 0) {
+            ota_flash_err = ESP_ERR_INVALID_ARG;
             goto fail;
         }
     }
 
-    ret = esp_ota_write(handle, (const void *)cmd->ota_binary,
-                        cmd->ota_binary_len);
+    data = (uint8_t *)cmd->ota_binary;
+    len = cmd->ota_binary_len;
 
-fail:
-    if (ret) {
-        esp_ota_abort(handle);
-        ESP_LOGE(TAG, "OTA update failed in OTA Write");
-        cmd_status = CMD_RESPONSE_FAIL;
+    while (len) {
+        n = OTA_FLASH_BUF_SIZE - ota_fill->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(ota_fill->data + ota_fill->len, data, n);
+        ota_fill->len += n;
+        data += n;
+        len -= n;
+
+        /* Blocks only while the other buffer is still being flashed */
+        if (ota_fill->len == OTA_FLASH_BUF_SIZE) {
+            xQueueSend(ota_full_bufs, &ota_fill, portMAX_DELAY);
+            xQueueReceive(ota_free_bufs, &ota_fill, portMAX_DELAY);
+        }
     }
 
-    ret = send_command_resp(if_type, CMD_START_OTA_WRITE, cmd_status, NULL, 0, 0);
-    return ret;
+    return send_command_resp(if_type, CMD_START_OTA_WRITE, cmd_status, NULL, 0, 0);
+
+fail:
+    ESP_LOGE(TAG, "OTA update failed in OTA Write");
+    cmd_status = CMD_RESPONSE_FAIL;
+    return send_command_resp(if_type, CMD_START_OTA_WRITE, cmd_status, NULL, 0, 0);
 }
 
 static void esp_reset_callback(TimerHandle_t xTimer)
@@ -1323,6 +1874,20 @@ int process_ota_end(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
     uint8_t cmd_status = CMD_RESPONSE_SUCCESS;
     TimerHandle_t xTimer = NULL;
 
+    if (!ota_active) {
+        ESP_LOGE(TAG, "OTA end without OTA begin");
+        cmd_status = CMD_RESPONSE_FAIL;
+        goto fail;
+    }
+
+    ret = ota_flash_sync();
+    if (ret != ESP_OK) {
+        ota_flash_abort();
+        cmd_status = CMD_RESPONSE_FAIL;
+        goto fail;
+    }
+
+    ota_active = false;
     ret = esp_ota_end(handle);
     if (ret != ESP_OK) {
         if (ret == ESP_ERR_OTA_VALIDATE_FAILED) {
@@ -2028,7 +2593,8 @@ send_resp:
     return ret;
 }
 
-static int send_mgmt_tx_done(uint8_t cmd_status, wifi_interface_t wifi_if_type, uint8_t *data, uint32_t len);
+static int send_mgmt_tx_done(uint8_t cmd_status, wifi_interface_t wifi_if_type,
+                             uint8_t *data, uint32_t len, uint16_t seq);
 
 uint8_t *esp_wifi_get_eb_data(void *eb);
 uint32_t esp_wifi_get_eb_data_len(void *eb);
@@ -2048,7 +2614,8 @@ static void mgmt_txcb(void *eb)
 
     ieee80211_tx_mgt_cb(eb);
     if (!IS_BROADCAST_ADDR(data + 4)) {
-        send_mgmt_tx_done(cmd_status, WIFI_IF_AP, data, len);
+        send_mgmt_tx_done(cmd_status, WIFI_IF_AP, data, len,
+                          mgmt_tx_seq_pop(data + 4));
     }
     ESP_LOGD(TAG, "tx cb status=%d data_len=%ld\n", cmd_status, len);
     /* ESP_LOG_BUFFER_HEXDUMP(TAG, data, len, ESP_LOG_INFO); */
@@ -2130,7 +2697,8 @@ send_resp:
     return ret;
 }
 
-static int send_mgmt_tx_done(uint8_t cmd_status, wifi_interface_t wifi_if_type, uint8_t *data, uint32_t len)
+static int send_mgmt_tx_done(uint8_t cmd_status, wifi_interface_t wifi_if_type,
+                             uint8_t *data, uint32_t len, uint16_t seq)
 {
     interface_buffer_handle_t buf_handle = {0};
     struct cmd_mgmt_tx *header;
@@ -2152,6 +2720,7 @@ static int send_mgmt_tx_done(uint8_t cmd_status, wifi_interface_t wifi_if_type,
     header = (struct cmd_mgmt_tx *) buf_handle.payload;
 
     header->header.cmd_code = CMD_MGMT_TX;
+    header->header.seq_num = seq;
     header->header.len = 0;
     header->header.cmd_status = cmd_status;
     if (len > TX_DONE_PREFIX) {
@@ -2211,9 +2780,10 @@ int process_mgmt_tx(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
         goto send_resp;
     }
     /* send response in separate ctx once done */
+    mgmt_tx_seq_push(mgmt_tx->buf + 4, cur_cmd_seq);
     return 0;
 send_resp:
-    return send_mgmt_tx_done(cmd_status, wifi_if_type, NULL, 0);
+    return send_mgmt_tx_done(cmd_status, wifi_if_type, NULL, 0, cur_cmd_seq);
 }
 
 int ieee80211_add_node(wifi_interface_t wifi_if_type, uint8_t *mac, uint16_t aid,
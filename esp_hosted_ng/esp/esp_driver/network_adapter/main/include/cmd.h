@@ -29,10 +29,27 @@ struct l2_ethhdr {
 struct macfilter_list {
     uint8_t count;
     uint8_t mac_addr[MAX_MULTICAST_ADDR_COUNT][MAC_ADDR_LEN];
+    uint8_t mode;
+    uint8_t hash[MCAST_HASH_BITS / 8];
+    /* Host sent a full filter: unmatched multicast is dropped on RX */
+    bool filter_rx;
 };
+/* Commands the host may have in flight, advertised at boot-up */
+#define CMD_WINDOW 4
+
 #define ETH_P_PAE 0x8E88 /* Port Access Entity (IEEE 802.1X) */
 #define ETH_P_EAPOL ETH_P_PAE
 
+/* EVENT_STA_INFO period, advertised at boot-up */
+#ifdef CONFIG_ESP_STA_INFO_INTERVAL_MS
+#define STA_INFO_INTERVAL_MS CONFIG_ESP_STA_INFO_INTERVAL_MS
+#else
+#define STA_INFO_INTERVAL_MS 0
+#endif
+
+void sta_info_count_tx_retry(void);
+/* seq_num of the request being handled, copied into its response */
+void set_cur_cmd_seq(uint16_t seq);
 int process_init_interface(uint8_t if_type, uint8_t *payload, uint16_t payload_len);
 int process_deinit_interface(uint8_t if_type, uint8_t *payload, uint16_t payload_len);
 int process_start_scan(uint8_t if_type, uint8_t *payload, uint16_t payload_len);
@@ -122,5 +122,6 @@ int32_t sdio_write_aggr(interface_handle_t *handle, uint8_t *payload,
                         uint16_t payload_len);
 #endif
 esp_err_t send_to_host(uint8_t prio_q_idx, interface_buffer_handle_t *buf_handle);
+void esp_stamp_tx_tag(struct esp_payload_header *header);
 esp_err_t send_bootup_event_to_host(uint8_t cap);
 #endif
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+
+#ifndef __WMM__H__
+#define __WMM__H__
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "adapter.h"
+
+/* Weighted round robin over the ESP_NUM_AC lanes of PRIO_Q_LOW.
+ * Not thread safe: use one per consumer task, or serialize the callers. */
+struct wmm_sched {
+    uint8_t cur;
+    uint8_t credit;
+};
+
+void wmm_sched_init(struct wmm_sched *s);
+/* Lane to serve next, -1 if all of @lanes are empty */
+int wmm_sched_next(struct wmm_sched *s, QueueHandle_t lanes[ESP_NUM_AC]);
+/* @frames left the lane wmm_sched_next() returned */
+void wmm_sched_charge(struct wmm_sched *s, uint16_t frames);
+
+/* Access category of an Ethernet frame from its IP DSCP, BE for
+ * anything else */
+uint8_t wmm_frame_ac(const uint8_t *frame, uint16_t len);
+
+#endif
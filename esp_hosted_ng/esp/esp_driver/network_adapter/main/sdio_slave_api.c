@@ -32,6 +32,7 @@
 #include "stats.h"
 #include "soc/gpio_reg.h"
 #include "esp_fw_version.h"
+#include "cmd.h"
 #include "esp_heap_caps.h"
 #include "esp_memory_utils.h"
 
@@ -342,6 +343,7 @@ static int32_t sdio_write(interface_handle_t *handle, interface_buffer_handle_t
     header->reserved2 = buf_handle->flag;
     header->offset = htole16(sizeof(struct esp_payload_header) + align_padding);
     header->packet_type = buf_handle->pkt_type;
+    esp_stamp_tx_tag(header);
 
 #if CONFIG_ESP_SDIO_CHECKSUM
     header->checksum = htole16(compute_checksum(sendbuf,
@@ -439,6 +441,18 @@ esp_err_t send_bootup_event_to_host(uint8_t cap)
     memcpy(pos, &rx_buf_sz, sizeof(rx_buf_sz));
     pos += sizeof(rx_buf_sz);             len += sizeof(rx_buf_sz);
 
+    /* TLV - Command window */
+    *pos = ESP_BOOTUP_CMD_WINDOW;         pos++; len++;
+    *pos = LENGTH_1_BYTE;                 pos++; len++;
+    *pos = CMD_WINDOW;                    pos++; len++;
+
+    /* TLV - Station info period */
+    *pos = ESP_BOOTUP_STA_INFO;           pos++; len++;
+    *pos = 2;                             pos++; len++;
+    uint16_t sta_info_ms = htole16(STA_INFO_INTERVAL_MS);
+    memcpy(pos, &sta_info_ms, sizeof(sta_info_ms));
+    pos += sizeof(sta_info_ms);           len += sizeof(sta_info_ms);
+
     /* TLV - FW data */
     *pos = ESP_BOOTUP_FW_DATA;            pos++; len++;
     *pos = sizeof(struct fw_data);        pos++; len++;
@@ -29,6 +29,7 @@
 #include "stats.h"
 #include "soc/gpio_reg.h"
 #include "esp_fw_version.h"
+#include "cmd.h"
 
 // de-assert HS signal on CS, instead of at end of transaction
 #if defined(CONFIG_ESP_SPI_DEASSERT_HS_ON_CS)
@@ -303,6 +304,18 @@ esp_err_t send_bootup_event_to_host(uint8_t cap)
     memcpy(pos, &rx_buf_sz, sizeof(rx_buf_sz));
     pos += sizeof(rx_buf_sz);             len += sizeof(rx_buf_sz);
 
+    /* TLV - Command window */
+    *pos = ESP_BOOTUP_CMD_WINDOW;         pos++; len++;
+    *pos = LENGTH_1_BYTE;                 pos++; len++;
+    *pos = CMD_WINDOW;                    pos++; len++;
+
+    /* TLV - Station info period */
+    *pos = ESP_BOOTUP_STA_INFO;           pos++; len++;
+    *pos = 2;                             pos++; len++;
+    uint16_t sta_info_ms = htole16(STA_INFO_INTERVAL_MS);
+    memcpy(pos, &sta_info_ms, sizeof(sta_info_ms));
+    pos += sizeof(sta_info_ms);           len += sizeof(sta_info_ms);
+
     /* TLV - FW data */
     *pos = ESP_BOOTUP_FW_DATA;            pos++; len++;
     *pos = sizeof(struct fw_data);        pos++; len++;
@@ -796,6 +809,7 @@ static int32_t esp_spi_write(interface_handle_t *handle, interface_buffer_handle
     header->offset = htole16(sizeof(struct esp_payload_header) + align_padding);
     header->flags = buf_handle->flag;
     header->packet_type = buf_handle->pkt_type;
+    esp_stamp_tx_tag(header);
 
 #if CONFIG_ESP_SPI_CHECKSUM
     header->checksum = htole16(compute_checksum(tx_buf_handle.payload,
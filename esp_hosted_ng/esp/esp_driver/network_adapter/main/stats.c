@@ -294,6 +294,7 @@ int process_raw_tp(uint8_t if_type, uint8_t *payload, uint16_t payload_len)
     }
 
     resp_header->cmd_code = header->cmd_code;
+    resp_header->seq_num = header->seq_num;
     resp_header->len = 0;
     resp_header->cmd_status = CMD_RESPONSE_SUCCESS;
 
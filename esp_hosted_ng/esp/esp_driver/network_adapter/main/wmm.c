@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+//
+
+/* WMM access-category lanes for Wi-Fi data going to the host.
+ *
+ * Received frames are classified by DSCP into BE/BK/VI/VO lanes with the
+ * same mapping the host uses (esp_dscp_to_up() in adapter.h), and the
+ * transport drains them VO, VI, BE, BK at 8:4:2:1 frames per turn, the same
+ * weights the host uses towards us. A voice frame then waits for at most
+ * one aggregate of bulk data instead of a full queue of it.
+ */
+
+#include "wmm.h"
+
+#define ETH_HDR_LEN            14
+#define ETH_TYPE_IPV4          0x0800
+#define ETH_TYPE_IPV6          0x86DD
+
+/* Service order, and frames per turn at each position */
+static const uint8_t wmm_order[ESP_NUM_AC] = {
+    ESP_AC_VO, ESP_AC_VI, ESP_AC_BE, ESP_AC_BK
+};
+static const uint8_t wmm_weight[ESP_NUM_AC] = { 8, 4, 2, 1 };
+
+void wmm_sched_init(struct wmm_sched *s)
+{
+    s->cur = 0;
+    s->credit = wmm_weight[0];
+}
+
+int wmm_sched_next(struct wmm_sched *s, QueueHandle_t lanes[ESP_NUM_AC])
+{
+    uint8_t ac;
+    int i;
+
+    for (i = 0; i <= ESP_NUM_AC; i++) {
+        ac = wmm_order[s->cur];
+        if (s->credit && uxQueueMessagesWaiting(lanes[ac])) {
+            return ac;
+        }
+
+        /* Turn used up, or nothing to send: next lane, full share */
+        s->cur = (s->cur + 1) % ESP_NUM_AC;
+        s->credit = wmm_weight[s->cur];
+    }
+
+    return -1;
+}
+
+void wmm_sched_charge(struct wmm_sched *s, uint16_t frames)
+{
+    s->credit = frames < s->credit ? s->credit - frames : 0;
+}
+
+uint8_t wmm_frame_ac(const uint8_t *frame, uint16_t len)
+{
+    uint16_t eth_type;
+    uint8_t tos;
+
+    if (!frame || len < ETH_HDR_LEN + 2) {
+        return ESP_AC_BE;
+    }
+
+    eth_type = (frame[12] << 8) | frame[13];
+    if (eth_type == ETH_TYPE_IPV4) {
+        tos = frame[ETH_HDR_LEN + 1];
+    } else if (eth_type == ETH_TYPE_IPV6) {
+        tos = ((frame[ETH_HDR_LEN] & 0x0f) << 4) | (frame[ETH_HDR_LEN + 1] >> 4);
+    } else {
+        return ESP_AC_BE;
+    }
+
+    return esp_up_to_ac(esp_dscp_to_up(tos >> 2));
+}
@@ -293,8 +293,9 @@ struct wireless_dev *esp_cfg80211_add_iface(struct wiphy *wiphy,
 		return NULL;
 	}
 
-	ndev = ALLOC_NETDEV(sizeof(struct esp_wifi_device), name, name_assign_type,
-			ether_setup);
+	/* One TX queue per access category */
+	ndev = ALLOC_NETDEV_MQS(sizeof(struct esp_wifi_device), name, name_assign_type,
+			ether_setup, ESP_NUM_AC, 1);
 
 	if (!ndev)
 		return ERR_PTR(-ENOMEM);
@@ -317,6 +318,8 @@ struct wireless_dev *esp_cfg80211_add_iface(struct wiphy *wiphy,
 	esp_wdev->wdev.iftype = type;
 
 	init_waitqueue_head(&esp_wdev->wait_for_scan_completion);
+	spin_lock_init(&esp_wdev->sta_info_lock);
+	esp_wdev->sta_info_valid = false;
 	esp_wdev->stop_data = 1;
 	esp_wdev->port_open = 0;
 
@@ -780,9 +783,87 @@ static int esp_cfg80211_set_tx_power(struct wiphy *wiphy,
                 esp_warn("unknown type:%d\n", type);
         }
 
+	/* The cached value is the old setting until the next report */
+	esp_invalidate_sta_info(priv);
+
 	return cmd_set_tx_power(priv, priv->tx_pwr);
 }
 
+static void esp_sta_info_rate(const struct sta_info_event *info,
+			      struct rate_info *rate)
+{
+	memset(rate, 0, sizeof(*rate));
+
+	switch (info->rate_mode) {
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0))
+	case STA_INFO_RATE_HE:
+		rate->flags = RATE_INFO_FLAGS_HE_MCS;
+		rate->mcs = info->mcs;
+		rate->nss = info->nss;
+		rate->he_gi = NL80211_RATE_INFO_HE_GI_0_8;
+		break;
+#endif
+	case STA_INFO_RATE_HT:
+		rate->flags = RATE_INFO_FLAGS_MCS;
+		/* HT MCS index spans all streams */
+		rate->mcs = info->mcs + 8 * (max_t(u8, info->nss, 1) - 1);
+		if (info->short_gi)
+			rate->flags |= RATE_INFO_FLAGS_SHORT_GI;
+		break;
+	default:
+		rate->legacy = le16_to_cpu(info->legacy_rate);
+		break;
+	}
+
+	rate->bw = info->bw_mhz == 40 ? RATE_INFO_BW_40 : RATE_INFO_BW_20;
+}
+
+/* From the EVENT_STA_INFO cache when it is fresh, which costs no command.
+ * Otherwise only the RSSI is fetched from the firmware, as before. */
+static void esp_fill_station_info(struct esp_wifi_device *priv,
+				  struct station_info *sinfo)
+{
+	struct sta_info_event info;
+	bool cached;
+
+	cached = esp_get_sta_info(priv, &info);
+	if (!cached)
+		cmd_get_rssi(priv);
+
+	sinfo->filled |= BIT(NL80211_STA_INFO_SIGNAL);
+	sinfo->signal = cached ? info.rssi : priv->rssi;
+
+	sinfo->filled |= BIT(NL80211_STA_INFO_RX_BYTES);
+	sinfo->rx_bytes = priv->stats.rx_bytes;
+	sinfo->filled |= BIT(NL80211_STA_INFO_RX_PACKETS);
+	sinfo->rx_packets = priv->stats.rx_packets;
+
+	sinfo->filled |= BIT(NL80211_STA_INFO_TX_BYTES);
+	sinfo->tx_bytes = priv->stats.tx_bytes;
+	sinfo->filled |= BIT(NL80211_STA_INFO_TX_PACKETS);
+	sinfo->tx_packets = priv->stats.tx_packets;
+
+	sinfo->filled |= BIT(NL80211_STA_INFO_TX_FAILED);
+	sinfo->tx_failed = priv->stats.tx_dropped;
+
+	if (!cached)
+		return;
+
+	/* Dropped on the host plus not acked over the air */
+	sinfo->tx_failed += le32_to_cpu(info.tx_failed);
+
+	sinfo->filled |= BIT(NL80211_STA_INFO_TX_RETRIES);
+	sinfo->tx_retries = le32_to_cpu(info.tx_retries);
+
+	sinfo->filled |= BIT(NL80211_STA_INFO_BEACON_LOSS);
+	sinfo->beacon_loss_count = le32_to_cpu(info.beacon_loss);
+
+	sinfo->filled |= BIT(NL80211_STA_INFO_TX_BITRATE);
+	esp_sta_info_rate(&info, &sinfo->txrate);
+	sinfo->filled |= BIT(NL80211_STA_INFO_RX_BITRATE);
+	esp_sta_info_rate(&info, &sinfo->rxrate);
+}
+
 static int esp_cfg80211_get_station(struct wiphy *wiphy, struct net_device *ndev,
 				    const u8 *mac, struct station_info *sinfo)
 {
@@ -794,25 +875,31 @@ static int esp_cfg80211_get_station(struct wiphy *wiphy, struct net_device *ndev
 		esp_err("mac=%p priv=%p\n", mac, priv);
 		return -ENOENT;
 	}
-	if (wireless_dev_current_bss_exists(&priv->wdev)) {
+	if (wireless_dev_current_bss_exists(&priv->wdev))
+		esp_fill_station_info(priv, sinfo);
 
-		sinfo->filled |= BIT(NL80211_STA_INFO_SIGNAL);
-		cmd_get_rssi(priv);
-		sinfo->signal = priv->rssi;
+	return 0;
+}
+
+/* A station interface has a single peer, its AP */
+static int esp_cfg80211_dump_station(struct wiphy *wiphy, struct net_device *ndev,
+				     int idx, u8 *mac, struct station_info *sinfo)
+{
+	struct esp_wifi_device *priv = netdev_priv(ndev);
+	struct sta_info_event info;
 
-		sinfo->filled |= BIT(NL80211_STA_INFO_RX_BYTES);
-		sinfo->rx_bytes = priv->stats.rx_bytes;
-		sinfo->filled |= BIT(NL80211_STA_INFO_RX_PACKETS);
-		sinfo->rx_packets = priv->stats.rx_packets;
+	if (!priv || idx || priv->if_type != ESP_STA_IF ||
+	    !wireless_dev_current_bss_exists(&priv->wdev))
+		return -ENOENT;
 
-		sinfo->filled |= BIT(NL80211_STA_INFO_TX_BYTES);
-		sinfo->tx_bytes = priv->stats.tx_bytes;
-		sinfo->filled |= BIT(NL80211_STA_INFO_TX_PACKETS);
-		sinfo->tx_packets = priv->stats.tx_packets;
+	if (esp_get_sta_info(priv, &info))
+		ether_addr_copy(mac, info.bssid);
+	else if (priv->bss)
+		ether_addr_copy(mac, priv->bss->bssid);
+	else
+		return -ENOENT;
 
-		sinfo->filled |= BIT(NL80211_STA_INFO_TX_FAILED);
-		sinfo->tx_failed = priv->stats.tx_dropped;
-	}
+	esp_fill_station_info(priv, sinfo);
 
 	return 0;
 }
@@ -828,6 +915,7 @@ static int esp_cfg80211_get_tx_power(struct wiphy *wiphy,
 				     int *dbm)
 {
 	struct esp_wifi_device *priv = NULL;
+	struct sta_info_event info;
 
 	if (!wiphy || !wdev || !dbm || !wdev->netdev) {
 		esp_info("%u invalid input\n", __LINE__);
@@ -841,8 +929,11 @@ static int esp_cfg80211_get_tx_power(struct wiphy *wiphy,
 		esp_err("Empty priv\n");
 		return -EINVAL;
 	}
-	/* Update Tx power from firmware */
-	cmd_get_tx_power(priv);
+	/* Update Tx power from firmware, unless the station info has it */
+	if (!esp_get_sta_info(priv, &info))
+		cmd_get_tx_power(priv);
+	else
+		priv->tx_pwr = info.tx_power;
 
 	*dbm = esp_pwr_to_dbm(priv->tx_pwr);
 
@@ -1136,6 +1227,7 @@ static struct cfg80211_ops esp_cfg80211_ops = {
 	.add_station = esp_cfg80211_add_station,
 	.change_station = esp_cfg80211_change_station,
 	.get_station = esp_cfg80211_get_station,
+	.dump_station = esp_cfg80211_dump_station,
 	.set_ap_chanwidth = esp_cfg80211_set_ap_chanwidth
 };
 
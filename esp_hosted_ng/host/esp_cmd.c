@@ -16,9 +16,18 @@
 #include "esp_stats.h"
 
 #define COMMAND_RESPONSE_TIMEOUT (5 * HZ)
+/* OTA begin erases the partition, OTA end verifies the image; a write may
+ * wait behind a flash sector erase on the slave */
+#define COMMAND_OTA_TIMEOUT      (20 * HZ)
 u8 ap_bssid[MAC_ADDR_LEN];
 extern u32 raw_tp_mode;
 
+/* Upper bound on commands in flight; the firmware's own limit applies too.
+ * Firmware that does not advertise one gets a single command at a time. */
+static unsigned int cmd_window = 4;
+module_param(cmd_window, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(cmd_window, "Max firmware commands in flight");
+
 static int handle_mgmt_tx_done(struct esp_wifi_device *priv,
 				struct command_node *cmd_node);
 static void recycle_cmd_node(struct esp_adapter *adapter,
@@ -57,6 +66,8 @@ static struct command_node *get_free_cmd_node(struct esp_adapter *adapter)
 	}
 
 	cmd_node->in_cmd_queue = true;
+	cmd_node->in_flight = false;
+	reinit_completion(&cmd_node->done);
 
 	return cmd_node;
 }
@@ -70,8 +81,15 @@ static inline void reset_cmd_node(struct esp_adapter *adapter, struct command_no
 		spin_lock_bh(&adapter->cmd_pending_queue_lock);
 		list_del(&cmd_node->list);
 		spin_unlock_bh(&adapter->cmd_pending_queue_lock);
+		cmd_node->in_cmd_queue = false;
+	}
+	if (cmd_node->in_flight) {
+		list_del(&cmd_node->list);
+		cmd_node->in_flight = false;
+		adapter->cmd_inflight_cnt--;
 	}
 	cmd_node->cmd_code = 0;
+	cmd_node->seq = 0;
 	if (cmd_node->cmd_skb) {
 		dev_kfree_skb_any(cmd_node->cmd_skb);
 		cmd_node->cmd_skb = NULL;
@@ -254,6 +272,7 @@ static int wait_and_decode_cmd_resp(struct esp_wifi_device *priv,
 		struct command_node *cmd_node)
 {
 	struct esp_adapter *adapter = NULL;
+	struct sk_buff *resp_skb;
 	int ret = 0;
 
 	if (!priv || !priv->adapter || !cmd_node) {
@@ -269,24 +288,41 @@ static int wait_and_decode_cmd_resp(struct esp_wifi_device *priv,
 	adapter = priv->adapter;
 
 	/* wait for command response */
-	ret = wait_event_interruptible_timeout(adapter->wait_for_cmd_resp,
-			adapter->cmd_resp == cmd_node->cmd_code, COMMAND_RESPONSE_TIMEOUT);
+	ret = wait_for_completion_interruptible_timeout(&cmd_node->done,
+			cmd_node->timeout);
 
 	if (!test_bit(ESP_DRIVER_ACTIVE, &adapter->state_flags))
 		return 0;
 
-	if (ret == 0) {
-		esp_err("Command[0x%X] timed out\n", cmd_node->cmd_code);
-		ret = -EINVAL;
-	} else {
-		esp_verbose("Resp for command [0x%X]\n", cmd_node->cmd_code);
+	spin_lock_bh(&adapter->cmd_lock);
+	if (cmd_node->in_flight) {
+		/* No response: free the window slot */
+		list_del(&cmd_node->list);
+		cmd_node->in_flight = false;
+		adapter->cmd_inflight_cnt--;
+	}
+	resp_skb = cmd_node->resp_skb;
+	spin_unlock_bh(&adapter->cmd_lock);
+
+	if (resp_skb) {
+		esp_verbose("Resp for command [0x%X] seq %u\n",
+				cmd_node->cmd_code, cmd_node->seq);
 		ret = 0;
+	} else {
+		if (ret == 0)
+			esp_err("Command[0x%X] seq %u timed out\n",
+					cmd_node->cmd_code, cmd_node->seq);
+		else if (ret < 0)
+			esp_err("Command[0x%X] seq %u interrupted\n",
+					cmd_node->cmd_code, cmd_node->seq);
+		else
+			esp_err("Command[0x%X] seq %u not sent\n",
+					cmd_node->cmd_code, cmd_node->seq);
+		ret = -EINVAL;
 	}
 
-	spin_lock_bh(&adapter->cmd_lock);
-	adapter->cur_cmd = NULL;
-	adapter->cmd_resp = 0;
-	spin_unlock_bh(&adapter->cmd_lock);
+	/* A slot may have opened for queued commands */
+	queue_work(adapter->cmd_wq, &adapter->cmd_work);
 
 	switch (cmd_node->cmd_code) {
 
@@ -402,18 +438,45 @@ static int alloc_esp_cmd_pool(struct esp_adapter *adapter)
 
 		cmd_pool[i].cmd_skb = NULL;
 		cmd_pool[i].resp_skb = NULL;
+		init_completion(&cmd_pool[i].done);
 		recycle_cmd_node(adapter, &cmd_pool[i]);
 	}
 
 	return 0;
 }
 
+static u8 esp_cmd_window(struct esp_adapter *adapter)
+{
+	u32 window = READ_ONCE(cmd_window);
+
+	if (!adapter->fw_cmd_window)
+		return 1;
+
+	return clamp_t(u32, window, 1, adapter->fw_cmd_window);
+}
+
+/* Send failed: wake the caller, unless it already gave up on @seq */
+static void esp_cmd_send_failed(struct esp_adapter *adapter,
+		struct command_node *cmd_node, u16 seq)
+{
+	spin_lock_bh(&adapter->cmd_lock);
+	if (cmd_node->in_flight && cmd_node->seq == seq) {
+		list_del(&cmd_node->list);
+		cmd_node->in_flight = false;
+		adapter->cmd_inflight_cnt--;
+		complete(&cmd_node->done);
+	}
+	spin_unlock_bh(&adapter->cmd_lock);
+}
+
 static void esp_cmd_work(struct work_struct *work)
 {
 	int ret;
 	struct command_node *cmd_node = NULL;
 	struct esp_adapter *adapter = NULL;
 	struct esp_payload_header *payload_header = NULL;
+	struct sk_buff *skb;
+	u16 seq;
 
 	adapter = esp_get_adapter();
 
@@ -424,82 +487,69 @@ static void esp_cmd_work(struct work_struct *work)
 		return;
 
 	synchronize_rcu();
-	spin_lock_bh(&adapter->cmd_lock);
-	if (adapter->cur_cmd) {
-		/* Busy in another command */
-		esp_verbose("Busy in another cmd execution\n");
-		spin_unlock_bh(&adapter->cmd_lock);
-		/* We should queue ourself here and remove the queuing from process_cmd_resp */
-		return;
-	}
 
-	spin_lock_bh(&adapter->cmd_pending_queue_lock);
+	/* Send in queue order until the window is full; each response or
+	 * timeout queues this work again */
+	for (;;) {
+		spin_lock_bh(&adapter->cmd_lock);
+		if (adapter->cmd_inflight_cnt >= esp_cmd_window(adapter)) {
+			esp_verbose("%u cmds in flight, wait\n", adapter->cmd_inflight_cnt);
+			spin_unlock_bh(&adapter->cmd_lock);
+			return;
+		}
 
-	if (list_empty(&adapter->cmd_pending_queue)) {
-		/* No command to process */
-		esp_verbose("No more command in queue.\n");
-		spin_unlock_bh(&adapter->cmd_pending_queue_lock);
-		spin_unlock_bh(&adapter->cmd_lock);
-		return;
-	}
+		spin_lock_bh(&adapter->cmd_pending_queue_lock);
 
-	cmd_node = list_first_entry(&adapter->cmd_pending_queue,
-				    struct command_node, list);
-	if (!cmd_node) {
-		esp_dbg("cmd node NULL\n");
-		spin_unlock_bh(&adapter->cmd_pending_queue_lock);
-		spin_unlock_bh(&adapter->cmd_lock);
-		return;
-	}
-	esp_verbose("Processing Command [0x%X]\n", cmd_node->cmd_code);
+		if (list_empty(&adapter->cmd_pending_queue)) {
+			/* No command to process */
+			esp_verbose("No more command in queue.\n");
+			spin_unlock_bh(&adapter->cmd_pending_queue_lock);
+			spin_unlock_bh(&adapter->cmd_lock);
+			return;
+		}
 
-	list_del(&cmd_node->list);
-	cmd_node->in_cmd_queue = false;
+		cmd_node = list_first_entry(&adapter->cmd_pending_queue,
+					    struct command_node, list);
+		esp_verbose("Processing Command [0x%X] seq %u\n",
+				cmd_node->cmd_code, cmd_node->seq);
 
-	/* this should never happen */
-	if (!cmd_node->cmd_skb || !cmd_node->cmd_code) {
-		esp_warn("cmd_node->cmd_skb =%p , cmd_code=[0x%X]\n", cmd_node->cmd_skb, cmd_node->cmd_code);
+		list_del(&cmd_node->list);
+		cmd_node->in_cmd_queue = false;
 		spin_unlock_bh(&adapter->cmd_pending_queue_lock);
-		spin_unlock_bh(&adapter->cmd_lock);
-		recycle_cmd_node(adapter, cmd_node);
-		return;
-	}
-
-	/* Set as current cmd */
-	adapter->cur_cmd = cmd_node;
-
-	adapter->cmd_resp = 0;
 
-	payload_header = (struct esp_payload_header *)cmd_node->cmd_skb->data;
-	if (adapter->capabilities & ESP_CHECKSUM_ENABLED)
-		payload_header->checksum = cpu_to_le16(compute_checksum(cmd_node->cmd_skb->data,
-					payload_header->len+payload_header->offset));
+		/* this should never happen */
+		if (!cmd_node->cmd_skb || !cmd_node->cmd_code) {
+			esp_warn("cmd_node->cmd_skb =%p , cmd_code=[0x%X]\n", cmd_node->cmd_skb, cmd_node->cmd_code);
+			/* The caller wakes up without a response and recycles it */
+			complete(&cmd_node->done);
+			spin_unlock_bh(&adapter->cmd_lock);
+			continue;
+		}
 
-	ret = esp_send_packet(adapter, cmd_node->cmd_skb);
+		list_add_tail(&cmd_node->list, &adapter->cmd_inflight);
+		cmd_node->in_flight = true;
+		adapter->cmd_inflight_cnt++;
 
-	if (ret) {
-		esp_err("Failed to send command [0x%X]\n", cmd_node->cmd_code);
-		if (adapter->if_ops && adapter->if_ops->write)
-			cmd_node->cmd_skb = NULL;
-		adapter->cur_cmd = NULL;
-		spin_unlock_bh(&adapter->cmd_pending_queue_lock);
+		/* The transport owns the skb from here */
+		skb = cmd_node->cmd_skb;
+		cmd_node->cmd_skb = NULL;
+		seq = cmd_node->seq;
 		spin_unlock_bh(&adapter->cmd_lock);
-		recycle_cmd_node(adapter, cmd_node);
-		return;
-	}
 
-	cmd_node->cmd_skb = NULL;
+		payload_header = (struct esp_payload_header *)skb->data;
+		if (adapter->capabilities & ESP_CHECKSUM_ENABLED)
+			payload_header->checksum = cpu_to_le16(compute_checksum(skb->data,
+						payload_header->len+payload_header->offset));
 
-	if (!list_empty(&adapter->cmd_pending_queue)) {
-		esp_verbose("Pending cmds, queue work again\n");
-		spin_unlock_bh(&adapter->cmd_pending_queue_lock);
-		spin_unlock_bh(&adapter->cmd_lock);
-                /* should we wait before queuing the work again? */
-		queue_work(adapter->cmd_wq, &adapter->cmd_work);
-		return;
+		ret = esp_send_packet(adapter, skb);
+
+		if (ret) {
+			esp_err("Failed to send command [0x%X]\n", cmd_node->cmd_code);
+			if (!adapter->if_ops || !adapter->if_ops->write)
+				dev_kfree_skb_any(skb);
+			esp_cmd_send_failed(adapter, cmd_node, seq);
+		}
 	}
-	spin_unlock_bh(&adapter->cmd_pending_queue_lock);
-	spin_unlock_bh(&adapter->cmd_lock);
 }
 
 static int create_cmd_wq(struct esp_adapter *adapter)
@@ -526,6 +576,18 @@ static void destroy_cmd_wq(struct esp_adapter *adapter)
 
 }
 
+static unsigned long esp_cmd_timeout(u8 cmd_code)
+{
+	switch (cmd_code) {
+	case CMD_START_OTA_UPDATE:
+	case CMD_START_OTA_WRITE:
+	case CMD_START_OTA_END:
+		return COMMAND_OTA_TIMEOUT;
+	default:
+		return COMMAND_RESPONSE_TIMEOUT;
+	}
+}
+
 static struct command_node *prepare_command_request(struct esp_adapter *adapter, u8 cmd_code, u16 len)
 {
 	struct command_header *cmd;
@@ -564,6 +626,14 @@ static struct command_node *prepare_command_request(struct esp_adapter *adapter,
 	}
 
 	node->cmd_code = cmd_code;
+	node->timeout = esp_cmd_timeout(cmd_code);
+
+	spin_lock_bh(&adapter->cmd_lock);
+	/* 0 is what firmware without seq_num support sends back */
+	if (!++adapter->cmd_seq)
+		adapter->cmd_seq = 1;
+	node->seq = adapter->cmd_seq;
+	spin_unlock_bh(&adapter->cmd_lock);
 
 	len += sizeof(struct esp_payload_header);
 
@@ -577,13 +647,34 @@ static struct command_node *prepare_command_request(struct esp_adapter *adapter,
 
 	cmd = (struct command_header *) (node->cmd_skb->data + payload_header->offset);
 	cmd->cmd_code = cmd_code;
+	cmd->seq_num = node->seq;
 
 /*	payload_header->checksum = cpu_to_le16(compute_checksum(skb->data, len));*/
 	return node;
 }
 
+/* Called with cmd_lock held. Firmware that echoes seq_num is matched on it;
+ * older firmware answers in order, so the oldest command of that code. */
+static struct command_node *find_inflight_cmd(struct esp_adapter *adapter,
+		struct command_header *header)
+{
+	struct command_node *cmd_node;
+
+	list_for_each_entry(cmd_node, &adapter->cmd_inflight, list) {
+		if (cmd_node->cmd_code != header->cmd_code)
+			continue;
+		if (!header->seq_num || cmd_node->seq == header->seq_num)
+			return cmd_node;
+	}
+
+	return NULL;
+}
+
 int process_cmd_resp(struct esp_adapter *adapter, struct sk_buff *skb)
 {
+	struct command_node *cmd_node;
+	struct command_header *header;
+
 	if (!skb || !adapter) {
 		esp_err("CMD resp: invalid!\n");
 
@@ -600,20 +691,25 @@ int process_cmd_resp(struct esp_adapter *adapter, struct sk_buff *skb)
 		return -1;
 	}
 
+	header = (struct command_header *) skb->data;
+
 	spin_lock_bh(&adapter->cmd_lock);
-	if (!adapter->cur_cmd) {
-		struct command_header *header = (struct command_header *) skb->data;
-		esp_err("Command response not expected=%d\n", header->cmd_code);
+	cmd_node = find_inflight_cmd(adapter, header);
+	if (!cmd_node) {
+		esp_err("Command response not expected=%d seq %u\n",
+				header->cmd_code, header->seq_num);
 		dev_kfree_skb_any(skb);
 		spin_unlock_bh(&adapter->cmd_lock);
 		return -1;
 	}
 
-	adapter->cur_cmd->resp_skb = skb;
-	adapter->cmd_resp = adapter->cur_cmd->cmd_code;
+	list_del(&cmd_node->list);
+	cmd_node->in_flight = false;
+	adapter->cmd_inflight_cnt--;
+	cmd_node->resp_skb = skb;
+	complete(&cmd_node->done);
 	spin_unlock_bh(&adapter->cmd_lock);
 
-	wake_up_interruptible(&adapter->wait_for_cmd_resp);
 	queue_work(adapter->cmd_wq, &adapter->cmd_work);
 
 	return 0;
@@ -652,8 +748,9 @@ static int handle_mgmt_tx_done(struct esp_wifi_device *priv,
 	return ret;
 }
 
-static void process_scan_result_event(struct esp_wifi_device *priv,
-		struct scan_event *scan_evt)
+/* Reports one beacon/probe response to cfg80211 */
+static void esp_inform_bss(struct esp_wifi_device *priv, const u8 *bssid,
+		u8 frame_subtype, u8 channel, s32 rssi, u8 *frame, u32 frame_len)
 {
 	struct cfg80211_bss *bss = NULL;
 	struct beacon_probe_fixed_params *fixed_params = NULL;
@@ -666,28 +763,13 @@ static void process_scan_result_event(struct esp_wifi_device *priv,
 	int freq;
 	int frame_type = CFG80211_BSS_FTYPE_UNKNOWN; /* int type for older compatibility */
 
-	if (!priv || !scan_evt) {
-		esp_err("Invalid arguments\n");
+	if (frame_len < sizeof(struct beacon_probe_fixed_params)) {
+		esp_info("Scan report: Skip short frame[%u]\n", frame_len);
 		return;
 	}
 
-	/*if (!priv->scan_in_progress) {
-		return;
-	}*/
-
-	/* End of scan; notify cfg80211 */
-	if (scan_evt->header.status == 0) {
-
-		ESP_MARK_SCAN_DONE(priv, false);
-		if (priv->waiting_for_scan_done) {
-			priv->waiting_for_scan_done = false;
-			wake_up_interruptible(&priv->wait_for_scan_completion);
-		}
-		return;
-	}
-
-	ie_buf = (u8 *) scan_evt->frame;
-	ie_len = le16_to_cpu(scan_evt->frame_len);
+	ie_buf = frame;
+	ie_len = frame_len;
 
 	fixed_params = (struct beacon_probe_fixed_params *) ie_buf;
 
@@ -695,27 +777,27 @@ static void process_scan_result_event(struct esp_wifi_device *priv,
 	beacon_interval = le16_to_cpu(fixed_params->beacon_interval);
 	cap_info = le16_to_cpu(fixed_params->cap_info);
 
-	if (scan_evt->channel > 14) {
-		freq = ieee80211_channel_to_frequency(scan_evt->channel, NL80211_BAND_5GHZ);
+	if (channel > 14) {
+		freq = ieee80211_channel_to_frequency(channel, NL80211_BAND_5GHZ);
 	} else {
-		freq = ieee80211_channel_to_frequency(scan_evt->channel, NL80211_BAND_2GHZ);
+		freq = ieee80211_channel_to_frequency(channel, NL80211_BAND_2GHZ);
 	}
 	chan = ieee80211_get_channel(priv->adapter->wiphy, freq);
 
 	ie_buf += sizeof(struct beacon_probe_fixed_params);
 	ie_len -= sizeof(struct beacon_probe_fixed_params);
 
-	if ((scan_evt->frame_type << 4) == IEEE80211_STYPE_BEACON) {
+	if ((frame_subtype << 4) == IEEE80211_STYPE_BEACON) {
 		frame_type = CFG80211_BSS_FTYPE_BEACON;
-	} else if ((scan_evt->frame_type << 4) == IEEE80211_STYPE_PROBE_RESP) {
+	} else if ((frame_subtype << 4) == IEEE80211_STYPE_PROBE_RESP) {
 		frame_type = CFG80211_BSS_FTYPE_PRESP;
 	}
 
 	if (chan && !(chan->flags & IEEE80211_CHAN_DISABLED)) {
 		bss = CFG80211_INFORM_BSS(priv->adapter->wiphy, chan,
-				frame_type, scan_evt->bssid, timestamp,
+				frame_type, bssid, timestamp,
 				cap_info, beacon_interval, ie_buf, ie_len,
-				(le32_to_cpu(scan_evt->rssi) * 100), GFP_ATOMIC);
+				(rssi * 100), GFP_ATOMIC);
 
 		if (bss)
 			cfg80211_put_bss(priv->adapter->wiphy, bss);
@@ -724,6 +806,69 @@ static void process_scan_result_event(struct esp_wifi_device *priv,
 	}
 }
 
+static void process_scan_result_event(struct esp_wifi_device *priv,
+		struct scan_event *scan_evt)
+{
+	if (!priv || !scan_evt) {
+		esp_err("Invalid arguments\n");
+		return;
+	}
+
+	/*if (!priv->scan_in_progress) {
+		return;
+	}*/
+
+	/* End of scan; notify cfg80211 */
+	if (scan_evt->header.status == 0) {
+
+		ESP_MARK_SCAN_DONE(priv, false);
+		if (priv->waiting_for_scan_done) {
+			priv->waiting_for_scan_done = false;
+			wake_up_interruptible(&priv->wait_for_scan_completion);
+		}
+		return;
+	}
+
+	esp_inform_bss(priv, scan_evt->bssid, scan_evt->frame_type,
+			scan_evt->channel, le32_to_cpu(scan_evt->rssi),
+			scan_evt->frame, le16_to_cpu(scan_evt->frame_len));
+}
+
+/* Walks the records of an EVENT_SCAN_RESULT_BATCH; @len is the event
+ * length as received */
+static void process_scan_batch_event(struct esp_wifi_device *priv,
+		struct scan_batch_event *event, u32 len)
+{
+	struct scan_result_record *rec;
+	u32 pos = sizeof(struct scan_batch_event);
+	u32 rec_len;
+	u16 frame_len;
+	u8 i;
+
+	if (len < sizeof(struct scan_batch_event)) {
+		esp_err("Short scan batch: %u\n", len);
+		return;
+	}
+
+	for (i = 0; i < event->count; i++) {
+		if (pos + sizeof(struct scan_result_record) > len)
+			break;
+
+		rec = (struct scan_result_record *) ((u8 *) event + pos);
+		frame_len = le16_to_cpu(rec->frame_len);
+		rec_len = ALIGN(sizeof(struct scan_result_record) + frame_len, 4);
+		if (pos + sizeof(struct scan_result_record) + frame_len > len)
+			break;
+
+		esp_inform_bss(priv, rec->bssid, rec->frame_type, rec->channel,
+				le32_to_cpu(rec->rssi), rec->frame, frame_len);
+		pos += rec_len;
+	}
+
+	if (i != event->count)
+		esp_err("Scan batch truncated: %u of %u records\n", i, event->count);
+}
+
 static void process_auth_event(struct esp_wifi_device *priv,
 		struct auth_event *event)
 {
@@ -792,6 +937,8 @@ static void process_disconnect_event(struct esp_wifi_device *priv,
 	esp_info("Disconnect event for ssid %s [reason:%d]\n",
 			event->ssid, event->reason);
 
+	esp_invalidate_sta_info(priv);
+
 	//esp_mark_disconnect(priv, event->reason, true);
 	/* Flush previous scan results from kernel */
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0))
@@ -845,6 +992,47 @@ static void process_assoc_event(struct esp_wifi_device *priv,
 	esp_port_open(priv);
 }
 
+static void process_sta_info_event(struct esp_wifi_device *priv,
+		struct sta_info_event *event)
+{
+	spin_lock_bh(&priv->sta_info_lock);
+	memcpy(&priv->sta_info, event, sizeof(*event));
+	priv->sta_info_jiffies = jiffies;
+	priv->sta_info_valid = true;
+	priv->rssi = event->rssi;
+	priv->tx_pwr = event->tx_power;
+	spin_unlock_bh(&priv->sta_info_lock);
+}
+
+/* Copy out the last EVENT_STA_INFO if it can stand in for a command round
+ * trip: a few periods of slack cover a busy event path. */
+bool esp_get_sta_info(struct esp_wifi_device *priv, struct sta_info_event *info)
+{
+	unsigned long max_age;
+	bool fresh;
+
+	if (!priv->adapter || !priv->adapter->sta_info_interval)
+		return false;
+
+	max_age = msecs_to_jiffies(3 * priv->adapter->sta_info_interval);
+
+	spin_lock_bh(&priv->sta_info_lock);
+	fresh = priv->sta_info_valid &&
+		time_before(jiffies, priv->sta_info_jiffies + max_age);
+	if (fresh)
+		memcpy(info, &priv->sta_info, sizeof(*info));
+	spin_unlock_bh(&priv->sta_info_lock);
+
+	return fresh;
+}
+
+void esp_invalidate_sta_info(struct esp_wifi_device *priv)
+{
+	spin_lock_bh(&priv->sta_info_lock);
+	priv->sta_info_valid = false;
+	spin_unlock_bh(&priv->sta_info_lock);
+}
+
 int process_cmd_event(struct esp_wifi_device *priv, struct sk_buff *skb)
 {
 	struct event_header *header;
@@ -863,6 +1051,11 @@ int process_cmd_event(struct esp_wifi_device *priv, struct sk_buff *skb)
 				(struct scan_event *)(skb->data));
 		break;
 
+	case EVENT_SCAN_RESULT_BATCH:
+		process_scan_batch_event(priv,
+				(struct scan_batch_event *)(skb->data), skb->len);
+		break;
+
 	case EVENT_ASSOC_RX:
 		process_assoc_event(priv,
 				(struct assoc_event *)(skb->data));
@@ -882,6 +1075,15 @@ int process_cmd_event(struct esp_wifi_device *priv, struct sk_buff *skb)
 				(struct mgmt_event *)(skb->data));
 		break;
 
+	case EVENT_STA_INFO:
+		if (skb->len < sizeof(struct sta_info_event)) {
+			esp_err("Short sta info event: %u\n", skb->len);
+			break;
+		}
+		process_sta_info_event(priv,
+				(struct sta_info_event *)(skb->data));
+		break;
+
 	default:
 		esp_info("%u unhandled event[%u]\n",
 				__LINE__, header->event_code);
@@ -918,6 +1120,9 @@ int cmd_set_mcast_mac_list(struct esp_wifi_device *priv, struct multicast_list *
 	cmd_mcast_mac_list->count = list->addr_count;
 	memcpy(cmd_mcast_mac_list->mcast_addr, list->mcast_addr,
 			sizeof(cmd_mcast_mac_list->mcast_addr));
+	cmd_mcast_mac_list->mode = list->mode;
+	memcpy(cmd_mcast_mac_list->mcast_hash, list->mcast_hash,
+			sizeof(cmd_mcast_mac_list->mcast_hash));
 
 	queue_cmd_node(priv->adapter, cmd_node, ESP_CMD_DFLT_PRIO);
 	queue_work(priv->adapter->cmd_wq, &priv->adapter->cmd_work);
@@ -1659,6 +1864,7 @@ int internal_scan_request(struct esp_wifi_device *priv, char *ssid,
 	}
 
 	scan_req->channel = channel;
+	scan_req->flags = SCAN_REQ_BATCH_RESULTS;
 
 	priv->scan_in_progress = true;
 
@@ -1724,6 +1930,7 @@ int cmd_scan_request(struct esp_wifi_device *priv, struct cfg80211_scan_request
 #if LINUX_VERSION_CODE > KERNEL_VERSION(4, 7, 0)
 	memcpy(scan_req->bssid, request->bssid, MAC_ADDR_LEN);
 #endif
+	scan_req->flags = SCAN_REQ_BATCH_RESULTS;
 
 	priv->scan_in_progress = true;
 	priv->request = request;
@@ -1764,40 +1971,46 @@ int cmd_process_ota_start(struct esp_wifi_device *priv)
 
 }
 
-int cmd_process_ota_write(struct esp_wifi_device *priv, char *ota_chunk, ssize_t nread)
+/* Queues one image chunk and returns without waiting, so several writes can
+ * be in flight; every returned node must be passed to cmd_ota_write_wait() */
+struct command_node *cmd_ota_write_queue(struct esp_wifi_device *priv,
+		const char *ota_chunk, size_t len)
 {
 	u16 cmd_len;
 	struct command_node *cmd_node = NULL;
-	struct cmd_ota_update_request * cmd_ota_req = NULL;
-
+	struct cmd_ota_update_request *cmd_ota_req = NULL;
 
-	if (!priv || !priv->adapter) {
+	if (!priv || !priv->adapter || !len || len > OTA_STREAM_CHUNK_SIZE) {
 		esp_err("Invalid argument\n");
-		return -EINVAL;
+		return NULL;
 	}
 
-	cmd_len = sizeof(struct cmd_ota_update_request) + nread;
+	cmd_len = sizeof(struct cmd_ota_update_request) + len;
 
 	cmd_node = prepare_command_request(priv->adapter, CMD_START_OTA_WRITE, cmd_len);
 
 	if (!cmd_node) {
 		esp_err("Failed to get command node\n");
-		return -ENOMEM;
+		return NULL;
 	}
 
 	cmd_ota_req = (struct cmd_ota_update_request *) (cmd_node->cmd_skb->data +
 			sizeof(struct esp_payload_header));
 
-	cmd_ota_req->ota_binary_len = nread;
-	memcpy(cmd_ota_req->ota_binary, ota_chunk, nread);
+	cmd_ota_req->ota_binary_len = len;
+	memcpy(cmd_ota_req->ota_binary, ota_chunk, len);
 
 	queue_cmd_node(priv->adapter, cmd_node, ESP_CMD_DFLT_PRIO);
 	queue_work(priv->adapter->cmd_wq, &priv->adapter->cmd_work);
 
+	return cmd_node;
+}
+
+int cmd_ota_write_wait(struct esp_wifi_device *priv, struct command_node *cmd_node)
+{
 	RET_ON_FAIL(wait_and_decode_cmd_resp(priv, cmd_node));
 
 	return 0;
-
 }
 
 int cmd_process_ota_end(struct esp_wifi_device *priv)
@@ -2096,11 +2309,11 @@ int esp_commands_setup(struct esp_adapter *adapter)
 		return -EINVAL;
 	}
 
-	init_waitqueue_head(&adapter->wait_for_cmd_resp);
-
 	spin_lock_init(&adapter->cmd_lock);
 
 	INIT_LIST_HEAD(&adapter->cmd_pending_queue);
+	INIT_LIST_HEAD(&adapter->cmd_inflight);
+	adapter->cmd_inflight_cnt = 0;
 	INIT_LIST_HEAD(&adapter->cmd_free_queue);
 
 	spin_lock_init(&adapter->cmd_pending_queue_lock);
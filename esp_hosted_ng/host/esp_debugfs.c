@@ -3,30 +3,74 @@
 #include <linux/module.h>
 #include <linux/fs.h>
 #include <linux/uaccess.h>
+#include <linux/percpu.h>
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
+#include <linux/sched/clock.h>
+#else
+#include <linux/sched.h>
+#endif
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/ctype.h>
+#include <asm/local.h>
+#include "esp_kernel_port.h"
 
 #define DEBUGFS_DIR_NAME "esp32"
 #define LOG_LEVEL "log_level"
 #define VERSION "version"
+#define DEBUGFS_LOG_LEVEL "debugfs_log_level"
+#define HOST_LOGS "logs"
 
 #define DEBUGFS_TODO 0
 
 #if DEBUGFS_TODO
-#define DEBUGFS_LOG_LEVEL "debugfs_log_level"
-#define HOST_LOGS "logs"
 #define FW_LOGS "fw_logs"
 #define FW_LOGS_LEVEL "fw_logs_level"
 #endif
 
-#define LOG_BUFFER_SIZE 2048
+/* Host log records are kept in binary form, one ring per CPU, and only
+ * formatted when the logs file is read. A writer reserves a slot with a
+ * local increment of its CPU's head, so it never takes a lock and never
+ * races a writer on another CPU; a record interrupted by one logged from
+ * IRQ context simply lands in the next slot. The reader merges the rings
+ * by timestamp, and reports records that were overwritten before it got
+ * to them. */
+#define LOG_RING_SIZE   256     /* records per CPU, power of 2 */
+#define LOG_ARG_WORDS   32      /* vbin_printf() words per record */
+#define LOG_LINE_MAX    256
+
+struct esp_log_rec {
+	/* Ring position + 1 once complete, 0 while being written */
+	unsigned long seq;
+	u64 ts_ns;
+	const char *function;
+	const char *fmt;
+	u8 level;
+	bool truncated;
+	/* Formatted at log time, see log_fmt_needs_text() */
+	bool is_text;
+	union {
+#ifdef CONFIG_BINARY_PRINTF
+		u32 args[LOG_ARG_WORDS];
+#endif
+		char text[LOG_ARG_WORDS * sizeof(u32)];
+	};
+};
+
+struct esp_log_ring {
+	local_t head;           /* next slot to write */
+	unsigned long tail;     /* next slot to read, reader only */
+	struct esp_log_rec recs[LOG_RING_SIZE];
+};
 
 struct esp32_debugfs {
 	struct dentry *debugfs_dir;
 	struct dentry *log_level_file; /* log level for host dmesg */
 	struct dentry *version;
-#if DEBUGFS_TODO
 	struct dentry *host_log_level_file; /* log level for host logs in debugfs logger */
 	struct dentry *host_log_file; /* debugfs host logger */
-
+#if DEBUGFS_TODO
 	struct dentry *fw_log_level_file; /* debugfs firmware log level */
 	struct dentry *fw_log_file; /* debugfs firmware logger */
 #endif
@@ -37,13 +81,12 @@ struct esp32_debugfs drv_debugfs;
 // Define a variable to store the logging level
 extern int log_level;
 
-#if DEBUGFS_TODO
-int debugfs_log_level;
+int debugfs_log_level = ESP_INFO;
 
-static char log_buffer[LOG_BUFFER_SIZE] = "";
-static size_t log_length = 0;
-static size_t write_pos = 0;
-#endif
+static DEFINE_PER_CPU(struct esp_log_ring *, log_ring);
+static bool log_rings_ready;
+static DEFINE_MUTEX(log_read_lock);
+static unsigned long log_lost;
 #ifndef VERSION_BUFFER_SIZE
 #define VERSION_BUFFER_SIZE 50
 #endif
@@ -88,7 +131,6 @@ static ssize_t log_level_write(struct file *file, const char __user *buf, size_t
 	return count;
 }
 
-#if DEBUGFS_TODO
 // Read operation for the debugfs file
 static ssize_t debugfs_log_level_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
 {
@@ -123,48 +165,233 @@ static ssize_t debugfs_log_level_write(struct file *file, const char __user *buf
 	return count;
 }
 
+/* vbin_printf() keeps only the pointer for %p extensions such as %pM or
+ * %pi4 on most kernels, and the data behind it may be gone by the time the
+ * logs file is read. Records using them are formatted right away, as they
+ * are without binary printf. */
+static bool log_fmt_needs_text(const char *fmt)
+{
+#ifdef CONFIG_BINARY_PRINTF
+	while ((fmt = strchr(fmt, '%'))) {
+		fmt++;
+		if (*fmt == '%') {
+			fmt++;
+			continue;
+		}
+		fmt += strspn(fmt, "-+ #0123456789.*");
+		if (*fmt == 'p' && isalnum(fmt[1]))
+			return true;
+	}
+	return false;
+#else
+	return true;
+#endif
+}
+
+/* Called by esp_logger() for every message, whatever the dmesg level */
+void esp_debugfs_log(int level, const char *function, const char *fmt, va_list args)
+{
+	struct esp_log_ring *ring;
+	struct esp_log_rec *rec;
+	unsigned long pos;
+	int len;
+
+	if (level > READ_ONCE(debugfs_log_level))
+		return;
+
+	rcu_read_lock_sched();
+	if (!READ_ONCE(log_rings_ready))
+		goto out;
+
+	ring = *this_cpu_ptr(&log_ring);
+	pos = local_inc_return(&ring->head) - 1;
+	rec = &ring->recs[pos & (LOG_RING_SIZE - 1)];
+
+	WRITE_ONCE(rec->seq, 0);
+	smp_wmb();
+
+	rec->ts_ns = local_clock();
+	rec->function = function;
+	rec->fmt = fmt;
+	rec->level = level;
+	rec->is_text = log_fmt_needs_text(fmt);
+	if (rec->is_text) {
+		len = vscnprintf(rec->text, sizeof(rec->text), fmt, args);
+		rec->truncated = len == sizeof(rec->text) - 1;
+	} else {
+#ifdef CONFIG_BINARY_PRINTF
+		len = vbin_printf(rec->args, LOG_ARG_WORDS, fmt, args);
+		rec->truncated = len > LOG_ARG_WORDS;
+#endif
+	}
+
+	smp_store_release(&rec->seq, pos + 1);
+out:
+	rcu_read_unlock_sched();
+}
+
+/* Copy out the oldest unread record of @ring. Reader lock held. */
+static bool log_ring_peek(struct esp_log_ring *ring, struct esp_log_rec *rec)
+{
+	struct esp_log_rec *src;
+	unsigned long head = local_read(&ring->head);
+	unsigned long seq;
+
+	while (ring->tail != head) {
+		if (head - ring->tail > LOG_RING_SIZE) {
+			log_lost += head - ring->tail - LOG_RING_SIZE;
+			ring->tail = head - LOG_RING_SIZE;
+		}
+
+		src = &ring->recs[ring->tail & (LOG_RING_SIZE - 1)];
+		seq = smp_load_acquire(&src->seq);
+		memcpy(rec, src, sizeof(*rec));
+		smp_rmb();
+
+		/* Still being written: pick it up on the next read */
+		if (!seq || (long)(seq - (ring->tail + 1)) < 0)
+			return false;
+
+		if (seq == ring->tail + 1 && READ_ONCE(src->seq) == seq)
+			return true;
+
+		/* Overwritten while we looked */
+		log_lost++;
+		ring->tail++;
+	}
+
+	return false;
+}
+
+/* Oldest unread record across the CPUs, NULL ring if there is none */
+static struct esp_log_ring *log_rings_oldest(struct esp_log_rec *rec)
+{
+	struct esp_log_ring *ring, *oldest = NULL;
+	struct esp_log_rec cur;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu(log_ring, cpu);
+		if (!ring || !log_ring_peek(ring, &cur))
+			continue;
+
+		if (!oldest || cur.ts_ns < rec->ts_ns) {
+			oldest = ring;
+			memcpy(rec, &cur, sizeof(cur));
+		}
+	}
+
+	return oldest;
+}
+
+static int log_rec_format(struct esp_log_rec *rec, char *buf, size_t size)
+{
+	static const char levels[] = "EWIDV";
+	u64 secs = rec->ts_ns;
+	u32 nsecs = do_div(secs, NSEC_PER_SEC);
+	int len;
+
+	len = scnprintf(buf, size, "[%5llu.%06u] %c %s: ", secs, nsecs / 1000,
+			rec->level < sizeof(levels) - 1 ? levels[rec->level] : '?',
+			rec->function);
+	if (rec->is_text) {
+		len += scnprintf(buf + len, size - len, "%s", rec->text);
+	} else {
+#ifdef CONFIG_BINARY_PRINTF
+		if (rec->truncated)
+			len += scnprintf(buf + len, size - len, "(args dropped) %s", rec->fmt);
+		else
+			len += min_t(int, bstr_printf(buf + len, size - len, rec->fmt, rec->args),
+				     size - len - 1);
+#endif
+	}
+
+	if (buf[len - 1] != '\n') {
+		if (len == size - 1)
+			len--;
+		buf[len++] = '\n';
+		buf[len] = '\0';
+	}
+
+	return len;
+}
+
 // Read operation for the log output file
 static ssize_t log_output_read(struct file *file, char __user *user_buffer, size_t count, loff_t *ppos)
 {
-	ssize_t ret = 0;
-	if (log_length > 0) {
-		ret = simple_read_from_buffer(user_buffer, count, ppos, log_buffer, log_length);
-		if (ret > 0) {
-			// Update read position
-			*ppos += ret;
-			// Clear buffer if no more data is available
-			if (*ppos >= log_length) {
-				log_length = 0;
-				write_pos = 0;
-			}
+	struct esp_log_ring *ring;
+	struct esp_log_rec rec;
+	char line[LOG_LINE_MAX];
+	char *page;
+	size_t len = 0;
+	int n;
+	ssize_t ret;
+
+	page = (char *)__get_free_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	count = min_t(size_t, count, PAGE_SIZE);
+
+	mutex_lock(&log_read_lock);
+	while (len < count) {
+		if (log_lost) {
+			n = scnprintf(line, sizeof(line), "--- %lu records overwritten ---\n",
+				      log_lost);
+			if (len + n > count)
+				break;
+			log_lost = 0;
+		} else {
+			ring = log_rings_oldest(&rec);
+			if (!ring)
+				break;
+
+			n = log_rec_format(&rec, line, sizeof(line));
+			if (len + n > count)
+				break;
+			ring->tail++;
 		}
+
+		memcpy(page + len, line, n);
+		len += n;
 	}
+	mutex_unlock(&log_read_lock);
+
+	ret = len;
+	if (len && copy_to_user(user_buffer, page, len))
+		ret = -EFAULT;
+
+	free_page((unsigned long)page);
 	return ret;
 }
 
-static int va_format_to_char(char *buf, size_t size, const char *fmt, va_list args)
+static int log_rings_alloc(void)
 {
-	return vsnprintf(buf, size, fmt, args);
+	struct esp_log_ring *ring;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = kzalloc_node(sizeof(*ring), GFP_KERNEL, cpu_to_node(cpu));
+		if (!ring)
+			return -ENOMEM;
+		per_cpu(log_ring, cpu) = ring;
+	}
+
+	WRITE_ONCE(log_rings_ready, true);
+	return 0;
 }
 
-void write_to_buffer(const char *fmt, ...)
+static void log_rings_free(void)
 {
-	size_t space_left = LOG_BUFFER_SIZE - log_length;
-	va_list args;
-	int len;
+	int cpu;
 
-	va_start(args, fmt);
-	len = va_format_to_char(log_buffer + write_pos, LOG_BUFFER_SIZE - write_pos, fmt, args);
-	va_end(args);
+	WRITE_ONCE(log_rings_ready, false);
+	/* Writers run with preemption off */
+	ESP_SYNCHRONIZE_SCHED();
 
-	if (len > space_left)
-		len = space_left;
-
-	if (len > 0) {
-		write_pos += len;
-		log_length += len;
-		if (write_pos >= LOG_BUFFER_SIZE)
-			write_pos = 0;  // Wrap around if buffer is full
+	for_each_possible_cpu(cpu) {
+		kfree(per_cpu(log_ring, cpu));
+		per_cpu(log_ring, cpu) = NULL;
 	}
 }
 
@@ -176,9 +403,11 @@ static const struct file_operations debugfs_log_level_ops = {
 
 // File operations for the debugfs file
 static const struct file_operations debugfs_log_output_ops = {
+	.open = nonseekable_open,
 	.read = log_output_read,
 };
 
+#if DEBUGFS_TODO
 // File operations for the debugfs file
 static const struct file_operations debugfs_fw_log_level_ops = {
 	.read = debugfs_fw_log_level_read,
@@ -205,6 +434,14 @@ int debugfs_init(void)
 {
 	struct esp32_debugfs *debugfs = &drv_debugfs;
 	int ret = -ENODEV;
+
+	ret = log_rings_alloc();
+	if (ret) {
+		esp_err("Failed to allocate log rings\n");
+		goto cleanup;
+	}
+	ret = -ENODEV;
+
 	// Create debugfs directory
 	debugfs->debugfs_dir = debugfs_create_dir(DEBUGFS_DIR_NAME, NULL);
 
@@ -226,19 +463,19 @@ int debugfs_init(void)
 		goto cleanup;
 	}
 
-#if DEBUGFS_TODO
-	debugfs->host_log_level_file = debugfs_create_file(DEBUGFS_LOG_LEVEL, 0644, debugfs_dir, NULL, &debugfs_log_level_ops);
-	if (!debugfs->debugfs_log_level_file) {
+	debugfs->host_log_level_file = debugfs_create_file(DEBUGFS_LOG_LEVEL, 0644, debugfs->debugfs_dir, NULL, &debugfs_log_level_ops);
+	if (!debugfs->host_log_level_file) {
 		esp_err("Failed to create debugfs %s file\n", DEBUGFS_LOG_LEVEL);
 		goto cleanup;
 	}
 
-	debugfs->host_log_file = debugfs_create_file(HOST_LOGS, 0644, debugfs_dir, NULL, &debugfs_log_output_ops);
+	debugfs->host_log_file = debugfs_create_file(HOST_LOGS, 0444, debugfs->debugfs_dir, NULL, &debugfs_log_output_ops);
 	if (!debugfs->host_log_file) {
 		esp_err("Failed to create debugfs %s file\n", HOST_LOGS);
 		goto cleanup;
 	}
 
+#if DEBUGFS_TODO
 	debugfs->fw_log_file = debugfs_create_file(FW_LOGS, 0644, debugfs_dir, NULL, &debugfs_fw_log_output_ops);
 	if (!debugfs->fw_log_file) {
 		esp_err("Failed to create debugfs %s file\n", FW_LOGS);
@@ -267,11 +504,15 @@ void debugfs_exit(void)
 		debugfs_remove(debugfs->fw_log_file);
 	if (debugfs->fw_log_level_file)
 		debugfs_remove(debugfs->fw_log_level_file);
-	if (debugfs->host_log_file)
+#endif
+	if (debugfs->host_log_file) {
 		debugfs_remove(debugfs->host_log_file);
-	if (debugfs->host_log_level_file)
+		debugfs->host_log_file = NULL;
+	}
+	if (debugfs->host_log_level_file) {
 		debugfs_remove(debugfs->host_log_level_file);
-#endif
+		debugfs->host_log_level_file = NULL;
+	}
 	if (debugfs->log_level_file) {
 		debugfs_remove(debugfs->log_level_file);
 		debugfs->log_level_file = NULL;
@@ -284,4 +525,6 @@ void debugfs_exit(void)
 		debugfs_remove(debugfs->debugfs_dir);
 		debugfs->debugfs_dir = NULL;
 	}
+
+	log_rings_free();
 }
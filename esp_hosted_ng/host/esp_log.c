@@ -39,6 +39,10 @@ void esp_logger(int level, const char *function, const char* fmt, ...)
 	struct va_format vaf;
 	va_list args;
 
+	va_start(args, fmt);
+	esp_debugfs_log(level, function, fmt, args);
+	va_end(args);
+
 	if (level > log_level)
 		return;
 
@@ -0,0 +1,399 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Espressif Systems Wireless LAN device driver
+ *
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+ *
+ */
+
+/* Streaming firmware update.
+ *
+ * The image is cut into OTA_STREAM_CHUNK_SIZE writes and up to
+ * ESP_OTA_WINDOW of them are kept in flight; the command window and
+ * sequence IDs take care of matching the responses. The firmware acks a
+ * write once the chunk is staged and flashes in the background, so the
+ * update runs at bus and flash speed rather than one round trip per chunk.
+ *
+ * Two ways in:
+ *   ota_file=<path>   module parameter, read at init as before
+ *   /dev/esp_ota      write the image (or splice it: cat, dd, sendfile);
+ *                     the update ends when the last reference to the open
+ *                     file is closed, and its result is logged. A failed
+ *                     write is returned to the writer.
+ *
+ * Only one update runs at a time, so a second open() gets -EBUSY. While
+ * the update runs, i.e. from open() to the final close() of /dev/esp_ota,
+ * the driver rejects every command other than the OTA ones.
+ *
+ * If the card goes away meanwhile, esp_ota_teardown() kills the update
+ * before the command pool is freed: writes then fail with -ENODEV and a
+ * new update may be started once the card is back.
+ */
+
+#include "utils.h"
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/uio.h>
+#include "esp.h"
+#include "esp_api.h"
+#include "esp_cmd.h"
+#include "esp_ota.h"
+
+/* Writes in flight; must stay below ESP_NUM_OF_CMD_NODES */
+#define ESP_OTA_WINDOW          8
+#define ESP_OTA_READ_SIZE       (16 * OTA_STREAM_CHUNK_SIZE)
+
+struct esp_ota_stream {
+	/* Queued writes, oldest at first */
+	struct command_node     *inflight[ESP_OTA_WINDOW];
+	u8                      first;
+	u8                      count;
+	/* First failure; everything after it is only drained */
+	int                     err;
+	/* Serializes writers sharing the open file (dup, fork), and them
+	 * against esp_ota_teardown() */
+	struct mutex            lock;
+	/* Card removed: in-flight writes are gone with the command pool */
+	bool                    dead;
+	u16                     chunk_len;
+	char                    chunk[OTA_STREAM_CHUNK_SIZE];
+};
+
+/* The running update, if any; esp_ota_stream_end() and esp_ota_teardown()
+ * run under ota_stream_lock */
+static struct esp_ota_stream *ota_stream;
+static DEFINE_MUTEX(ota_stream_lock);
+
+/* Looked up on every use rather than kept in the stream, as the interface
+ * goes away with the card */
+static struct esp_wifi_device *esp_ota_priv(void)
+{
+	struct esp_adapter *adapter = esp_get_adapter();
+
+	if (!adapter || !test_bit(ESP_CMD_INIT_DONE, &adapter->state_flags))
+		return NULL;
+
+	return adapter->priv[ESP_STA_NW_IF];
+}
+
+static void esp_ota_stream_reap(struct esp_ota_stream *s)
+{
+	struct command_node *node = s->inflight[s->first];
+	struct esp_wifi_device *priv = esp_ota_priv();
+
+	s->first = (s->first + 1) % ESP_OTA_WINDOW;
+	s->count--;
+
+	if (!priv) {
+		s->err = -ENODEV;
+		return;
+	}
+
+	if (cmd_ota_write_wait(priv, node) && !s->err) {
+		esp_err("OTA write failed\n");
+		s->err = -EIO;
+	}
+}
+
+static int esp_ota_stream_send(struct esp_ota_stream *s)
+{
+	struct command_node *node;
+
+	if (s->count == ESP_OTA_WINDOW)
+		esp_ota_stream_reap(s);
+	if (s->err)
+		return s->err;
+
+	node = cmd_ota_write_queue(esp_ota_priv(), s->chunk, s->chunk_len);
+	if (!node) {
+		s->err = -ENOMEM;
+		return s->err;
+	}
+
+	s->inflight[(s->first + s->count++) % ESP_OTA_WINDOW] = node;
+	s->chunk_len = 0;
+	return 0;
+}
+
+static struct esp_ota_stream *esp_ota_stream_begin(struct esp_adapter *adapter)
+{
+	struct esp_ota_stream *s;
+	int ret = 0;
+
+	if (!adapter->priv[ESP_STA_NW_IF])
+		return ERR_PTR(-ENODEV);
+
+	if (test_and_set_bit(ESP_OTA_IN_PROGRESS, &adapter->state_flags))
+		return ERR_PTR(-EBUSY);
+
+	s = kzalloc(sizeof(*s), GFP_KERNEL);
+	if (!s) {
+		clear_bit(ESP_OTA_IN_PROGRESS, &adapter->state_flags);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	mutex_init(&s->lock);
+
+	mutex_lock(&ota_stream_lock);
+	if (cmd_process_ota_start(esp_ota_priv()) != 0) {
+		esp_err("OTA Start failed\n");
+		ret = -EIO;
+	} else {
+		ota_stream = s;
+	}
+	mutex_unlock(&ota_stream_lock);
+
+	if (ret) {
+		kfree(s);
+		clear_bit(ESP_OTA_IN_PROGRESS, &adapter->state_flags);
+		return ERR_PTR(ret);
+	}
+
+	return s;
+}
+
+static int esp_ota_stream_write(struct esp_ota_stream *s, const char *data, size_t len)
+{
+	size_t n;
+	int ret;
+
+	mutex_lock(&s->lock);
+	if (s->dead)
+		s->err = -ENODEV;
+
+	while (len && !s->err) {
+		n = min_t(size_t, len, OTA_STREAM_CHUNK_SIZE - s->chunk_len);
+		memcpy(s->chunk + s->chunk_len, data, n);
+		s->chunk_len += n;
+		data += n;
+		len -= n;
+
+		if (s->chunk_len == OTA_STREAM_CHUNK_SIZE)
+			esp_ota_stream_send(s);
+	}
+	ret = s->err;
+	mutex_unlock(&s->lock);
+
+	return ret;
+}
+
+/* Sends what is left and finishes the update, unless @abort or a write
+ * failed; in both cases the firmware is left on its current image. No
+ * writer may be left. */
+static int esp_ota_stream_end(struct esp_ota_stream *s, bool abort)
+{
+	int ret;
+
+	mutex_lock(&ota_stream_lock);
+	if (ota_stream == s)
+		ota_stream = NULL;
+
+	/* esp_ota_teardown() already ended it */
+	if (s->dead) {
+		mutex_unlock(&ota_stream_lock);
+		kfree(s);
+		return -ENODEV;
+	}
+
+	if (!abort && s->chunk_len)
+		esp_ota_stream_send(s);
+
+	while (s->count)
+		esp_ota_stream_reap(s);
+
+	ret = s->err;
+	if (!ret && abort)
+		ret = -ECANCELED;
+
+	if (!ret) {
+		ret = cmd_process_ota_end(esp_ota_priv());
+		if (ret != 0)
+			esp_err("cmd_process_ota_end failed %d \n", ret);
+	}
+
+	clear_bit(ESP_OTA_IN_PROGRESS, &esp_get_adapter()->state_flags);
+	mutex_unlock(&ota_stream_lock);
+
+	kfree(s);
+	return ret;
+}
+
+void esp_ota_teardown(struct esp_adapter *adapter)
+{
+	struct esp_ota_stream *s;
+
+	mutex_lock(&ota_stream_lock);
+	s = ota_stream;
+	if (s) {
+		/* Waits out a writer blocked on a response, at most the
+		 * OTA command timeout */
+		mutex_lock(&s->lock);
+		s->dead = true;
+		s->count = 0;
+		if (!s->err)
+			s->err = -ENODEV;
+		mutex_unlock(&s->lock);
+
+		ota_stream = NULL;
+		clear_bit(ESP_OTA_IN_PROGRESS, &adapter->state_flags);
+		esp_err("OTA update aborted, card removed\n");
+	}
+	mutex_unlock(&ota_stream_lock);
+}
+
+int esp_start_ota(struct esp_adapter *adapter, char *ota_file)
+{
+	struct esp_ota_stream *s;
+	struct file *file;
+	ssize_t nread;
+	char *buf;
+	int ret;
+
+	buf = kmalloc(ESP_OTA_READ_SIZE, GFP_KERNEL);
+	if (!buf) {
+		esp_err("Failed to allocate buffer for ota_chunk\n");
+		return -ENOMEM;
+	}
+
+	file = filp_open(ota_file, O_RDONLY, 0);
+	if (IS_ERR(file)) {
+		esp_err("Error reading ota bin, or ota bin not found at %s \n", ota_file);
+		kfree(buf);
+		return -EINVAL;
+	}
+
+	s = esp_ota_stream_begin(adapter);
+	if (IS_ERR(s)) {
+		ret = PTR_ERR(s);
+		goto done;
+	}
+
+	while ((nread = kernel_read(file, buf, ESP_OTA_READ_SIZE, &file->f_pos)) > 0) {
+		if (esp_ota_stream_write(s, buf, nread))
+			break;
+	}
+
+	if (nread < 0)
+		esp_err("Failed to read ota binary file %s \n", ota_file);
+
+	ret = esp_ota_stream_end(s, nread < 0);
+
+done:
+	filp_close(file, NULL);
+	kfree(buf);
+	return ret;
+}
+
+/* /dev/esp_ota: one open at a time, the update ends on release */
+static int esp_ota_dev_open(struct inode *inode, struct file *file)
+{
+	struct esp_adapter *adapter = esp_get_adapter();
+	struct esp_ota_stream *s;
+
+	if ((file->f_flags & O_ACCMODE) != O_WRONLY)
+		return -EINVAL;
+
+	if (!adapter || !test_bit(ESP_CMD_INIT_DONE, &adapter->state_flags))
+		return -ENODEV;
+
+	s = esp_ota_stream_begin(adapter);
+	if (IS_ERR(s))
+		return PTR_ERR(s);
+
+	file->private_data = s;
+	return nonseekable_open(inode, file);
+}
+
+static ssize_t esp_ota_dev_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct esp_ota_stream *s = iocb->ki_filp->private_data;
+	size_t total = iov_iter_count(from);
+	ssize_t ret = total;
+	size_t n;
+
+	if (mutex_lock_interruptible(&s->lock))
+		return -ERESTARTSYS;
+
+	if (s->dead)
+		ret = -ENODEV;
+
+	/* Straight into the pending chunk, no bounce buffer */
+	while (iov_iter_count(from) && !s->dead) {
+		if (s->err) {
+			ret = s->err;
+			break;
+		}
+
+		n = copy_from_iter(s->chunk + s->chunk_len,
+				   OTA_STREAM_CHUNK_SIZE - s->chunk_len, from);
+		if (!n) {
+			ret = -EFAULT;
+			break;
+		}
+
+		s->chunk_len += n;
+		if (s->chunk_len == OTA_STREAM_CHUNK_SIZE)
+			esp_ota_stream_send(s);
+	}
+
+	mutex_unlock(&s->lock);
+	return ret;
+}
+
+/* Last reference gone, so no writer can race with us any more. What
+ * release returns never reaches close(), so the outcome is only logged. */
+static int esp_ota_dev_release(struct inode *inode, struct file *file)
+{
+	struct esp_ota_stream *s = file->private_data;
+	int ret;
+
+	ret = esp_ota_stream_end(s, false);
+	if (ret)
+		esp_err("OTA update via /dev/esp_ota failed: %d\n", ret);
+	else
+		esp_info("OTA update via /dev/esp_ota done\n");
+
+	return 0;
+}
+
+static const struct file_operations esp_ota_dev_fops = {
+	.owner          = THIS_MODULE,
+	.open           = esp_ota_dev_open,
+	.write_iter     = esp_ota_dev_write_iter,
+	.splice_write   = iter_file_splice_write,
+	.release        = esp_ota_dev_release,
+};
+
+static struct miscdevice esp_ota_dev = {
+	.minor          = MISC_DYNAMIC_MINOR,
+	.name           = "esp_ota",
+	.fops           = &esp_ota_dev_fops,
+	.mode           = 0200,
+};
+
+static bool esp_ota_dev_registered;
+
+int esp_ota_dev_init(void)
+{
+	int ret;
+
+	ret = misc_register(&esp_ota_dev);
+	if (ret) {
+		esp_err("Failed to register /dev/%s: %d\n", esp_ota_dev.name, ret);
+		return ret;
+	}
+
+	esp_ota_dev_registered = true;
+	return 0;
+}
+
+void esp_ota_dev_deinit(void)
+{
+	if (!esp_ota_dev_registered)
+		return;
+
+	misc_deregister(&esp_ota_dev);
+	esp_ota_dev_registered = false;
+}
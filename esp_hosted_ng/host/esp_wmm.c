@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Espressif Systems Wireless LAN device driver
+ *
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+ *
+ */
+
+/* Four access-category lanes for Wi-Fi data on the host->ESP path.
+ *
+ * ndo_select_queue picks the AC from the 802.1d priority (SO_PRIORITY
+ * 256..263, as mac80211 reads it) or the IP DSCP, mapped the same way the
+ * ESP maps received frames (esp_dscp_to_up()), and the AC becomes the netdev
+ * TX queue, so qdiscs see four queues. The transport keeps the
+ * AC in its PRIO_Q_LOW lane, which is drained VO, VI, BE, BK by weighted
+ * round robin: voice and video no longer wait behind a bulk transfer, and
+ * background still gets a share under load.
+ */
+
+#include "utils.h"
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <net/dsfield.h>
+#include "esp_wmm.h"
+
+/* Service order, and frames per turn at each position */
+static const u8 esp_ac_order[ESP_NUM_AC] = {
+	ESP_AC_VO, ESP_AC_VI, ESP_AC_BE, ESP_AC_BK
+};
+static const u8 esp_ac_weight[ESP_NUM_AC] = { 8, 4, 2, 1 };
+
+void esp_ac_queue_init(struct esp_ac_queue *acq)
+{
+	int ac;
+
+	for (ac = 0; ac < ESP_NUM_AC; ac++)
+		skb_queue_head_init(&acq->q[ac]);
+
+	acq->cur = 0;
+	acq->credit = esp_ac_weight[0];
+}
+
+void esp_ac_queue_purge(struct esp_ac_queue *acq)
+{
+	int ac;
+
+	for (ac = 0; ac < ESP_NUM_AC; ac++)
+		skb_queue_purge(&acq->q[ac]);
+}
+
+void esp_ac_enqueue(struct esp_ac_queue *acq, struct sk_buff *skb)
+{
+	u16 ac = skb_get_queue_mapping(skb);
+
+	if (ac >= ESP_NUM_AC)
+		ac = ESP_AC_BE;
+
+	skb_queue_tail(&acq->q[ac], skb);
+}
+
+/* Lane the next frame comes from, -1 if all are empty */
+static int esp_ac_next(struct esp_ac_queue *acq)
+{
+	u8 ac;
+	int i;
+
+	for (i = 0; i <= ESP_NUM_AC; i++) {
+		ac = esp_ac_order[acq->cur];
+		if (acq->credit && !skb_queue_empty(&acq->q[ac]))
+			return ac;
+
+		/* Turn used up, or nothing to send: next lane, full share */
+		acq->cur = (acq->cur + 1) % ESP_NUM_AC;
+		acq->credit = esp_ac_weight[acq->cur];
+	}
+
+	return -1;
+}
+
+struct sk_buff *esp_ac_peek(struct esp_ac_queue *acq)
+{
+	int ac = esp_ac_next(acq);
+
+	return ac < 0 ? NULL : skb_peek(&acq->q[ac]);
+}
+
+struct sk_buff *esp_ac_dequeue(struct esp_ac_queue *acq)
+{
+	struct sk_buff *skb;
+	int ac;
+
+	ac = esp_ac_next(acq);
+	if (ac < 0)
+		return NULL;
+
+	skb = skb_dequeue(&acq->q[ac]);
+	if (skb)
+		acq->credit--;
+
+	return skb;
+}
+
+bool esp_ac_queue_empty(struct esp_ac_queue *acq)
+{
+	int ac;
+
+	for (ac = 0; ac < ESP_NUM_AC; ac++)
+		if (!skb_queue_empty(&acq->q[ac]))
+			return false;
+
+	return true;
+}
+
+u16 esp_wmm_classify(struct sk_buff *skb)
+{
+	u8 up = 0;
+
+	if (skb->priority >= 256 && skb->priority <= 263) {
+		up = skb->priority - 256;
+		goto out;
+	}
+
+	switch (skb->protocol) {
+	case htons(ETH_P_IP):
+		if (pskb_may_pull(skb, skb_network_offset(skb) + sizeof(struct iphdr)))
+			up = esp_dscp_to_up(ipv4_get_dsfield(ip_hdr(skb)) >> 2);
+		break;
+	case htons(ETH_P_IPV6):
+		if (pskb_may_pull(skb, skb_network_offset(skb) + sizeof(struct ipv6hdr)))
+			up = esp_dscp_to_up(ipv6_get_dsfield(ipv6_hdr(skb)) >> 2);
+		break;
+	default:
+		break;
+	}
+
+out:
+	skb->priority = up;
+	return esp_up_to_ac(up);
+}
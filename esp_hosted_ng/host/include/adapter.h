@@ -12,6 +12,63 @@
 #define PRIO_Q_MID                      1
 #define PRIO_Q_LOW                      2
 #define MAX_PRIORITY_QUEUES             3
+
+/* WMM access categories in 802.11 ACI order. Wi-Fi data is split into one
+ * lane per AC inside PRIO_Q_LOW on both sides; on the host the AC is also
+ * the netdev TX queue. 0, best effort, takes everything unclassified. */
+enum ESP_AC {
+	ESP_AC_BE,
+	ESP_AC_BK,
+	ESP_AC_VI,
+	ESP_AC_VO,
+	ESP_NUM_AC,
+};
+
+/* 802.1d user priority of a 6-bit DSCP. Host and ESP both classify with
+ * this, following RFC 8325 (as cfg80211_classify8021d() does) and falling
+ * back to the class selector bits. */
+static inline uint8_t esp_dscp_to_up(uint8_t dscp)
+{
+	switch (dscp) {
+	case 8:				/* CS1 */
+		return 1;
+	case 10: case 12: case 14:	/* AF1x */
+	case 16:			/* CS2 */
+		return 0;
+	case 18: case 20: case 22:	/* AF2x */
+		return 3;
+	case 24:			/* CS3 */
+	case 26: case 28: case 30:	/* AF3x */
+	case 32:			/* CS4 */
+	case 34: case 36: case 38:	/* AF4x */
+		return 4;
+	case 40:			/* CS5 */
+		return 5;
+	case 44:			/* VOICE-ADMIT */
+	case 46:			/* EF */
+		return 6;
+	case 48:			/* CS6 */
+		return 7;
+	default:
+		return dscp >> 3;
+	}
+}
+
+/* Access category of an 802.1d user priority (0..7) */
+static inline uint8_t esp_up_to_ac(uint8_t up)
+{
+	switch (up & 7) {
+	case 1: case 2:
+		return ESP_AC_BK;
+	case 4: case 5:
+		return ESP_AC_VI;
+	case 6: case 7:
+		return ESP_AC_VO;
+	default:
+		return ESP_AC_BE;
+	}
+}
+
 #define MAC_ADDR_LEN                    6
 #define MAX_KEY_LEN                     32
 #define MAX_SEQ_LEN                     10
@@ -21,8 +78,11 @@
 #define MORE_FRAGMENT                   (1 << 0)
 #define MAX_SSID_LEN                    32
 #define OTA_CHUNK_SIZE                  1016
+/* Largest CMD_START_OTA_WRITE chunk; fits a single SPI transfer */
+#define OTA_STREAM_CHUNK_SIZE           1400
 
 #define MAX_MULTICAST_ADDR_COUNT        8
+#define MCAST_HASH_BITS                 256
 
 struct esp_payload_header {
 	uint8_t          if_type:4;
@@ -124,6 +184,12 @@ enum ESP_BOOTUP_TAG_TYPE {
 	ESP_BOOTUP_FIRMWARE_CHIP_ID,
 	ESP_BOOTUP_TEST_RAW_TP,
 	ESP_BOOTUP_RX_BUF_SIZE,
+	/* 1 byte: commands the firmware accepts in flight. Also says that
+	 * responses echo command_header.seq_num. */
+	ESP_BOOTUP_CMD_WINDOW,
+	/* 2 bytes LE: EVENT_STA_INFO period in ms while the station is
+	 * connected. Absent or 0: no such events. */
+	ESP_BOOTUP_STA_INFO,
 };
 
 enum COMMAND_CODE {
@@ -168,6 +234,8 @@ enum EVENT_CODE {
 	EVENT_AUTH_RX,
 	EVENT_ASSOC_RX,
 	EVENT_AP_MGMT_RX,
+	EVENT_STA_INFO,
+	EVENT_SCAN_RESULT_BATCH,
 };
 
 enum COMMAND_RESPONSE_TYPE {
@@ -183,6 +251,7 @@ struct command_header {
 	uint8_t    cmd_code;
 	uint8_t    cmd_status;
 	uint16_t   len;
+	/* Set by the host per command, copied into its response */
 	uint16_t   seq_num;
 	uint8_t    reserved1;
 	uint8_t    reserved2;
@@ -200,9 +269,13 @@ struct scan_request {
 	uint16_t   duration;
 	char       ssid[MAX_SSID_LEN+1];
 	uint8_t    channel;
-	uint8_t    pad[2];
+	uint8_t    flags;
+	uint8_t    pad[1];
 } __packed;
 
+/* scan_request.flags */
+#define SCAN_REQ_BATCH_RESULTS          (1 << 0)
+
 struct cmd_config_mac_address {
 	struct     command_header header;
 	uint8_t    mac_addr[MAC_ADDR_LEN];
@@ -315,10 +388,22 @@ struct cmd_set_ip_addr {
 	uint32_t ip;
 } __packed;
 
+/* cmd_set_mcast_mac_addr.mode */
+enum MCAST_FILTER_MODE {
+	MCAST_FILTER_LIST,      /* mcast_addr[0..count) */
+	MCAST_FILTER_HASH,      /* Buckets set in mcast_hash */
+	MCAST_FILTER_ALLMULTI,  /* Any multicast address */
+};
+
 struct cmd_set_mcast_mac_addr {
 	struct command_header header;
 	uint8_t count;
 	uint8_t mcast_addr[MAX_MULTICAST_ADDR_COUNT][MAC_ADDR_LEN];
+	/* Not sent by older hosts, whose list is only used for wakeup */
+	uint8_t mode;
+	uint8_t pad[3];
+	/* Bucket of an address is the top byte of its Ethernet CRC32 */
+	uint8_t mcast_hash[MCAST_HASH_BITS / 8];
 } __packed;
 
 struct wifi_sec_key {
@@ -376,6 +461,29 @@ struct scan_event {
 	uint8_t    frame[0];
 } __packed;
 
+/* One BSS in EVENT_SCAN_RESULT_BATCH, same fields as scan_event. Records
+ * follow each other 4 byte aligned. */
+struct scan_result_record {
+	uint8_t    bssid[MAC_ADDR_LEN];
+	uint8_t    frame_type;
+	uint8_t    channel;
+	uint32_t   rssi;
+	uint64_t   tsf;
+	uint16_t   frame_len;
+	uint8_t    pad[2];
+	uint8_t    frame[0];
+} __packed;
+
+/* Sent during scans the host requested with SCAN_REQ_BATCH_RESULTS, in
+ * place of per-BSS scan_events. A BSS is reported once per frame type and
+ * channel in a scan. The end of the scan is still a scan_event with status 0. */
+struct scan_batch_event {
+	struct     event_header header;
+	uint8_t    count;
+	uint8_t    pad[3];
+	uint8_t    records[0];
+} __packed;
+
 struct auth_event {
 	struct     event_header header;
 	uint8_t    bssid[MAC_ADDR_LEN];
@@ -417,6 +525,32 @@ struct disconnect_event {
 	uint8_t    reason;
 } __packed;
 
+enum STA_INFO_RATE_MODE {
+	STA_INFO_RATE_LEGACY,
+	STA_INFO_RATE_HT,
+	STA_INFO_RATE_HE,
+};
+
+/* Periodic link report of the station interface. The rate is the highest
+ * one negotiated with the AP; the Wi-Fi library does not report the rate of
+ * individual frames. Counters run from the last connect. */
+struct sta_info_event {
+	struct     event_header header;
+	uint8_t    bssid[MAC_ADDR_LEN];
+	int8_t     rssi;
+	int8_t     tx_power;        /* esp_wifi_get_max_tx_power() units */
+	uint8_t    rate_mode;       /* STA_INFO_RATE_* */
+	uint8_t    mcs;
+	uint8_t    nss;
+	uint8_t    bw_mhz;
+	uint16_t   legacy_rate;     /* 100 kbps, STA_INFO_RATE_LEGACY only */
+	uint8_t    short_gi;
+	uint8_t    pad;
+	uint32_t   tx_retries;
+	uint32_t   tx_failed;
+	uint32_t   beacon_loss;
+} __packed;
+
 struct cmd_config_mode {
 	struct     command_header header;
 	uint16_t   mode;
@@ -15,6 +15,7 @@
 #include <linux/inetdevice.h>
 #include <linux/etherdevice.h>
 #include <linux/spinlock.h>
+#include <linux/completion.h>
 #include <net/cfg80211.h>
 #include <net/bluetooth/bluetooth.h>
 #include <net/bluetooth/hci_core.h>
@@ -80,9 +81,16 @@ enum priv_flags_e {
 struct command_node {
 	struct list_head list;
 	uint8_t cmd_code;
+	/* command_header.seq_num, echoed back in the response */
+	uint16_t seq;
+	/* Response wait, in jiffies */
+	unsigned long timeout;
 	struct sk_buff *cmd_skb;
 	struct sk_buff *resp_skb;
+	/* Response arrived, or the command could not be sent */
+	struct completion done;
 	bool in_cmd_queue;
+	bool in_flight;
 };
 
 struct esp_adapter {
@@ -106,9 +114,6 @@ struct esp_adapter {
 	struct workqueue_struct *if_rx_workqueue;
 	struct work_struct      if_rx_work;
 
-	wait_queue_head_t       wait_for_cmd_resp;
-	uint8_t                 cmd_resp;
-
 	/* wpa supplicant commands structures */
 	struct command_node     *cmd_pool;
 	struct list_head        cmd_free_queue;
@@ -116,8 +121,15 @@ struct esp_adapter {
 	struct list_head        cmd_pending_queue;
 	spinlock_t              cmd_pending_queue_lock;
 
-	struct command_node     *cur_cmd;
+	/* Sent and waiting for a response, oldest first. Protected by cmd_lock */
+	struct list_head        cmd_inflight;
+	uint8_t                 cmd_inflight_cnt;
+	uint16_t                cmd_seq;
 	spinlock_t              cmd_lock;
+	/* Commands the firmware takes at once, 0: one, and no seq_num echo */
+	uint8_t                 fw_cmd_window;
+	/* EVENT_STA_INFO period in ms, 0: firmware does not send it */
+	uint16_t                sta_info_interval;
 
 	struct work_struct      mac_flter_work;
 
@@ -176,6 +188,12 @@ struct esp_wifi_device {
 	uint8_t                 tx_pwr;
 	uint32_t                rssi;
 	bool                    local_disconnect_req;
+
+	/* Last EVENT_STA_INFO, serves get_station without a command */
+	spinlock_t              sta_info_lock;
+	struct sta_info_event   sta_info;
+	unsigned long           sta_info_jiffies;
+	bool                    sta_info_valid;
 };
 
 
@@ -28,6 +28,9 @@ int esp_send_packet(struct esp_adapter *adapter, struct sk_buff *skb);
 u8 esp_is_bt_supported_over_sdio(u32 cap);
 void esp_tx_pause(struct esp_wifi_device *priv);
 void esp_tx_resume(struct esp_wifi_device *priv);
+void esp_tx_bql_sent(struct sk_buff *skb);
+void esp_tx_bql_completed(struct sk_buff *skb);
+void esp_tx_bql_reset(struct esp_adapter *adapter);
 void esp_init_priv(struct net_device *ndev);
 void esp_port_open(struct esp_wifi_device *priv);
 void esp_port_close(struct esp_wifi_device *priv);
@@ -43,5 +46,4 @@ int esp_init_raw_tp(struct esp_adapter *adapter);
 bool esp_is_valid_hardware_id(int hardware_id);
 char *esp_get_hardware_name(int hardware_id);
 int generate_slave_intr(void *context, u8 data);
-int esp_start_ota(struct esp_adapter *adapter, char *ota_file);
 #endif
@@ -20,6 +20,8 @@ struct multicast_list {
 	struct esp_wifi_device *priv;
 	u8 addr_count;
 	u8 mcast_addr[MAX_MULTICAST_ADDR_COUNT][MAC_ADDR_LEN];
+	u8 mode;
+	u8 mcast_hash[MCAST_HASH_BITS / 8];
 };
 
 
@@ -35,6 +37,8 @@ int cmd_get_mac(struct esp_wifi_device *priv);
 int cmd_set_mac(struct esp_wifi_device *priv, uint8_t *mac_addr);
 int cmd_get_rssi(struct esp_wifi_device *priv);
 int process_cmd_event(struct esp_wifi_device *priv, struct sk_buff *skb);
+bool esp_get_sta_info(struct esp_wifi_device *priv, struct sta_info_event *info);
+void esp_invalidate_sta_info(struct esp_wifi_device *priv);
 int cmd_connect_request(struct esp_wifi_device *priv,
 		struct cfg80211_connect_params *params);
 int cmd_auth_request(struct esp_wifi_device *priv,
@@ -67,6 +71,8 @@ int cmd_sta_change(struct esp_wifi_device *priv,
 		     struct station_parameters *sta_info);
 int cmd_update_fw_time(struct esp_wifi_device *priv);
 int cmd_process_ota_start(struct esp_wifi_device *priv);
-int cmd_process_ota_write(struct esp_wifi_device *priv, char *ota_chunk, ssize_t nread);
+struct command_node *cmd_ota_write_queue(struct esp_wifi_device *priv,
+		const char *ota_chunk, size_t len);
+int cmd_ota_write_wait(struct esp_wifi_device *priv, struct command_node *cmd_node);
 int cmd_process_ota_end(struct esp_wifi_device *priv);
 #endif
@@ -35,9 +35,33 @@ static inline void ether_addr_copy(u8 *dst, const u8 *src)
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3, 17, 0)
   #define ALLOC_NETDEV(size, name, type, setup) \
     alloc_netdev(size, name, setup)
+  #define ALLOC_NETDEV_MQS(size, name, type, setup, txqs, rxqs) \
+    alloc_netdev_mqs(size, name, setup, txqs, rxqs)
 #else
   #define ALLOC_NETDEV(size, name, type, setup) \
     alloc_netdev(size, name, type, setup)
+  #define ALLOC_NETDEV_MQS(size, name, type, setup, txqs, rxqs) \
+    alloc_netdev_mqs(size, name, type, setup, txqs, rxqs)
+#endif
+
+/* Trailing ndo_select_queue() arguments */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+  #define ESP_SELECT_QUEUE_ARGS struct net_device *sb_dev
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+  #define ESP_SELECT_QUEUE_ARGS struct net_device *sb_dev, \
+    select_queue_fallback_t fallback
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
+  #define ESP_SELECT_QUEUE_ARGS void *accel_priv, \
+    select_queue_fallback_t fallback
+#else
+  #define ESP_SELECT_QUEUE_ARGS void *accel_priv
+#endif
+
+/* Waits out preempt-disabled (rcu_read_lock_sched) sections */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 20, 0)
+  #define ESP_SYNCHRONIZE_SCHED() synchronize_rcu()
+#else
+  #define ESP_SYNCHRONIZE_SCHED() synchronize_sched()
 #endif
 
 
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Espressif Systems Wireless LAN device driver
+ *
+ * SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+ *
+ */
+#ifndef __ESP_OTA__H__
+#define __ESP_OTA__H__
+
+#include "esp.h"
+
+/* Streams the image at @ota_file to the firmware and ends the update */
+int esp_start_ota(struct esp_adapter *adapter, char *ota_file);
+/* Kills a running update; before the command pool goes away */
+void esp_ota_teardown(struct esp_adapter *adapter);
+
+/* /dev/esp_ota, a write-only sink for the firmware image */
+int esp_ota_dev_init(void);
+void esp_ota_dev_deinit(void);
+
+#endif
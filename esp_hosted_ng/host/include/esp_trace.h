@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: 2015-2026 Espressif Systems (Shanghai) CO LTD
+
+/* Packet lifecycle tracepoints, e.g.
+ *   perf record -e 'esp_hosted_ng:*' -a
+ *   echo 1 > /sys/kernel/tracing/events/esp_hosted_ng/enable
+ *
+ * The payload header has no sequence field, so each side numbers the frames
+ * it sends in a spare header byte (8 bits, wraps) and frame events report it
+ * as "tag": reserved2 for H2E frames (stamped by the host), reserved1 for E2H
+ * frames (stamped by the slave, since reserved2 carries its buffer flag).
+ * The slave logs the same tags at verbose level on its RX and TX paths. The
+ * host timestamp is the trace record's own.
+ *
+ * esp_hosted_fg has its own copy of these events. The two drivers are built
+ * as separate modules from separate trees, register different TRACE_SYSTEMs
+ * and read the tag from different header fields (FG has a real seq_num), so
+ * the classes are kept apart; keep event names and formats in step.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM esp_hosted_ng
+
+#if !defined(_ESP_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _ESP_TRACE_H_
+
+#include <linux/tracepoint.h>
+#include "adapter.h"
+
+TRACE_EVENT(esp_xmit,
+	TP_PROTO(u8 if_type, u8 if_num, u32 len),
+	TP_ARGS(if_type, if_num, len),
+	TP_STRUCT__entry(
+		__field(u8, if_type)
+		__field(u8, if_num)
+		__field(u32, len)
+	),
+	TP_fast_assign(
+		__entry->if_type = if_type;
+		__entry->if_num = if_num;
+		__entry->len = len;
+	),
+	TP_printk("if=%u/%u len=%u",
+		  __entry->if_type, __entry->if_num, __entry->len)
+);
+
+/* H2E frame, tag stamped by the host */
+DECLARE_EVENT_CLASS(esp_h2e_frame,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h),
+	TP_STRUCT__entry(
+		__field(u8, if_type)
+		__field(u8, if_num)
+		__field(u8, flags)
+		__field(u8, packet_type)
+		__field(u8, tag)
+		__field(u16, len)
+	),
+	TP_fast_assign(
+		__entry->if_type = h->if_type;
+		__entry->if_num = h->if_num;
+		__entry->flags = h->flags;
+		__entry->packet_type = h->packet_type;
+		__entry->tag = h->reserved2;
+		__entry->len = le16_to_cpu(h->len);
+	),
+	TP_printk("if=%u/%u type=%u tag=%u len=%u flags=0x%x",
+		  __entry->if_type, __entry->if_num, __entry->packet_type,
+		  __entry->tag, __entry->len, __entry->flags)
+);
+
+/* E2H frame, tag stamped by the slave */
+DECLARE_EVENT_CLASS(esp_e2h_frame,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h),
+	TP_STRUCT__entry(
+		__field(u8, if_type)
+		__field(u8, if_num)
+		__field(u8, flags)
+		__field(u8, packet_type)
+		__field(u8, tag)
+		__field(u16, len)
+	),
+	TP_fast_assign(
+		__entry->if_type = h->if_type;
+		__entry->if_num = h->if_num;
+		__entry->flags = h->flags;
+		__entry->packet_type = h->packet_type;
+		__entry->tag = h->reserved1;
+		__entry->len = le16_to_cpu(h->len);
+	),
+	TP_printk("if=%u/%u type=%u tag=%u len=%u flags=0x%x",
+		  __entry->if_type, __entry->if_num, __entry->packet_type,
+		  __entry->tag, __entry->len, __entry->flags)
+);
+
+/* Frame put on a transport TX queue */
+TRACE_EVENT(esp_tx_enqueue,
+	TP_PROTO(const struct esp_payload_header *h, u8 prio, u32 pending),
+	TP_ARGS(h, prio, pending),
+	TP_STRUCT__entry(
+		__field(u8, if_type)
+		__field(u8, prio)
+		__field(u8, tag)
+		__field(u16, len)
+		__field(u32, pending)
+	),
+	TP_fast_assign(
+		__entry->if_type = h->if_type;
+		__entry->prio = prio;
+		__entry->tag = h->reserved2;
+		__entry->len = le16_to_cpu(h->len);
+		__entry->pending = pending;
+	),
+	TP_printk("if=%u tag=%u len=%u prio=%u pending=%u",
+		  __entry->if_type, __entry->tag, __entry->len,
+		  __entry->prio, __entry->pending)
+);
+
+/* Frame copied into the TX aggregate being built */
+DEFINE_EVENT(esp_h2e_frame, esp_tx_aggr_add,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h)
+);
+
+/* TX aggregate built and about to be written */
+TRACE_EVENT(esp_tx_aggr,
+	TP_PROTO(u32 frames, u32 bytes, u64 build_ns),
+	TP_ARGS(frames, bytes, build_ns),
+	TP_STRUCT__entry(
+		__field(u32, frames)
+		__field(u32, bytes)
+		__field(u64, build_ns)
+	),
+	TP_fast_assign(
+		__entry->frames = frames;
+		__entry->bytes = bytes;
+		__entry->build_ns = build_ns;
+	),
+	TP_printk("frames=%u bytes=%u build_ns=%llu",
+		  __entry->frames, __entry->bytes, __entry->build_ns)
+);
+
+TRACE_EVENT(esp_tx_credit,
+	TP_PROTO(u32 needed, u64 wait_ns, bool ok),
+	TP_ARGS(needed, wait_ns, ok),
+	TP_STRUCT__entry(
+		__field(u32, needed)
+		__field(u64, wait_ns)
+		__field(bool, ok)
+	),
+	TP_fast_assign(
+		__entry->needed = needed;
+		__entry->wait_ns = wait_ns;
+		__entry->ok = ok;
+	),
+	TP_printk("needed=%u wait_ns=%llu ok=%d",
+		  __entry->needed, __entry->wait_ns, __entry->ok)
+);
+
+/* TX aggregate written to the bus */
+TRACE_EVENT(esp_tx_flush,
+	TP_PROTO(u32 bytes, u64 write_ns, int ret),
+	TP_ARGS(bytes, write_ns, ret),
+	TP_STRUCT__entry(
+		__field(u32, bytes)
+		__field(u64, write_ns)
+		__field(int, ret)
+	),
+	TP_fast_assign(
+		__entry->bytes = bytes;
+		__entry->write_ns = write_ns;
+		__entry->ret = ret;
+	),
+	TP_printk("bytes=%u write_ns=%llu ret=%d",
+		  __entry->bytes, __entry->write_ns, __entry->ret)
+);
+
+/* One bus read, possibly carrying several frames */
+TRACE_EVENT(esp_rx_read,
+	TP_PROTO(u32 bytes, u64 read_ns),
+	TP_ARGS(bytes, read_ns),
+	TP_STRUCT__entry(
+		__field(u32, bytes)
+		__field(u64, read_ns)
+	),
+	TP_fast_assign(
+		__entry->bytes = bytes;
+		__entry->read_ns = read_ns;
+	),
+	TP_printk("bytes=%u read_ns=%llu", __entry->bytes, __entry->read_ns)
+);
+
+/* Frame split out of a bus read */
+DEFINE_EVENT(esp_e2h_frame, esp_rx_frame,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h)
+);
+
+/* Frame handed to its interface (netdev, HCI, command/event) */
+DEFINE_EVENT(esp_e2h_frame, esp_rx_dispatch,
+	TP_PROTO(const struct esp_payload_header *h),
+	TP_ARGS(h)
+);
+
+#endif /* _ESP_TRACE_H_ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE esp_trace
+#include <trace/define_trace.h>
@@ -35,6 +35,7 @@ void esp_hex_dump_verbose(const char *prefix_str, const void *buf, size_t len);
 
 int debugfs_init(void);
 void debugfs_exit(void);
+void esp_debugfs_log(int level, const char *function, const char *fmt, va_list args);
 
 #define esp_err(format, ...) esp_logger(ESP_ERR, __func__, format, ##__VA_ARGS__)
 #define esp_warn(format, ...) esp_logger(ESP_WARNING, __func__, format, ##__VA_ARGS__)
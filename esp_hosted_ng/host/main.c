@@ -11,6 +11,7 @@
 #include <linux/kernel.h>
 #include <linux/gpio.h>
 #include <linux/igmp.h>
+#include <linux/crc32.h>
 
 #include "esp.h"
 #include "esp_if.h"
@@ -22,9 +23,16 @@
 
 #include "esp_cfg80211.h"
 #include "esp_stats.h"
+#include "esp_wmm.h"
+#include "esp_ota.h"
+
+#define CREATE_TRACE_POINTS
+#include "esp_trace.h"
 
 #define HOST_GPIO_PIN_INVALID -1
 #define CONFIG_ALLOW_MULTICAST_WAKEUP 1
+/* Beyond this many groups the hash filter passes most multicast anyway */
+#define MCAST_HASH_MAX_ADDR_COUNT 64
 
 #define STRINGIFY_HELPER(x) #x
 #define STRINGIFY(x) STRINGIFY_HELPER(x)
@@ -144,6 +152,8 @@ static int process_tx_packet(struct sk_buff *skb)
 		/* Populate new SKB */
 		skb_copy_from_linear_data(skb, pos, skb->len);
 		skb_put(new_skb, skb->len + pad_len);
+		/* The transport picks the AC lane from it */
+		skb_set_queue_mapping(new_skb, skb_get_queue_mapping(skb));
 
 		/* Replace old SKB */
 		dev_kfree_skb_any(skb);
@@ -191,8 +201,15 @@ static int process_tx_packet(struct sk_buff *skb)
 
 void esp_port_open(struct esp_wifi_device *priv)
 {
+	bool was_open = priv->port_open;
+
 	priv->port_open = 1;
 	priv->stop_data = 0;
+
+	/* update_mac_filter() skips updates while the port is closed, so
+	 * push the current list now */
+	if (!was_open)
+		schedule_work(&esp_get_adapter()->mac_flter_work);
 }
 
 void esp_port_close(struct esp_wifi_device *priv)
@@ -310,6 +327,9 @@ static int process_event_esp_bootup(struct esp_adapter *adapter, u8 *evt_buf, u8
 	clear_bit(ESP_INIT_DONE, &adapter->state_flags);
 	/* Initialize dynamic TX aggregate size default to 0, transport-specific defaults will be used if TLV is absent */
 	adapter->tx_aggr_size = 0;
+	/* Older firmware: one command at a time */
+	adapter->fw_cmd_window = 0;
+	adapter->sta_info_interval = 0;
 	/* Deinit module if already initialized */
 	test_raw_tp_cleanup();
 	esp_deinit_module(adapter);
@@ -332,6 +352,16 @@ static int process_event_esp_bootup(struct esp_adapter *adapter, u8 *evt_buf, u8
 				esp_info("Slave RX Buffer Size configured dynamically: %u bytes\n", val);
 			}
 			break;
+		case ESP_BOOTUP_CMD_WINDOW:
+			adapter->fw_cmd_window = *(pos + 2);
+			esp_info("Firmware takes %u commands in flight\n",
+					adapter->fw_cmd_window);
+			break;
+		case ESP_BOOTUP_STA_INFO:
+			adapter->sta_info_interval = le16_to_cpup((__le16 *)(pos + 2));
+			esp_info("Station info pushed every %u ms\n",
+					adapter->sta_info_interval);
+			break;
 		case ESP_BOOTUP_FIRMWARE_CHIP_ID:
 			ret = esp_validate_chipset(adapter, *(pos + 2));
 			break;
@@ -491,16 +521,25 @@ static int esp_hard_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		return NETDEV_TX_OK;
 	}
 
+	trace_esp_xmit(priv->if_type, priv->if_num, skb->len);
+
 	cb = (struct esp_skb_cb *) skb->cb;
 	cb->priv = priv;
 
 	return process_tx_packet(skb);
 }
 
+static u16 esp_select_queue(struct net_device *ndev, struct sk_buff *skb,
+		ESP_SELECT_QUEUE_ARGS)
+{
+	return esp_wmm_classify(skb);
+}
+
 static const struct net_device_ops esp_netdev_ops = {
 	.ndo_open = esp_open,
 	.ndo_stop = esp_stop,
 	.ndo_start_xmit = esp_hard_start_xmit,
+	.ndo_select_queue = esp_select_queue,
 	.ndo_set_mac_address = esp_set_mac_address,
 	.ndo_validate_addr = eth_validate_addr,
 	.ndo_get_stats = esp_get_stats,
@@ -535,65 +574,6 @@ static int esp_add_network_ifaces(struct esp_adapter *adapter)
 	return -1;
 }
 
-int esp_start_ota(struct esp_adapter *adapter, char *ota_file)
-{
-	struct file *file;
-	ssize_t nread;
-	int ret = 0;
-	char *ota_chunk = kmalloc(OTA_CHUNK_SIZE, GFP_KERNEL);;
-
-	if (!ota_chunk) {
-		esp_err("Failed to allocate buffer for ota_chunk\n");
-		return -ENOMEM;
-	}
-
-	memset(ota_chunk, 0, OTA_CHUNK_SIZE);
-
-	file = filp_open(ota_file, O_RDONLY, 0);
-
-	if (IS_ERR(file)) {
-		esp_err("Error reading ota bin, or ota bin not found at %s \n", ota_file);
-		kfree(ota_chunk);
-		return -EINVAL;
-	}
-
-	set_bit(ESP_OTA_IN_PROGRESS, &adapter->state_flags);
-	if (cmd_process_ota_start(adapter->priv[ESP_STA_NW_IF]) != 0) {
-		esp_err("OTA Start failed\n");
-		ret = EINVAL;
-		goto done;
-	}
-
-	while ((nread = kernel_read(file, ota_chunk, OTA_CHUNK_SIZE, &file->f_pos)) > 0) {
-		if (cmd_process_ota_write(adapter->priv[ESP_STA_NW_IF], ota_chunk, nread) !=0) {
-			esp_err("OTA Write failed\n");
-			ret = EINVAL;
-			goto done;
-		}
-		if (nread < OTA_CHUNK_SIZE) {
-			break;
-		}
-	}
-
-	if (nread < 0) {
-		esp_err("Failed to read ota binary file %s \n", ota_file);
-		ret = EINVAL;
-		goto done;
-	}
-
-
-	ret = cmd_process_ota_end(adapter->priv[ESP_STA_NW_IF]);
-	if (ret != 0) {
-		esp_err("cmd_process_ota_end failed %d \n", ret);
-	}
-
-done:
-	kfree(ota_chunk);
-	filp_close(file, NULL);
-	clear_bit(ESP_OTA_IN_PROGRESS, &adapter->state_flags);
-	return ret;
-}
-
 int esp_init_raw_tp(struct esp_adapter *adapter)
 {
 	RET_ON_FAIL(cmd_init_raw_tp_task_timer(adapter->priv[ESP_STA_NW_IF]));
@@ -703,6 +683,7 @@ int esp_remove_card(struct esp_adapter *adapter)
 	if (adapter->if_rx_workqueue) {
 		flush_workqueue(adapter->if_rx_workqueue);
 	}
+	esp_ota_teardown(adapter);
 	esp_commands_teardown(adapter);
 	esp_remove_network_ifaces(adapter);
 	esp_remove_wiphy(adapter);
@@ -795,6 +776,7 @@ static void process_rx_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 
 	/* get the paload header */
 	payload_header = (struct esp_payload_header *) skb->data;
+	trace_esp_rx_dispatch(payload_header);
 
 	len = le16_to_cpu(payload_header->len);
 	offset = le16_to_cpu(payload_header->offset);
@@ -946,8 +928,9 @@ void esp_tx_pause(struct esp_wifi_device *priv)
 	if (!priv || !priv->ndev)
 		return;
 
+	/* The transport has a single budget for all AC queues */
 	if (!netif_queue_stopped((const struct net_device *)priv->ndev)) {
-		netif_stop_queue(priv->ndev);
+		netif_tx_stop_all_queues(priv->ndev);
 	}
 }
 
@@ -957,7 +940,60 @@ void esp_tx_resume(struct esp_wifi_device *priv)
 		return;
 
 	if (netif_queue_stopped((const struct net_device *)priv->ndev)) {
-		netif_wake_queue(priv->ndev);
+		netif_tx_wake_all_queues(priv->ndev);
+	}
+}
+
+/* Byte queue limits, per AC queue of each netdev. Only network data is
+ * accounted; the transport reports a frame sent when it takes it in and
+ * completed once it leaves its queue for the bus, or is dropped there. */
+static struct netdev_queue *esp_tx_bql_queue(struct sk_buff *skb)
+{
+	struct esp_payload_header *payload_header;
+	struct esp_skb_cb *cb = (struct esp_skb_cb *)skb->cb;
+
+	payload_header = (struct esp_payload_header *)skb->data;
+	if (payload_header->packet_type != PACKET_TYPE_DATA ||
+	    (payload_header->if_type != ESP_STA_IF &&
+	     payload_header->if_type != ESP_AP_IF))
+		return NULL;
+
+	if (!cb->priv || !cb->priv->ndev)
+		return NULL;
+
+	return netdev_get_tx_queue(cb->priv->ndev, skb_get_queue_mapping(skb));
+}
+
+void esp_tx_bql_sent(struct sk_buff *skb)
+{
+	struct netdev_queue *txq = esp_tx_bql_queue(skb);
+
+	if (txq)
+		netdev_tx_sent_queue(txq, skb->len);
+}
+
+void esp_tx_bql_completed(struct sk_buff *skb)
+{
+	struct netdev_queue *txq = esp_tx_bql_queue(skb);
+
+	if (txq)
+		netdev_tx_completed_queue(txq, 1, skb->len);
+}
+
+/* Transport queues were purged: forget what was in flight */
+void esp_tx_bql_reset(struct esp_adapter *adapter)
+{
+	struct esp_wifi_device *priv;
+	unsigned int q;
+	int i;
+
+	for (i = 0; i < ESP_MAX_INTERFACE; i++) {
+		priv = adapter->priv[i];
+		if (!priv || !priv->ndev)
+			continue;
+
+		for (q = 0; q < priv->ndev->num_tx_queues; q++)
+			netdev_tx_reset_queue(netdev_get_tx_queue(priv->ndev, q));
 	}
 }
 
@@ -974,6 +1010,28 @@ static int esp_get_packets(struct esp_adapter *adapter)
 	return 0;
 }
 
+/* Number H2E frames in reserved2 so host traces and slave logs can be
+ * matched. Callers have already sealed the byte-sum checksum, which is
+ * patched for the new byte instead of being recomputed. */
+static void esp_stamp_tx_seq(struct esp_adapter *adapter, struct sk_buff *skb)
+{
+	static atomic_t tx_seq_num;
+	struct esp_payload_header *h;
+	u8 seq;
+
+	if (!skb || skb->len < sizeof(*h))
+		return;
+
+	h = (struct esp_payload_header *)skb->data;
+	if (h->reserved2)
+		return;
+
+	seq = (u8)atomic_inc_return(&tx_seq_num);
+	h->reserved2 = seq;
+	if (adapter->capabilities & ESP_CHECKSUM_ENABLED)
+		h->checksum = cpu_to_le16(le16_to_cpu(h->checksum) + seq);
+}
+
 int esp_send_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 {
 	if (!adapter || !adapter->if_ops || !adapter->if_ops->write) {
@@ -981,6 +1039,8 @@ int esp_send_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 		return -EINVAL;
 	}
 
+	esp_stamp_tx_seq(adapter, skb);
+
 	return adapter->if_ops->write(adapter, skb);
 }
 
@@ -997,6 +1057,7 @@ static void update_mac_filter(struct work_struct *work)
 	struct net_device *ndev;
 	struct netdev_hw_addr *mac_addr;
 	u32 count = 0;
+	u8 bucket;
 
 	if (!priv)
 		return;
@@ -1011,12 +1072,28 @@ static void update_mac_filter(struct work_struct *work)
 	}
 
 #if CONFIG_ALLOW_MULTICAST_WAKEUP
+	memset(&mcast_list, 0, sizeof(mcast_list));
+
+	netif_addr_lock_bh(ndev);
+	/* Exact list while it fits, then the hash, then everything */
+	if ((ndev->flags & (IFF_PROMISC | IFF_ALLMULTI)) ||
+	    netdev_mc_count(ndev) > MCAST_HASH_MAX_ADDR_COUNT)
+		mcast_list.mode = MCAST_FILTER_ALLMULTI;
+	else if (netdev_mc_count(ndev) > MAX_MULTICAST_ADDR_COUNT)
+		mcast_list.mode = MCAST_FILTER_HASH;
+	else
+		mcast_list.mode = MCAST_FILTER_LIST;
+
 	netdev_for_each_mc_addr(mac_addr, ndev) {
 		if (count < MAX_MULTICAST_ADDR_COUNT) {
 			esp_verbose("%d: "MACSTR"\n", count+1, MAC2STR(mac_addr->addr));
 			memcpy(&mcast_list.mcast_addr[count++], mac_addr->addr, ETH_ALEN);
 		}
+
+		bucket = ether_crc(ETH_ALEN, mac_addr->addr) >> 24;
+		mcast_list.mcast_hash[bucket / 8] |= BIT(bucket % 8);
 	}
+	netif_addr_unlock_bh(ndev);
 
 	mcast_list.priv = priv;
 	mcast_list.addr_count = count;
@@ -1132,7 +1209,12 @@ static int __init esp_init(void)
 	}
 
 	ret = debugfs_init();
-	return ret;
+	if (ret)
+		return ret;
+
+	/* ota_file still works without it */
+	esp_ota_dev_init();
+	return 0;
 }
 
 static void __exit esp_exit(void)
@@ -1143,6 +1225,8 @@ static void __exit esp_exit(void)
 		test_raw_tp_cleanup();
 	}
 #endif
+	esp_ota_dev_deinit();
+
 	for (iface_idx = 0; iface_idx < ESP_MAX_INTERFACE; iface_idx++) {
 		cmd_deinit_interface(adapter.priv[iface_idx]);
 	}
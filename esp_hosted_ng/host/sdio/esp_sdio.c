@@ -20,13 +20,18 @@
 #include <linux/kthread.h>
 #include <linux/ktime.h>
 #include "esp_stats.h"
+#include "esp_trace.h"
 #include "esp_utils.h"
 #include "esp_kernel_port.h"
 
 extern u32 raw_tp_mode;
 #define MAX_WRITE_RETRIES       2000
-#define TX_MAX_PENDING_COUNT    1000
+#define TX_MAX_PENDING_COUNT    1000   /* high-water: pause netdev queues */
+#define TX_PENDING_HEADROOM     64     /* frames past high-water before drops */
+#define TX_HARD_PENDING_COUNT   (TX_MAX_PENDING_COUNT + TX_PENDING_HEADROOM)
 #define TX_RESUME_THRESHOLD     (TX_MAX_PENDING_COUNT/5)
+#define TX_MAX_PENDING_BYTES    (2 * 1024 * 1024)  /* default byte high-water */
+#define TX_PENDING_BYTES_MIN    (64 * 1024)
 
 #define CHECK_SDIO_RW_ERROR(ret) do {			\
 	if (ret)						\
@@ -35,7 +40,12 @@ extern u32 raw_tp_mode;
 
 struct esp_sdio_context sdio_context;
 static atomic_t tx_pending;
+static atomic_t tx_pending_bytes;
 static atomic_t queue_items[MAX_PRIORITY_QUEUES];
+
+static uint tx_max_pending_bytes = TX_MAX_PENDING_BYTES;
+module_param(tx_max_pending_bytes, uint, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+MODULE_PARM_DESC(tx_max_pending_bytes, "H2E bytes queued before network TX is paused");
 #ifdef ESP_DEBUG_STATS
 static atomic_t h2e_host_tx_queued;
 static atomic_t h2e_host_tx_sent;
@@ -316,8 +326,12 @@ static void esp_remove(struct sdio_func *func)
 	if (context) {
 		for (prio_q_idx = 0; prio_q_idx < MAX_PRIORITY_QUEUES; prio_q_idx++)
 			skb_queue_purge(&(sdio_context.tx_q[prio_q_idx]));
+		esp_ac_queue_purge(&sdio_context.tx_data);
 		skb_queue_purge(&(sdio_context.rx_q));
 		atomic_set(&tx_pending, 0);
+		atomic_set(&tx_pending_bytes, 0);
+		if (context->adapter)
+			esp_tx_bql_reset(context->adapter);
 	}
 
 	if (tx_thread)
@@ -437,6 +451,7 @@ static int init_context(struct esp_sdio_context *context)
 		skb_queue_head_init(&(sdio_context.tx_q[prio_q_idx]));
 		atomic_set(&queue_items[prio_q_idx], 0);
 	}
+	esp_ac_queue_init(&sdio_context.tx_data);
 	skb_queue_head_init(&(sdio_context.rx_q));
 
 	context->adapter->if_type = ESP_IF_TYPE_SDIO;
@@ -453,6 +468,7 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	struct esp_sdio_context *context;
 	struct esp_payload_header *header;
 	u16 len, offset, frame_len, aligned_len, pos_in_aggr;
+	u64 read_start = ktime_get_ns();
 
 	if (!adapter || !adapter->if_context) {
 		esp_err("INVALID args\n");
@@ -540,6 +556,7 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	} while (data_left > 0);
 
 	sdio_release_host(context->func);
+	trace_esp_rx_read(len_from_slave, ktime_get_ns() - read_start);
 
 	header = (struct esp_payload_header *)skb->data;
 	len = le16_to_cpu(header->len);
@@ -565,6 +582,7 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	if (aligned_len >= len_from_slave) {
 		if (frame_len < skb->len)
 			skb_trim(skb, frame_len);
+		trace_esp_rx_frame(header);
 		return skb;
 	}
 
@@ -597,6 +615,7 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 		}
 		skb_put(frame_skb, frame_len);
 		memcpy(frame_skb->data, skb->data + pos_in_aggr, frame_len);
+		trace_esp_rx_frame(header);
 		skb_queue_tail(&(context->rx_q), frame_skb);
 		pos_in_aggr += aligned_len;
 	}
@@ -605,6 +624,62 @@ static struct sk_buff *read_packet(struct esp_adapter *adapter)
 	return skb_dequeue(&(context->rx_q));
 }
 
+/* PRIO_Q_LOW is split per access category */
+static void sdio_tx_enqueue(struct esp_sdio_context *context, int prio,
+		struct sk_buff *skb)
+{
+	if (prio == PRIO_Q_LOW)
+		esp_ac_enqueue(&context->tx_data, skb);
+	else
+		skb_queue_tail(&context->tx_q[prio], skb);
+}
+
+static struct sk_buff *sdio_tx_peek(struct esp_sdio_context *context, int prio)
+{
+	if (prio == PRIO_Q_LOW)
+		return esp_ac_peek(&context->tx_data);
+
+	return skb_peek(&context->tx_q[prio]);
+}
+
+static struct sk_buff *sdio_tx_dequeue(struct esp_sdio_context *context, int prio)
+{
+	if (prio == PRIO_Q_LOW)
+		return esp_ac_dequeue(&context->tx_data);
+
+	return skb_dequeue(&context->tx_q[prio]);
+}
+
+static u32 tx_pending_bytes_limit(void)
+{
+	return max_t(u32, READ_ONCE(tx_max_pending_bytes), TX_PENDING_BYTES_MIN);
+}
+
+/* A frame left the transport queues, for the bus or dropped */
+static void sdio_tx_done(struct sk_buff *skb)
+{
+	atomic_dec_if_positive(&tx_pending);
+	atomic_sub(skb->len, &tx_pending_bytes);
+	esp_tx_bql_completed(skb);
+}
+
+/* Low watermark: wake every paused netdev, whichever frame got us here */
+static void sdio_tx_wake(struct esp_adapter *adapter)
+{
+	int i;
+
+	if (atomic_read(&tx_pending) >= TX_RESUME_THRESHOLD ||
+	    atomic_read(&tx_pending_bytes) >= tx_pending_bytes_limit() / 5)
+		return;
+
+	for (i = 0; i < ESP_MAX_INTERFACE; i++)
+		esp_tx_resume(adapter->priv[i]);
+#if TEST_RAW_TP
+	if (raw_tp_mode != 0)
+		esp_raw_tp_queue_resume();
+#endif
+}
+
 static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 {
 	u32 max_pkt_size = ESP_RX_BUFFER_SIZE - sizeof(struct esp_payload_header);
@@ -630,9 +705,23 @@ static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 		return -EPERM;
 	}
 
+	if (payload_header->if_type == ESP_INTERNAL_IF)
+		prio = PRIO_Q_HIGH;
+	else if (payload_header->if_type == ESP_HCI_IF)
+		prio = PRIO_Q_MID;
+	else
+		prio = PRIO_Q_LOW;
+
+	/* Hard backstop for producers without a qdisc (raw TP, HCI). Netdev
+	 * traffic is held back by the high-water pause below and never gets
+	 * here; commands are bounded by the command window instead. */
 	cb = (struct esp_skb_cb *)skb->cb;
-	if (cb && cb->priv && (atomic_read(&tx_pending) >= TX_MAX_PENDING_COUNT)) {
-		esp_tx_pause(cb->priv);
+	if (prio != PRIO_Q_HIGH &&
+	    (atomic_read(&tx_pending) >= TX_HARD_PENDING_COUNT ||
+	     atomic_read(&tx_pending_bytes) + skb->len >
+	     tx_pending_bytes_limit() + TX_PENDING_HEADROOM * ESP_RX_BUFFER_SIZE)) {
+		if (cb->priv)
+			esp_tx_pause(cb->priv);
 		H2E_HOST_STATS_INC(h2e_host_drop_queue_full);
 		dev_kfree_skb(skb);
 		skb = NULL;
@@ -642,18 +731,22 @@ static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 
 	/* Enqueue SKB in tx_q */
 	atomic_inc(&tx_pending);
+	atomic_add(skb->len, &tx_pending_bytes);
+	/* Before the TX thread can see the skb and complete it */
+	esp_tx_bql_sent(skb);
 
-	/* Notify to process queue */
-	if (payload_header->if_type == ESP_INTERNAL_IF)
-		prio = PRIO_Q_HIGH;
-	else if (payload_header->if_type == ESP_HCI_IF)
-		prio = PRIO_Q_MID;
-	else
-		prio = PRIO_Q_LOW;
-
+	trace_esp_tx_enqueue(payload_header, prio, atomic_read(&tx_pending));
 	atomic_inc(&queue_items[prio]);
 	H2E_HOST_STATS_INC(h2e_host_tx_queued);
-	skb_queue_tail(&(sdio_context.tx_q[prio]), skb);
+	sdio_tx_enqueue(&sdio_context, prio, skb);
+
+	/* High-water: this skb is kept and the netdev stops, so further
+	 * frames wait in the qdisc instead of being dropped here. tx_process
+	 * wakes it at the low watermark. */
+	if (cb->priv &&
+	    (atomic_read(&tx_pending) >= TX_MAX_PENDING_COUNT ||
+	     atomic_read(&tx_pending_bytes) >= tx_pending_bytes_limit()))
+		esp_tx_pause(cb->priv);
 
 	return 0;
 }
@@ -707,7 +800,6 @@ static int tx_process(void *data)
 	struct sk_buff *tx_skb = NULL;
 	struct esp_adapter *adapter = (struct esp_adapter *) data;
 	struct esp_sdio_context *context = NULL;
-	struct esp_skb_cb *cb = NULL;
 	struct esp_payload_header *payload_header = NULL;
 	u8 *aggr_buf = NULL;
 	u32 aggr_len = 0;
@@ -715,6 +807,7 @@ static int tx_process(void *data)
 	bool flush_after_pkt = false;
 	int prio = -1;
 	ktime_t aggr_start, credit_start, write_start;
+	u32 aggr_frames;
 
 	context = adapter->if_context;
 	u32 tx_aggr_size = adapter->tx_aggr_size ? adapter->tx_aggr_size : ESP_HOST_TX_AGGR_SIZE;
@@ -738,6 +831,7 @@ static int tx_process(void *data)
 
 		aggr_start = ktime_get();
 		aggr_len = 0;
+		aggr_frames = 0;
 		while (aggr_len < tx_aggr_size) {
 			prio = -1;
 			if (atomic_read(&queue_items[PRIO_Q_HIGH]) > 0)
@@ -750,7 +844,7 @@ static int tx_process(void *data)
 			if (prio < 0)
 				break;
 
-			tx_skb = skb_peek(&(context->tx_q[prio]));
+			tx_skb = sdio_tx_peek(context, prio);
 			if (!tx_skb) {
 				atomic_dec(&queue_items[prio]);
 				continue;
@@ -763,9 +857,10 @@ static int tx_process(void *data)
 						le16_to_cpu(payload_header->len),
 						le16_to_cpu(payload_header->offset));
 					H2E_HOST_STATS_INC(h2e_host_drop_invalid);
-					tx_skb = skb_dequeue(&(context->tx_q[prio]));
+					tx_skb = sdio_tx_dequeue(context, prio);
 					if (tx_skb) {
 					atomic_dec(&queue_items[prio]);
+					sdio_tx_done(tx_skb);
 					dev_kfree_skb(tx_skb);
 					tx_skb = NULL;
 				}
@@ -777,9 +872,10 @@ static int tx_process(void *data)
 					esp_err("Drop truncated tx pkt: frame_len=%d skb_len=%d\n",
 						frame_len, tx_skb->len);
 					H2E_HOST_STATS_INC(h2e_host_drop_truncated);
-					tx_skb = skb_dequeue(&(context->tx_q[prio]));
+					tx_skb = sdio_tx_dequeue(context, prio);
 					if (tx_skb) {
 					atomic_dec(&queue_items[prio]);
+					sdio_tx_done(tx_skb);
 					dev_kfree_skb(tx_skb);
 					tx_skb = NULL;
 				}
@@ -794,30 +890,23 @@ static int tx_process(void *data)
 			if (aggr_len + len_to_send > tx_aggr_size)
 				break;
 
-			tx_skb = skb_dequeue(&(context->tx_q[prio]));
+			tx_skb = sdio_tx_dequeue(context, prio);
 			if (!tx_skb)
 				continue;
 
 			atomic_dec(&queue_items[prio]);
-			if (atomic_read(&tx_pending))
-				atomic_dec(&tx_pending);
+			sdio_tx_done(tx_skb);
 
 			/* resume network tx queue if bearable load */
-			cb = (struct esp_skb_cb *)tx_skb->cb;
-			if (cb && cb->priv &&
-			    atomic_read(&tx_pending) < TX_RESUME_THRESHOLD) {
-				esp_tx_resume(cb->priv);
-#if TEST_RAW_TP
-				if (raw_tp_mode != 0)
-					esp_raw_tp_queue_resume();
-#endif
-			}
+			sdio_tx_wake(adapter);
 
+			trace_esp_tx_aggr_add(payload_header);
 			memcpy(aggr_buf + aggr_len, tx_skb->data, frame_len);
 			if (len_to_send > frame_len)
 				memset(aggr_buf + aggr_len + frame_len, 0,
 				       len_to_send - frame_len);
 			aggr_len += len_to_send;
+			aggr_frames++;
 			dev_kfree_skb(tx_skb);
 			tx_skb = NULL;
 			if (flush_after_pkt)
@@ -829,6 +918,8 @@ static int tx_process(void *data)
 			continue;
 		}
 		H2E_HOST_STATS_TIME_ADD(h2e_host_time_aggr_us, aggr_start);
+		trace_esp_tx_aggr(aggr_frames, aggr_len,
+				  ktime_to_ns(ktime_sub(ktime_get(), aggr_start)));
 
 		buf_needed = (aggr_len + ESP_RX_BUFFER_SIZE - 1) / ESP_RX_BUFFER_SIZE;
 
@@ -843,6 +934,8 @@ static int tx_process(void *data)
 				usleep_range(10, 20);
 			} while (!kthread_should_stop());
 			H2E_HOST_STATS_TIME_ADD(h2e_host_time_credit_us, credit_start);
+			trace_esp_tx_credit(buf_needed,
+				ktime_to_ns(ktime_sub(ktime_get(), credit_start)), ret);
 			if (kthread_should_stop())
 				break;
 
@@ -874,6 +967,8 @@ static int tx_process(void *data)
 			pos += len_to_send;
 		} while (data_left);
 		H2E_HOST_STATS_TIME_ADD(h2e_host_time_write_us, write_start);
+		trace_esp_tx_flush(aggr_len,
+				   ktime_to_ns(ktime_sub(ktime_get(), write_start)), ret);
 
 		if (ret) {
 			/* drop the packet */
@@ -951,6 +1046,7 @@ static int esp_probe(struct sdio_func *func,
 
 	context = init_sdio_func(func, &ret);;
 	atomic_set(&tx_pending, 0);
+	atomic_set(&tx_pending_bytes, 0);
 
 	if (!context) {
 		if (ret)
@@ -9,6 +9,7 @@
 #define _ESP_DECL_H_
 
 #include "esp.h"
+#include "esp_wmm.h"
 
 /* Interrupt Status */
 #define ESP_SLAVE_BIT0_INT             BIT(0)
@@ -79,7 +80,9 @@
 struct esp_sdio_context {
 	struct esp_adapter     *adapter;
 	struct sdio_func       *func;
+	/* tx_q[PRIO_Q_LOW] stays empty: Wi-Fi data goes to tx_data */
 	struct sk_buff_head    tx_q[MAX_PRIORITY_QUEUES];
+	struct esp_ac_queue    tx_data;
 	struct sk_buff_head    rx_q;
 	u32                    rx_byte_count;
 	u32                    tx_buffer_count;
@@ -169,7 +169,7 @@ static int write_packet(struct esp_adapter *adapter, struct sk_buff *skb)
 	} else if (payload_header->if_type == ESP_HCI_IF) {
 		skb_queue_tail(&spi_context.tx_q[PRIO_Q_MID], skb);
 	} else {
-		skb_queue_tail(&spi_context.tx_q[PRIO_Q_LOW], skb);
+		esp_ac_enqueue(&spi_context.tx_data, skb);
 	}
 
 	if (spi_context.spi_workqueue)
@@ -216,6 +216,7 @@ int esp_deinit_module(struct esp_adapter *adapter)
 	for (prio_q_idx = 0; prio_q_idx < MAX_PRIORITY_QUEUES; prio_q_idx++) {
 		skb_queue_purge(&spi_context.tx_q[prio_q_idx]);
 	}
+	esp_ac_queue_purge(&spi_context.tx_data);
 	atomic_set(&tx_pending, 0);
 
 	for (iface_idx = 0; iface_idx < ESP_MAX_INTERFACE; iface_idx++) {
@@ -228,6 +229,7 @@ int esp_deinit_module(struct esp_adapter *adapter)
 	for (prio_q_idx = 0; prio_q_idx < MAX_PRIORITY_QUEUES; prio_q_idx++) {
 		skb_queue_head_init(&spi_context.tx_q[prio_q_idx]);
 	}
+	esp_ac_queue_init(&spi_context.tx_data);
 
 	return 0;
 }
@@ -305,7 +307,7 @@ static void esp_spi_work(struct work_struct *work)
 		if (!tx_skb)
 			tx_skb = skb_dequeue(&spi_context.tx_q[PRIO_Q_MID]);
 		if (!tx_skb)
-			tx_skb = skb_dequeue(&spi_context.tx_q[PRIO_Q_LOW]);
+			tx_skb = esp_ac_dequeue(&spi_context.tx_data);
 		if (tx_skb) {
 			if (atomic_read(&tx_pending))
 				atomic_dec(&tx_pending);
@@ -570,6 +572,7 @@ static int spi_init(void)
 		skb_queue_head_init(&spi_context.tx_q[prio_q_idx]);
 		skb_queue_head_init(&spi_context.rx_q[prio_q_idx]);
 	}
+	esp_ac_queue_init(&spi_context.tx_data);
 
 	status = spi_dev_init(spi_context.spi_clk_mhz);
 	if (status) {
@@ -635,6 +638,7 @@ static void spi_exit(void)
 		skb_queue_purge(&spi_context.tx_q[prio_q_idx]);
 		skb_queue_purge(&spi_context.rx_q[prio_q_idx]);
 	}
+	esp_ac_queue_purge(&spi_context.tx_data);
 	atomic_set(&tx_pending, 0);
 
 	if (spi_context.spi_workqueue) {
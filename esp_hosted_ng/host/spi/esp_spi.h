@@ -8,6 +8,7 @@
 #define _ESP_SPI_H_
 
 #include "esp.h"
+#include "esp_wmm.h"
 
 #define HANDSHAKE_PIN           22
 #define SPI_IRQ                 gpio_to_irq(HANDSHAKE_PIN)
@@ -28,7 +29,9 @@ enum spi_flags_e {
 struct esp_spi_context {
 	struct esp_adapter          *adapter;
 	struct spi_device           *esp_spi_dev;
+	/* tx_q[PRIO_Q_LOW] stays empty: Wi-Fi data goes to tx_data */
 	struct sk_buff_head         tx_q[MAX_PRIORITY_QUEUES];
+	struct esp_ac_queue         tx_data;
 	struct sk_buff_head         rx_q[MAX_PRIORITY_QUEUES];
 	struct workqueue_struct     *spi_workqueue;
 	struct work_struct          spi_work;